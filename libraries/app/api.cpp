@@ -69,9 +69,17 @@ namespace graphene { namespace app {
 
        for( const std::string& api_name : acc->allowed_apis )
           enable_api( api_name );
+       // the limits belong to the access entry, unknown users are granted the one of "*" and share its limits
+       if( _session_costs )
+          _session_costs->set_user( _app.has_own_api_access_info( user ) ? user : "*", acc->throttle );
        return true;
     }
 
+    void login_api::set_session_costs( std::shared_ptr<api_session_costs> costs )
+    {
+       _session_costs = std::move( costs );
+    }
+
     void login_api::enable_api( const std::string& api_name )
     {
        if( api_name == "database_api" )
@@ -112,6 +120,10 @@ namespace graphene { namespace app {
           if( _app.get_plugin( "debug_witness" ) )
              _debug_api = std::make_shared< graphene::debug_witness::debug_api >( std::ref(_app) );
        }
+       else if( api_name == "metrics_api" )
+       {
+          _metrics_api = std::make_shared< metrics_api >( std::ref( _app ) );
+       }
        return;
     }
 
@@ -129,6 +141,152 @@ namespace graphene { namespace app {
        return res;
     }
 
+    packed_data block_api::get_blocks_packed(uint32_t block_num_from, uint32_t block_num_to)const
+    {
+       FC_ASSERT( block_num_to >= block_num_from );
+       // the layout of fc::raw::pack( vector<optional<signed_block>> ), built from the blocks as they are stored
+       packed_data res;
+       res.data = fc::raw::pack( fc::unsigned_int( block_num_to - block_num_from + 1 ) );
+       for(uint32_t block_num=block_num_from; block_num<=block_num_to; block_num++) {
+          const optional<vector<char>> block = _db.fetch_packed_block_by_number(block_num);
+          res.data.push_back( block.valid() ? 1 : 0 );
+          if( block.valid() )
+             res.data.insert( res.data.end(), block->begin(), block->end() );
+       }
+       return res;
+    }
+
+    const uint32_t block_api::max_streams;
+    const uint32_t block_api::max_window;
+
+    struct block_api::block_stream
+    {
+       uint32_t                                 id = 0;
+       std::function<void(const variant&)>      callback;
+       uint32_t                                 next_block_num = 0;
+       uint32_t                                 last_block_num = 0;
+       uint32_t                                 window = 0;
+       uint32_t                                 sent = 0;         ///< sequence of the last chunk sent
+       uint32_t                                 acknowledged = 0; ///< sequence of the last chunk acknowledged
+       bool                                     sending = false;
+       bool                                     finished = false;
+    };
+
+    uint32_t block_api::stream_blocks( std::function<void(const variant&)> callback, uint32_t block_num_from,
+                                       uint32_t block_num_to, uint32_t window )
+    {
+       FC_ASSERT( block_num_from > 0 && block_num_to >= block_num_from );
+       FC_ASSERT( window > 0 && window <= max_window, "The window must be between 1 and ${m}", ("m", max_window) );
+       FC_ASSERT( _streams.size() < max_streams, "At most ${m} block streams can run at the same time",
+                  ("m", max_streams) );
+
+       auto stream = std::make_shared<block_stream>();
+       stream->id = _next_stream_id++;
+       stream->callback = callback;
+       stream->next_block_num = block_num_from;
+       stream->last_block_num = block_num_to;
+       stream->window = window;
+       _streams[ stream->id ] = stream;
+
+       // the first chunks follow the response to this call
+       auto capture_this = shared_from_this();
+       fc::async( [capture_this,stream]() { capture_this->send_chunks( stream ); } );
+       return stream->id;
+    }
+
+    void block_api::acknowledge_block_chunk( uint32_t stream_id, uint32_t sequence )
+    {
+       auto itr = _streams.find( stream_id );
+       // the stream may have sent its last chunk already
+       if( itr == _streams.end() )
+          return;
+       const auto stream = itr->second;
+       FC_ASSERT( sequence <= stream->sent, "Chunk ${s} has not been sent yet", ("s", sequence) );
+       stream->acknowledged = std::max( stream->acknowledged, sequence );
+       if( !stream->sending )
+       {
+          auto capture_this = shared_from_this();
+          fc::async( [capture_this,stream]() { capture_this->send_chunks( stream ); } );
+       }
+    }
+
+    void block_api::cancel_block_stream( uint32_t stream_id )
+    {
+       auto itr = _streams.find( stream_id );
+       if( itr == _streams.end() )
+          return;
+       itr->second->finished = true;
+       _streams.erase( itr );
+    }
+
+    void block_api::send_chunks( const std::shared_ptr<block_stream>& stream )
+    {
+       // sending may yield, acknowledgements arriving meanwhile are picked up by this loop
+       if( stream->sending )
+          return;
+       stream->sending = true;
+       try
+       {
+          while( !stream->finished && stream->sent - stream->acknowledged < stream->window )
+          {
+             const block_chunk chunk = next_chunk( *stream );
+             if( chunk.last )
+             {
+                stream->finished = true;
+                _streams.erase( stream->id );
+             }
+             stream->callback( fc::variant( chunk, 2 ) );
+          }
+       }
+       catch( const fc::exception& e )
+       {
+          // e.g. the client disconnected, the stream must not keep its slot
+          wlog( "Block stream ${id} ended: ${e}", ("id", stream->id)("e", e.to_string()) );
+          stream->finished = true;
+          _streams.erase( stream->id );
+       }
+       catch( const std::exception& e )
+       {
+          wlog( "Block stream ${id} ended: ${e}", ("id", stream->id)("e", e.what()) );
+          stream->finished = true;
+          _streams.erase( stream->id );
+       }
+       stream->sending = false;
+    }
+
+    block_chunk block_api::next_chunk( block_stream& stream )const
+    {
+       block_chunk chunk;
+       chunk.stream_id = stream.id;
+       chunk.sequence = ++stream.sent;
+       chunk.first_block_num = stream.next_block_num;
+
+       // the blocks as fc::raw::pack( vector<signed_block> ) lays them out, the count is prepended below
+       const uint32_t last_block_num = std::min( stream.last_block_num, _db.head_block_num() );
+       vector<char> body;
+       bool missing = false;
+       while( stream.next_block_num <= last_block_num && chunk.block_count < max_chunk_blocks
+              && body.size() < max_chunk_bytes )
+       {
+          const optional<vector<char>> block = _db.fetch_packed_block_by_number( stream.next_block_num );
+          if( !block.valid() )
+          {
+             missing = true;
+             break;
+          }
+          body.insert( body.end(), block->begin(), block->end() );
+          ++chunk.block_count;
+          ++stream.next_block_num;
+       }
+       chunk.last = missing || stream.next_block_num > last_block_num;
+       if( missing )
+          chunk.error = "Block " + std::to_string( stream.next_block_num ) + " is not available";
+
+       chunk.blocks.data = fc::raw::pack( fc::unsigned_int( chunk.block_count ) );
+       chunk.blocks.data.insert( chunk.blocks.data.end(), body.begin(), body.end() );
+       return chunk;
+    }
+
     network_broadcast_api::network_broadcast_api(application& a):_app(a)
     {
        _applied_block_connection = _app.chain_database()->applied_block.connect([this](const signed_block& b){ on_applied_block(b); });
@@ -283,6 +441,12 @@ namespace graphene { namespace app {
        return *_debug_api;
     }
 
+    fc::api<metrics_api> login_api::metrics() const
+    {
+       FC_ASSERT(_metrics_api);
+       return *_metrics_api;
+    }
+
     vector<order_history_object> history_api::get_fill_order_history( std::string asset_a, std::string asset_b, uint32_t limit  )const
     {
        FC_ASSERT(_app.chain_database());
@@ -345,6 +509,14 @@ namespace graphene { namespace app {
        return result;
     }
 
+    packed_data history_api::get_account_history_packed( const std::string account_id_or_name,
+                                                         operation_history_id_type stop,
+                                                         unsigned limit,
+                                                         operation_history_id_type start ) const
+    {
+       return pack_data( get_account_history( account_id_or_name, stop, limit, start ) );
+    }
+
     vector<operation_history_object> history_api::get_account_history_operations( const std::string account_id_or_name,
                                                                        int operation_type,
                                                                        operation_history_id_type start,
@@ -647,4 +819,60 @@ namespace graphene { namespace app {
       return result;
    }
 
+   // metrics_api
+   metrics_api::metrics_api( application& app ) : _app( app ) { }
+
+   execution_profile metrics_api::get_execution_profile()const
+   {
+      return _app.chain_database()->get_execution_profiler().get_profile();
+   }
+
+   void metrics_api::reset_execution_profile()
+   {
+      _app.chain_database()->get_execution_profiler().reset();
+   }
+
+   vector<block_phase_trace> metrics_api::get_block_phase_traces( uint32_t limit )const
+   {
+      return _app.chain_database()->get_block_phase_tracer().get_traces( limit );
+   }
+
+   object_cache_stats metrics_api::get_object_cache_stats()const
+   {
+      return serialized_object_cache::get( *_app.chain_database() )->get_stats();
+   }
+
+   void metrics_api::reset_object_cache_stats()
+   {
+      serialized_object_cache::get( *_app.chain_database() )->reset_stats();
+   }
+
+   vector<api_method_profile> metrics_api::get_api_execution_profile()const
+   {
+      return api_executor::get( *_app.chain_database() )->get_profile();
+   }
+
+   void metrics_api::reset_api_execution_profile()
+   {
+      api_executor::get( *_app.chain_database() )->reset_profile();
+   }
+
+   vector<api_method_metrics> metrics_api::get_api_method_metrics()const
+   {
+      const auto metrics = _app.get_api_metrics();
+      return metrics ? metrics->get_metrics() : vector<api_method_metrics>();
+   }
+
+   void metrics_api::reset_api_method_metrics()
+   {
+      const auto metrics = _app.get_api_metrics();
+      if( metrics )
+         metrics->reset();
+   }
+
+   vector<api_cost_info> metrics_api::get_api_session_costs()const
+   {
+      return _app.get_api_cost_registry()->get_costs();
+   }
+
 } } // graphene::app
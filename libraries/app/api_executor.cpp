@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_executor.hpp>
+
+namespace graphene { namespace app {
+
+using graphene::chain::database;
+
+std::shared_ptr<api_executor> api_executor::get( database& db )
+{
+   static std::mutex executors_mutex;
+   static std::map< const database*, std::weak_ptr<api_executor> > executors;
+
+   std::lock_guard<std::mutex> guard( executors_mutex );
+   std::shared_ptr<api_executor> executor = executors[ &db ].lock();
+   if( !executor )
+   {
+      for( auto itr = executors.begin(); itr != executors.end(); )
+      {
+         if( itr->second.expired() )
+            itr = executors.erase( itr );
+         else
+            ++itr;
+      }
+      executor = std::make_shared<api_executor>( db );
+      executors[ &db ] = executor;
+   }
+   return executor;
+}
+
+api_executor::api_executor( database& db ) : _db( db ) {}
+
+api_executor::~api_executor() {}
+
+void api_executor::set_thread_count( uint16_t count )
+{
+   // destroying a thread lets it finish its tasks
+   _threads.clear();
+   for( uint16_t i = 0; i < count; ++i )
+      _threads.emplace_back( new fc::thread( "api_" + std::to_string( i ) ) );
+   if( count > 0 )
+      ilog( "Executing read-only database API calls on ${n} threads", ("n", count) );
+}
+
+api_executor::call_timer::call_timer( api_executor& executor, const char* method, clock::time_point queued )
+   : _executor( executor ), _method( method ), _queued( queued ), _started( clock::now() ) {}
+
+api_executor::call_timer::~call_timer()
+{
+   using std::chrono::duration_cast;
+   using std::chrono::nanoseconds;
+   _executor.record( _method, duration_cast< nanoseconds >( _started - _queued ).count(),
+                     duration_cast< nanoseconds >( clock::now() - _started ).count() );
+}
+
+void api_executor::record( const char* method, uint64_t queue_wait_ns, uint64_t execution_ns )
+{
+   std::lock_guard<std::mutex> guard( _stats_mutex );
+   method_stats& stats = _stats[ method ];
+   stats.queue_wait.record( queue_wait_ns );
+   stats.execution.record( execution_ns );
+}
+
+std::vector< api_method_profile > api_executor::get_profile()const
+{
+   std::vector< api_method_profile > result;
+   std::lock_guard<std::mutex> guard( _stats_mutex );
+   result.reserve( _stats.size() );
+   for( const auto& item : _stats )
+   {
+      api_method_profile profile;
+      profile.method = item.first;
+      profile.queue_wait = graphene::chain::summarize( item.first, item.second.queue_wait );
+      profile.execution = graphene::chain::summarize( item.first, item.second.execution );
+      result.push_back( std::move( profile ) );
+   }
+   return result;
+}
+
+void api_executor::reset_profile()
+{
+   std::lock_guard<std::mutex> guard( _stats_mutex );
+   _stats.clear();
+}
+
+} } // graphene::app
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_metrics.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace graphene { namespace app {
+
+namespace {
+
+   void write_seconds( std::ostream& out, uint64_t ns )
+   {
+      out << ns / 1000000000 << '.' << std::setw(9) << std::setfill('0') << ns % 1000000000;
+   }
+
+} // anonymous namespace
+
+std::string prometheus_escape_label( const std::string& value )
+{
+   std::string result;
+   result.reserve( value.size() );
+   for( char c : value )
+   {
+      if( c == '\\' || c == '"' )
+      {
+         result += '\\';
+         result += c;
+      }
+      else if( c == '\n' )
+         result += "\\n";
+      else
+         result += c;
+   }
+   return result;
+}
+
+void write_prometheus_header( std::ostream& out, const char* name, const char* type, const char* help )
+{
+   out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+}
+
+const std::array< uint64_t, api_metrics::latency_bucket_count > api_metrics::latency_bounds_ns = {{
+   100000, 250000, 500000,                   // 0.1, 0.25, 0.5 ms
+   1000000, 2500000, 5000000,                // 1, 2.5, 5 ms
+   10000000, 25000000, 50000000,             // 10, 25, 50 ms
+   100000000, 250000000, 500000000,          // 0.1, 0.25, 0.5 s
+   1000000000, 2500000000, 5000000000,       // 1, 2.5, 5 s
+   10000000000                               // 10 s
+}};
+
+void api_metrics::record( const std::string& api, const std::string& method, uint64_t latency_ns,
+                          uint64_t response_bytes, bool error )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _stats.find( std::make_pair( api, method ) );
+   if( itr == _stats.end() )
+   {
+      const auto key = _stats.size() < max_methods ? std::make_pair( api, method )
+                                                    : std::make_pair( std::string( "other" ), std::string( "other" ) );
+      itr = _stats.emplace( key, method_stats() ).first;
+   }
+   method_stats& stats = itr->second;
+   stats.latency.record( latency_ns );
+   stats.response_bytes += response_bytes;
+   if( error )
+      ++stats.errors;
+   const auto bucket = std::lower_bound( latency_bounds_ns.begin(), latency_bounds_ns.end(), latency_ns );
+   if( bucket != latency_bounds_ns.end() )
+      ++stats.buckets[ bucket - latency_bounds_ns.begin() ];
+}
+
+std::vector< api_method_metrics > api_metrics::get_metrics()const
+{
+   std::vector< api_method_metrics > result;
+   std::lock_guard<std::mutex> guard( _mutex );
+   result.reserve( _stats.size() );
+   for( const auto& item : _stats )
+   {
+      api_method_metrics metrics;
+      metrics.api = item.first.first;
+      metrics.method = item.first.second;
+      metrics.calls = item.second.latency.count;
+      metrics.errors = item.second.errors;
+      metrics.response_bytes = item.second.response_bytes;
+      metrics.latency = graphene::chain::summarize( item.first.second, item.second.latency );
+      result.push_back( std::move( metrics ) );
+   }
+   return result;
+}
+
+void api_metrics::reset()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _stats.clear();
+}
+
+std::string api_metrics::to_prometheus( const graphene::chain::database& db )const
+{
+   std::ostringstream out;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      auto labels = []( const std::pair< std::string, std::string >& key ) {
+         return "api=\"" + prometheus_escape_label( key.first ) + "\",method=\""
+                + prometheus_escape_label( key.second ) + "\"";
+      };
+
+      write_prometheus_header( out, "graphene_api_calls_total", "counter", "API calls by method." );
+      for( const auto& item : _stats )
+         out << "graphene_api_calls_total{" << labels( item.first ) << "} " << item.second.latency.count << '\n';
+
+      write_prometheus_header( out, "graphene_api_errors_total", "counter",
+                               "API calls which returned an error." );
+      for( const auto& item : _stats )
+         out << "graphene_api_errors_total{" << labels( item.first ) << "} " << item.second.errors << '\n';
+
+      write_prometheus_header( out, "graphene_api_response_bytes_total", "counter",
+                               "Size of the API responses." );
+      for( const auto& item : _stats )
+         out << "graphene_api_response_bytes_total{" << labels( item.first ) << "} " << item.second.response_bytes
+             << '\n';
+
+      write_prometheus_header( out, "graphene_api_latency_seconds", "histogram",
+                               "Time from the arrival of an API request until its response is ready." );
+      for( const auto& item : _stats )
+      {
+         const std::string label = labels( item.first );
+         uint64_t cumulative = 0;
+         for( size_t b = 0; b < latency_bucket_count; ++b )
+         {
+            cumulative += item.second.buckets[b];
+            out << "graphene_api_latency_seconds_bucket{" << label << ",le=\"";
+            write_seconds( out, latency_bounds_ns[b] );
+            out << "\"} " << cumulative << '\n';
+         }
+         out << "graphene_api_latency_seconds_bucket{" << label << ",le=\"+Inf\"} "
+             << item.second.latency.count << '\n';
+         out << "graphene_api_latency_seconds_sum{" << label << "} ";
+         write_seconds( out, item.second.latency.total_ns );
+         out << "\ngraphene_api_latency_seconds_count{" << label << "} " << item.second.latency.count << '\n';
+      }
+   }
+
+   write_prometheus_header( out, "graphene_head_block_number", "gauge", "Number of the head block." );
+   out << "graphene_head_block_number " << db.head_block_num() << '\n';
+   write_prometheus_header( out, "graphene_head_block_age_seconds", "gauge",
+                            "Time since the timestamp of the head block." );
+   out << "graphene_head_block_age_seconds "
+       << std::max< int64_t >( 0, ( fc::time_point::now() - db.head_block_time() ).to_seconds() ) << '\n';
+   write_prometheus_header( out, "graphene_pending_transactions", "gauge",
+                            "Transactions waiting to be included in a block." );
+   out << "graphene_pending_transactions " << db.get_pending_transaction_count() << '\n';
+   write_prometheus_header( out, "graphene_undo_depth", "gauge", "Blocks and sessions which can be undone." );
+   out << "graphene_undo_depth " << db._undo_db.size() << '\n';
+   return out.str();
+}
+
+} } // graphene::app
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_throttle.hpp>
+#include <graphene/app/api_metrics.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace graphene { namespace app {
+
+token_bucket::token_bucket( double rate, double burst )
+   : _rate( std::max( rate, 0.0 ) ),
+     // without a configured burst a client may spend one second worth of its rate at once
+     _burst( burst > 0 ? burst : _rate ),
+     _tokens( _burst ),
+     _updated( fc::time_point::now() )
+{}
+
+void token_bucket::refill( fc::time_point now )
+{
+   if( now <= _updated )
+      return;
+   _tokens = std::min( _burst, _tokens + _rate * ( now - _updated ).count() / 1000000.0 );
+   _updated = now;
+}
+
+bool token_bucket::can_spend( fc::time_point now )
+{
+   if( !is_limited() )
+      return true;
+   refill( now );
+   return _tokens > 0;
+}
+
+void token_bucket::spend( double cost, fc::time_point now )
+{
+   if( !is_limited() )
+      return;
+   refill( now );
+   // may go negative, the debt of an expensive call delays the next calls
+   _tokens = std::max( _tokens - cost, -_burst );
+}
+
+double token_bucket::balance( fc::time_point now )const
+{
+   const double elapsed = now > _updated ? ( now - _updated ).count() / 1000000.0 : 0;
+   return std::min( _burst, _tokens + _rate * elapsed );
+}
+
+double token_bucket::available( fc::time_point now )const
+{
+   if( !is_limited() )
+      return 0;
+   return std::max( balance( now ), 0.0 );
+}
+
+void token_bucket::continue_from( const token_bucket& previous, fc::time_point now )
+{
+   if( !is_limited() || !previous.is_limited() )
+      return;
+   refill( now );
+   _tokens = std::max( std::min( _tokens, previous.balance( now ) ), -_burst );
+}
+
+struct api_session_costs::user_costs
+{
+   user_costs( const std::string& n, const api_throttle_config& config )
+      : name( n ), bucket( config.user_rate, config.user_burst ) {}
+
+   const std::string name;
+   std::mutex        mutex;
+   token_bucket      bucket;
+   uint64_t          calls     = 0;
+   uint64_t          throttled = 0;
+   double            cost      = 0;
+};
+
+api_session_costs::api_session_costs( std::shared_ptr<api_cost_registry> registry, uint64_t id )
+   : _registry( registry ), _id( id ), _bucket( 0, 0 )
+{}
+
+api_session_costs::~api_session_costs()
+{
+   _registry->remove_session( _id );
+}
+
+void api_session_costs::set_user( const std::string& user, const fc::optional<api_throttle_config>& config )
+{
+   const api_throttle_config effective = config.valid() ? *config : api_throttle_config();
+   auto costs = _registry->get_user( user, config );
+   std::lock_guard<std::mutex> guard( _mutex );
+   if( _user_costs == costs )
+      return;
+   // a connection could otherwise refill its budget by logging in again
+   token_bucket bucket( effective.connection_rate, effective.connection_burst );
+   bucket.continue_from( _bucket, fc::time_point::now() );
+   _user = user;
+   _config = effective;
+   _bucket = bucket;
+   _user_costs = costs;
+}
+
+bool api_session_costs::is_limited()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   if( _bucket.is_limited() )
+      return true;
+   if( !_user_costs )
+      return false;
+   std::lock_guard<std::mutex> user_guard( _user_costs->mutex );
+   return _user_costs->bucket.is_limited();
+}
+
+bool api_session_costs::admit( const std::string& method )
+{
+   const fc::time_point now = fc::time_point::now();
+   std::lock_guard<std::mutex> guard( _mutex );
+   const auto itr = _config.method_costs.find( method );
+   const double cost = itr != _config.method_costs.end() ? itr->second : _config.default_method_cost;
+
+   bool admitted = _bucket.can_spend( now );
+   if( _user_costs )
+   {
+      std::lock_guard<std::mutex> user_guard( _user_costs->mutex );
+      admitted = admitted && _user_costs->bucket.can_spend( now );
+      ++( admitted ? _user_costs->calls : _user_costs->throttled );
+   }
+   if( !admitted )
+   {
+      ++_throttled;
+      return false;
+   }
+   ++_calls;
+   spend( cost, now );
+   return true;
+}
+
+void api_session_costs::charge( uint64_t latency_ns, uint64_t response_bytes )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   spend( _config.cost_per_ms * latency_ns / 1000000.0 + _config.cost_per_kib * response_bytes / 1024.0,
+          fc::time_point::now() );
+}
+
+void api_session_costs::spend( double cost, fc::time_point now )
+{
+   _cost += cost;
+   _bucket.spend( cost, now );
+   if( _user_costs )
+   {
+      std::lock_guard<std::mutex> user_guard( _user_costs->mutex );
+      _user_costs->cost += cost;
+      _user_costs->bucket.spend( cost, now );
+   }
+}
+
+api_cost_info api_session_costs::get_info()const
+{
+   api_cost_info info;
+   std::lock_guard<std::mutex> guard( _mutex );
+   info.session_id = _id;
+   info.user = _user;
+   info.calls = _calls;
+   info.throttled = _throttled;
+   info.cost = _cost;
+   info.limited = _bucket.is_limited();
+   info.available = _bucket.available( fc::time_point::now() );
+   return info;
+}
+
+std::shared_ptr<api_session_costs> api_cost_registry::new_session()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   const uint64_t id = _next_id++;
+   auto session = std::make_shared<api_session_costs>( shared_from_this(), id );
+   _sessions[id] = session;
+   return session;
+}
+
+std::shared_ptr<api_session_costs::user_costs> api_cost_registry::get_user(
+      const std::string& user, const fc::optional<api_throttle_config>& config )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto& costs = _users[user];
+   if( !costs )
+      costs = std::make_shared<api_session_costs::user_costs>( user, config.valid() ? *config
+                                                                                    : api_throttle_config() );
+   return costs;
+}
+
+void api_cost_registry::remove_session( uint64_t id )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _sessions.erase( id );
+}
+
+std::vector<api_cost_info> api_cost_registry::get_costs()const
+{
+   std::vector< std::shared_ptr<api_session_costs> > sessions;
+   std::vector< std::shared_ptr<api_session_costs::user_costs> > users;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      sessions.reserve( _sessions.size() );
+      for( const auto& item : _sessions )
+         if( auto session = item.second.lock() )
+            sessions.push_back( session );
+      for( const auto& item : _users )
+         users.push_back( item.second );
+   }
+   // the sessions may be destroyed when released, which needs _mutex, so collect the costs unlocked
+
+   std::vector<api_cost_info> result;
+   result.reserve( sessions.size() + users.size() );
+   for( const auto& session : sessions )
+      result.push_back( session->get_info() );
+   const fc::time_point now = fc::time_point::now();
+   for( const auto& user : users )
+   {
+      std::lock_guard<std::mutex> guard( user->mutex );
+      api_cost_info info;
+      info.user = user->name;
+      info.calls = user->calls;
+      info.throttled = user->throttled;
+      info.cost = user->cost;
+      info.limited = user->bucket.is_limited();
+      info.available = user->bucket.available( now );
+      result.push_back( info );
+   }
+   return result;
+}
+
+std::string api_cost_registry::to_prometheus()const
+{
+   const std::vector<api_cost_info> costs = get_costs();
+   auto labels = []( const api_cost_info& info ) {
+      std::string result = "user=\"" + prometheus_escape_label( info.user ) + "\"";
+      if( info.session_id != 0 )
+         result += ",session=\"" + std::to_string( info.session_id ) + "\"";
+      return result;
+   };
+
+   std::ostringstream out;
+   write_prometheus_header( out, "graphene_api_session_cost_total", "counter",
+                            "Cost of the API calls of a connection." );
+   for( const auto& info : costs )
+      if( info.session_id != 0 )
+         out << "graphene_api_session_cost_total{" << labels( info ) << "} " << info.cost << '\n';
+   write_prometheus_header( out, "graphene_api_session_throttled_calls_total", "counter",
+                            "API calls of a connection rejected by throttling." );
+   for( const auto& info : costs )
+      if( info.session_id != 0 )
+         out << "graphene_api_session_throttled_calls_total{" << labels( info ) << "} " << info.throttled << '\n';
+   write_prometheus_header( out, "graphene_api_user_cost_total", "counter",
+                            "Cost of the API calls of all connections of a user." );
+   for( const auto& info : costs )
+      if( info.session_id == 0 )
+         out << "graphene_api_user_cost_total{" << labels( info ) << "} " << info.cost << '\n';
+   write_prometheus_header( out, "graphene_api_user_throttled_calls_total", "counter",
+                            "API calls of all connections of a user rejected by throttling." );
+   for( const auto& info : costs )
+      if( info.session_id == 0 )
+         out << "graphene_api_user_throttled_calls_total{" << labels( info ) << "} " << info.throttled << '\n';
+   return out.str();
+}
+
+} } // graphene::app
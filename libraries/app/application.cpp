@@ -24,6 +24,7 @@
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
 #include <graphene/app/application.hpp>
+#include <graphene/app/batch_api_connection.hpp>
 #include <graphene/app/plugin.hpp>
 
 #include <graphene/chain/db_with.hpp>
@@ -246,12 +247,14 @@ std::vector<fc::ip::endpoint> application_impl::resolve_string_to_ip_endpoints(c
 
 void application_impl::new_connection( const fc::http::websocket_connection_ptr& c )
 {
-   auto wsc = std::make_shared<fc::rpc::websocket_api_connection>(*c, GRAPHENE_NET_MAX_NESTED_OBJECTS);
+   auto costs = _api_costs->new_session();
+   auto wsc = std::make_shared<batch_api_connection>(*c, GRAPHENE_NET_MAX_NESTED_OBJECTS, _api_metrics, costs);
    auto login = std::make_shared<graphene::app::login_api>( std::ref(*_self) );
+   login->set_session_costs( costs );
    login->enable_api("database_api");
 
-   wsc->register_api(login->database());
-   wsc->register_api(fc::api<graphene::app::login_api>(login));
+   wsc->set_api_name( wsc->register_api(login->database()), "database" );
+   wsc->set_api_name( wsc->register_api(fc::api<graphene::app::login_api>(login)), "login" );
    c->set_session_data( wsc );
 
    std::string username = "*";
@@ -308,6 +311,31 @@ void application_impl::reset_websocket_tls_server()
    _websocket_tls_server->start_accept();
 } FC_CAPTURE_AND_RETHROW() }
 
+void application_impl::reset_metrics_server()
+{ try {
+   if( !_options->count("api-metrics-endpoint") )
+      return;
+
+   _api_metrics = std::make_shared<api_metrics>();
+   _metrics_server = std::make_shared<fc::http::server>();
+   ilog("Configured API metrics to be served on ${ip}", ("ip",_options->at("api-metrics-endpoint").as<string>()));
+   _metrics_server->listen( fc::ip::endpoint::from_string(_options->at("api-metrics-endpoint").as<string>()) );
+   // due to implementation, on_request() must come AFTER listen()
+   _metrics_server->on_request( [this]( const fc::http::request& req, const fc::http::server::response& resp ) {
+      if( req.path != "/metrics" )
+      {
+         resp.set_status( fc::http::reply::NotFound );
+         resp.set_length( 0 );
+         return;
+      }
+      const std::string body = _api_metrics->to_prometheus( *_chain_db ) + _api_costs->to_prometheus();
+      resp.add_header( "Content-Type", "text/plain; version=0.0.4" );
+      resp.set_status( fc::http::reply::OK );
+      resp.set_length( body.size() );
+      resp.write( body.c_str(), body.size() );
+   });
+} FC_CAPTURE_AND_RETHROW() }
+
 void application_impl::set_dbg_init_key( graphene::chain::genesis_state_type& genesis, const std::string& init_key )
 {
    flat_set< std::string > initial_witness_names;
@@ -393,6 +421,34 @@ void application_impl::startup()
       _chain_db->enable_standby_votes_tracking( _options->at("enable-standby-votes-tracking").as<bool>() );
    }
 
+   if( _options->count("vote-tally-threads") )
+      _chain_db->set_vote_tally_threads( _options->at("vote-tally-threads").as<uint32_t>() );
+   if( _options->count("verify-vote-tally") )
+      _chain_db->enable_vote_tally_verification( _options->at("verify-vote-tally").as<bool>() );
+
+   if( _options->count("enable-execution-profiling") )
+      _chain_db->get_execution_profiler().enable( _options->at("enable-execution-profiling").as<bool>() );
+   if( _options->count("execution-profiling-log-interval") )
+      _chain_db->get_execution_profiler().set_log_interval(
+            _options->at("execution-profiling-log-interval").as<uint32_t>() );
+   if( _options->count("block-phase-trace-size") )
+      _chain_db->get_block_phase_tracer().set_capacity( _options->at("block-phase-trace-size").as<uint32_t>() );
+   if( _options->count("block-phase-trace-file") )
+   {
+      if( !_chain_db->get_block_phase_tracer().is_enabled() )
+         _chain_db->get_block_phase_tracer().set_capacity( 1 );
+      _chain_db->get_block_phase_tracer().set_trace_file(
+            _options->at("block-phase-trace-file").as<boost::filesystem::path>() );
+   }
+   if( _options->count("api-object-cache-size") )
+      serialized_object_cache::get( *_chain_db )->set_capacity( _options->at("api-object-cache-size").as<uint32_t>() );
+   _subscriptions = subscription_registry::get( *_chain_db );
+   if( _options->count("api-max-subscribed-objects") )
+      _subscriptions->set_max_objects_per_subscriber( _options->at("api-max-subscribed-objects").as<uint32_t>() );
+   _api_executor = api_executor::get( *_chain_db );
+   if( _options->count("api-threads") )
+      _api_executor->set_thread_count( _options->at("api-threads").as<uint16_t>() );
+
    if( _options->count("replay-blockchain") || _options->count("revalidate-blockchain") )
       _chain_db->wipe( _data_dir / "blockchain", false );
 
@@ -467,6 +523,7 @@ void application_impl::startup()
    }
 
    reset_p2p_node(_data_dir);
+   reset_metrics_server();
    reset_websocket_server();
    reset_websocket_tls_server();
 } FC_LOG_AND_RETHROW() }
@@ -968,13 +1025,41 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("server-pem-password,P", bpo::value<string>()->implicit_value(""), "Password for this certificate")
          ("genesis-json", bpo::value<boost::filesystem::path>(), "File to read Genesis State from")
          ("dbg-init-key", bpo::value<string>(), "Block signing key to use for init witnesses, overrides genesis file")
-         ("api-access", bpo::value<boost::filesystem::path>(), "JSON file specifying API permissions")
+         ("api-access", bpo::value<boost::filesystem::path>(), "JSON file specifying API permissions and throttling")
          ("io-threads", bpo::value<uint16_t>()->implicit_value(0), "Number of IO threads, default to 0 for auto-configuration")
          ("enable-subscribe-to-all", bpo::value<bool>()->implicit_value(true),
           "Whether allow API clients to subscribe to universal object creation and removal events")
          ("enable-standby-votes-tracking", bpo::value<bool>()->implicit_value(true),
           "Whether to enable tracking of votes of standby witnesses and committee members. "
           "Set it to true to provide accurate data to API clients, set to false for slightly better performance.")
+         ("vote-tally-threads", bpo::value<uint32_t>(),
+          "Number of threads to recount votes with during chain maintenance, 1 to count serially, "
+          "0 to use the size of the thread pool (default)")
+         ("verify-vote-tally", bpo::value<bool>()->implicit_value(true),
+          "Whether to check incrementally maintained vote totals against a full serial recount at every "
+          "maintenance interval, for testing purposes")
+         ("enable-execution-profiling", bpo::value<bool>()->implicit_value(true),
+          "Whether to collect execution time statistics per operation type and per transaction check, "
+          "also during replay. Results are available through metrics_api.")
+         ("execution-profiling-log-interval", bpo::value<uint32_t>(),
+          "Log a summary of the execution profile every this many blocks, 0 to disable (default)")
+         ("block-phase-trace-size", bpo::value<uint32_t>(),
+          "Number of recently applied blocks to keep a per-phase timing trace of, 0 to disable (default). "
+          "Traces are available through metrics_api.")
+         ("block-phase-trace-file", bpo::value<boost::filesystem::path>(),
+          "File to append per-phase timing traces of all applied blocks to, in Chrome trace event format")
+         ("api-object-cache-size", bpo::value<uint32_t>(),
+          "Number of objects to keep the API representation of until they change, 0 to disable, "
+          "10000 by default. Hit rates are available through metrics_api.")
+         ("api-max-subscribed-objects", bpo::value<uint32_t>(),
+          "Number of objects an API session can be subscribed to, 10000 by default. Objects returned after that "
+          "are not subscribed to.")
+         ("api-threads", bpo::value<uint16_t>(),
+          "Number of threads to execute read-only database API calls on, 0 to execute them on the thread applying "
+          "blocks (default). Queue wait and execution times are available through metrics_api.")
+         ("api-metrics-endpoint", bpo::value<string>()->implicit_value("127.0.0.1:8095"),
+          "Endpoint to serve per-method API call, error, latency and response size metrics and chain metrics on, "
+          "at /metrics in the Prometheus text format. Not collected if unset.")
          ;
    command_line_options.add(configuration_file_options);
    command_line_options.add_options()
@@ -1039,6 +1124,11 @@ optional< api_access_info > application::get_api_access_info( const string& user
    return my->get_api_access_info( username );
 }
 
+bool application::has_own_api_access_info( const string& username )const
+{
+   return my->_apiaccess.permission_map.find( username ) != my->_apiaccess.permission_map.end();
+}
+
 void application::set_api_access_info(const string& username, api_access_info&& permissions)
 {
    my->set_api_access_info(username, std::move(permissions));
@@ -1100,5 +1190,15 @@ const application_options& application::get_options()
    return my->_app_options;
 }
 
+std::shared_ptr<api_metrics> application::get_api_metrics()const
+{
+   return my->_api_metrics;
+}
+
+std::shared_ptr<api_cost_registry> application::get_api_cost_registry()const
+{
+   return my->_api_costs;
+}
+
 // namespace detail
 } }
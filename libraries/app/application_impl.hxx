@@ -1,10 +1,15 @@
 #pragma once
 
+#include <fc/network/http/server.hpp>
 #include <fc/network/http/websocket.hpp>
 #include <fc/thread/parallel.hpp>
 
 #include <graphene/app/application.hpp>
 #include <graphene/app/api_access.hpp>
+#include <graphene/app/api_executor.hpp>
+#include <graphene/app/api_metrics.hpp>
+#include <graphene/app/api_throttle.hpp>
+#include <graphene/app/subscription_registry.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/net/message.hpp>
@@ -30,6 +35,8 @@ class application_impl : public net::node_delegate
 
       void reset_websocket_tls_server();
 
+      void reset_metrics_server();
+
       explicit application_impl(application* self)
          : _self(self),
            _chain_db(std::make_shared<chain::database>())
@@ -191,6 +198,13 @@ class application_impl : public net::node_delegate
       std::shared_ptr<graphene::net::node>                  _p2p_network;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
+      /// Keeps the API threads alive while no session is open
+      std::shared_ptr<api_executor>                    _api_executor;
+      /// Keeps the configured subscription limits while no session is open
+      std::shared_ptr<subscription_registry>           _subscriptions;
+      std::shared_ptr<api_metrics>                     _api_metrics;
+      std::shared_ptr<fc::http::server>                _metrics_server;
+      std::shared_ptr<api_cost_registry>               _api_costs = std::make_shared<api_cost_registry>();
 
       std::map<string, std::shared_ptr<abstract_plugin>> _active_plugins;
       std::map<string, std::shared_ptr<abstract_plugin>> _available_plugins;
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/batch_api_connection.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/variant_object.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+namespace graphene { namespace app {
+
+namespace {
+
+   /// Error codes of the JSON-RPC 2.0 specification
+   const int64_t parse_error     = -32700;
+   const int64_t invalid_request = -32600;
+   /// Implementation defined server error code for throttled calls
+   const int64_t limit_exceeded  = -32005;
+
+   std::string error_response( const fc::variant& id, int64_t code, const std::string& message, uint32_t max_depth )
+   {
+      fc::mutable_variant_object error;
+      error( "code", code )( "message", message );
+      fc::mutable_variant_object response;
+      response( "id", id )( "jsonrpc", "2.0" )( "error", error );
+      return fc::json::to_string( response, fc::json::stringify_large_ints_and_doubles, max_depth );
+   }
+
+   fc::variant request_id( const fc::variant& request )
+   {
+      const fc::variant_object& obj = request.get_object();
+      return obj.contains( "id" ) ? obj["id"] : fc::variant();
+   }
+
+
+   bool is_batch( const std::string& message )
+   {
+      auto first = std::find_if( message.begin(), message.end(), []( unsigned char c ) { return !std::isspace( c ); } );
+      return first != message.end() && *first == '[';
+   }
+
+} // anonymous namespace
+
+batch_api_connection::batch_api_connection( fc::http::websocket_connection& c, uint32_t max_conversion_depth,
+                                            std::shared_ptr<api_metrics> metrics,
+                                            std::shared_ptr<api_session_costs> costs )
+   : fc::rpc::websocket_api_connection( c, max_conversion_depth ), _max_depth( max_conversion_depth ),
+     _metrics( std::move( metrics ) ), _costs( std::move( costs ) )
+{
+   // replaces the handlers installed by websocket_api_connection
+   _connection.on_message_handler( [this]( const std::string& msg ) { handle_message( msg, true ); } );
+   _connection.on_http_handler( [this]( const std::string& msg ) { return handle_message( msg, false ); } );
+}
+
+void batch_api_connection::set_api_name( uint64_t api_id, const std::string& name )
+{
+   _api_names[ api_id ] = name;
+}
+
+std::string batch_api_connection::handle_message( const std::string& message, bool send_message )
+{
+   if( !is_batch( message ) )
+   {
+      if( !is_accounted() )
+         return on_message( message, send_message );
+      fc::variant request;
+      try
+      {
+         request = fc::json::from_string( message, fc::json::legacy_parser, _max_depth );
+      }
+      catch( const fc::exception& )
+      {
+         return on_message( message, send_message );
+      }
+      return dispatch( request, message, send_message );
+   }
+   const std::string reply = handle_batch( message );
+   if( send_message && !reply.empty() )
+      _connection.send_message( reply );
+   return reply;
+}
+
+std::string batch_api_connection::handle_batch( const std::string& message )
+{
+   fc::variants requests;
+   try
+   {
+      requests = fc::json::from_string( message, fc::json::legacy_parser, _max_depth ).get_array();
+   }
+   catch( const fc::exception& e )
+   {
+      return error_response( fc::variant(), parse_error, e.to_string(), _max_depth );
+   }
+   if( requests.empty() )
+      return error_response( fc::variant(), invalid_request, "Empty batch", _max_depth );
+   if( requests.size() > max_batch_size )
+      return error_response( fc::variant(), invalid_request,
+                             "A batch may contain at most " + std::to_string( max_batch_size ) + " requests",
+                             _max_depth );
+
+   // each call which waits for an API thread lets the next one start
+   std::vector< fc::future<std::string> > calls;
+   calls.reserve( requests.size() );
+   for( const fc::variant& request : requests )
+      calls.push_back( fc::async( [this,&request]() { return handle_request( request ); }, "batch api call" ) );
+
+   std::string reply = "[";
+   for( auto& call : calls )
+   {
+      const std::string& response = call.wait();
+      if( response.empty() )
+         continue;
+      if( reply.size() > 1 )
+         reply += ',';
+      reply += response;
+   }
+   // nothing is returned if the batch only consists of notifications
+   if( reply.size() == 1 )
+      return std::string();
+   reply += ']';
+   return reply;
+}
+
+std::string batch_api_connection::handle_request( const fc::variant& request )
+{
+   if( !request.is_object() )
+      return error_response( fc::variant(), invalid_request, "A request must be an object", _max_depth );
+   // fc takes a request without a method for a response to a call of the server, and only accepts integer ids
+   const fc::variant_object& obj = request.get_object();
+   if( !obj.contains( "method" ) || !obj["method"].is_string() )
+      return error_response( fc::variant(), invalid_request, "A request must have a method", _max_depth );
+   const fc::variant id = request_id( request );
+   if( !id.is_null() && !id.is_int64() && !id.is_uint64() )
+      return error_response( fc::variant(), invalid_request, "The id of a request must be an integer", _max_depth );
+   try
+   {
+      const std::string response = dispatch( request, std::string(), false );
+      // on_message answers a request it could not convert with the plain text of the exception, which is not
+      // valid in a batch, while responses are always serialized starting with the opening brace of an object
+      if( !response.empty() && response[0] != '{' )
+         return error_response( id, invalid_request, response, _max_depth );
+      return response;
+   }
+   catch( const fc::exception& e )
+   {
+      return error_response( id, invalid_request, e.to_string(), _max_depth );
+   }
+   catch( const std::exception& e )
+   {
+      return error_response( id, invalid_request, e.what(), _max_depth );
+   }
+}
+
+std::string batch_api_connection::dispatch( const fc::variant& request, const std::string& message,
+                                            bool send_message )
+{
+   // on_message also handles what is no call, e.g. a response to a callback, and answers malformed calls
+   auto legacy = [&]() {
+      return on_message( message.empty() ? fc::json::to_string( request, fc::json::stringify_large_ints_and_doubles,
+                                                                _max_depth )
+                                         : message,
+                         send_message );
+   };
+   if( !is_accounted() || !request.is_object() || !request.get_object().contains( "method" ) )
+      return legacy();
+   fc::rpc::request call;
+   try
+   {
+      call = request.as<fc::rpc::request>( _max_depth );
+   }
+   catch( const fc::exception& )
+   {
+      return legacy();
+   }
+
+   // methods other than call are executed on the first API
+   std::string api = api_name( fc::variant( 0 ) );
+   std::string method = call.method;
+   if( method == "call" && call.params.size() >= 2 && call.params[1].is_string() )
+   {
+      api = api_name( call.params[0] );
+      method = call.params[1].get_string();
+   }
+
+   const clock::time_point start = clock::now();
+   auto elapsed_ns = [&start]() -> uint64_t {
+      return std::chrono::duration_cast< std::chrono::nanoseconds >( clock::now() - start ).count();
+   };
+   if( _costs && !_costs->admit( method ) )
+   {
+      // like on_message, nothing is answered to a notification
+      std::string response = !call.id ? std::string()
+                           : error_response( fc::variant( *call.id ), limit_exceeded, "API call rate limit exceeded",
+                                             _max_depth );
+      if( send_message && !response.empty() )
+         _connection.send_message( response );
+      if( _metrics )
+         _metrics->record( api, method, elapsed_ns(), response.size(), true );
+      return response;
+   }
+
+   fc::variant result;
+   bool error = false;
+   std::string response;
+   try
+   {
+      response = execute( call, send_message, result, error );
+   }
+   catch( ... )
+   {
+      if( _costs )
+         _costs->charge( elapsed_ns(), 0 );
+      if( _metrics )
+         _metrics->record( api, method, elapsed_ns(), 0, true );
+      throw;
+   }
+   const uint64_t latency_ns = elapsed_ns();
+   if( _costs )
+      _costs->charge( latency_ns, response.size() );
+   if( _metrics )
+      _metrics->record( api, method, latency_ns, response.size(), error );
+
+   // the login API returns the ids under which it registered the other APIs
+   if( api == "login" && method != "login" && !error && result.is_numeric() )
+      set_api_name( result.as_uint64(), method );
+   return response;
+}
+
+std::string batch_api_connection::execute( const fc::rpc::request& call, bool send_message, fc::variant& result,
+                                           bool& error )
+{
+   // answers like on_message, but the outcome is known without reading the response again
+   std::string reply;
+   try
+   {
+      try
+      {
+         result = _rpc_state.local_call( call.method, call.params );
+      }
+      FC_CAPTURE_AND_RETHROW( (call.method)(call.params) )
+      if( !call.id )
+         return reply;
+      reply = fc::json::to_string( fc::variant( fc::rpc::response( *call.id, result, "2.0" ), _max_depth ),
+                                   fc::json::stringify_large_ints_and_doubles, _max_depth );
+   }
+   catch( const fc::exception& e )
+   {
+      error = true;
+      if( !call.id )
+         return reply;
+      const fc::rpc::error_object failure{ 1, e.to_detail_string(), fc::variant( e, _max_depth ) };
+      reply = fc::json::to_string( fc::variant( fc::rpc::response( *call.id, failure, "2.0" ), _max_depth ),
+                                   fc::json::stringify_large_ints_and_doubles, _max_depth );
+   }
+   if( send_message )
+      _connection.send_message( reply );
+   return reply;
+}
+
+std::string batch_api_connection::api_name( const fc::variant& api )const
+{
+   if( api.is_string() )
+      return api.get_string();
+   if( !api.is_numeric() )
+      return "unknown";
+   const uint64_t id = api.as_uint64();
+   auto itr = _api_names.find( id );
+   return itr != _api_names.end() ? itr->second : std::to_string( id );
+}
+
+bool batch_api_connection::is_accounted()const
+{
+   return _metrics || ( _costs && _costs->is_limited() );
+}
+
+} } // graphene::app
@@ -23,12 +23,14 @@
  */
 
 #include <graphene/app/database_api.hpp>
+#include <graphene/app/api_executor.hpp>
+#include <graphene/app/order_book_feed.hpp>
+#include <graphene/app/serialized_object_cache.hpp>
+#include <graphene/app/subscription_registry.hpp>
 #include <graphene/app/util.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/chain/hardfork.hpp>
 
-#include <fc/bloom_filter.hpp>
-
 #include <fc/crypto/hex.hpp>
 #include <fc/uint128.hpp>
 
@@ -38,21 +40,38 @@
 
 #include <cctype>
 
+#include <atomic>
 #include <cfenv>
 #include <iostream>
+#include <mutex>
 
 #define GET_REQUIRED_FEES_MAX_RECURSION 4
 
-typedef std::map< std::pair<graphene::chain::asset_id_type, graphene::chain::asset_id_type>, std::vector<fc::variant> > market_queue_type;
-
 namespace graphene { namespace app {
 
-class database_api_impl : public std::enable_shared_from_this<database_api_impl>
+class database_api_impl : public std::enable_shared_from_this<database_api_impl>,
+                          public subscription_registry::subscriber,
+                          public order_book_feed::subscriber
 {
    public:
       explicit database_api_impl( graphene::chain::database& db, const application_options* app_options );
       ~database_api_impl();
 
+      /**
+       * Executes the read-only call @p f, see @ref api_executor
+       *
+       * The calls of a session, e.g. those of a JSON-RPC batch, may execute concurrently on different threads,
+       * while the session's subscription setters run on the calling thread. Read-only calls therefore only use
+       * session state which is thread safe: @ref _subscribed, @ref _subscribed_accounts under its mutex, and the
+       * subscription registry, object cache and order book feed, which lock themselves. Anything else they
+       * need must be guarded the same way.
+       */
+      template<typename Function>
+      auto run( const char* method, Function&& f ) -> decltype( f() )
+      {
+         return _executor->run( method, std::forward<Function>( f ) );
+      }
+
 
       // Objects
       fc::variants get_objects(const vector<object_id_type>& ids)const;
@@ -61,6 +80,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       void set_subscribe_callback( std::function<void(const variant&)> cb, bool notify_remove_create );
       void set_pending_transaction_callback( std::function<void(const variant&)> cb );
       void set_block_applied_callback( std::function<void(const variant& block_id)> cb );
+      void set_notification_encoding( api_encoding encoding );
       void cancel_all_subscriptions(bool reset_callback, bool reset_market_subscriptions);
 
       // Blocks and transactions
@@ -118,6 +138,9 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 
       void subscribe_to_market(std::function<void(const variant&)> callback, const std::string& a, const std::string& b);
       void unsubscribe_from_market(const std::string& a, const std::string& b);
+      void subscribe_to_order_book_deltas( std::function<void(const variant&)> callback, const std::string& a, const std::string& b );
+      void unsubscribe_from_order_book_deltas( const std::string& a, const std::string& b );
+      order_book_snapshot get_order_book_snapshot( const std::string& a, const std::string& b )const;
 
       market_ticker                      get_ticker( const string& base, const string& quote, bool skip_order_book = false )const;
       market_volume                      get_24_volume( const string& base, const string& quote )const;
@@ -171,43 +194,14 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
    //private:
       static string price_to_string( const price& _price, const asset_object& _base, const asset_object& _quote );
 
+      /// Only object ids are matched against the changed objects, other items are not tracked
       template<typename T>
-      void subscribe_to_item( const T& i )const
-      {
-         auto vec = fc::raw::pack(i);
-         if( !_subscribe_callback )
-            return;
-
-         if( !is_subscribed_to_item(i) )
-            _subscribe_filter.insert( vec.data(), vec.size() );
-      }
+      void subscribe_to_item( const T& )const {}
 
-      template<typename T>
-      bool is_subscribed_to_item( const T& i )const
+      void subscribe_to_item( const object_id_type& id )const
       {
-         if( !_subscribe_callback )
-            return false;
-
-         return _subscribe_filter.contains( i );
-      }
-
-      bool is_impacted_account( const flat_set<account_id_type>& accounts)
-      {
-         if( !_subscribed_accounts.size() || !accounts.size() )
-            return false;
-
-         return std::any_of(accounts.begin(), accounts.end(), [this](const account_id_type& account) {
-            return _subscribed_accounts.find(account) != _subscribed_accounts.end();
-         });
-      }
-
-      const std::pair<asset_id_type,asset_id_type> get_order_market( const force_settlement_object& order )
-      {
-         // TODO cache the result to avoid repeatly fetching from db
-         asset_id_type backing_id = order.balance.asset_id( _db ).bitasset_data( _db ).options.short_backing_asset;
-         auto tmp = std::make_pair( order.balance.asset_id, backing_id );
-         if( tmp.first > tmp.second ) std::swap( tmp.first, tmp.second );
-         return tmp;
+         if( _subscribed )
+            _subscriptions->subscribe_to_object( this, id );
       }
 
       const account_object* get_account_from_string( const std::string& name_or_id ) const
@@ -263,79 +257,59 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       {
          FC_ASSERT( limit <= 300 );
 
-         const auto& limit_order_idx = _db.get_index_type<limit_order_index>();
-         const auto& limit_price_idx = limit_order_idx.indices().get<by_price>();
+         const auto& book = _db.get_limit_order_book();
 
          vector<limit_order_object> result;
          result.reserve(limit*2);
 
-         uint32_t count = 0;
-         auto limit_itr = limit_price_idx.lower_bound(price::max(a,b));
-         auto limit_end = limit_price_idx.upper_bound(price::min(a,b));
-         while(limit_itr != limit_end && count < limit)
-         {
-            result.push_back(*limit_itr);
-            ++limit_itr;
-            ++count;
-         }
-         count = 0;
-         limit_itr = limit_price_idx.lower_bound(price::max(b,a));
-         limit_end = limit_price_idx.upper_bound(price::min(b,a));
-         while(limit_itr != limit_end && count < limit)
-         {
-            result.push_back(*limit_itr);
-            ++limit_itr;
-            ++count;
-         }
+         auto add_orders = [&book,&result,limit]( asset_id_type sell_asset, asset_id_type receive_asset ) {
+            uint32_t count = 0;
+            book.visit_orders( sell_asset, receive_asset, [&result,&count,limit]( const limit_order_object& order ) -> bool {
+               if( count >= limit )
+                  return false;
+               result.push_back( order );
+               ++count;
+               return true;
+            });
+         };
+         add_orders( a, b );
+         add_orders( b, a );
 
          return result;
       }
 
-      template<typename T>
-      const std::pair<asset_id_type,asset_id_type> get_order_market( const T& order )
-      {
-         return order.get_market();
-      }
-
-      template<typename T>
-      void enqueue_if_subscribed_to_market(const object* obj, market_queue_type& queue, bool full_object=true)
-      {
-         const T* order = dynamic_cast<const T*>(obj);
-         FC_ASSERT( order != nullptr);
-
-         const auto& market = get_order_market( *order );
-
-         auto sub = _market_subscriptions.find( market );
-         if( sub != _market_subscriptions.end() ) {
-            queue[market].emplace_back( full_object ? obj->to_variant() : fc::variant(obj->id, 1) );
-         }
-      }
-
       void broadcast_updates( const vector<variant>& updates );
       void broadcast_market_updates( const market_queue_type& queue);
-      void handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts, std::function<const object*(object_id_type id)> find_object);
 
-      /** called every time a block is applied to report the objects that were changed */
-      void on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_removed(const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts);
+      /** called every time a block is applied with the changed objects matching the subscriptions */
+      void on_object_updates( const vector<variant>& updates ) override;
+      void on_market_updates( const market_queue_type& queue ) override;
+      void on_order_book_delta( const market_type& market, const variant& delta ) override;
+      bool wants_packed_updates()const override { return _packed_notifications; }
       void on_applied_block();
 
-      bool _notify_remove_create = false;
-      mutable fc::bloom_filter _subscribe_filter;
+      /// Read-only calls may run on another thread than the one changing the subscriptions, and concurrently
+      ///@{
+      std::atomic<bool> _subscribed{ false };
+      std::mutex _subscribed_accounts_mutex;
       std::set<account_id_type> _subscribed_accounts;
+      ///@}
+      /// Read by the subscription registry while it notifies the sessions
+      std::atomic<bool> _packed_notifications{ false };
       std::function<void(const fc::variant&)> _subscribe_callback;
       std::function<void(const fc::variant&)> _pending_trx_callback;
       std::function<void(const fc::variant&)> _block_applied_callback;
 
-      boost::signals2::scoped_connection                                                                                           _new_connection;
-      boost::signals2::scoped_connection                                                                                           _change_connection;
-      boost::signals2::scoped_connection                                                                                           _removed_connection;
       boost::signals2::scoped_connection                                                                                           _applied_block_connection;
       boost::signals2::scoped_connection                                                                                           _pending_trx_connection;
       map< pair<asset_id_type,asset_id_type>, std::function<void(const variant&)> >      _market_subscriptions;
+      map< market_type, std::function<void(const variant&)> >                            _order_book_subscriptions;
       graphene::chain::database&                                                                                                            _db;
       const application_options* _app_options = nullptr;
+      std::shared_ptr<subscription_registry> _subscriptions;
+      std::shared_ptr<serialized_object_cache> _object_cache;
+      std::shared_ptr<order_book_feed> _order_book_feed;
+      std::shared_ptr<api_executor> _executor;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -350,28 +324,28 @@ database_api::database_api( graphene::chain::database& db, const application_opt
 database_api::~database_api() {}
 
 database_api_impl::database_api_impl( graphene::chain::database& db, const application_options* app_options )
-:_db(db), _app_options(app_options)
+:_db(db), _app_options(app_options), _subscriptions( subscription_registry::get( db ) ),
+ _object_cache( serialized_object_cache::get( db ) ), _order_book_feed( order_book_feed::get( db ) ),
+ _executor( api_executor::get( db ) )
 {
    wlog("creating database api ${x}", ("x",int64_t(this)) );
-   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_new(ids, impacted_accounts);
-                                });
-   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_changed(ids, impacted_accounts);
-                                });
-   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_removed(ids, objs, impacted_accounts);
-                                });
    _applied_block_connection = _db.applied_block.connect([this](const signed_block&){ on_applied_block(); });
 
    _pending_trx_connection = _db.on_pending_transaction.connect([this](const signed_transaction& trx ){
-                         if( _pending_trx_callback ) _pending_trx_callback( fc::variant(trx, GRAPHENE_MAX_NESTED_OBJECTS) );
+                         if( !_pending_trx_callback )
+                            return;
+                         if( _packed_notifications )
+                            _pending_trx_callback( fc::variant( pack_data( trx ), 1 ) );
+                         else
+                            _pending_trx_callback( fc::variant( trx, GRAPHENE_MAX_NESTED_OBJECTS ) );
                       });
 }
 
 database_api_impl::~database_api_impl()
 {
    elog("freeing database api ${x}", ("x",int64_t(this)) );
+   _subscriptions->remove( this );
+   _order_book_feed->remove( this );
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -447,12 +421,12 @@ market_ticker::market_ticker(const fc::time_point_sec& now,
 
 fc::variants database_api::get_objects(const vector<object_id_type>& ids)const
 {
-   return my->get_objects( ids );
+   return my->run( "get_objects", [&]() { return my->get_objects( ids ); } );
 }
 
 fc::variants database_api_impl::get_objects(const vector<object_id_type>& ids)const
 {
-   if( _subscribe_callback )  {
+   if( _subscribed )  {
       for( auto id : ids )
       {
          if( id.type() == operation_history_object_type && id.space() == protocol_ids ) continue;
@@ -468,7 +442,7 @@ fc::variants database_api_impl::get_objects(const vector<object_id_type>& ids)co
    std::transform(ids.begin(), ids.end(), std::back_inserter(result),
                   [this](object_id_type id) -> fc::variant {
       if(auto obj = _db.find_object(id))
-         return obj->to_variant();
+         return _object_cache->to_variant( *obj );
       return {};
    });
 
@@ -497,7 +471,9 @@ void database_api_impl::set_subscribe_callback( std::function<void(const variant
    cancel_all_subscriptions(false, false);
 
    _subscribe_callback = cb;
-   _notify_remove_create = notify_remove_create;
+   if( _subscribe_callback )
+      _subscriptions->subscribe_to_objects( shared_from_this(), notify_remove_create );
+   _subscribed = bool( _subscribe_callback );
 }
 
 void database_api::set_pending_transaction_callback( std::function<void(const variant&)> cb )
@@ -520,6 +496,16 @@ void database_api_impl::set_block_applied_callback( std::function<void(const var
    _block_applied_callback = cb;
 }
 
+void database_api::set_notification_encoding( api_encoding encoding )
+{
+   my->set_notification_encoding( encoding );
+}
+
+void database_api_impl::set_notification_encoding( api_encoding encoding )
+{
+   _packed_notifications = ( encoding == api_encoding::packed );
+}
+
 void database_api::cancel_all_subscriptions()
 {
    my->cancel_all_subscriptions(true, true);
@@ -531,12 +517,19 @@ void database_api_impl::cancel_all_subscriptions( bool reset_callback, bool rese
       _subscribe_callback = std::function<void(const fc::variant&)>();
 
    if ( reset_market_subscriptions )
+   {
       _market_subscriptions.clear();
+      _subscriptions->cancel_market_subscriptions( this );
+      _order_book_subscriptions.clear();
+      _order_book_feed->remove( this );
+   }
 
-   _notify_remove_create = false;
-   _subscribed_accounts.clear();
-   static fc::bloom_parameters param(10000, 1.0/100, 1024*8*8*2);
-   _subscribe_filter = fc::bloom_filter(param);
+   _subscribed = bool( _subscribe_callback );
+   {
+      std::lock_guard<std::mutex> guard( _subscribed_accounts_mutex );
+      _subscribed_accounts.clear();
+   }
+   _subscriptions->cancel_object_subscriptions( this );
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -547,7 +540,7 @@ void database_api_impl::cancel_all_subscriptions( bool reset_callback, bool rese
 
 optional<block_header> database_api::get_block_header(uint32_t block_num)const
 {
-   return my->get_block_header( block_num );
+   return my->run( "get_block_header", [&]() { return my->get_block_header( block_num ); } );
 }
 
 optional<block_header> database_api_impl::get_block_header(uint32_t block_num) const
@@ -559,7 +552,7 @@ optional<block_header> database_api_impl::get_block_header(uint32_t block_num) c
 }
 map<uint32_t, optional<block_header>> database_api::get_block_header_batch(const vector<uint32_t> block_nums)const
 {
-   return my->get_block_header_batch( block_nums );
+   return my->run( "get_block_header_batch", [&]() { return my->get_block_header_batch( block_nums ); } );
 }
 
 map<uint32_t, optional<block_header>> database_api_impl::get_block_header_batch(const vector<uint32_t> block_nums) const
@@ -574,7 +567,7 @@ map<uint32_t, optional<block_header>> database_api_impl::get_block_header_batch(
 
 optional<signed_block> database_api::get_block(uint32_t block_num)const
 {
-   return my->get_block( block_num );
+   return my->run( "get_block", [&]() { return my->get_block( block_num ); } );
 }
 
 optional<signed_block> database_api_impl::get_block(uint32_t block_num)const
@@ -584,16 +577,18 @@ optional<signed_block> database_api_impl::get_block(uint32_t block_num)const
 
 processed_transaction database_api::get_transaction( uint32_t block_num, uint32_t trx_in_block )const
 {
-   return my->get_transaction( block_num, trx_in_block );
+   return my->run( "get_transaction", [&]() { return my->get_transaction( block_num, trx_in_block ); } );
 }
 
 optional<signed_transaction> database_api::get_recent_transaction_by_id( const transaction_id_type& id )const
 {
-   try {
-      return my->_db.get_recent_transaction( id );
-   } catch ( ... ) {
-      return optional<signed_transaction>();
-   }
+   return my->run( "get_recent_transaction_by_id", [&]() -> optional<signed_transaction> {
+      try {
+         return my->_db.get_recent_transaction( id );
+      } catch ( ... ) {
+         return optional<signed_transaction>();
+      }
+   });
 }
 
 processed_transaction database_api_impl::get_transaction(uint32_t block_num, uint32_t trx_num)const
@@ -612,7 +607,7 @@ processed_transaction database_api_impl::get_transaction(uint32_t block_num, uin
 
 chain_property_object database_api::get_chain_properties()const
 {
-   return my->get_chain_properties();
+   return my->run( "get_chain_properties", [&]() { return my->get_chain_properties(); } );
 }
 
 chain_property_object database_api_impl::get_chain_properties()const
@@ -622,7 +617,7 @@ chain_property_object database_api_impl::get_chain_properties()const
 
 global_property_object database_api::get_global_properties()const
 {
-   return my->get_global_properties();
+   return my->run( "get_global_properties", [&]() { return my->get_global_properties(); } );
 }
 
 global_property_object database_api_impl::get_global_properties()const
@@ -632,7 +627,7 @@ global_property_object database_api_impl::get_global_properties()const
 
 fc::variant_object database_api::get_config()const
 {
-   return my->get_config();
+   return my->run( "get_config", [&]() { return my->get_config(); } );
 }
 
 fc::variant_object database_api_impl::get_config()const
@@ -642,7 +637,7 @@ fc::variant_object database_api_impl::get_config()const
 
 chain_id_type database_api::get_chain_id()const
 {
-   return my->get_chain_id();
+   return my->run( "get_chain_id", [&]() { return my->get_chain_id(); } );
 }
 
 chain_id_type database_api_impl::get_chain_id()const
@@ -652,7 +647,7 @@ chain_id_type database_api_impl::get_chain_id()const
 
 dynamic_global_property_object database_api::get_dynamic_global_properties()const
 {
-   return my->get_dynamic_global_properties();
+   return my->run( "get_dynamic_global_properties", [&]() { return my->get_dynamic_global_properties(); } );
 }
 
 dynamic_global_property_object database_api_impl::get_dynamic_global_properties()const
@@ -669,7 +664,7 @@ dynamic_global_property_object database_api_impl::get_dynamic_global_properties(
 vector<vector<account_id_type>> database_api::get_key_references( vector<public_key_type> key )const
 {
    FC_ASSERT(key.size() <= 100, "Number of keys must be 100 or less");
-   return my->get_key_references( key );
+   return my->run( "get_key_references", [&]() { return my->get_key_references( key ); } );
 }
 
 /**
@@ -764,12 +759,14 @@ bool database_api_impl::is_public_key_registered(string public_key) const
 
 account_id_type database_api::get_account_id_from_string(const std::string& name_or_id)const
 {
-   return my->get_account_from_string( name_or_id )->id;
+   return my->run( "get_account_id_from_string", [&]() {
+      return my->get_account_from_string( name_or_id )->id;
+   });
 }
 
 vector<optional<account_object>> database_api::get_accounts(const vector<std::string>& account_names_or_ids)const
 {
-   return my->get_accounts( account_names_or_ids );
+   return my->run( "get_accounts", [&]() { return my->get_accounts( account_names_or_ids ); } );
 }
 
 vector<optional<account_object>> database_api_impl::get_accounts(const vector<std::string>& account_names_or_ids)const
@@ -793,7 +790,9 @@ vector<optional<account_object>> database_api_impl::get_accounts(const vector<st
 vector<limit_order_object> database_api::get_account_limit_orders( const string& account_name_or_id, const string &base,
         const string &quote, uint32_t limit, optional<limit_order_id_type> ostart_id, optional<price> ostart_price)
 {
-   return my->get_account_limit_orders( account_name_or_id, base, quote, limit, ostart_id, ostart_price );
+   return my->run( "get_account_limit_orders", [&]() {
+      return my->get_account_limit_orders( account_name_or_id, base, quote, limit, ostart_id, ostart_price );
+   });
 }
 
 vector<limit_order_object> database_api_impl::get_account_limit_orders( const string& account_name_or_id, const string &base,
@@ -878,7 +877,7 @@ vector<limit_order_object> database_api_impl::get_account_limit_orders( const st
 
 std::map<string,full_account> database_api::get_full_accounts( const vector<string>& names_or_ids, bool subscribe )
 {
-   return my->get_full_accounts( names_or_ids, subscribe );
+   return my->run( "get_full_accounts", [&]() { return my->get_full_accounts( names_or_ids, subscribe ); } );
 }
 
 std::map<std::string, full_account> database_api_impl::get_full_accounts( const vector<std::string>& names_or_ids, bool subscribe)
@@ -897,8 +896,11 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
 
       if( subscribe )
       {
+         std::lock_guard<std::mutex> guard( _subscribed_accounts_mutex );
          if(_subscribed_accounts.size() < 100) {
             _subscribed_accounts.insert( account->get_id() );
+            if( _subscribed )
+               _subscriptions->subscribe_to_account( this, account->get_id() );
             subscribe_to_item( account->id );
          }
       }
@@ -927,8 +929,8 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
 
       // Add the account's balances
       const auto& balances = _db.get_index_type< primary_index< account_balance_index > >().get_secondary_index< balances_by_account_index >().get_account_balances( account->id );
-      for( const auto balance : balances )
-         acnt.balances.emplace_back( *balance.second );
+      for( const account_balance_object* balance : balances )
+         acnt.balances.emplace_back( *balance );
 
       // Add the account's vesting balances
       auto vesting_range = _db.get_index_type<vesting_balance_index>().indices().get<by_account>().equal_range(account->id);
@@ -976,7 +978,7 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
 
 optional<account_object> database_api::get_account_by_name( string name )const
 {
-   return my->get_account_by_name( name );
+   return my->run( "get_account_by_name", [&]() { return my->get_account_by_name( name ); } );
 }
 
 optional<account_object> database_api_impl::get_account_by_name( string name )const
@@ -990,7 +992,9 @@ optional<account_object> database_api_impl::get_account_by_name( string name )co
 
 vector<account_id_type> database_api::get_account_references( const std::string account_id_or_name )const
 {
-   return my->get_account_references( account_id_or_name );
+   return my->run( "get_account_references", [&]() {
+      return my->get_account_references( account_id_or_name );
+   });
 }
 
 vector<account_id_type> database_api_impl::get_account_references( const std::string account_id_or_name )const
@@ -1012,7 +1016,7 @@ vector<account_id_type> database_api_impl::get_account_references( const std::st
 
 vector<optional<account_object>> database_api::lookup_account_names(const vector<string>& account_names)const
 {
-   return my->lookup_account_names( account_names );
+   return my->run( "lookup_account_names", [&]() { return my->lookup_account_names( account_names ); } );
 }
 
 vector<optional<account_object>> database_api_impl::lookup_account_names(const vector<string>& account_names)const
@@ -1030,7 +1034,7 @@ vector<optional<account_object>> database_api_impl::lookup_account_names(const v
 
 map<string,account_id_type> database_api::lookup_accounts(const string& lower_bound_name, uint32_t limit)const
 {
-   return my->lookup_accounts( lower_bound_name, limit );
+   return my->run( "lookup_accounts", [&]() { return my->lookup_accounts( lower_bound_name, limit ); } );
 }
 
 map<string,account_id_type> database_api_impl::lookup_accounts(const string& lower_bound_name, uint32_t limit)const
@@ -1053,7 +1057,7 @@ map<string,account_id_type> database_api_impl::lookup_accounts(const string& low
 
 uint64_t database_api::get_account_count()const
 {
-   return my->get_account_count();
+   return my->run( "get_account_count", [&]() { return my->get_account_count(); } );
 }
 
 uint64_t database_api_impl::get_account_count()const
@@ -1069,7 +1073,9 @@ uint64_t database_api_impl::get_account_count()const
 
 vector<asset> database_api::get_account_balances(const std::string& account_name_or_id, const flat_set<asset_id_type>& assets)const
 {
-   return my->get_account_balances( account_name_or_id, assets );
+   return my->run( "get_account_balances", [&]() {
+      return my->get_account_balances( account_name_or_id, assets );
+   });
 }
 
 vector<asset> database_api_impl::get_account_balances(const std::string& account_name_or_id, const flat_set<asset_id_type>& assets)const
@@ -1082,8 +1088,9 @@ vector<asset> database_api_impl::get_account_balances(const std::string& account
       // if the caller passes in an empty list of assets, return balances for all assets the account owns
       const auto& balance_index = _db.get_index_type< primary_index< account_balance_index > >();
       const auto& balances = balance_index.get_secondary_index< balances_by_account_index >().get_account_balances( acnt );
-      for( const auto balance : balances )
-         result.push_back( balance.second->get_balance() );
+      result.reserve( balances.size() );
+      for( const account_balance_object* balance : balances )
+         result.push_back( balance->get_balance() );
    }
    else
    {
@@ -1098,12 +1105,12 @@ vector<asset> database_api_impl::get_account_balances(const std::string& account
 
 vector<asset> database_api::get_named_account_balances(const std::string& name, const flat_set<asset_id_type>& assets)const
 {
-   return my->get_account_balances( name, assets );
+   return my->run( "get_named_account_balances", [&]() { return my->get_account_balances( name, assets ); } );
 }
 
 vector<balance_object> database_api::get_balance_objects( const vector<address>& addrs )const
 {
-   return my->get_balance_objects( addrs );
+   return my->run( "get_balance_objects", [&]() { return my->get_balance_objects( addrs ); } );
 }
 
 vector<balance_object> database_api_impl::get_balance_objects( const vector<address>& addrs )const
@@ -1132,7 +1139,7 @@ vector<balance_object> database_api_impl::get_balance_objects( const vector<addr
 
 vector<asset> database_api::get_vested_balances( const vector<balance_id_type>& objs )const
 {
-   return my->get_vested_balances( objs );
+   return my->run( "get_vested_balances", [&]() { return my->get_vested_balances( objs ); } );
 }
 
 vector<asset> database_api_impl::get_vested_balances( const vector<balance_id_type>& objs )const
@@ -1150,7 +1157,7 @@ vector<asset> database_api_impl::get_vested_balances( const vector<balance_id_ty
 
 vector<vesting_balance_object> database_api::get_vesting_balances( const std::string account_id_or_name )const
 {
-   return my->get_vesting_balances( account_id_or_name );
+   return my->run( "get_vesting_balances", [&]() { return my->get_vesting_balances( account_id_or_name ); } );
 }
 
 vector<vesting_balance_object> database_api_impl::get_vesting_balances( const std::string account_id_or_name )const
@@ -1177,12 +1184,14 @@ vector<vesting_balance_object> database_api_impl::get_vesting_balances( const st
 
 asset_id_type database_api::get_asset_id_from_string(const std::string& symbol_or_id)const
 {
-   return my->get_asset_from_string( symbol_or_id )->id;
+   return my->run( "get_asset_id_from_string", [&]() {
+      return my->get_asset_from_string( symbol_or_id )->id;
+   });
 }
 
 vector<optional<asset_object>> database_api::get_assets(const vector<std::string>& asset_symbols_or_ids)const
 {
-   return my->get_assets( asset_symbols_or_ids );
+   return my->run( "get_assets", [&]() { return my->get_assets( asset_symbols_or_ids ); } );
 }
 
 vector<optional<asset_object>> database_api_impl::get_assets(const vector<std::string>& asset_symbols_or_ids)const
@@ -1204,7 +1213,7 @@ vector<optional<asset_object>> database_api_impl::get_assets(const vector<std::s
 
 vector<asset_object> database_api::list_assets(const string& lower_bound_symbol, uint32_t limit)const
 {
-   return my->list_assets( lower_bound_symbol, limit );
+   return my->run( "list_assets", [&]() { return my->list_assets( lower_bound_symbol, limit ); } );
 }
 
 vector<asset_object> database_api_impl::list_assets(const string& lower_bound_symbol, uint32_t limit)const
@@ -1227,7 +1236,7 @@ vector<asset_object> database_api_impl::list_assets(const string& lower_bound_sy
 
 uint64_t database_api::get_asset_count()const
 {
-   return my->get_asset_count();
+   return my->run( "get_asset_count", [&]() { return my->get_asset_count(); } );
 }
 
 uint64_t database_api_impl::get_asset_count()const
@@ -1237,7 +1246,7 @@ uint64_t database_api_impl::get_asset_count()const
 
 vector<optional<asset_object>> database_api::lookup_asset_symbols(const vector<string>& symbols_or_ids)const
 {
-   return my->lookup_asset_symbols( symbols_or_ids );
+   return my->run( "lookup_asset_symbols", [&]() { return my->lookup_asset_symbols( symbols_or_ids ); } );
 }
 
 vector<optional<asset_object>> database_api_impl::lookup_asset_symbols(const vector<string>& symbols_or_ids)const
@@ -1266,7 +1275,7 @@ vector<optional<asset_object>> database_api_impl::lookup_asset_symbols(const vec
 
 vector<limit_order_object> database_api::get_limit_orders(std::string a, std::string b, uint32_t limit)const
 {
-   return my->get_limit_orders( a, b, limit );
+   return my->run( "get_limit_orders", [&]() { return my->get_limit_orders( a, b, limit ); } );
 }
 
 /**
@@ -1282,9 +1291,14 @@ vector<limit_order_object> database_api_impl::get_limit_orders(const std::string
    return get_limit_orders(asset_a_id, asset_b_id, limit);
 }
 
+packed_data database_api::get_limit_orders_packed(std::string a, std::string b, uint32_t limit)const
+{
+   return my->run( "get_limit_orders_packed", [&]() { return pack_data( my->get_limit_orders( a, b, limit ) ); } );
+}
+
 vector<call_order_object> database_api::get_call_orders(const std::string& a, uint32_t limit)const
 {
-   return my->get_call_orders( a, limit );
+   return my->run( "get_call_orders", [&]() { return my->get_call_orders( a, limit ); } );
 }
 
 vector<call_order_object> database_api_impl::get_call_orders(const std::string& a, uint32_t limit)const
@@ -1296,8 +1310,8 @@ vector<call_order_object> database_api_impl::get_call_orders(const std::string&
    price index_price = price::min( mia->bitasset_data(_db).options.short_backing_asset, mia->get_id() );
    
    vector< call_order_object> result;
-   auto itr_min = call_index.lower_bound(index_price);
-   auto itr_max = call_index.upper_bound(index_price.max());
+   auto itr_min = call_index.lower_bound(price_index_key(index_price));
+   auto itr_max = call_index.upper_bound(price_index_key(index_price.max()));
    while( itr_min != itr_max && result.size() < limit ) 
    {
       result.emplace_back(*itr_min);
@@ -1308,7 +1322,7 @@ vector<call_order_object> database_api_impl::get_call_orders(const std::string&
 
 vector<force_settlement_object> database_api::get_settle_orders(const std::string& a, uint32_t limit)const
 {
-   return my->get_settle_orders( a, limit );
+   return my->run( "get_settle_orders", [&]() { return my->get_settle_orders( a, limit ); } );
 }
 
 vector<force_settlement_object> database_api_impl::get_settle_orders(const std::string& a, uint32_t limit)const
@@ -1332,7 +1346,7 @@ vector<force_settlement_object> database_api_impl::get_settle_orders(const std::
 
 vector<call_order_object> database_api::get_margin_positions( const std::string account_id_or_name )const
 {
-   return my->get_margin_positions( account_id_or_name );
+   return my->run( "get_margin_positions", [&]() { return my->get_margin_positions( account_id_or_name ); } );
 }
 
 vector<call_order_object> database_api_impl::get_margin_positions( const std::string account_id_or_name )const
@@ -1356,7 +1370,7 @@ vector<call_order_object> database_api_impl::get_margin_positions( const std::st
 
 vector<collateral_bid_object> database_api::get_collateral_bids(const std::string& asset, uint32_t limit, uint32_t start)const
 {
-   return my->get_collateral_bids( asset, limit, start );
+   return my->run( "get_collateral_bids", [&]() { return my->get_collateral_bids( asset, limit, start ); } );
 }
 
 vector<collateral_bid_object> database_api_impl::get_collateral_bids(const std::string& asset, uint32_t limit, uint32_t skip)const
@@ -1369,8 +1383,10 @@ vector<collateral_bid_object> database_api_impl::get_collateral_bids(const std::
    const asset_object& back = bad.options.short_backing_asset(_db);
    const auto& idx = _db.get_index_type<collateral_bid_index>();
    const auto& aidx = idx.indices().get<by_price>();
-   auto start = aidx.lower_bound( boost::make_tuple( asset_id, price::max(back.id, asset_id), collateral_bid_id_type() ) );
-   auto end = aidx.lower_bound( boost::make_tuple( asset_id, price::min(back.id, asset_id), collateral_bid_id_type(GRAPHENE_DB_MAX_INSTANCE_ID) ) );
+   const price max_bid = price::max(back.id, asset_id);
+   const price min_bid = price::min(back.id, asset_id);
+   auto start = aidx.lower_bound( boost::make_tuple( asset_id, price_sort_key(max_bid), max_bid, collateral_bid_id_type() ) );
+   auto end = aidx.lower_bound( boost::make_tuple( asset_id, price_sort_key(min_bid), min_bid, collateral_bid_id_type(GRAPHENE_DB_MAX_INSTANCE_ID) ) );
    vector<collateral_bid_object> result;
    while( skip-- > 0 && start != end ) { ++start; }
    while( start != end && limit-- > 0)
@@ -1394,6 +1410,7 @@ void database_api_impl::subscribe_to_market(std::function<void(const variant&)>
    if(asset_a_id > asset_b_id) std::swap(asset_a_id,asset_b_id);
    FC_ASSERT(asset_a_id != asset_b_id);
    _market_subscriptions[ std::make_pair(asset_a_id,asset_b_id) ] = callback;
+   _subscriptions->subscribe_to_market( shared_from_this(), std::make_pair(asset_a_id,asset_b_id) );
 }
 
 void database_api::unsubscribe_from_market(const std::string& a, const std::string& b)
@@ -1409,6 +1426,49 @@ void database_api_impl::unsubscribe_from_market(const std::string& a, const std:
    if(a > b) std::swap(asset_a_id,asset_b_id);
    FC_ASSERT(asset_a_id != asset_b_id);
    _market_subscriptions.erase(std::make_pair(asset_a_id,asset_b_id));
+   _subscriptions->unsubscribe_from_market( this, std::make_pair(asset_a_id,asset_b_id) );
+}
+
+void database_api::subscribe_to_order_book_deltas( std::function<void(const variant&)> callback,
+                                                   const std::string& a, const std::string& b )
+{
+   my->subscribe_to_order_book_deltas( callback, a, b );
+}
+
+void database_api_impl::subscribe_to_order_book_deltas( std::function<void(const variant&)> callback,
+                                                        const std::string& a, const std::string& b )
+{
+   auto market = std::make_pair( get_asset_from_string(a)->id, get_asset_from_string(b)->id );
+   if( market.first > market.second ) std::swap( market.first, market.second );
+   FC_ASSERT( market.first != market.second );
+   _order_book_subscriptions[ market ] = callback;
+   _order_book_feed->subscribe( shared_from_this(), market );
+}
+
+void database_api::unsubscribe_from_order_book_deltas( const std::string& a, const std::string& b )
+{
+   my->unsubscribe_from_order_book_deltas( a, b );
+}
+
+void database_api_impl::unsubscribe_from_order_book_deltas( const std::string& a, const std::string& b )
+{
+   auto market = std::make_pair( get_asset_from_string(a)->id, get_asset_from_string(b)->id );
+   if( market.first > market.second ) std::swap( market.first, market.second );
+   _order_book_subscriptions.erase( market );
+   _order_book_feed->unsubscribe( this, market );
+}
+
+order_book_snapshot database_api::get_order_book_snapshot( const std::string& a, const std::string& b )const
+{
+   return my->run( "get_order_book_snapshot", [&]() { return my->get_order_book_snapshot( a, b ); } );
+}
+
+order_book_snapshot database_api_impl::get_order_book_snapshot( const std::string& a, const std::string& b )const
+{
+   auto market = std::make_pair( get_asset_from_string(a)->id, get_asset_from_string(b)->id );
+   if( market.first > market.second ) std::swap( market.first, market.second );
+   FC_ASSERT( market.first != market.second );
+   return _order_book_feed->get_snapshot( market );
 }
 
 string database_api_impl::price_to_string( const price& _price, const asset_object& _base, const asset_object& _quote )
@@ -1476,7 +1536,7 @@ market_volume database_api_impl::get_24_volume( const string& base, const string
 
 order_book database_api::get_order_book( const string& base, const string& quote, unsigned limit )const
 {
-   return my->get_order_book( base, quote, limit);
+   return my->run( "get_order_book", [&]() { return my->get_order_book( base, quote, limit); } );
 }
 
 order_book database_api_impl::get_order_book( const string& base, const string& quote, unsigned limit )const
@@ -1521,7 +1581,7 @@ order_book database_api_impl::get_order_book( const string& base, const string&
 
 vector<market_ticker> database_api::get_top_markets(uint32_t limit)const
 {
-   return my->get_top_markets(limit);
+   return my->run( "get_top_markets", [&]() { return my->get_top_markets(limit); } );
 }
 
 vector<market_ticker> database_api_impl::get_top_markets(uint32_t limit)const
@@ -1555,7 +1615,9 @@ vector<market_trade> database_api::get_trade_history( const string& base,
                                                       fc::time_point_sec stop,
                                                       unsigned limit )const
 {
-   return my->get_trade_history( base, quote, start, stop, limit );
+   return my->run( "get_trade_history", [&]() {
+      return my->get_trade_history( base, quote, start, stop, limit );
+   });
 }
 
 vector<market_trade> database_api_impl::get_trade_history( const string& base,
@@ -1645,7 +1707,9 @@ vector<market_trade> database_api::get_trade_history_by_sequence(
                                                       fc::time_point_sec stop,
                                                       unsigned limit )const
 {
-   return my->get_trade_history_by_sequence( base, quote, start, stop, limit );
+   return my->run( "get_trade_history_by_sequence", [&]() {
+      return my->get_trade_history_by_sequence( base, quote, start, stop, limit );
+   });
 }
 
 vector<market_trade> database_api_impl::get_trade_history_by_sequence(
@@ -1751,7 +1815,7 @@ vector<market_trade> database_api_impl::get_trade_history_by_sequence(
 
 vector<optional<witness_object>> database_api::get_witnesses(const vector<witness_id_type>& witness_ids)const
 {
-   return my->get_witnesses( witness_ids );
+   return my->run( "get_witnesses", [&]() { return my->get_witnesses( witness_ids ); } );
 }
 
 vector<optional<witness_object>> database_api_impl::get_witnesses(const vector<witness_id_type>& witness_ids)const
@@ -1768,7 +1832,9 @@ vector<optional<witness_object>> database_api_impl::get_witnesses(const vector<w
 
 fc::optional<witness_object> database_api::get_witness_by_account(const std::string account_id_or_name)const
 {
-   return my->get_witness_by_account( account_id_or_name );
+   return my->run( "get_witness_by_account", [&]() {
+      return my->get_witness_by_account( account_id_or_name );
+   });
 }
 
 fc::optional<witness_object> database_api_impl::get_witness_by_account(const std::string account_id_or_name) const
@@ -1783,7 +1849,9 @@ fc::optional<witness_object> database_api_impl::get_witness_by_account(const std
 
 map<string, witness_id_type> database_api::lookup_witness_accounts(const string& lower_bound_name, uint32_t limit)const
 {
-   return my->lookup_witness_accounts( lower_bound_name, limit );
+   return my->run( "lookup_witness_accounts", [&]() {
+      return my->lookup_witness_accounts( lower_bound_name, limit );
+   });
 }
 
 map<string, witness_id_type> database_api_impl::lookup_witness_accounts(const string& lower_bound_name, uint32_t limit)const
@@ -1811,7 +1879,7 @@ map<string, witness_id_type> database_api_impl::lookup_witness_accounts(const st
 
 uint64_t database_api::get_witness_count()const
 {
-   return my->get_witness_count();
+   return my->run( "get_witness_count", [&]() { return my->get_witness_count(); } );
 }
 
 uint64_t database_api_impl::get_witness_count()const
@@ -1827,7 +1895,9 @@ uint64_t database_api_impl::get_witness_count()const
 
 vector<optional<committee_member_object>> database_api::get_committee_members(const vector<committee_member_id_type>& committee_member_ids)const
 {
-   return my->get_committee_members( committee_member_ids );
+   return my->run( "get_committee_members", [&]() {
+      return my->get_committee_members( committee_member_ids );
+   });
 }
 
 vector<optional<committee_member_object>> database_api_impl::get_committee_members(const vector<committee_member_id_type>& committee_member_ids)const
@@ -1844,7 +1914,9 @@ vector<optional<committee_member_object>> database_api_impl::get_committee_membe
 
 fc::optional<committee_member_object> database_api::get_committee_member_by_account(const std::string account_id_or_name)const
 {
-   return my->get_committee_member_by_account( account_id_or_name );
+   return my->run( "get_committee_member_by_account", [&]() {
+      return my->get_committee_member_by_account( account_id_or_name );
+   });
 }
 
 fc::optional<committee_member_object> database_api_impl::get_committee_member_by_account(const std::string account_id_or_name) const
@@ -1859,7 +1931,9 @@ fc::optional<committee_member_object> database_api_impl::get_committee_member_by
 
 map<string, committee_member_id_type> database_api::lookup_committee_member_accounts(const string& lower_bound_name, uint32_t limit)const
 {
-   return my->lookup_committee_member_accounts( lower_bound_name, limit );
+   return my->run( "lookup_committee_member_accounts", [&]() {
+      return my->lookup_committee_member_accounts( lower_bound_name, limit );
+   });
 }
 
 map<string, committee_member_id_type> database_api_impl::lookup_committee_member_accounts(const string& lower_bound_name, uint32_t limit)const
@@ -1957,7 +2031,7 @@ uint64_t database_api_impl::get_worker_count()const
 
 vector<variant> database_api::lookup_vote_ids( const vector<vote_id_type>& votes )const
 {
-   return my->lookup_vote_ids( votes );
+   return my->run( "lookup_vote_ids", [&]() { return my->lookup_vote_ids( votes ); } );
 }
 
 vector<variant> database_api_impl::lookup_vote_ids( const vector<vote_id_type>& votes )const
@@ -2030,7 +2104,7 @@ vector<variant> database_api_impl::lookup_vote_ids( const vector<vote_id_type>&
 
 std::string database_api::get_transaction_hex(const signed_transaction& trx)const
 {
-   return my->get_transaction_hex( trx );
+   return my->run( "get_transaction_hex", [&]() { return my->get_transaction_hex( trx ); } );
 }
 
 std::string database_api_impl::get_transaction_hex(const signed_transaction& trx)const
@@ -2041,7 +2115,9 @@ std::string database_api_impl::get_transaction_hex(const signed_transaction& trx
 std::string database_api::get_transaction_hex_without_sig(
    const signed_transaction &trx) const
 {
-   return my->get_transaction_hex_without_sig(trx);
+   return my->run( "get_transaction_hex_without_sig", [&]() {
+      return my->get_transaction_hex_without_sig(trx);
+   });
 }
 
 std::string database_api_impl::get_transaction_hex_without_sig(
@@ -2052,7 +2128,9 @@ std::string database_api_impl::get_transaction_hex_without_sig(
 
 set<public_key_type> database_api::get_required_signatures( const signed_transaction& trx, const flat_set<public_key_type>& available_keys )const
 {
-   return my->get_required_signatures( trx, available_keys );
+   return my->run( "get_required_signatures", [&]() {
+      return my->get_required_signatures( trx, available_keys );
+   });
 }
 
 set<public_key_type> database_api_impl::get_required_signatures( const signed_transaction& trx, const flat_set<public_key_type>& available_keys )const
@@ -2069,7 +2147,7 @@ set<public_key_type> database_api_impl::get_required_signatures( const signed_tr
 
 set<public_key_type> database_api::get_potential_signatures( const signed_transaction& trx )const
 {
-   return my->get_potential_signatures( trx );
+   return my->run( "get_potential_signatures", [&]() { return my->get_potential_signatures( trx ); } );
 }
 set<address> database_api::get_potential_address_signatures( const signed_transaction& trx )const
 {
@@ -2140,7 +2218,7 @@ set<address> database_api_impl::get_potential_address_signatures( const signed_t
 
 bool database_api::verify_authority( const signed_transaction& trx )const
 {
-   return my->verify_authority( trx );
+   return my->run( "verify_authority", [&]() { return my->verify_authority( trx ); } );
 }
 
 bool database_api_impl::verify_authority( const signed_transaction& trx )const
@@ -2156,7 +2234,9 @@ bool database_api_impl::verify_authority( const signed_transaction& trx )const
 
 bool database_api::verify_account_authority( const string& account_name_or_id, const flat_set<public_key_type>& signers )const
 {
-   return my->verify_account_authority( account_name_or_id, signers );
+   return my->run( "verify_account_authority", [&]() {
+      return my->verify_account_authority( account_name_or_id, signers );
+   });
 }
 
 bool database_api_impl::verify_account_authority( const string& account_name_or_id, 
@@ -2195,7 +2275,7 @@ processed_transaction database_api_impl::validate_transaction( const signed_tran
 
 vector< fc::variant > database_api::get_required_fees( const vector<operation>& ops, const std::string& asset_id_or_symbol )const
 {
-   return my->get_required_fees( ops, asset_id_or_symbol );
+   return my->run( "get_required_fees", [&]() { return my->get_required_fees( ops, asset_id_or_symbol ); } );
 }
 
 /**
@@ -2284,7 +2364,9 @@ vector< fc::variant > database_api_impl::get_required_fees( const vector<operati
 
 vector<proposal_object> database_api::get_proposed_transactions( const std::string account_id_or_name )const
 {
-   return my->get_proposed_transactions( account_id_or_name );
+   return my->run( "get_proposed_transactions", [&]() {
+      return my->get_proposed_transactions( account_id_or_name );
+   });
 }
 
 /** TODO: add secondary index that will accelerate this process */
@@ -2314,7 +2396,7 @@ vector<proposal_object> database_api_impl::get_proposed_transactions( const std:
 
 vector<blinded_balance_object> database_api::get_blinded_balances( const flat_set<commitment_type>& commitments )const
 {
-   return my->get_blinded_balances( commitments );
+   return my->run( "get_blinded_balances", [&]() { return my->get_blinded_balances( commitments ); } );
 }
 
 vector<blinded_balance_object> database_api_impl::get_blinded_balances( const flat_set<commitment_type>& commitments )const
@@ -2339,7 +2421,9 @@ vector<blinded_balance_object> database_api_impl::get_blinded_balances( const fl
 
 vector<withdraw_permission_object> database_api::get_withdraw_permissions_by_giver(const std::string account_id_or_name, withdraw_permission_id_type start, uint32_t limit)const
 {
-   return my->get_withdraw_permissions_by_giver( account_id_or_name, start, limit );
+   return my->run( "get_withdraw_permissions_by_giver", [&]() {
+      return my->get_withdraw_permissions_by_giver( account_id_or_name, start, limit );
+   });
 }
 
 vector<withdraw_permission_object> database_api_impl::get_withdraw_permissions_by_giver(const std::string account_id_or_name, withdraw_permission_id_type start, uint32_t limit)const
@@ -2361,7 +2445,9 @@ vector<withdraw_permission_object> database_api_impl::get_withdraw_permissions_b
 
 vector<withdraw_permission_object> database_api::get_withdraw_permissions_by_recipient(const std::string account_id_or_name, withdraw_permission_id_type start, uint32_t limit)const
 {
-   return my->get_withdraw_permissions_by_recipient( account_id_or_name, start, limit );
+   return my->run( "get_withdraw_permissions_by_recipient", [&]() {
+      return my->get_withdraw_permissions_by_recipient( account_id_or_name, start, limit );
+   });
 }
 
 vector<withdraw_permission_object> database_api_impl::get_withdraw_permissions_by_recipient(const std::string account_id_or_name, withdraw_permission_id_type start, uint32_t limit)const
@@ -2414,93 +2500,29 @@ void database_api_impl::broadcast_market_updates( const market_queue_type& queue
    }
 }
 
-void database_api_impl::on_objects_removed( const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts)
-{
-   handle_object_changed(_notify_remove_create, false, ids, impacted_accounts,
-      [objs](object_id_type id) -> const object* {
-         auto it = std::find_if(
-               objs.begin(), objs.end(),
-               [id](const object* o) {return o != nullptr && o->id == id;});
-
-         if (it != objs.end())
-            return *it;
-
-         return nullptr;
-      }
-   );
-}
-
-void database_api_impl::on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts)
-{
-   handle_object_changed(_notify_remove_create, true, ids, impacted_accounts,
-      std::bind(&object_database::find_object, &_db, std::placeholders::_1)
-   );
-}
-
-void database_api_impl::on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts)
+void database_api_impl::on_object_updates( const vector<variant>& updates )
 {
-   handle_object_changed(false, true, ids, impacted_accounts,
-      std::bind(&object_database::find_object, &_db, std::placeholders::_1)
-   );
+   broadcast_updates( updates );
 }
 
-void database_api_impl::handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts, std::function<const object*(object_id_type id)> find_object)
+void database_api_impl::on_market_updates( const market_queue_type& queue )
 {
-   if( _subscribe_callback )
-   {
-      vector<variant> updates;
-
-      for(auto id : ids)
-      {
-         if( force_notify || is_subscribed_to_item(id) || is_impacted_account(impacted_accounts) )
-         {
-            if( full_object )
-            {
-               auto obj = find_object(id);
-               if( obj )
-               {
-                  updates.emplace_back( obj->to_variant() );
-               }
-            }
-            else
-            {
-               updates.emplace_back( fc::variant( id, 1 ) );
-            }
-         }
-      }
-
-      if( updates.size() )
-         broadcast_updates(updates);
-   }
-
-   if( _market_subscriptions.size() )
-   {
-      market_queue_type broadcast_queue;
-
-      for(auto id : ids)
-      {
-         if( id.is<call_order_object>() )
-         {
-            enqueue_if_subscribed_to_market<call_order_object>( find_object(id), broadcast_queue, full_object );
-         }
-         else if( id.is<limit_order_object>() )
-         {
-            enqueue_if_subscribed_to_market<limit_order_object>( find_object(id), broadcast_queue, full_object );
-         }
-         else if( id.is<force_settlement_object>() )
-         {
-            enqueue_if_subscribed_to_market<force_settlement_object>( find_object(id), broadcast_queue, full_object );
-         }
-      }
-
-      if( broadcast_queue.size() )
-         broadcast_market_updates(broadcast_queue);
-   }
+   broadcast_market_updates( queue );
 }
 
 /** note: this method cannot yield because it is called in the middle of
  * apply a block.
  */
+void database_api_impl::on_order_book_delta( const market_type& market, const variant& delta )
+{
+   auto capture_this = shared_from_this();
+   fc::async([capture_this, this, market, delta](){
+      auto sub = _order_book_subscriptions.find( market );
+      if( sub != _order_book_subscriptions.end() )
+         sub->second( delta );
+   });
+}
+
 void database_api_impl::on_applied_block()
 {
    if (_block_applied_callback)
@@ -23,7 +23,12 @@
  */
 #pragma once
 
+#include <graphene/app/api_executor.hpp>
+#include <graphene/app/api_metrics.hpp>
+#include <graphene/app/api_throttle.hpp>
 #include <graphene/app/database_api.hpp>
+#include <graphene/app/packed_encoding.hpp>
+#include <graphene/app/serialized_object_cache.hpp>
 
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/chain/protocol/confidential.hpp>
@@ -107,6 +112,21 @@ namespace graphene { namespace app {
       price         max_price; ///< possible highest price in the group
       share_type    total_for_sale; ///< total amount of asset for sale, asset id is min_price.base.asset_id
    };
+
+   /**
+    * @brief consecutive blocks sent by block_api::stream_blocks
+    */
+   struct block_chunk
+   {
+      uint32_t    stream_id = 0;
+      uint32_t    sequence = 0;        ///< 1 for the first chunk of a stream
+      uint32_t    first_block_num = 0;
+      uint32_t    block_count = 0;
+      bool        last = false;        ///< whether the stream ends with this chunk
+      packed_data blocks;              ///< a packed vector<signed_block>
+      /// Set in the last chunk if the stream ended before the requested range, e.g. because a block is missing
+      optional<string> error;
+   };
    
    /**
     * @brief The history_api class implements the RPC API for account history
@@ -134,6 +154,17 @@ namespace graphene { namespace app {
             operation_history_id_type start = operation_history_id_type()
          )const;
 
+         /**
+          * @brief Get operations relevant to the specificed account, in the binary format
+          * @return The result of @ref get_account_history as a packed vector<operation_history_object>
+          */
+         packed_data get_account_history_packed(
+            const std::string account_id_or_name,
+            operation_history_id_type stop = operation_history_id_type(),
+            unsigned limit = 100,
+            operation_history_id_type start = operation_history_id_type()
+         )const;
+
          /**
           * @brief Get operations relevant to the specified account filtering by operation type
           * @param account_id_or_name The account ID or name whose history should be queried
@@ -222,9 +253,16 @@ namespace graphene { namespace app {
    /**
     * @brief Block api
     */
-   class block_api
+   class block_api : public std::enable_shared_from_this<block_api>
    {
    public:
+      /// Streams a connection may run at the same time
+      static const uint32_t max_streams = 4;
+      /// Chunks of a stream which may be sent before the client acknowledges them
+      static const uint32_t max_window = 16;
+      static const uint32_t max_chunk_blocks = 100;
+      static const size_t   max_chunk_bytes = 1024 * 1024;
+
       block_api(graphene::chain::database& db);
       ~block_api();
 
@@ -236,8 +274,49 @@ namespace graphene { namespace app {
           */
       vector<optional<signed_block>> get_blocks(uint32_t block_num_from, uint32_t block_num_to)const;
 
+      /**
+          * @brief Get signed blocks in the binary format
+          * @param block_num_from The lowest block number
+          * @param block_num_to The highest block number
+          * @return The result of @ref get_blocks as a packed vector<optional<signed_block>>, irreversible blocks
+          *         are copied from the block database without being unpacked
+          */
+      packed_data get_blocks_packed(uint32_t block_num_from, uint32_t block_num_to)const;
+
+      /**
+          * @brief Stream a range of blocks in chunks
+          * @param callback Called with every @ref block_chunk of the stream
+          * @param block_num_from The lowest block number
+          * @param block_num_to The highest block number, the stream ends at the head block if that comes first
+          * @param window Number of chunks which may be sent before the first unacknowledged one is acknowledged
+          * @return The id of the stream
+          *
+          * Chunks hold up to max_chunk_blocks blocks or about max_chunk_bytes bytes, irreversible blocks are copied
+          * from the block database without being unpacked. Once the window is full, the stream waits for
+          * @ref acknowledge_block_chunk, so that a slow client does not make the node buffer the whole range.
+          */
+      uint32_t stream_blocks( std::function<void(const variant&)> callback, uint32_t block_num_from,
+                              uint32_t block_num_to, uint32_t window );
+
+      /**
+          * @brief Let a stream send more chunks
+          * @param stream_id The id returned by @ref stream_blocks
+          * @param sequence The sequence of the last chunk processed by the client
+          */
+      void acknowledge_block_chunk( uint32_t stream_id, uint32_t sequence );
+
+      /// @brief Stop a stream before its last chunk
+      void cancel_block_stream( uint32_t stream_id );
+
    private:
+      struct block_stream;
+
+      void send_chunks( const std::shared_ptr<block_stream>& stream );
+      block_chunk next_chunk( block_stream& stream )const;
+
       graphene::chain::database& _db;
+      uint32_t _next_stream_id = 1;
+      map< uint32_t, std::shared_ptr<block_stream> > _streams;
    };
 
 
@@ -504,6 +583,86 @@ namespace graphene { namespace app {
          graphene::app::database_api database_api;
    };
 
+   /**
+    * @brief The metrics_api class exposes performance data collected by this node
+    */
+   class metrics_api
+   {
+      public:
+         metrics_api(application& app);
+
+         /**
+          * @brief Get execution time statistics of operations and transaction checks
+          * @return Count, total, median, 99th percentile and maximum execution time per operation type,
+          *         ordered by total time, followed by the same data for signature, TaPoS and dupe checks.
+          *         The node collects data only if started with enable-execution-profiling.
+          */
+         execution_profile get_execution_profile()const;
+
+         /**
+          * @brief Discard the execution time statistics collected so far
+          */
+         void reset_execution_profile();
+
+         /**
+          * @brief Get per-phase timing of the most recently applied blocks
+          * @param limit Maximum number of blocks to return
+          * @return Traces of up to limit blocks, newest first. The node keeps traces only if started with
+          *         block-phase-trace-size.
+          */
+         vector<block_phase_trace> get_block_phase_traces( uint32_t limit )const;
+
+         /**
+          * @brief Get hit and invalidation counts of the cache of objects returned by the API
+          * @return Counts since the node started or the last reset, and the current size and capacity of the
+          *         cache, which is set with api-object-cache-size
+          */
+         object_cache_stats get_object_cache_stats()const;
+
+         /**
+          * @brief Reset the counts of the object cache
+          */
+         void reset_object_cache_stats();
+
+         /**
+          * @brief Get queue wait and execution time statistics of the database API methods
+          * @return Count, total, median, 99th percentile and maximum queue wait and execution time per method
+          *         called since the node started or the last reset. Calls wait in the queue of the threads set
+          *         with api-threads, and for blocks being applied.
+          */
+         vector<api_method_profile> get_api_execution_profile()const;
+
+         /**
+          * @brief Discard the API timing statistics collected so far
+          */
+         void reset_api_execution_profile();
+
+         /**
+          * @brief Get call, error, latency and response size statistics of the API methods
+          * @return The statistics per API and method called over the websocket and HTTP endpoints since the node
+          *         started or the last reset. The node collects them only if started with api-metrics-endpoint,
+          *         which also serves them in the Prometheus format.
+          */
+         vector<api_method_metrics> get_api_method_metrics()const;
+
+         /**
+          * @brief Discard the API call statistics collected so far
+          */
+         void reset_api_method_metrics();
+
+         /**
+          * @brief Get the cost of the API calls of the open connections and of each user
+          * @return One entry per connection, followed by the totals of each user across all of its connections,
+          *         which have a session_id of 0. Calls are accounted on connections with throttling configured
+          *         in the api-access file, and on all connections if the node was started with
+          *         api-metrics-endpoint.
+          */
+         vector<api_cost_info> get_api_session_costs()const;
+
+      private:
+         application& _app;
+   };
+
    /**
     * @brief The login_api class implements the bottom layer of the RPC API
     *
@@ -543,12 +702,17 @@ namespace graphene { namespace app {
          fc::api<orders_api> orders()const;
          /// @brief Retrieve the debug API (if available)
          fc::api<graphene::debug_witness::debug_api> debug()const;
+         /// @brief Retrieve the metrics API
+         fc::api<metrics_api> metrics()const;
 
          /// @brief Called to enable an API, not reflected.
          void enable_api( const string& api_name );
+         /// @brief Called to account the calls of the connection, not reflected.
+         void set_session_costs( std::shared_ptr<api_session_costs> costs );
       private:
 
          application& _app;
+         std::shared_ptr<api_session_costs> _session_costs;
          optional< fc::api<block_api> > _block_api;
          optional< fc::api<database_api> > _database_api;
          optional< fc::api<network_broadcast_api> > _network_broadcast_api;
@@ -558,6 +722,7 @@ namespace graphene { namespace app {
          optional< fc::api<asset_api> > _asset_api;
          optional< fc::api<orders_api> > _orders_api;
          optional< fc::api<graphene::debug_witness::debug_api> > _debug_api;
+         optional< fc::api<metrics_api> > _metrics_api;
    };
 
 }}  // graphene::app
@@ -572,6 +737,8 @@ FC_REFLECT( graphene::app::history_operation_detail,
             (total_count)(operation_history_objs) )
 FC_REFLECT( graphene::app::limit_order_group,
             (min_price)(max_price)(total_for_sale) )
+FC_REFLECT( graphene::app::block_chunk,
+            (stream_id)(sequence)(first_block_num)(block_count)(last)(blocks)(error) )
 //FC_REFLECT_TYPENAME( fc::ecc::compact_signature );
 //FC_REFLECT_TYPENAME( fc::ecc::commitment_type );
 
@@ -580,6 +747,7 @@ FC_REFLECT( graphene::app::asset_holders, (asset_id)(count) );
 
 FC_API(graphene::app::history_api,
        (get_account_history)
+       (get_account_history_packed)
        (get_account_history_by_operations)
        (get_account_history_operations)
        (get_relative_account_history)
@@ -589,6 +757,10 @@ FC_API(graphene::app::history_api,
      )
 FC_API(graphene::app::block_api,
        (get_blocks)
+       (get_blocks_packed)
+       (stream_blocks)
+       (acknowledge_block_chunk)
+       (cancel_block_stream)
      )
 FC_API(graphene::app::network_broadcast_api,
        (broadcast_transaction)
@@ -622,6 +794,18 @@ FC_API(graphene::app::orders_api,
        (get_tracked_groups)
        (get_grouped_limit_orders)
      )
+FC_API(graphene::app::metrics_api,
+       (get_execution_profile)
+       (reset_execution_profile)
+       (get_block_phase_traces)
+       (get_object_cache_stats)
+       (reset_object_cache_stats)
+       (get_api_execution_profile)
+       (reset_api_execution_profile)
+       (get_api_method_metrics)
+       (reset_api_method_metrics)
+       (get_api_session_costs)
+     )
 FC_API(graphene::app::login_api,
        (login)
        (block)
@@ -633,4 +817,5 @@ FC_API(graphene::app::login_api,
        (asset)
        (orders)
        (debug)
+       (metrics)
      )
@@ -23,6 +23,7 @@
  */
 #pragma once
 
+#include <fc/optional.hpp>
 #include <fc/reflect/reflect.hpp>
 
 #include <map>
@@ -31,11 +32,30 @@
 
 namespace graphene { namespace app {
 
+/**
+ * Costs of the API calls of a user and the rates at which they may be spent, see api_session_costs
+ *
+ * The cost of a call is the cost of its method, plus the time it took and the size of its response.
+ * A rate of 0 means no limit.
+ */
+struct api_throttle_config
+{
+   double connection_rate  = 0;   ///< cost per second each connection of the user may spend on average
+   double connection_burst = 0;   ///< cost a connection may spend at once after being idle
+   double user_rate        = 0;   ///< cost per second all connections of the user together may spend on average
+   double user_burst       = 0;
+   double default_method_cost = 1;
+   std::map< std::string, double > method_costs; ///< by method name, e.g. get_account_history
+   double cost_per_ms      = 1;
+   double cost_per_kib     = 0.1; ///< per KiB of response
+};
+
 struct api_access_info
 {
    std::string password_hash_b64;
    std::string password_salt_b64;
    std::vector< std::string > allowed_apis;
+   fc::optional< api_throttle_config > throttle;
 };
 
 struct api_access
@@ -45,10 +65,22 @@ struct api_access
 
 } } // graphene::app
 
+FC_REFLECT( graphene::app::api_throttle_config,
+    (connection_rate)
+    (connection_burst)
+    (user_rate)
+    (user_burst)
+    (default_method_cost)
+    (method_costs)
+    (cost_per_ms)
+    (cost_per_kib)
+   )
+
 FC_REFLECT( graphene::app::api_access_info,
     (password_hash_b64)
     (password_salt_b64)
     (allowed_apis)
+    (throttle)
    )
 
 FC_REFLECT( graphene::app::api_access,
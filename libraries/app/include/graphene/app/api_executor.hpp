@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/execution_profiler.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   using graphene::chain::execution_profile_entry;
+
+   /// Timing of the calls of one API method, all durations in nanoseconds
+   struct api_method_profile
+   {
+      std::string             method;
+      execution_profile_entry queue_wait; ///< from the call until the start of its execution, including lock waits
+      execution_profile_entry execution;
+   };
+
+   /**
+    * @brief Executes the read-only database API calls, optionally on a pool of threads
+    *
+    * By default the calls run inline on the calling thread, which is also the one applying blocks, so that a
+    * slow query delays block application and the other way round. With a thread count above 0, the calls run
+    * on a pool of threads instead, holding the chain access lock of the database shared, while block and
+    * transaction processing holds it exclusively only for as long as it changes the state. The calling task
+    * waits for the result without blocking its thread.
+    *
+    * Calls are spread over the threads in turn, so that the calls of a session, e.g. those of a JSON-RPC
+    * batch, may execute concurrently. Calls of one session are not ordered among each other, so every piece of
+    * session state a read-only call uses must be thread safe, see database_api_impl::run. Queue wait and
+    * execution times are recorded per method either way.
+    */
+   class api_executor
+   {
+      public:
+         typedef std::chrono::steady_clock clock;
+
+         /// @return the executor of the sessions on @p db, created when the first one asks for it
+         static std::shared_ptr<api_executor> get( graphene::chain::database& db );
+
+         explicit api_executor( graphene::chain::database& db );
+         ~api_executor();
+
+         /// Run the calls on @p count threads, or inline with 0. Must not be called while calls are executing.
+         void set_thread_count( uint16_t count );
+         size_t get_thread_count()const { return _threads.size(); }
+
+         /// Executes the read-only call @p f, waiting for its result
+         template< typename Function >
+         auto run( const char* method, Function&& f ) -> decltype( f() )
+         {
+            const clock::time_point queued = clock::now();
+            if( _threads.empty() )
+            {
+               call_timer timer( *this, method, queued );
+               return f();
+            }
+            return _threads[ _next_thread++ % _threads.size() ]->async( [this,method,queued,&f]() -> decltype( f() ) {
+               graphene::chain::chain_access_lock::read_guard guard( _db.get_chain_access_lock() );
+               call_timer timer( *this, method, queued );
+               return f();
+            }, method ).wait();
+         }
+
+         /// @return the timing of every method called since the last reset, by method name
+         std::vector< api_method_profile > get_profile()const;
+         void reset_profile();
+
+      private:
+         struct method_stats
+         {
+            graphene::chain::execution_stats queue_wait;
+            graphene::chain::execution_stats execution;
+         };
+
+         /// Records the queue wait and the execution time of the enclosing call
+         class call_timer
+         {
+            public:
+               call_timer( api_executor& executor, const char* method, clock::time_point queued );
+               ~call_timer();
+            private:
+               api_executor&     _executor;
+               const char*       _method;
+               clock::time_point _queued;
+               clock::time_point _started;
+         };
+
+         void record( const char* method, uint64_t queue_wait_ns, uint64_t execution_ns );
+
+         graphene::chain::database&                   _db;
+         std::vector< std::unique_ptr<fc::thread> >   _threads;
+         std::atomic<size_t>                          _next_thread{ 0 };
+         mutable std::mutex                           _stats_mutex;
+         std::map< std::string, method_stats >        _stats;
+   };
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::api_method_profile, (method)(queue_wait)(execution) )
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/execution_profiler.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   using graphene::chain::execution_profile_entry;
+
+   /// Escapes a label value of the Prometheus text exposition format
+   std::string prometheus_escape_label( const std::string& value );
+   /// Writes the HELP and TYPE lines of a metric in the Prometheus text exposition format
+   void write_prometheus_header( std::ostream& out, const char* name, const char* type, const char* help );
+
+   /// Calls of one API method over the websocket and HTTP endpoints
+   struct api_method_metrics
+   {
+      std::string             api;
+      std::string             method;
+      uint64_t                calls          = 0;
+      uint64_t                errors         = 0;
+      uint64_t                response_bytes = 0;
+      execution_profile_entry latency;       ///< from the arrival of the request until its response is ready
+   };
+
+   /**
+    * @brief Counts, errors, latencies and response sizes of the API calls of all connections
+    *
+    * The API connections record every call they dispatch, named after the API it was made on as the client
+    * requested it from the login API, e.g. database, history or block, and the method. The metrics are
+    * exposed in the Prometheus text exposition format along with a few chain metrics.
+    *
+    * Method names come from clients, so at most max_methods distinct ones are kept, further ones are
+    * recorded as method "other".
+    */
+   class api_metrics
+   {
+      public:
+         static const size_t max_methods = 1000;
+         static const size_t latency_bucket_count = 16;
+         /// Upper bounds of the latency histogram exposed to Prometheus, in nanoseconds
+         static const std::array< uint64_t, latency_bucket_count > latency_bounds_ns;
+
+         void record( const std::string& api, const std::string& method, uint64_t latency_ns,
+                      uint64_t response_bytes, bool error );
+
+         /// @return the metrics of every method called since the last reset, by API and method name
+         std::vector< api_method_metrics > get_metrics()const;
+         void reset();
+
+         /// @return the API metrics and the head block, pending transaction and undo metrics of @p db
+         std::string to_prometheus( const graphene::chain::database& db )const;
+
+      private:
+         struct method_stats
+         {
+            graphene::chain::execution_stats                latency;
+            uint64_t                                        errors         = 0;
+            uint64_t                                        response_bytes = 0;
+            std::array< uint64_t, latency_bucket_count >    buckets{};
+         };
+
+         mutable std::mutex                                               _mutex;
+         std::map< std::pair< std::string, std::string >, method_stats >  _stats;
+   };
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::api_method_metrics, (api)(method)(calls)(errors)(response_bytes)(latency) )
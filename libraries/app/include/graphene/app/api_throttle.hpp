@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/app/api_access.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   /// Spent and throttled API calls of a connection, or of all connections of a user
+   struct api_cost_info
+   {
+      uint64_t    session_id = 0; ///< 0 for the totals of a user
+      std::string user;
+      uint64_t    calls      = 0;
+      uint64_t    throttled  = 0; ///< calls rejected because the connection or the user ran out of budget
+      double      cost       = 0;
+      double      available  = 0; ///< cost which may be spent right now, as long as limited
+      bool        limited    = false;
+   };
+
+   /**
+    * @brief A budget refilled at a constant rate up to a maximum
+    *
+    * Calls are admitted as long as the budget is positive, and charged when their cost is known, so that the
+    * budget may become negative after an expensive call and has to be refilled before the next one.
+    */
+   class token_bucket
+   {
+      public:
+         token_bucket( double rate, double burst );
+
+         bool is_limited()const { return _rate > 0; }
+         bool can_spend( fc::time_point now );
+         void spend( double cost, fc::time_point now );
+         double available( fc::time_point now )const;
+         /// Limits the budget to what is left of @p previous, including its debt, unless that is unlimited
+         void continue_from( const token_bucket& previous, fc::time_point now );
+
+      private:
+         void refill( fc::time_point now );
+         /// @return the budget at @p now, negative while in debt
+         double balance( fc::time_point now )const;
+
+         double         _rate;
+         double         _burst;
+         double         _tokens;
+         fc::time_point _updated;
+   };
+
+   class api_cost_registry;
+
+   /**
+    * @brief Cost accounting and throttling of the API calls of one connection
+    *
+    * A connection is limited by its own token bucket and by the one of its user, both configured in the
+    * throttle section of the user in the api-access file. All connections of a user share the user bucket,
+    * which for the "*" user means all clients which logged in as a user without an entry of its own. HTTP
+    * requests open a connection each, so only the user limits apply to them.
+    */
+   class api_session_costs
+   {
+      public:
+         api_session_costs( std::shared_ptr<api_cost_registry> registry, uint64_t id );
+         ~api_session_costs();
+
+         /**
+          * Applies the limits of @p user, called when the connection logs in
+          *
+          * @p user names the api-access entry the limits are configured in, i.e. "*" for users without one. Logging
+          * in again as the same user keeps the budget of the connection, and switching users never raises it.
+          */
+         void set_user( const std::string& user, const fc::optional<api_throttle_config>& config );
+
+         bool is_limited()const;
+
+         /// @return whether a call of @p method may execute now, if so its method cost is charged
+         bool admit( const std::string& method );
+         /// Charges the time and the response size of an admitted call
+         void charge( uint64_t latency_ns, uint64_t response_bytes );
+
+         api_cost_info get_info()const;
+
+      private:
+         struct user_costs;
+         friend class api_cost_registry;
+
+         void spend( double cost, fc::time_point now );
+
+         std::shared_ptr<api_cost_registry>     _registry;
+         const uint64_t                         _id;
+         mutable std::mutex                     _mutex;
+         std::string                            _user;
+         api_throttle_config                    _config;
+         token_bucket                           _bucket;
+         std::shared_ptr<user_costs>            _user_costs;
+         uint64_t                               _calls     = 0;
+         uint64_t                               _throttled = 0;
+         double                                 _cost      = 0;
+   };
+
+   /**
+    * @brief The costs of all API connections and users of the node
+    */
+   class api_cost_registry : public std::enable_shared_from_this<api_cost_registry>
+   {
+      public:
+         std::shared_ptr<api_session_costs> new_session();
+
+         /// @return the costs of the open connections, followed by the totals per user
+         std::vector<api_cost_info> get_costs()const;
+
+         /// @return the costs in the Prometheus text exposition format
+         std::string to_prometheus()const;
+
+      private:
+         friend class api_session_costs;
+
+         std::shared_ptr<api_session_costs::user_costs> get_user( const std::string& user,
+                                                                  const fc::optional<api_throttle_config>& config );
+         void remove_session( uint64_t id );
+
+         mutable std::mutex                                                   _mutex;
+         uint64_t                                                             _next_id = 1;
+         std::map< uint64_t, std::weak_ptr<api_session_costs> >               _sessions;
+         std::map< std::string, std::shared_ptr<api_session_costs::user_costs> > _users;
+   };
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::api_cost_info, (session_id)(user)(calls)(throttled)(cost)(available)(limited) )
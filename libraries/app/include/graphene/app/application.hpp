@@ -34,6 +34,8 @@ namespace graphene { namespace app {
    using std::string;
 
    class abstract_plugin;
+   class api_metrics;
+   class api_cost_registry;
 
    class application_options
    {
@@ -93,6 +95,8 @@ namespace graphene { namespace app {
 
          void set_block_production(bool producing_blocks);
          fc::optional< api_access_info > get_api_access_info( const string& username )const;
+         /// @return whether @p username has access of its own, rather than the one of "*" granted to unknown users
+         bool has_own_api_access_info( const string& username )const;
          void set_api_access_info(const string& username, api_access_info&& permissions);
 
          bool is_finished_syncing()const;
@@ -101,6 +105,11 @@ namespace graphene { namespace app {
 
          const application_options& get_options();
 
+         /// @return the metrics of the API calls, null unless api-metrics-endpoint is set
+         std::shared_ptr<api_metrics> get_api_metrics()const;
+         /// @return the costs of the API calls of all connections and users
+         std::shared_ptr<api_cost_registry> get_api_cost_registry()const;
+
          void enable_plugin( const string& name );
 
       private:
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/app/api_metrics.hpp>
+#include <graphene/app/api_throttle.hpp>
+
+#include <fc/network/http/websocket.hpp>
+#include <fc/rpc/websocket_api.hpp>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace graphene { namespace app {
+
+   /**
+    * @brief A websocket and HTTP API connection which also accepts JSON-RPC 2.0 batch requests
+    *
+    * A batch is a JSON array of requests, answered with one array of the responses in a single frame. The calls
+    * of a batch are started in order, each in its own task, so that read-only calls, which the @ref api_executor
+    * runs on its threads if configured, execute concurrently. The responses come in the order of the requests,
+    * notifications, i.e. requests without an id, get none. Elements of a batch which are no valid request, e.g.
+    * which lack a method or have a non-integer id, are answered with error code -32600. Single requests are handled
+    * as before.
+    *
+    * If given @ref api_metrics, the connection records every call, single or in a batch, under the name of the
+    * API it was made on. The names of the APIs returned by the login API are learned from its responses.
+    *
+    * If given @ref api_session_costs, calls are accounted and, once the connection or its user ran out of budget,
+    * rejected with error code -32005 before they execute. Calls are accounted while metrics are recorded or the
+    * connection is throttled.
+    */
+   class batch_api_connection : public fc::rpc::websocket_api_connection
+   {
+      public:
+         /// Number of requests a batch may contain at most
+         static const size_t max_batch_size = 100;
+
+         batch_api_connection( fc::http::websocket_connection& c, uint32_t max_conversion_depth,
+                               std::shared_ptr<api_metrics> metrics = std::shared_ptr<api_metrics>(),
+                               std::shared_ptr<api_session_costs> costs = std::shared_ptr<api_session_costs>() );
+
+         /// Name the API registered as @p api_id in the metrics
+         void set_api_name( uint64_t api_id, const std::string& name );
+
+         /**
+          * @param message a single request or a batch
+          * @param send_message whether to send the response over the websocket, rather than only return it
+          * @return the response to @p message, empty if there is none
+          */
+         std::string handle_message( const std::string& message, bool send_message );
+
+      private:
+         typedef std::chrono::steady_clock clock;
+
+         std::string handle_batch( const std::string& message );
+         std::string handle_request( const fc::variant& request );
+         /**
+          * Executes @p request unless throttled and records it in the metrics
+          * @param message @p request as it was received, empty if it is to be serialized again when needed
+          */
+         std::string dispatch( const fc::variant& request, const std::string& message, bool send_message );
+         /**
+          * Executes a call which has already been parsed and answers it like on_message
+          * @param result set to the result of the call if it succeeded
+          * @param error set to whether the call failed
+          * @return the response, empty for a notification
+          */
+         std::string execute( const fc::rpc::request& call, bool send_message, fc::variant& result, bool& error );
+         std::string api_name( const fc::variant& api )const;
+         bool is_accounted()const;
+
+         uint32_t                           _max_depth;
+         std::shared_ptr<api_metrics>       _metrics;
+         std::shared_ptr<api_session_costs> _costs;
+         std::map<uint64_t, std::string>    _api_names;
+   };
+
+} } // graphene::app
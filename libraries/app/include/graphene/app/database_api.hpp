@@ -24,6 +24,8 @@
 #pragma once
 
 #include <graphene/app/full_account.hpp>
+#include <graphene/app/order_book_feed.hpp>
+#include <graphene/app/packed_encoding.hpp>
 
 #include <graphene/chain/protocol/types.hpp>
 
@@ -160,6 +162,10 @@ class database_api
        *        newly removed objects to the client, no matter whether client subscribed to the objects.
        *        By default, API servers don't allow subscribing to universal events, which can be changed
        *        on server startup.
+       *
+       * Once registered, the objects returned by the API calls are subscribed to. A session can be subscribed
+       * to at most api-max-subscribed-objects objects, 10000 by default. Objects returned after that are not
+       * subscribed to until the subscriptions are cancelled or the callback is registered again.
        */
       void set_subscribe_callback( std::function<void(const variant&)> cb, bool notify_remove_create );
       /**
@@ -176,6 +182,13 @@ class database_api
        * @param cb The callback handle to register
        */
       void set_block_applied_callback( std::function<void(const variant& block_id)> cb );
+      /**
+       * @brief Choose how objects and transactions are sent to the callbacks of this connection
+       * @param encoding json by default; with packed, every changed object, changed order of a subscribed market
+       *        and pending transaction is sent as @ref packed_data, the ids of removed objects are still sent
+       *        as ids
+       */
+      void set_notification_encoding( api_encoding encoding );
       /**
        * @brief Stop receiving any notifications
        *
@@ -435,6 +448,12 @@ class database_api
        */
       vector<limit_order_object> get_limit_orders(std::string a, std::string b, uint32_t limit)const;
 
+      /**
+       * @brief Get limit orders in a given market, in the binary format
+       * @return The result of @ref get_limit_orders as a packed vector<limit_order_object>
+       */
+      packed_data get_limit_orders_packed(std::string a, std::string b, uint32_t limit)const;
+
       /**
        * @brief Get call orders in a given asset
        * @param a Symbol or ID of asset being called
@@ -484,6 +503,36 @@ class database_api
        */
       void unsubscribe_from_market( const std::string& a, const std::string& b );
 
+      /**
+       * @brief Request the changed price levels of the limit order book of a market after every block
+       * @param callback Callback method which is called with an @ref order_book_delta
+       * @param a First asset Symbol or ID
+       * @param b Second asset Symbol or ID
+       *
+       * Deltas carry the new total amount for sale at each changed price, 0 when the price level is gone,
+       * and are numbered consecutively per market. Subscribe first, then fetch a snapshot with
+       * @ref get_order_book_snapshot, drop the deltas not above its sequence and apply the others. Fetch a
+       * new snapshot whenever a sequence number is skipped.
+       */
+      void subscribe_to_order_book_deltas( std::function<void(const variant&)> callback,
+                                           const std::string& a, const std::string& b );
+
+      /**
+       * @brief Unsubscribe from the order book deltas of a given market
+       * @param a First asset Symbol or ID
+       * @param b Second asset Symbol or ID
+       */
+      void unsubscribe_from_order_book_deltas( const std::string& a, const std::string& b );
+
+      /**
+       * @brief Get all price levels of the limit order book of a market, to apply order book deltas to
+       * @param a First asset Symbol or ID
+       * @param b Second asset Symbol or ID
+       * @return The levels of the market as of the sequence of the last delta, which is 0 when the session
+       *         is not subscribed to the deltas of the market
+       */
+      order_book_snapshot get_order_book_snapshot( const std::string& a, const std::string& b )const;
+
       /**
        * @brief Returns the ticker for the market assetA:assetB
        * @param a String name of the first asset
@@ -764,6 +813,7 @@ FC_API(graphene::app::database_api,
    (set_subscribe_callback)
    (set_pending_transaction_callback)
    (set_block_applied_callback)
+   (set_notification_encoding)
    (cancel_all_subscriptions)
 
    // Blocks and transactions
@@ -811,6 +861,7 @@ FC_API(graphene::app::database_api,
    // Markets / feeds
    (get_order_book)
    (get_limit_orders)
+   (get_limit_orders_packed)
    (get_account_limit_orders)
    (get_call_orders)
    (get_settle_orders)
@@ -818,6 +869,9 @@ FC_API(graphene::app::database_api,
    (get_collateral_bids)
    (subscribe_to_market)
    (unsubscribe_from_market)
+   (subscribe_to_order_book_deltas)
+   (unsubscribe_from_order_book_deltas)
+   (get_order_book_snapshot)
    (get_ticker)
    (get_24_volume)
    (get_top_markets)
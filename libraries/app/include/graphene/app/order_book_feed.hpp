@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/app/subscription_registry.hpp>
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/variant.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   using graphene::chain::price;
+   using graphene::chain::share_type;
+
+   /// The total amount for sale by the limit orders at one price
+   struct order_book_level
+   {
+      price      level_price; ///< the sell price of the orders, its base asset is the one for sale
+      share_type for_sale;    ///< 0 if the last order at this price is gone
+   };
+
+   /// The price levels of a market which changed in a block
+   struct order_book_delta
+   {
+      asset_id_type              base;      ///< the lower asset id of the market
+      asset_id_type              quote;     ///< the higher asset id of the market
+      uint64_t                   sequence  = 0; ///< one more than the sequence of the previous delta of the market
+      uint32_t                   block_num = 0;
+      vector<order_book_level>   levels;
+   };
+
+   /// All price levels of a market, as of a delta sequence number
+   struct order_book_snapshot
+   {
+      asset_id_type              base;
+      asset_id_type              quote;
+      uint64_t                   sequence  = 0; ///< the sequence of the last delta included in the snapshot
+      uint32_t                   block_num = 0;
+      vector<order_book_level>   levels;    ///< the levels selling base, then those selling quote, by ascending price
+   };
+
+   /**
+    * @brief Publishes the changed price levels of the limit order books of subscribed markets, once per block
+    *
+    * The feed keeps the aggregated price levels of every market with at least one subscriber, as of the
+    * last applied block. After each block it recomputes the levels at the prices of the limit orders which
+    * were created, filled or cancelled, and sends each subscriber of the market one delta with the new
+    * totals of the levels which changed. Deltas of a market are numbered consecutively.
+    *
+    * A client keeps its depth current as follows:
+    *  1. subscribe to the market and buffer the deltas received
+    *  2. fetch a snapshot, and drop the buffered deltas with a sequence not above the one of the snapshot
+    *  3. apply the remaining deltas by replacing the total of each level, removing the levels which reach 0
+    *  4. whenever a sequence number is skipped, e.g. after a reconnect, go back to step 2
+    *
+    * Pending transactions never appear in the feed. As popping blocks does not notify the changed objects,
+    * all levels of the subscribed markets are compared again with the order book at the first block
+    * following a chain reorganization, and when a market starts being followed.
+    */
+   class order_book_feed
+   {
+      public:
+         class subscriber
+         {
+            public:
+               virtual ~subscriber() {}
+               /// @param delta an @ref order_book_delta of @p market
+               virtual void on_order_book_delta( const market_type& market, const fc::variant& delta ) = 0;
+         };
+
+         /// @return the feed shared by the sessions on @p db, created when the first one asks for it
+         static std::shared_ptr<order_book_feed> get( graphene::chain::database& db );
+
+         explicit order_book_feed( graphene::chain::database& db );
+
+         /// @param market the pair of asset ids, lower one first
+         void subscribe( const std::shared_ptr<subscriber>& s, const market_type& market );
+         void unsubscribe( const subscriber* s, const market_type& market );
+         /// Removes all subscriptions of @p s
+         void remove( const subscriber* s );
+
+         /// @return the levels of a followed market, or of the current order book with sequence 0 otherwise
+         order_book_snapshot get_snapshot( const market_type& market )const;
+
+         size_t market_count()const;
+
+      private:
+         typedef std::map< price, share_type > level_map;
+         typedef vector< std::pair< std::shared_ptr<subscriber>, std::pair< market_type, fc::variant > > > delivery_list;
+
+         struct market_state
+         {
+            fc::flat_set<const subscriber*> subscribers;
+            level_map                       levels;
+            uint64_t                        sequence   = 0;
+            uint32_t                        block_num  = 0;
+            bool                            full_check = true; ///< compare all levels at the next block
+         };
+         struct subscriber_state
+         {
+            std::weak_ptr<subscriber>       session;
+            fc::flat_set<market_type>       markets;
+         };
+
+         void on_applied_block( const graphene::chain::signed_block& block );
+         void on_limit_orders_changed( const graphene::chain::database::object_changes& changes );
+         /// Sends the changed @p levels of @p market to its subscribers, unless there are none
+         void publish( const market_type& market, market_state& state, vector<order_book_level>&& levels,
+                       delivery_list& deliveries );
+         share_type level_total( const price& sell_price )const;
+         level_map current_levels( const market_type& market )const;
+         void remove_from_market( const subscriber* s, const market_type& market );
+         void update_connections();
+
+         graphene::chain::database&                       _db;
+         mutable std::mutex                               _mutex;
+         std::map< market_type, market_state >            _markets;
+         std::map< const subscriber*, subscriber_state >  _subscribers;
+         uint32_t                                         _last_block_num = 0;
+
+         boost::signals2::scoped_connection               _applied_block_connection;
+         boost::signals2::scoped_connection               _orders_connection;
+   };
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::order_book_level, (level_price)(for_sale) )
+FC_REFLECT( graphene::app::order_book_delta, (base)(quote)(sequence)(block_num)(levels) )
+FC_REFLECT( graphene::app::order_book_snapshot, (base)(quote)(sequence)(block_num)(levels) )
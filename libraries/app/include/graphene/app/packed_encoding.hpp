@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/db/object_id.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/variant.hpp>
+
+#include <vector>
+
+namespace graphene { namespace app {
+
+   using graphene::db::object_id_type;
+
+   /// Encoding of bulk API results and of subscription notifications
+   enum class api_encoding
+   {
+      json,   ///< objects as JSON, the default
+      packed  ///< objects in the fc::raw binary format, see @ref packed_data
+   };
+
+   /**
+    * @brief Values in the fc::raw binary format, as used on the p2p network and in the block log
+    *
+    * Packing a block or an object is a plain copy of its fields, whereas converting it to JSON builds a
+    * variant tree with a node per field first. Since the frames of the API connections are text, the bytes
+    * are returned as a single base64 string.
+    *
+    * Clients decode the values with @ref unpack_result or @ref unpack_data, using the same
+    * graphene::chain types as the node.
+    */
+   struct packed_data
+   {
+      std::vector<char> data;
+   };
+
+   template< typename T >
+   packed_data pack_data( const T& value )
+   {
+      packed_data result;
+      result.data = fc::raw::pack( value );
+      return result;
+   }
+
+   template< typename T >
+   T unpack_data( const packed_data& packed )
+   {
+      return fc::raw::unpack< T >( packed.data );
+   }
+
+   /// @return the value of type @p T in the result of an API call returning @ref packed_data
+   template< typename T >
+   T unpack_result( const fc::variant& result )
+   {
+      return unpack_data< T >( result.as< packed_data >( 1 ) );
+   }
+
+   /**
+    * @return the id of the packed object in a subscription notification, which tells its type
+    *
+    * Every object starts with its id, so that the object can be unpacked by a client which does not know
+    * in advance which object it is notified of.
+    */
+   object_id_type packed_object_id( const packed_data& packed );
+
+} } // graphene::app
+
+namespace fc {
+   void to_variant( const graphene::app::packed_data& packed, fc::variant& v, uint32_t max_depth = 1 );
+   void from_variant( const fc::variant& v, graphene::app::packed_data& packed, uint32_t max_depth = 1 );
+}
+
+FC_REFLECT_ENUM( graphene::app::api_encoding, (json)(packed) )
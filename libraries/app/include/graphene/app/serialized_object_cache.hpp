@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/variant.hpp>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   using graphene::db::object;
+   using graphene::db::object_id_type;
+
+   struct object_cache_stats
+   {
+      uint64_t hits          = 0;
+      uint64_t misses        = 0;
+      uint64_t invalidations = 0; ///< cached objects dropped because they were modified or removed
+      uint64_t evictions     = 0; ///< least recently used objects dropped to stay within the capacity
+      uint64_t size          = 0;
+      uint64_t capacity      = 0;
+   };
+
+   /**
+    * @brief Keeps the variant representation of the objects recently returned by the API
+    *
+    * API sessions convert the same popular objects, like the global properties, the core asset or busy
+    * accounts, for every request and every subscription update. The cache converts an object once and
+    * hands out copies of its variant, which share the contents, until the object is modified or removed.
+    *
+    * The cache observes all indexes which exist when it is created, so that a change made by a block, a
+    * pending transaction or an undo drops the cached variant right away. Objects of indexes added later
+    * are converted every time.
+    */
+   class serialized_object_cache : public graphene::db::index_observer
+   {
+      public:
+         static const size_t default_capacity = 10000;
+
+         /// @return the cache of the objects in @p db, attached to its indexes when first asked for
+         static std::shared_ptr<serialized_object_cache> get( graphene::chain::database& db );
+
+         serialized_object_cache();
+
+         /// @return the variant representation of @p obj, as obj.to_variant()
+         fc::variant to_variant( const object& obj );
+
+         /// Keep at most @p capacity objects, the least recently used ones are evicted first, 0 disables the cache
+         void set_capacity( size_t capacity );
+
+         object_cache_stats get_stats()const;
+         void reset_stats();
+
+         virtual void on_add( const object& obj ) override;
+         virtual void on_remove( const object& obj ) override;
+         virtual void on_modify( const object& obj ) override;
+
+      private:
+         static const size_t type_count = 1 << 16;
+
+         typedef std::list< std::pair< object_id_type, fc::variant > > lru_list;
+
+         void invalidate( object_id_type id );
+         void evict_to( size_t size );
+
+         mutable std::mutex                                            _mutex;
+         size_t                                                        _capacity = default_capacity;
+         /// The cached variants, most recently used first
+         lru_list                                                      _lru;
+         std::unordered_map< object_id_type, lru_list::iterator >      _variants;
+         object_cache_stats                                            _stats;
+
+         /// Types of the observed indexes, by object_id_type::space_type()
+         std::vector<bool>                                             _observed_types;
+         /// Types of which any object has been cached, modifications of other types skip the lock
+         std::unique_ptr< std::atomic<bool>[] >                        _cached_types;
+   };
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::object_cache_stats, (hits)(misses)(invalidations)(evictions)(size)(capacity) )
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/variant.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   using graphene::chain::account_id_type;
+   using graphene::chain::asset_id_type;
+   using graphene::db::object;
+   using graphene::db::object_id_type;
+
+   class serialized_object_cache;
+
+   typedef std::pair< asset_id_type, asset_id_type >           market_type;
+   typedef std::map< market_type, std::vector<fc::variant> >   market_queue_type;
+
+   /**
+    * @brief Matches the changed objects of every block against the subscriptions of all API sessions
+    *
+    * All sessions on a database share one registry, which is the only one among them to listen to the
+    * new_objects, changed_objects and removed_objects signals. It maps object ids, accounts and markets
+    * to the interested sessions, so that the work per block grows with the number of changes and of
+    * matching sessions rather than with the number of connected sessions, and every changed object is
+    * converted once per encoding no matter how many sessions receive it.
+    *
+    * Subscribers are identified by their address and held through weak pointers, a subscriber has to
+    * remove itself before it is destroyed.
+    */
+   class subscription_registry
+   {
+      public:
+         /// An API session receiving the updates which match its subscriptions
+         class subscriber
+         {
+            public:
+               virtual ~subscriber() {}
+               /// Changed objects, or ids of removed objects, matching the object subscriptions
+               virtual void on_object_updates( const std::vector<fc::variant>& updates ) = 0;
+               /// Changed orders of the subscribed markets
+               virtual void on_market_updates( const market_queue_type& queue ) = 0;
+               /// Whether changed objects are sent to this subscriber in the binary format, see @ref packed_data
+               virtual bool wants_packed_updates()const { return false; }
+         };
+
+         /// Object ids a single subscriber can subscribe to unless configured otherwise, see
+         /// @ref set_max_objects_per_subscriber
+         static const size_t default_max_objects_per_subscriber = 10000;
+
+         /// @return the registry shared by the sessions on @p db, created when the first one asks for it
+         static std::shared_ptr<subscription_registry> get( graphene::chain::database& db );
+
+         explicit subscription_registry( graphene::chain::database& db );
+
+         /// Registers @p s for object updates, replacing its previous object subscriptions
+         void subscribe_to_objects( const std::shared_ptr<subscriber>& s, bool notify_remove_create );
+         /// The following do nothing unless @p s is registered for object updates
+         ///@{
+         /// Once @p s is subscribed to the maximum number of objects, further ones are not added, and a warning is logged
+         void subscribe_to_object( const subscriber* s, object_id_type id );
+         void subscribe_to_account( const subscriber* s, account_id_type account );
+         ///@}
+         void cancel_object_subscriptions( const subscriber* s );
+
+         void subscribe_to_market( const std::shared_ptr<subscriber>& s, const market_type& market );
+         void unsubscribe_from_market( const subscriber* s, const market_type& market );
+         void cancel_market_subscriptions( const subscriber* s );
+
+         /// Removes all subscriptions of @p s
+         void remove( const subscriber* s );
+
+         size_t subscriber_count()const;
+
+         /// Limits the object ids a single subscriber can subscribe to, so that the registry can not grow without bound
+         void set_max_objects_per_subscriber( size_t max_objects );
+         size_t get_max_objects_per_subscriber()const;
+
+      private:
+         struct subscriber_state
+         {
+            std::weak_ptr<subscriber>          session;
+            bool                               objects = false; ///< whether registered for object updates
+            bool                               notify_remove_create = false;
+            bool                               objects_capped = false; ///< whether ids were not added for the limit
+            std::unordered_set<object_id_type> ids;
+            fc::flat_set<account_id_type>      accounts;
+            fc::flat_set<market_type>          markets;
+         };
+         typedef fc::flat_set<const subscriber*> subscriber_set;
+
+         void on_objects_changed( const std::vector<object_id_type>& ids, const fc::flat_set<account_id_type>& impacted_accounts,
+                                  bool created_or_removed, bool full_object,
+                                  const std::function<const object*(size_t)>& object_at );
+         void remove_object_subscriptions( const subscriber* s, subscriber_state& state );
+         void remove_market_subscriptions( const subscriber* s, subscriber_state& state );
+         void erase_if_unused( const subscriber* s );
+         void update_impacted_accounts_request();
+
+         graphene::chain::database&                           _db;
+         std::shared_ptr<serialized_object_cache>             _object_cache;
+         mutable std::mutex                                   _mutex;
+         size_t                                               _max_objects_per_subscriber
+                                                                 = default_max_objects_per_subscriber;
+         std::map< const subscriber*, subscriber_state >      _subscribers;
+         std::unordered_map< object_id_type, subscriber_set > _by_object;
+         std::map< account_id_type, subscriber_set >          _by_account;
+         std::map< market_type, subscriber_set >              _by_market;
+         subscriber_set                                       _remove_create;
+         /// Held while any subscriber is subscribed to an account
+         std::shared_ptr<void>                                _impacted_accounts_request;
+
+         boost::signals2::scoped_connection                   _new_connection;
+         boost::signals2::scoped_connection                   _change_connection;
+         boost::signals2::scoped_connection                   _removed_connection;
+   };
+
+} } // graphene::app
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/order_book_feed.hpp>
+
+#include <graphene/chain/limit_order_book.hpp>
+#include <graphene/chain/market_object.hpp>
+
+namespace graphene { namespace app {
+
+using namespace graphene::chain;
+
+namespace {
+
+   typedef vector< std::pair< std::shared_ptr<order_book_feed::subscriber>,
+                              std::pair< market_type, fc::variant > > > delivery_list;
+
+   void deliver( const delivery_list& deliveries )
+   {
+      for( const auto& item : deliveries )
+         item.first->on_order_book_delta( item.second.first, item.second.second );
+   }
+
+   vector<order_book_level> to_levels( const std::map< price, share_type >& levels )
+   {
+      vector<order_book_level> result;
+      result.reserve( levels.size() );
+      for( const auto& item : levels )
+         result.push_back( order_book_level{ item.first, item.second } );
+      return result;
+   }
+
+} // anonymous namespace
+
+std::shared_ptr<order_book_feed> order_book_feed::get( database& db )
+{
+   static std::mutex feeds_mutex;
+   static std::map< const database*, std::weak_ptr<order_book_feed> > feeds;
+
+   std::lock_guard<std::mutex> guard( feeds_mutex );
+   std::shared_ptr<order_book_feed> feed = feeds[ &db ].lock();
+   if( !feed )
+   {
+      for( auto itr = feeds.begin(); itr != feeds.end(); )
+      {
+         if( itr->second.expired() )
+            itr = feeds.erase( itr );
+         else
+            ++itr;
+      }
+      feed = std::make_shared<order_book_feed>( db );
+      feeds[ &db ] = feed;
+   }
+   return feed;
+}
+
+order_book_feed::order_book_feed( database& db ) : _db( db ) {}
+
+void order_book_feed::subscribe( const std::shared_ptr<subscriber>& s, const market_type& market )
+{
+   FC_ASSERT( market.first < market.second, "The assets of a market must be distinct and in ascending order" );
+   std::lock_guard<std::mutex> guard( _mutex );
+   subscriber_state& sub = _subscribers[ s.get() ];
+   sub.session = s;
+   if( !sub.markets.insert( market ).second )
+      return;
+   auto itr = _markets.find( market );
+   if( itr == _markets.end() )
+   {
+      // the order book may include pending transactions, the first block compares all levels again
+      market_state& state = _markets[ market ];
+      state.levels = current_levels( market );
+      state.block_num = _db.head_block_num();
+      itr = _markets.find( market );
+   }
+   itr->second.subscribers.insert( s.get() );
+   update_connections();
+}
+
+void order_book_feed::unsubscribe( const subscriber* s, const market_type& market )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( s );
+   if( itr == _subscribers.end() || itr->second.markets.erase( market ) == 0 )
+      return;
+   remove_from_market( s, market );
+   if( itr->second.markets.empty() )
+      _subscribers.erase( itr );
+   update_connections();
+}
+
+void order_book_feed::remove( const subscriber* s )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( s );
+   if( itr == _subscribers.end() )
+      return;
+   for( const market_type& market : itr->second.markets )
+      remove_from_market( s, market );
+   _subscribers.erase( itr );
+   update_connections();
+}
+
+order_book_snapshot order_book_feed::get_snapshot( const market_type& market )const
+{
+   order_book_snapshot result;
+   result.base = market.first;
+   result.quote = market.second;
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _markets.find( market );
+   if( itr == _markets.end() )
+   {
+      result.block_num = _db.head_block_num();
+      result.levels = to_levels( current_levels( market ) );
+   }
+   else
+   {
+      result.sequence = itr->second.sequence;
+      result.block_num = itr->second.block_num;
+      result.levels = to_levels( itr->second.levels );
+   }
+   return result;
+}
+
+size_t order_book_feed::market_count()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   return _markets.size();
+}
+
+void order_book_feed::remove_from_market( const subscriber* s, const market_type& market )
+{
+   auto itr = _markets.find( market );
+   if( itr == _markets.end() )
+      return;
+   itr->second.subscribers.erase( s );
+   if( itr->second.subscribers.empty() )
+      _markets.erase( itr );
+}
+
+void order_book_feed::update_connections()
+{
+   if( _markets.empty() )
+   {
+      _applied_block_connection.disconnect();
+      _orders_connection.disconnect();
+   }
+   else if( !_applied_block_connection.connected() )
+   {
+      _last_block_num = _db.head_block_num();
+      _applied_block_connection = _db.applied_block.connect( [this]( const signed_block& block ) {
+         on_applied_block( block );
+      });
+      _orders_connection = _db.subscribe_to_object_changes<limit_order_object>(
+         [this]( const database::object_changes& changes ) {
+            on_limit_orders_changed( changes );
+         });
+   }
+}
+
+share_type order_book_feed::level_total( const price& sell_price )const
+{
+   share_type total = 0;
+   const limit_order_book_index::price_level* level = _db.get_limit_order_book().find_level( sell_price );
+   if( level != nullptr )
+      for( const limit_order_object* order : level->orders )
+         total += order->for_sale;
+   return total;
+}
+
+order_book_feed::level_map order_book_feed::current_levels( const market_type& market )const
+{
+   level_map result;
+   const limit_order_book_index& book = _db.get_limit_order_book();
+   for( const auto* side : { book.find_side( market.first, market.second ), book.find_side( market.second, market.first ) } )
+   {
+      if( side == nullptr )
+         continue;
+      for( const auto& level : *side )
+      {
+         share_type total = 0;
+         for( const limit_order_object* order : level.orders )
+            total += order->for_sale;
+         result.emplace_hint( result.end(), level.level_price, total );
+      }
+   }
+   return result;
+}
+
+void order_book_feed::publish( const market_type& market, market_state& state, vector<order_book_level>&& levels,
+                               delivery_list& deliveries )
+{
+   state.block_num = _db.head_block_num();
+   if( levels.empty() )
+      return;
+   ++state.sequence;
+   order_book_delta delta;
+   delta.base = market.first;
+   delta.quote = market.second;
+   delta.sequence = state.sequence;
+   delta.block_num = state.block_num;
+   delta.levels = std::move( levels );
+   // converted once for all of the subscribers
+   const fc::variant value( delta, GRAPHENE_MAX_NESTED_OBJECTS );
+   for( const subscriber* s : state.subscribers )
+      if( auto session = _subscribers[ s ].session.lock() )
+         deliveries.emplace_back( std::move( session ), std::make_pair( market, value ) );
+}
+
+void order_book_feed::on_applied_block( const signed_block& block )
+{
+   delivery_list deliveries;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      const uint32_t block_num = block.block_num();
+      // a block which is not above the previous one follows popped blocks, whose changes were not notified
+      const bool reorganized = block_num <= _last_block_num;
+      _last_block_num = block_num;
+      for( auto& item : _markets )
+      {
+         market_state& state = item.second;
+         if( !state.full_check && !reorganized )
+            continue;
+         state.full_check = false;
+         level_map levels = current_levels( item.first );
+         vector<order_book_level> changed;
+         for( const auto& level : levels )
+         {
+            auto old = state.levels.find( level.first );
+            if( old == state.levels.end() || old->second != level.second )
+               changed.push_back( order_book_level{ level.first, level.second } );
+         }
+         for( const auto& level : state.levels )
+            if( levels.find( level.first ) == levels.end() )
+               changed.push_back( order_book_level{ level.first, 0 } );
+         state.levels = std::move( levels );
+         publish( item.first, state, std::move( changed ), deliveries );
+      }
+   }
+   deliver( deliveries );
+}
+
+void order_book_feed::on_limit_orders_changed( const database::object_changes& changes )
+{
+   delivery_list deliveries;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      if( _markets.empty() )
+         return;
+
+      // the prices touched in each followed market, the price of a limit order never changes
+      std::map< market_type, std::set<price> > touched;
+      auto touch = [this,&touched]( const object* obj ) {
+         if( obj == nullptr )
+            return;
+         const limit_order_object& order = static_cast<const limit_order_object&>( *obj );
+         const market_type market = order.get_market();
+         if( _markets.find( market ) != _markets.end() )
+            touched[ market ].insert( order.sell_price );
+      };
+      for( const object_id_type& id : changes.new_ids )
+         touch( _db.find_object( id ) );
+      for( const object_id_type& id : changes.changed_ids )
+         touch( _db.find_object( id ) );
+      for( const object* obj : changes.removed )
+         touch( obj );
+
+      for( const auto& item : touched )
+      {
+         market_state& state = _markets[ item.first ];
+         vector<order_book_level> changed;
+         for( const price& sell_price : item.second )
+         {
+            const share_type total = level_total( sell_price );
+            auto old = state.levels.find( sell_price );
+            if( old == state.levels.end() )
+            {
+               if( total > 0 )
+               {
+                  state.levels.emplace( sell_price, total );
+                  changed.push_back( order_book_level{ sell_price, total } );
+               }
+            }
+            else if( old->second != total )
+            {
+               // the level keeps the price it was first published with
+               changed.push_back( order_book_level{ old->first, total } );
+               if( total > 0 )
+                  old->second = total;
+               else
+                  state.levels.erase( old );
+            }
+         }
+         publish( item.first, state, std::move( changed ), deliveries );
+      }
+   }
+   deliver( deliveries );
+}
+
+} } // graphene::app
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/packed_encoding.hpp>
+
+#include <fc/crypto/base64.hpp>
+
+namespace graphene { namespace app {
+
+object_id_type packed_object_id( const packed_data& packed )
+{
+   fc::datastream<const char*> ds( packed.data.data(), packed.data.size() );
+   object_id_type id;
+   fc::raw::unpack( ds, id );
+   return id;
+}
+
+} } // graphene::app
+
+namespace fc {
+
+void to_variant( const graphene::app::packed_data& packed, fc::variant& v, uint32_t max_depth )
+{
+   v = fc::base64_encode( (const unsigned char*)packed.data.data(), packed.data.size() );
+}
+
+void from_variant( const fc::variant& v, graphene::app::packed_data& packed, uint32_t max_depth )
+{
+   const std::string bytes = fc::base64_decode( v.get_string() );
+   packed.data.assign( bytes.begin(), bytes.end() );
+}
+
+} // fc
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/serialized_object_cache.hpp>
+
+#include <map>
+
+namespace graphene { namespace app {
+
+using graphene::chain::database;
+
+std::shared_ptr<serialized_object_cache> serialized_object_cache::get( database& db )
+{
+   static std::mutex caches_mutex;
+   static std::map< const database*, std::weak_ptr<serialized_object_cache> > caches;
+
+   // the indexes hold the cache for as long as the database exists
+   std::lock_guard<std::mutex> guard( caches_mutex );
+   std::shared_ptr<serialized_object_cache> cache = caches[ &db ].lock();
+   if( !cache )
+   {
+      for( auto itr = caches.begin(); itr != caches.end(); )
+      {
+         if( itr->second.expired() )
+            itr = caches.erase( itr );
+         else
+            ++itr;
+      }
+      cache = std::make_shared<serialized_object_cache>();
+      db.inspect_all_indexes( [&cache]( graphene::db::index& idx ) {
+         idx.add_observer( cache );
+         cache->_observed_types[ object_id_type( idx.object_space_id(), idx.object_type_id(), 0 ).space_type() ] = true;
+      });
+      caches[ &db ] = cache;
+   }
+   return cache;
+}
+
+serialized_object_cache::serialized_object_cache()
+   : _observed_types( type_count, false ), _cached_types( new std::atomic<bool>[ type_count ]() ) {}
+
+fc::variant serialized_object_cache::to_variant( const object& obj )
+{
+   const uint16_t type = obj.id.space_type();
+   if( !_observed_types[ type ] )
+      return obj.to_variant();
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      if( _capacity == 0 )
+         return obj.to_variant();
+      auto itr = _variants.find( obj.id );
+      if( itr != _variants.end() )
+      {
+         ++_stats.hits;
+         _lru.splice( _lru.begin(), _lru, itr->second );
+         return itr->second->second;
+      }
+      ++_stats.misses;
+   }
+
+   fc::variant result = obj.to_variant();
+
+   std::lock_guard<std::mutex> guard( _mutex );
+   if( _capacity == 0 )
+      return result;
+   // another session may have cached the object meanwhile
+   auto itr = _variants.find( obj.id );
+   if( itr != _variants.end() )
+   {
+      _lru.splice( _lru.begin(), _lru, itr->second );
+      return result;
+   }
+   evict_to( _capacity - 1 );
+   _lru.emplace_front( obj.id, result );
+   _variants.emplace( obj.id, _lru.begin() );
+   _cached_types[ type ].store( true, std::memory_order_relaxed );
+   return result;
+}
+
+void serialized_object_cache::set_capacity( size_t capacity )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _capacity = capacity;
+   evict_to( _capacity );
+}
+
+void serialized_object_cache::evict_to( size_t size )
+{
+   while( _lru.size() > size )
+   {
+      _variants.erase( _lru.back().first );
+      _lru.pop_back();
+      ++_stats.evictions;
+   }
+}
+
+object_cache_stats serialized_object_cache::get_stats()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   object_cache_stats result = _stats;
+   result.size = _variants.size();
+   result.capacity = _capacity;
+   return result;
+}
+
+void serialized_object_cache::reset_stats()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _stats = object_cache_stats();
+}
+
+void serialized_object_cache::on_add( const object& obj )
+{
+   // the id of an object removed by an undo can be taken again
+   invalidate( obj.id );
+}
+
+void serialized_object_cache::on_remove( const object& obj )
+{
+   invalidate( obj.id );
+}
+
+void serialized_object_cache::on_modify( const object& obj )
+{
+   invalidate( obj.id );
+}
+
+void serialized_object_cache::invalidate( object_id_type id )
+{
+   if( !_cached_types[ id.space_type() ].load( std::memory_order_relaxed ) )
+      return;
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _variants.find( id );
+   if( itr == _variants.end() )
+      return;
+   _lru.erase( itr->second );
+   _variants.erase( itr );
+   ++_stats.invalidations;
+}
+
+} } // graphene::app
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/subscription_registry.hpp>
+#include <graphene/app/packed_encoding.hpp>
+#include <graphene/app/serialized_object_cache.hpp>
+
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+
+namespace graphene { namespace app {
+
+using namespace graphene::chain;
+
+namespace {
+
+   market_type get_order_market( const database&, const limit_order_object& order )
+   {
+      return order.get_market();
+   }
+
+   market_type get_order_market( const database&, const call_order_object& order )
+   {
+      return order.get_market();
+   }
+
+   market_type get_order_market( const database& db, const force_settlement_object& order )
+   {
+      asset_id_type backing_id = order.balance.asset_id( db ).bitasset_data( db ).options.short_backing_asset;
+      auto tmp = std::make_pair( order.balance.asset_id, backing_id );
+      if( tmp.first > tmp.second ) std::swap( tmp.first, tmp.second );
+      return tmp;
+   }
+
+   template<typename T>
+   optional<market_type> find_order_market( const database& db, const object* obj )
+   {
+      const T* order = dynamic_cast<const T*>( obj );
+      if( order == nullptr )
+         return {};
+      return get_order_market( db, *order );
+   }
+
+   optional<market_type> find_order_market( const database& db, object_id_type id, const object* obj )
+   {
+      if( id.is<call_order_object>() )
+         return find_order_market<call_order_object>( db, obj );
+      if( id.is<limit_order_object>() )
+         return find_order_market<limit_order_object>( db, obj );
+      if( id.is<force_settlement_object>() )
+         return find_order_market<force_settlement_object>( db, obj );
+      return {};
+   }
+
+   bool is_order( object_id_type id )
+   {
+      return id.is<call_order_object>() || id.is<limit_order_object>() || id.is<force_settlement_object>();
+   }
+
+} // anonymous namespace
+
+const size_t subscription_registry::default_max_objects_per_subscriber;
+
+std::shared_ptr<subscription_registry> subscription_registry::get( database& db )
+{
+   static std::mutex registries_mutex;
+   static std::map< const database*, std::weak_ptr<subscription_registry> > registries;
+
+   std::lock_guard<std::mutex> guard( registries_mutex );
+   std::shared_ptr<subscription_registry> registry = registries[ &db ].lock();
+   if( !registry )
+   {
+      for( auto itr = registries.begin(); itr != registries.end(); )
+      {
+         if( itr->second.expired() )
+            itr = registries.erase( itr );
+         else
+            ++itr;
+      }
+      registry = std::make_shared<subscription_registry>( db );
+      registries[ &db ] = registry;
+   }
+   return registry;
+}
+
+subscription_registry::subscription_registry( database& db )
+   : _db( db ), _object_cache( serialized_object_cache::get( db ) )
+{
+   _new_connection = _db.new_objects.connect(
+      [this]( const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts ) {
+         on_objects_changed( ids, impacted_accounts, true, true,
+                             [this,&ids]( size_t i ) { return _db.find_object( ids[i] ); } );
+      });
+   _change_connection = _db.changed_objects.connect(
+      [this]( const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts ) {
+         on_objects_changed( ids, impacted_accounts, false, true,
+                             [this,&ids]( size_t i ) { return _db.find_object( ids[i] ); } );
+      });
+   _removed_connection = _db.removed_objects.connect(
+      [this]( const vector<object_id_type>& ids, const vector<const object*>& objs,
+              const flat_set<account_id_type>& impacted_accounts ) {
+         // the last values of the removed objects are in the same order as their ids
+         on_objects_changed( ids, impacted_accounts, true, false, [&objs]( size_t i ) { return objs[i]; } );
+      });
+}
+
+void subscription_registry::subscribe_to_objects( const std::shared_ptr<subscriber>& s, bool notify_remove_create )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   subscriber_state& state = _subscribers[ s.get() ];
+   remove_object_subscriptions( s.get(), state );
+   state.session = s;
+   state.objects = true;
+   state.notify_remove_create = notify_remove_create;
+   if( notify_remove_create )
+      _remove_create.insert( s.get() );
+}
+
+void subscription_registry::subscribe_to_object( const subscriber* s, object_id_type id )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( s );
+   if( itr == _subscribers.end() || !itr->second.objects || itr->second.ids.count( id ) != 0 )
+      return;
+   // the call which subscribes is an ordinary read and succeeds nevertheless
+   if( itr->second.ids.size() >= _max_objects_per_subscriber )
+   {
+      if( !itr->second.objects_capped )
+         wlog( "An API session subscribed to ${max} objects, further objects are not subscribed to",
+               ("max", _max_objects_per_subscriber) );
+      itr->second.objects_capped = true;
+      return;
+   }
+   itr->second.ids.insert( id );
+   _by_object[ id ].insert( s );
+}
+
+void subscription_registry::subscribe_to_account( const subscriber* s, account_id_type account )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( s );
+   if( itr == _subscribers.end() || !itr->second.objects )
+      return;
+   if( itr->second.accounts.insert( account ).second )
+      _by_account[ account ].insert( s );
+   update_impacted_accounts_request();
+}
+
+void subscription_registry::cancel_object_subscriptions( const subscriber* s )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( s );
+   if( itr == _subscribers.end() )
+      return;
+   remove_object_subscriptions( s, itr->second );
+   erase_if_unused( s );
+}
+
+void subscription_registry::subscribe_to_market( const std::shared_ptr<subscriber>& s, const market_type& market )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   subscriber_state& state = _subscribers[ s.get() ];
+   state.session = s;
+   if( state.markets.insert( market ).second )
+      _by_market[ market ].insert( s.get() );
+}
+
+void subscription_registry::unsubscribe_from_market( const subscriber* s, const market_type& market )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( s );
+   if( itr == _subscribers.end() || itr->second.markets.erase( market ) == 0 )
+      return;
+   auto by_market = _by_market.find( market );
+   by_market->second.erase( s );
+   if( by_market->second.empty() )
+      _by_market.erase( by_market );
+   erase_if_unused( s );
+}
+
+void subscription_registry::cancel_market_subscriptions( const subscriber* s )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( s );
+   if( itr == _subscribers.end() )
+      return;
+   remove_market_subscriptions( s, itr->second );
+   erase_if_unused( s );
+}
+
+void subscription_registry::remove( const subscriber* s )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( s );
+   if( itr == _subscribers.end() )
+      return;
+   remove_object_subscriptions( s, itr->second );
+   remove_market_subscriptions( s, itr->second );
+   _subscribers.erase( itr );
+}
+
+size_t subscription_registry::subscriber_count()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   return _subscribers.size();
+}
+
+void subscription_registry::set_max_objects_per_subscriber( size_t max_objects )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _max_objects_per_subscriber = max_objects;
+}
+
+size_t subscription_registry::get_max_objects_per_subscriber()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   return _max_objects_per_subscriber;
+}
+
+void subscription_registry::remove_object_subscriptions( const subscriber* s, subscriber_state& state )
+{
+   for( const object_id_type& id : state.ids )
+   {
+      auto itr = _by_object.find( id );
+      itr->second.erase( s );
+      if( itr->second.empty() )
+         _by_object.erase( itr );
+   }
+   for( const account_id_type& account : state.accounts )
+   {
+      auto itr = _by_account.find( account );
+      itr->second.erase( s );
+      if( itr->second.empty() )
+         _by_account.erase( itr );
+   }
+   _remove_create.erase( s );
+   state.ids.clear();
+   state.accounts.clear();
+   state.objects = false;
+   state.notify_remove_create = false;
+   state.objects_capped = false;
+   update_impacted_accounts_request();
+}
+
+void subscription_registry::remove_market_subscriptions( const subscriber* s, subscriber_state& state )
+{
+   for( const market_type& market : state.markets )
+   {
+      auto itr = _by_market.find( market );
+      itr->second.erase( s );
+      if( itr->second.empty() )
+         _by_market.erase( itr );
+   }
+   state.markets.clear();
+}
+
+void subscription_registry::erase_if_unused( const subscriber* s )
+{
+   auto itr = _subscribers.find( s );
+   if( itr != _subscribers.end() && !itr->second.objects && itr->second.markets.empty() )
+      _subscribers.erase( itr );
+}
+
+void subscription_registry::update_impacted_accounts_request()
+{
+   if( _by_account.empty() )
+      _impacted_accounts_request.reset();
+   else if( !_impacted_accounts_request )
+      _impacted_accounts_request = _db.request_impacted_accounts();
+}
+
+void subscription_registry::on_objects_changed( const vector<object_id_type>& ids,
+                                                const flat_set<account_id_type>& impacted_accounts,
+                                                bool created_or_removed, bool full_object,
+                                                const std::function<const object*(size_t)>& object_at )
+{
+   // the updates are delivered after the lock is released, as a subscriber may remove itself when the last
+   // reference to it is dropped
+   vector< std::pair< std::shared_ptr<subscriber>, vector<fc::variant> > > object_updates;
+   vector< std::pair< std::shared_ptr<subscriber>, market_queue_type > > market_updates;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      if( _subscribers.empty() )
+         return;
+
+      // sessions notified of all creations and removals, and sessions subscribed to any account impacted by
+      // the block, receive all of the changed objects
+      subscriber_set receive_all;
+      if( created_or_removed )
+         receive_all = _remove_create;
+      for( const account_id_type& account : impacted_accounts )
+      {
+         auto itr = _by_account.find( account );
+         if( itr != _by_account.end() )
+            receive_all.insert( itr->second.begin(), itr->second.end() );
+      }
+
+      std::map< const subscriber*, vector<fc::variant> > updates;
+      std::map< const subscriber*, market_queue_type > queues;
+      for( size_t i = 0; i < ids.size(); ++i )
+      {
+         const object_id_type id = ids[i];
+         auto by_object = _by_object.find( id );
+         const bool check_market = !_by_market.empty() && is_order( id );
+         if( receive_all.empty() && by_object == _by_object.end() && !check_market )
+            continue;
+
+         // look up and convert every object once for all of the sessions, in each of the encodings
+         const object* obj = object_at( i );
+         optional<fc::variant> value;
+         optional<fc::variant> packed_value;
+         auto get_value = [&]( const subscriber* s ) -> const fc::variant& {
+            if( full_object && s->wants_packed_updates() )
+            {
+               if( !packed_value.valid() )
+               {
+                  packed_data packed;
+                  packed.data = obj->pack();
+                  packed_value = fc::variant( packed, 1 );
+               }
+               return *packed_value;
+            }
+            if( !value.valid() )
+               value = full_object ? _object_cache->to_variant( *obj ) : fc::variant( id, 1 );
+            return *value;
+         };
+
+         if( obj != nullptr || !full_object )
+         {
+            for( const subscriber* s : receive_all )
+               updates[ s ].push_back( get_value( s ) );
+            if( by_object != _by_object.end() )
+               for( const subscriber* s : by_object->second )
+                  if( receive_all.find( s ) == receive_all.end() )
+                     updates[ s ].push_back( get_value( s ) );
+         }
+
+         if( check_market && obj != nullptr )
+         {
+            const optional<market_type> market = find_order_market( _db, id, obj );
+            auto by_market = market.valid() ? _by_market.find( *market ) : _by_market.end();
+            if( by_market != _by_market.end() )
+               for( const subscriber* s : by_market->second )
+                  queues[ s ][ *market ].push_back( get_value( s ) );
+         }
+      }
+
+      for( auto& item : updates )
+         if( auto session = _subscribers[ item.first ].session.lock() )
+            object_updates.emplace_back( std::move( session ), std::move( item.second ) );
+      for( auto& item : queues )
+         if( auto session = _subscribers[ item.first ].session.lock() )
+            market_updates.emplace_back( std::move( session ), std::move( item.second ) );
+   }
+
+   for( const auto& item : object_updates )
+      item.first->on_object_updates( item.second );
+   for( const auto& item : market_updates )
+      item.first->on_market_updates( item.second );
+}
+
+} } // graphene::app
@@ -27,6 +27,8 @@
 #include <graphene/chain/hardfork.hpp>
 #include <fc/uint128.hpp>
 
+#include <algorithm>
+
 namespace graphene { namespace chain {
 
 share_type cut_fee(share_type a, uint16_t p)
@@ -256,6 +258,61 @@ void account_member_index::object_modified(const object& after)
 
 }
 
+namespace {
+
+   /**
+    * Fills a membership map from (member, account) pairs. The pairs are listed in the order of the accounts, which
+    * a stable sort by member keeps, so that every map node and set element is appended at the end.
+    */
+   template< typename Map >
+   void build_memberships( Map& memberships, vector< pair< typename Map::key_type, account_id_type > >& pairs )
+   {
+      const auto key_less = memberships.key_comp();
+      std::stable_sort( pairs.begin(), pairs.end(),
+                        [&key_less]( const pair< typename Map::key_type, account_id_type >& a,
+                                     const pair< typename Map::key_type, account_id_type >& b ) {
+                           return key_less( a.first, b.first );
+                        });
+      memberships.clear();
+      auto itr = memberships.end();
+      for( const auto& p : pairs )
+      {
+         if( itr == memberships.end() || key_less( itr->first, p.first ) )
+            itr = memberships.emplace_hint( memberships.end(), p.first, set<account_id_type>() );
+         itr->second.emplace_hint( itr->second.end(), p.second );
+      }
+   }
+
+} // anonymous namespace
+
+void account_member_index::rebuild( const vector<const object*>& objects )
+{
+   vector< pair< account_id_type, account_id_type > > account_pairs;
+   vector< pair< public_key_type, account_id_type > > key_pairs;
+   vector< pair< address, account_id_type > >         address_pairs;
+   key_pairs.reserve( objects.size() );
+   address_pairs.reserve( objects.size() );
+   for( const object* obj : objects )
+   {
+      assert( dynamic_cast<const account_object*>(obj) ); // for debug only
+      const account_object& a = static_cast<const account_object&>(*obj);
+      for( const auto& item : get_account_members(a) )
+         account_pairs.emplace_back( item, a.id );
+      for( const auto& item : get_key_members(a) )
+         key_pairs.emplace_back( item, a.id );
+      for( const auto& item : get_address_members(a) )
+         address_pairs.emplace_back( item, a.id );
+   }
+   build_memberships( account_to_account_memberships, account_pairs );
+   build_memberships( account_to_key_memberships, key_pairs );
+   build_memberships( account_to_address_memberships, address_pairs );
+}
+
+void account_referrer_index::rebuild( const vector<const object*>& objects )
+{
+   referred_by.clear();
+}
+
 void account_referrer_index::object_inserted( const object& obj )
 {
 }
@@ -272,6 +329,79 @@ void account_referrer_index::object_modified( const object& after  )
 const uint8_t  balances_by_account_index::bits = 20;
 const uint64_t balances_by_account_index::mask = (1ULL << balances_by_account_index::bits) - 1;
 
+size_t account_balance_list::size()const
+{
+   if( _spill )
+      return _spill->size();
+   size_t count = 0;
+   while( count < inline_capacity && _inline[count] != nullptr )
+      ++count;
+   return count;
+}
+
+const account_balance_object* account_balance_list::find( asset_id_type asset )const
+{
+   const auto itr = std::lower_bound( begin(), end(), asset,
+                                      []( const account_balance_object* b, asset_id_type a ) {
+                                         return b->asset_type < a;
+                                      });
+   if( itr == end() || (*itr)->asset_type != asset )
+      return nullptr;
+   return *itr;
+}
+
+void account_balance_list::insert( const account_balance_object* balance )
+{
+   const size_t count = size();
+   const size_t pos = std::lower_bound( begin(), end(), balance->asset_type,
+                                        []( const account_balance_object* b, asset_id_type a ) {
+                                           return b->asset_type < a;
+                                        }) - begin();
+   if( pos < count && (*(begin() + pos))->asset_type == balance->asset_type )
+   {
+      if( _spill )
+         (*_spill)[pos] = balance;
+      else
+         _inline[pos] = balance;
+      return;
+   }
+   if( !_spill && count == inline_capacity )
+      _spill.reset( new std::vector< const account_balance_object* >( _inline.begin(), _inline.end() ) );
+   if( _spill )
+   {
+      _spill->insert( _spill->begin() + pos, balance );
+      return;
+   }
+   for( size_t i = count; i > pos; --i )
+      _inline[i] = _inline[i - 1];
+   _inline[pos] = balance;
+}
+
+void account_balance_list::erase( asset_id_type asset )
+{
+   const size_t count = size();
+   const size_t pos = std::lower_bound( begin(), end(), asset,
+                                        []( const account_balance_object* b, asset_id_type a ) {
+                                           return b->asset_type < a;
+                                        }) - begin();
+   if( pos == count || (*(begin() + pos))->asset_type != asset )
+      return;
+   if( _spill )
+   {
+      _spill->erase( _spill->begin() + pos );
+      if( _spill->size() <= inline_capacity )
+      {
+         _inline.fill( nullptr );
+         std::copy( _spill->begin(), _spill->end(), _inline.begin() );
+         _spill.reset();
+      }
+      return;
+   }
+   for( size_t i = pos; i + 1 < count; ++i )
+      _inline[i] = _inline[i + 1];
+   _inline[count - 1] = nullptr;
+}
+
 void balances_by_account_index::object_inserted( const object& obj )
 {
    const auto& abo = dynamic_cast< const account_balance_object& >( obj );
@@ -281,7 +411,26 @@ void balances_by_account_index::object_inserted( const object& obj )
       balances.resize( balances.size() + 1 );
       balances.back().resize( 1ULL << bits );
    }
-   balances[abo.owner.instance.value >> bits][abo.owner.instance.value & mask][abo.asset_type] = &abo;
+   balances[abo.owner.instance.value >> bits][abo.owner.instance.value & mask].insert( &abo );
+}
+
+void balances_by_account_index::rebuild( const vector<const object*>& objects )
+{
+   balances.clear();
+   uint64_t max_owner = 0;
+   for( const object* obj : objects )
+      max_owner = std::max( max_owner, static_cast< const account_balance_object* >( obj )->owner.instance.value );
+   if( !objects.empty() )
+   {
+      balances.resize( (max_owner >> bits) + 1 );
+      for( auto& chunk : balances )
+         chunk.resize( 1ULL << bits );
+   }
+   for( const object* obj : objects )
+   {
+      const auto& abo = *static_cast< const account_balance_object* >( obj );
+      balances[abo.owner.instance.value >> bits][abo.owner.instance.value & mask].insert( &abo );
+   }
 }
 
 void balances_by_account_index::object_removed( const object& obj )
@@ -302,9 +451,9 @@ void balances_by_account_index::object_modified( const object& after  )
    ids_being_modified.pop();
 }
 
-const map< asset_id_type, const account_balance_object* >& balances_by_account_index::get_account_balances( const account_id_type& acct )const
+const account_balance_list& balances_by_account_index::get_account_balances( const account_id_type& acct )const
 {
-   static const map< asset_id_type, const account_balance_object* > _empty;
+   static const account_balance_list _empty;
 
    if( balances.size() < (acct.instance.value >> bits) + 1 ) return _empty;
    return balances[acct.instance.value >> bits][acct.instance.value & mask];
@@ -313,10 +462,7 @@ const map< asset_id_type, const account_balance_object* >& balances_by_account_i
 const account_balance_object* balances_by_account_index::get_account_balance( const account_id_type& acct, const asset_id_type& asset )const
 {
    if( balances.size() < (acct.instance.value >> bits) + 1 ) return nullptr;
-   const auto& mine = balances[acct.instance.value >> bits][acct.instance.value & mask];
-   const auto itr = mine.find( asset );
-   if( mine.end() == itr ) return nullptr;
-   return itr->second;
+   return balances[acct.instance.value >> bits][acct.instance.value & mask].find( asset );
 }
 
 } } // graphene::chain
@@ -25,6 +25,7 @@
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/chain/balance_write_batch.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/hardfork.hpp>
@@ -833,7 +834,7 @@ void_result asset_global_settle_evaluator::do_evaluate(const asset_global_settle
 
    const auto& idx = d.get_index_type<call_order_index>().indices().get<by_collateral>();
    FC_ASSERT( !idx.empty(), "Internal error: no debt position found" );
-   auto itr = idx.lower_bound( price::min( _bitasset_data.options.short_backing_asset, op.asset_to_settle ) );
+   auto itr = idx.lower_bound( price_index_key( price::min( _bitasset_data.options.short_backing_asset, op.asset_to_settle ) ) );
    FC_ASSERT( itr != idx.end() && itr->debt_type() == op.asset_to_settle, "Internal error: no debt position found" );
    const call_order_object& least_collateralized_short = *itr;
    FC_ASSERT(least_collateralized_short.get_debt() * op.settle_price <= least_collateralized_short.get_collateral(),
@@ -1033,7 +1034,9 @@ void_result asset_publish_feeds_evaluator::do_apply(const asset_publish_feed_ope
             d.revive_bitasset(base);
       }
       // Process margin calls, allow black swan, not for a new limit order
+      balance_write_batch call_balances( d );
       d.check_call_orders( base, true, false, bitasset_ptr );
+      call_balances.flush();
    }
 
    return void_result();
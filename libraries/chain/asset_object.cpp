@@ -48,21 +48,13 @@ void graphene::chain::asset_bitasset_data_object::update_median_feeds( time_poin
                                                                        time_point_sec next_maintenance_time )
 {
    bool after_core_hardfork_1270 = ( next_maintenance_time > HARDFORK_CORE_1270_TIME ); // call price caching issue
-   current_feed_publication_time = current_time;
-   vector<std::reference_wrapper<const price_feed>> current_feeds;
    // find feeds that were alive at current_time
-   for( const pair<account_id_type, pair<time_point_sec,price_feed>>& f : feeds )
-   {
-      if( (current_time - f.second.first).to_seconds() < options.feed_lifetime_sec &&
-          f.second.first != time_point_sec() )
-      {
-         current_feeds.emplace_back(f.second.second);
-         current_feed_publication_time = std::min(current_feed_publication_time, f.second.first);
-      }
-   }
+   median_feeds.update( feeds, current_time, options.feed_lifetime_sec );
+   current_feed_publication_time = median_feeds.oldest_publication_time();
+   const size_t live_feed_count = median_feeds.size();
 
    // If there are no valid feeds, or the number available is less than the minimum to calculate a median...
-   if( current_feeds.size() < options.minimum_feeds )
+   if( live_feed_count < options.minimum_feeds )
    {
       //... don't calculate a median, and set a null feed
       feed_cer_updated = false; // new median cer is null, won't update asset_object anyway, set to false for better performance
@@ -72,11 +64,12 @@ void graphene::chain::asset_bitasset_data_object::update_median_feeds( time_poin
          current_maintenance_collateralization = price();
       return;
    }
-   if( current_feeds.size() == 1 )
+   if( live_feed_count == 1 )
    {
-      if( current_feed.core_exchange_rate != current_feeds.front().get().core_exchange_rate )
+      const price_feed& only_feed = median_feeds.live_feeds().begin()->second.second;
+      if( current_feed.core_exchange_rate != only_feed.core_exchange_rate )
          feed_cer_updated = true;
-      current_feed = current_feeds.front();
+      current_feed = only_feed;
       // Note: perhaps can defer updating current_maintenance_collateralization for better performance
       if( after_core_hardfork_1270 )
          current_maintenance_collateralization = current_feed.maintenance_collateralization();
@@ -84,17 +77,29 @@ void graphene::chain::asset_bitasset_data_object::update_median_feeds( time_poin
    }
 
    // *** Begin Median Calculations ***
+   // The tracker reads the median of each field from its ranking. When the median of a field is one of several
+   // equivalent prices of different representation, the pick of std::nth_element decides as it always did.
+   optional<price_feed> ranked_median = median_feeds.median();
    price_feed median_feed;
-   const auto median_itr = current_feeds.begin() + current_feeds.size() / 2;
+   if( ranked_median.valid() )
+      median_feed = *ranked_median;
+   else
+   {
+      vector<std::reference_wrapper<const price_feed>> current_feeds;
+      current_feeds.reserve( live_feed_count );
+      for( const auto& f : median_feeds.live_feeds() )
+         current_feeds.emplace_back( f.second.second );
+      const auto median_itr = current_feeds.begin() + current_feeds.size() / 2;
 #define CALCULATE_MEDIAN_VALUE(r, data, field_name) \
-   std::nth_element( current_feeds.begin(), median_itr, current_feeds.end(), \
-                     [](const price_feed& a, const price_feed& b) { \
-      return a.field_name < b.field_name; \
-   }); \
-   median_feed.field_name = median_itr->get().field_name;
+      std::nth_element( current_feeds.begin(), median_itr, current_feeds.end(), \
+                        [](const price_feed& a, const price_feed& b) { \
+         return a.field_name < b.field_name; \
+      }); \
+      median_feed.field_name = median_itr->get().field_name;
 
-   BOOST_PP_SEQ_FOR_EACH( CALCULATE_MEDIAN_VALUE, ~, GRAPHENE_PRICE_FEED_FIELDS )
+      BOOST_PP_SEQ_FOR_EACH( CALCULATE_MEDIAN_VALUE, ~, GRAPHENE_PRICE_FEED_FIELDS )
 #undef CALCULATE_MEDIAN_VALUE
+   }
    // *** End Median Calculations ***
 
    if( current_feed.core_exchange_rate != median_feed.core_exchange_rate )
@@ -40,6 +40,7 @@ namespace graphene { namespace chain {
 
 void block_database::open( const fc::path& dbdir )
 { try {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    fc::create_directories(dbdir);
    _block_num_to_pos.exceptions(std::ios_base::failbit | std::ios_base::badbit);
    _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
@@ -59,23 +60,27 @@ void block_database::open( const fc::path& dbdir )
 
 bool block_database::is_open()const
 {
+  std::lock_guard<std::mutex> guard( _streams_mutex );
   return _blocks.is_open();
 }
 
 void block_database::close()
 {
+  std::lock_guard<std::mutex> guard( _streams_mutex );
   _blocks.close();
   _block_num_to_pos.close();
 }
 
 void block_database::flush()
 {
+  std::lock_guard<std::mutex> guard( _streams_mutex );
   _blocks.flush();
   _block_num_to_pos.flush();
 }
 
 void block_database::store( const block_id_type& _id, const signed_block& b )
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    block_id_type id = _id;
    if( id == block_id_type() )
    {
@@ -95,6 +100,7 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
 
 void block_database::remove( const block_id_type& id )
 { try {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    index_entry e;
    int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
    _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
@@ -114,6 +120,7 @@ void block_database::remove( const block_id_type& id )
 
 bool block_database::contains( const block_id_type& id )const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    if( id == block_id_type() )
       return false;
 
@@ -130,6 +137,7 @@ bool block_database::contains( const block_id_type& id )const
 
 block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    assert( block_num != 0 );
    index_entry e;
    int64_t index_pos = sizeof(e) * int64_t(block_num);
@@ -146,6 +154,7 @@ block_id_type block_database::fetch_block_id( uint32_t block_num )const
 
 optional<signed_block> block_database::fetch_optional( const block_id_type& id )const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    try
    {
       index_entry e;
@@ -178,6 +187,7 @@ optional<signed_block> block_database::fetch_optional( const block_id_type& id )
 
 optional<signed_block> block_database::fetch_by_number( uint32_t block_num )const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    try
    {
       index_entry e;
@@ -205,7 +215,43 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
+optional<vector<char>> block_database::fetch_packed_by_number( uint32_t block_num )const
+{
+   std::lock_guard<std::mutex> guard( _streams_mutex );
+   try
+   {
+      index_entry e;
+      int64_t index_pos = sizeof(e) * int64_t(block_num);
+      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
+      if ( _block_num_to_pos.tellg() <= index_pos )
+         return {};
+
+      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
+      _block_num_to_pos.read( (char*)&e, sizeof(e) );
+      if( e.block_size == 0 )
+         return {};
+
+      vector<char> data( e.block_size );
+      _blocks.seekg( e.block_pos );
+      _blocks.read( data.data(), e.block_size );
+      // the header alone identifies the block, the transactions are left packed
+      fc::datastream<const char*> ds( data.data(), data.size() );
+      signed_block_header header;
+      fc::raw::unpack( ds, header );
+      FC_ASSERT( header.id() == e.block_id );
+      return data;
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   return optional<vector<char>>();
+}
+
 optional<index_entry> block_database::last_index_entry()const {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    try
    {
       index_entry e;
@@ -272,11 +318,13 @@ optional<block_id_type> block_database::last_id()const
 
 size_t block_database::blocks_current_position()const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    return (size_t)_blocks.tellg();
 }
 
 size_t block_database::total_block_size()const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    _blocks.seekg( 0, _blocks.end );
    return (size_t)_blocks.tellg();
 }
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/block_phase_tracer.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+#include <iomanip>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   /// Writes a duration given in nanoseconds as fractional microseconds, the unit of the trace event format
+   void write_us( std::ostream& out, uint64_t ns )
+   {
+      out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000;
+   }
+
+   void write_event( std::ostream& out, const char* name, uint64_t block_start_us, uint64_t start_ns,
+                     uint64_t duration_ns, const block_phase_trace& trace )
+   {
+      out << "{\"name\":\"" << name << "\",\"cat\":\"block\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":";
+      write_us( out, block_start_us * 1000 + start_ns );
+      out << ",\"dur\":";
+      write_us( out, duration_ns );
+      out << ",\"args\":{\"block_num\":" << trace.block_num << "}},\n";
+   }
+
+} // anonymous namespace
+
+block_phase_tracer::scoped_phase::scoped_phase( block_phase_tracer& tracer, block_phase phase )
+{
+   if( !tracer._in_block )
+      return;
+   _tracer = &tracer;
+   _index = tracer._current.phases.size();
+   block_phase_timing timing;
+   timing.phase = phase;
+   timing.depth = tracer._depth++;
+   timing.start_ns = tracer.elapsed_ns();
+   tracer._current.phases.push_back( timing );
+}
+
+block_phase_tracer::scoped_phase::~scoped_phase()
+{
+   if( _tracer == nullptr || !_tracer->_in_block )
+      return;
+   block_phase_timing& timing = _tracer->_current.phases[_index];
+   timing.duration_ns = _tracer->elapsed_ns() - timing.start_ns;
+   --_tracer->_depth;
+}
+
+block_phase_tracer::block_phase_tracer() {}
+
+block_phase_tracer::~block_phase_tracer() {}
+
+void block_phase_tracer::set_capacity( size_t capacity )
+{
+   _capacity = capacity;
+   while( _traces.size() > _capacity )
+      _traces.pop_front();
+   if( _capacity == 0 )
+      _in_block = false;
+}
+
+void block_phase_tracer::set_trace_file( const fc::path& file )
+{ try {
+   _trace_file.reset();
+   if( file == fc::path() )
+      return;
+   const bool is_new = !fc::exists( file ) || fc::file_size( file ) == 0;
+   _trace_file.reset( new std::ofstream( file.generic_string(), std::ofstream::out | std::ofstream::app ) );
+   FC_ASSERT( _trace_file->good(), "Unable to open block phase trace file ${f}", ("f", file) );
+   // JSON array format of the trace event format, the closing bracket is optional
+   if( is_new )
+      *_trace_file << "[\n";
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+uint64_t block_phase_tracer::elapsed_ns()const
+{
+   return std::chrono::duration_cast< std::chrono::nanoseconds >( clock::now() - _block_start ).count();
+}
+
+void block_phase_tracer::begin_block( uint32_t block_num, fc::time_point_sec timestamp, uint32_t transaction_count )
+{
+   // a block that failed to apply never reaches end_block(), its partial trace is dropped here
+   _in_block = is_enabled();
+   if( !_in_block )
+      return;
+   _depth = 0;
+   _current = block_phase_trace();
+   _current.block_num = block_num;
+   _current.timestamp = timestamp;
+   _current.transaction_count = transaction_count;
+   _current.applied_at = fc::time_point::now();
+   _block_start = clock::now();
+}
+
+void block_phase_tracer::end_block( bool maintenance )
+{
+   if( !_in_block )
+      return;
+   _in_block = false;
+   _current.duration_ns = elapsed_ns();
+   _current.maintenance = maintenance;
+   if( _trace_file )
+      write_trace( _current );
+   _traces.push_back( std::move( _current ) );
+   while( _traces.size() > _capacity )
+      _traces.pop_front();
+}
+
+std::vector< block_phase_trace > block_phase_tracer::get_traces( uint32_t limit )const
+{
+   std::vector< block_phase_trace > result;
+   result.reserve( std::min< size_t >( limit, _traces.size() ) );
+   for( auto itr = _traces.rbegin(); itr != _traces.rend() && result.size() < limit; ++itr )
+      result.push_back( *itr );
+   return result;
+}
+
+void block_phase_tracer::write_trace( const block_phase_trace& trace )
+{
+   std::ostream& out = *_trace_file;
+   const uint64_t start_us = trace.applied_at.time_since_epoch().count();
+   write_event( out, trace.maintenance ? "apply_maintenance_block" : "apply_block", start_us, 0,
+                trace.duration_ns, trace );
+   for( const auto& timing : trace.phases )
+      write_event( out, fc::reflector< block_phase >::to_string( timing.phase ), start_us, timing.start_ns,
+                   timing.duration_ns, trace );
+   out.flush();
+   if( !out.good() )
+   {
+      elog( "Error writing block phase trace file, disabling it" );
+      _trace_file.reset();
+   }
+}
+
+} } // graphene::chain
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/chain_access_lock.hpp>
+
+namespace graphene { namespace chain {
+
+chain_access_lock::read_guard::read_guard( chain_access_lock& lock ) : _lock( lock )
+{
+   if( _lock.is_writing() )
+      return;
+   _lock._mutex.lock_shared();
+   _locked = true;
+}
+
+chain_access_lock::read_guard::~read_guard()
+{
+   if( _locked )
+      _lock._mutex.unlock_shared();
+}
+
+chain_access_lock::write_guard::write_guard( chain_access_lock& lock ) : _lock( lock )
+{
+   if( !_lock.is_writing() )
+   {
+      _lock._mutex.lock();
+      _lock._writer.store( std::this_thread::get_id() );
+   }
+   ++_lock._write_depth;
+}
+
+chain_access_lock::write_guard::~write_guard()
+{
+   if( --_lock._write_depth > 0 )
+      return;
+   _lock._writer.store( std::thread::id() );
+   _lock._mutex.unlock();
+}
+
+} } // graphene::chain
@@ -36,9 +36,10 @@ asset database::get_balance(account_id_type owner, asset_id_type asset_id) const
 {
    auto& index = get_index_type< primary_index< account_balance_index > >().get_secondary_index<balances_by_account_index>();
    auto abo = index.get_account_balance( owner, asset_id );
-   if( !abo )
-      return asset(0, asset_id);
-   return abo->get_balance();
+   asset result = abo ? abo->get_balance() : asset(0, asset_id);
+   if( _balance_write_batch != nullptr )
+      result.amount += _balance_write_batch->pending_delta( owner, asset_id );
+   return result;
 }
 
 asset database::get_balance(const account_object& owner, const asset_object& asset_obj) const
@@ -56,6 +57,12 @@ void database::adjust_balance(account_id_type account, asset delta )
    if( delta.amount == 0 )
       return;
 
+   if( _balance_write_batch != nullptr )
+   {
+      _balance_write_batch->adjust( account, delta );
+      return;
+   }
+
    auto& index = get_index_type< primary_index< account_balance_index > >().get_secondary_index<balances_by_account_index>();
    auto abo = index.get_account_balance( account, delta.asset_id );
    if( !abo )
@@ -82,6 +89,111 @@ void database::adjust_balance(account_id_type account, asset delta )
 
 } FC_CAPTURE_AND_RETHROW( (account)(delta) ) }
 
+balance_write_batch::balance_write_batch( database& db ) : _db( db )
+{
+   if( _db._balance_write_batch != nullptr )
+      return;
+   _active = true;
+   _db._balance_write_batch = this;
+}
+
+balance_write_batch::~balance_write_batch()
+{
+   if( !_active )
+      return;
+   try
+   {
+      flush();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Could not write the pending balance adjustments: ${e}", ("e", e.to_detail_string()) );
+   }
+   catch( const std::exception& e )
+   {
+      elog( "Could not write the pending balance adjustments: ${e}", ("e", e.what()) );
+   }
+}
+
+share_type balance_write_batch::pending_delta( account_id_type owner, asset_id_type asset_type )const
+{
+   auto itr = _positions.find( std::make_pair( owner, asset_type ) );
+   if( itr == _positions.end() )
+      return 0;
+   return _pending[ itr->second ].delta;
+}
+
+void balance_write_batch::adjust( account_id_type owner, const asset& delta )
+{
+   const auto key = std::make_pair( owner, delta.asset_id );
+   auto itr = _positions.find( key );
+   const account_balance_object* abo = nullptr;
+   share_type pending = 0;
+   if( itr != _positions.end() )
+   {
+      abo = _pending[ itr->second ].balance;
+      pending = _pending[ itr->second ].delta;
+   }
+   else
+   {
+      auto& index = _db.get_index_type< primary_index< account_balance_index > >()
+                       .get_secondary_index< balances_by_account_index >();
+      abo = index.get_account_balance( owner, delta.asset_id );
+   }
+
+   if( delta.amount < 0 )
+   {
+      // the balance the account would have now without the batch, 0 if it has never been credited
+      const asset balance( ( abo ? abo->balance : share_type(0) ) + pending, delta.asset_id );
+      FC_ASSERT( balance >= -delta, "Insufficient Balance: ${a}'s balance of ${b} is less than required ${r}",
+                 ("a",owner(_db).name)("b",_db.to_pretty_string(balance))("r",_db.to_pretty_string(-delta)));
+   }
+
+   if( itr != _positions.end() )
+   {
+      _pending[ itr->second ].delta += delta.amount;
+      return;
+   }
+   _positions.emplace( key, _pending.size() );
+   pending_balance entry;
+   entry.owner = owner;
+   entry.asset_type = delta.asset_id;
+   entry.balance = abo;
+   entry.delta = delta.amount;
+   _pending.push_back( entry );
+}
+
+void balance_write_batch::flush()
+{
+   if( !_active )
+      return;
+   _active = false;
+   _db._balance_write_batch = nullptr;
+
+   for( const pending_balance& entry : _pending )
+   {
+      // a zero net delta is still written, so that touched CORE balances get their maintenance flag as before
+      if( entry.balance == nullptr )
+      {
+         _db.create<account_balance_object>([&entry](account_balance_object& b) {
+            b.owner = entry.owner;
+            b.asset_type = entry.asset_type;
+            b.balance = entry.delta.value;
+            if( b.asset_type == asset_id_type() ) // CORE asset
+               b.maintenance_flag = true;
+         });
+      }
+      else
+      {
+         _db.modify( *entry.balance, [&entry](account_balance_object& b) {
+            b.adjust_balance( asset( entry.delta, entry.asset_type ) );
+         });
+      }
+   }
+   _pending.clear();
+   _positions.clear();
+}
+
 namespace detail {
 
    /**
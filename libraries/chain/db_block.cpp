@@ -78,6 +78,15 @@ optional<signed_block> database::fetch_block_by_number( uint32_t num )const
       return _block_id_to_block.fetch_by_number(num);
 }
 
+optional<vector<char>> database::fetch_packed_block_by_number( uint32_t num )const
+{
+   auto results = _fork_db.fetch_block_by_number(num);
+   if( results.size() == 1 )
+      return fc::raw::pack( results[0]->data );
+   else
+      return _block_id_to_block.fetch_packed_by_number(num);
+}
+
 const signed_transaction& database::get_recent_transaction(const transaction_id_type& trx_id) const
 {
    auto& index = get_index_type<transaction_index>().indices().get<by_trx_id>();
@@ -112,6 +121,7 @@ std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of
  */
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
+   chain_access_lock::write_guard write_guard( _chain_access_lock );
 //   idump((new_block.block_num())(new_block.id())(new_block.timestamp)(new_block.previous));
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
@@ -223,6 +233,7 @@ bool database::_push_block(const signed_block& new_block)
  */
 processed_transaction database::push_transaction( const precomputable_transaction& trx, uint32_t skip )
 { try {
+   chain_access_lock::write_guard write_guard( _chain_access_lock );
    // see https://github.com/bitshares/bitshares-core/issues/1573
    FC_ASSERT( fc::raw::pack_size( trx ) < (1024 * 1024), "Transaction exceeds maximum transaction size." );
    processed_transaction result;
@@ -260,6 +271,7 @@ processed_transaction database::_push_transaction( const precomputable_transacti
 
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
+   chain_access_lock::write_guard write_guard( _chain_access_lock );
    auto session = _undo_db.start_undo_session();
    return _apply_transaction( trx );
 }
@@ -329,6 +341,7 @@ signed_block database::generate_block(
    uint32_t skip /* = 0 */
    )
 { try {
+   chain_access_lock::write_guard write_guard( _chain_access_lock );
    signed_block result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -460,6 +473,7 @@ signed_block database::_generate_block(
  */
 void database::pop_block()
 { try {
+   chain_access_lock::write_guard write_guard( _chain_access_lock );
    _pending_tx_session.reset();
    auto fork_db_head = _fork_db.head();
    FC_ASSERT( fork_db_head, "Trying to pop() from empty fork database!?" );
@@ -476,6 +490,7 @@ void database::pop_block()
 
 void database::clear_pending()
 { try {
+   chain_access_lock::write_guard write_guard( _chain_access_lock );
    assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
    _pending_tx.clear();
    _pending_tx_session.reset();
@@ -535,19 +550,28 @@ void database::_apply_block( const signed_block& next_block )
    uint32_t skip = get_node_properties().skip_flags;
    _applied_ops.clear();
 
-   if( !(skip & skip_block_size_check) )
+   typedef block_phase_tracer::scoped_phase scoped_phase;
+   _block_phase_tracer.begin_block( next_block_num, next_block.timestamp, next_block.transactions.size() );
+
+   const witness_object* signing_witness_ptr = nullptr;
    {
-      FC_ASSERT( fc::raw::pack_size(next_block) <= get_global_properties().parameters.maximum_block_size );
-   }
+      scoped_phase phase( _block_phase_tracer, block_phase::validate_header );
+
+      if( !(skip & skip_block_size_check) )
+      {
+         FC_ASSERT( fc::raw::pack_size(next_block) <= get_global_properties().parameters.maximum_block_size );
+      }
 
-   FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(),
-              "",
-              ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)
-              ("calc",next_block.calculate_merkle_root())
-              ("next_block",next_block)
-              ("id",next_block.id()) );
+      FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(),
+                 "",
+                 ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)
+                 ("calc",next_block.calculate_merkle_root())
+                 ("next_block",next_block)
+                 ("id",next_block.id()) );
 
-   const witness_object& signing_witness = validate_block_header(skip, next_block);
+      signing_witness_ptr = &validate_block_header(skip, next_block);
+   }
+   const witness_object& signing_witness = *signing_witness_ptr;
    const auto& global_props = get_global_properties();
    const auto& dynamic_global_props = get_dynamic_global_properties();
    bool maint_needed = (dynamic_global_props.next_maintenance_time <= next_block.timestamp);
@@ -557,35 +581,68 @@ void database::_apply_block( const signed_block& next_block )
 
    _issue_453_affected_assets.clear();
 
-   for( const auto& trx : next_block.transactions )
    {
-      /* We do not need to push the undo state for each transaction
-       * because they either all apply and are valid or the
-       * entire block fails to apply.  We only need an "undo" state
-       * for transactions when validating broadcast transactions or
-       * when building a block.
-       */
-      apply_transaction( trx, skip );
-      ++_current_trx_in_block;
+      scoped_phase phase( _block_phase_tracer, block_phase::apply_transactions );
+      for( const auto& trx : next_block.transactions )
+      {
+         /* We do not need to push the undo state for each transaction
+          * because they either all apply and are valid or the
+          * entire block fails to apply.  We only need an "undo" state
+          * for transactions when validating broadcast transactions or
+          * when building a block.
+          */
+         apply_transaction( trx, skip );
+         ++_current_trx_in_block;
+      }
    }
 
-   const uint32_t missed = update_witness_missed_blocks( next_block );
-   update_global_dynamic_data( next_block, missed );
-   update_signing_witness(signing_witness, next_block);
-   update_last_irreversible_block();
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::update_global_properties );
+      const uint32_t missed = update_witness_missed_blocks( next_block );
+      update_global_dynamic_data( next_block, missed );
+      update_signing_witness(signing_witness, next_block);
+      update_last_irreversible_block();
+   }
 
    // Are we at the maintenance interval?
    if( maint_needed )
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::chain_maintenance );
       perform_chain_maintenance(next_block, global_props);
+   }
 
-   create_block_summary(next_block);
-   clear_expired_transactions();
-   clear_expired_proposals();
-   clear_expired_orders();
-   clear_expired_htlcs();
-   update_expired_feeds();       // this will update expired feeds and some core exchange rates
-   update_core_exchange_rates(); // this will update remaining core exchange rates
-   update_withdraw_permissions();
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::create_block_summary );
+      create_block_summary(next_block);
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::clear_expired_transactions );
+      clear_expired_transactions();
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::clear_expired_proposals );
+      clear_expired_proposals();
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::clear_expired_orders );
+      clear_expired_orders();
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::clear_expired_htlcs );
+      clear_expired_htlcs();
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::update_expired_feeds );
+      update_expired_feeds();       // this will update expired feeds and some core exchange rates
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::update_core_exchange_rates );
+      update_core_exchange_rates(); // this will update remaining core exchange rates
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::update_withdraw_permissions );
+      update_withdraw_permissions();
+   }
 
    // n.b., update_maintenance_flag() happens this late
    // because get_slot_time() / get_slot_at_time() is needed above
@@ -593,15 +650,30 @@ void database::_apply_block( const signed_block& next_block )
    // update_global_dynamic_data() as perhaps these methods only need
    // to be called for header validation?
    update_maintenance_flag( maint_needed );
-   update_witness_schedule();
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::update_witness_schedule );
+      update_witness_schedule();
+   }
    if( !_node_property_object.debug_updates.empty() )
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::apply_debug_updates );
       apply_debug_updates();
+   }
 
    // notify observers that the block has been applied
-   notify_applied_block( next_block ); //emit
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::notify_applied_block );
+      notify_applied_block( next_block ); //emit
+   }
    _applied_ops.clear();
 
-   notify_changed_objects();
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::notify_changed_objects );
+      notify_changed_objects();
+   }
+
+   _block_phase_tracer.end_block( maint_needed );
+   _execution_profiler.on_block_applied( next_block_num );
 } FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 
 
@@ -618,6 +690,7 @@ processed_transaction database::apply_transaction(const signed_transaction& trx,
 
 processed_transaction database::_apply_transaction(const signed_transaction& trx)
 { try {
+   execution_profiler::scoped_timer trx_timer( _execution_profiler.check_stats( execution_profiler::transaction_total ) );
    uint32_t skip = get_node_properties().skip_flags;
 
    trx.validate();
@@ -625,13 +698,17 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    auto& trx_idx = get_mutable_index_type<transaction_index>();
    const chain_id_type& chain_id = get_chain_id();
    if( !(skip & skip_transaction_dupe_check) )
+   {
+      execution_profiler::scoped_timer timer( _execution_profiler.check_stats( execution_profiler::dupe_check ) );
       FC_ASSERT( trx_idx.indices().get<by_trx_id>().find(trx.id()) == trx_idx.indices().get<by_trx_id>().end() );
+   }
    transaction_evaluation_state eval_state(this);
    const chain_parameters& chain_parameters = get_global_properties().parameters;
    eval_state._trx = &trx;
 
    if( !(skip & skip_transaction_signatures) )
    {
+      execution_profiler::scoped_timer timer( _execution_profiler.check_stats( execution_profiler::signature_check ) );
       bool allow_non_immediate_owner = ( head_block_time() >= HARDFORK_CORE_584_TIME );
       auto get_active = [&]( account_id_type id ) { return &id(*this).active; };
       auto get_owner  = [&]( account_id_type id ) { return &id(*this).owner;  };
@@ -646,6 +723,7 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    //expired, and TaPoS makes no sense as no blocks exist.
    if( BOOST_LIKELY(head_block_num() > 0) )
    {
+      execution_profiler::scoped_timer timer( _execution_profiler.check_stats( execution_profiler::tapos_check ) );
       if( !(skip & skip_tapos_check) )
       {
          const auto& tapos_block_summary = block_summary_id_type( trx.ref_block_num )(*this);
@@ -667,6 +745,7 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    //Insert transaction into unique transactions database.
    if( !(skip & skip_transaction_dupe_check) )
    {
+      execution_profiler::scoped_timer timer( _execution_profiler.check_stats( execution_profiler::dupe_record ) );
       create<transaction_object>([&trx](transaction_object& transaction) {
          transaction.trx_id = trx.id();
          transaction.trx = trx;
@@ -696,6 +775,7 @@ operation_result database::apply_operation(transaction_evaluation_state& eval_st
    FC_ASSERT( u_which < _operation_evaluators.size(), "No registered evaluator for operation ${op}", ("op",op) );
    unique_ptr<op_evaluator>& eval = _operation_evaluators[ u_which ];
    FC_ASSERT( eval, "No registered evaluator for operation ${op}", ("op",op) );
+   execution_profiler::scoped_timer timer( _execution_profiler.operation_stats( u_which ) );
    auto op_id = push_applied_operation( op );
    auto result = eval->evaluate( eval_state, op, true );
    set_applied_operation_result( op_id, result );
@@ -42,6 +42,7 @@
 #include <graphene/chain/special_authority_object.hpp>
 #include <graphene/chain/transaction_object.hpp>
 #include <graphene/chain/vesting_balance_object.hpp>
+#include <graphene/chain/vote_tally_object.hpp>
 #include <graphene/chain/withdraw_permission_object.hpp>
 #include <graphene/chain/witness_object.hpp>
 #include <graphene/chain/witness_schedule_object.hpp>
@@ -186,6 +187,8 @@ void database::initialize_evaluators()
 void database::initialize_indexes()
 {
    reset_indexes();
+   _expiration_scheduler.clear();
+   _margin_call_frontier->clear();
    _undo_db.set_max_size( GRAPHENE_MIN_UNDO_HISTORY );
 
    //Protocol object indexes
@@ -195,32 +198,53 @@ void database::initialize_indexes()
    auto acnt_index = add_index< primary_index<account_index, 20> >(); // ~1 million accounts per chunk
    acnt_index->add_secondary_index<account_member_index>();
    acnt_index->add_secondary_index<account_referrer_index>();
+   acnt_index->add_secondary_index< vote_tally_tracker<account_object> >( _vote_tally_changes );
 
    add_index< primary_index<committee_member_index, 8> >(); // 256 members per chunk
    add_index< primary_index<witness_index, 10> >(); // 1024 witnesses per chunk
-   add_index< primary_index<limit_order_index > >();
-   add_index< primary_index<call_order_index > >();
+   auto limit_order_idx = add_index< primary_index<limit_order_index > >();
+   limit_order_idx->add_secondary_index< expiration_tracker< limit_order_object,
+         member< limit_order_object, time_point_sec, &limit_order_object::expiration > > >(
+         _expiration_scheduler.add_wheel<limit_order_object>() );
+   _limit_order_book = limit_order_idx->add_secondary_index<limit_order_book_index>();
+   limit_order_idx->add_secondary_index< margin_call_tracker<limit_order_object> >( _margin_call_frontier );
+   auto call_order_idx = add_index< primary_index<call_order_index > >();
+   call_order_idx->add_secondary_index< margin_call_tracker<call_order_object> >( _margin_call_frontier );
 
    auto prop_index = add_index< primary_index<proposal_index > >();
    prop_index->add_secondary_index<required_approval_index>();
-
-   add_index< primary_index<withdraw_permission_index > >();
-   add_index< primary_index<vesting_balance_index> >();
+   prop_index->add_secondary_index< expiration_tracker< proposal_object,
+         member< proposal_object, time_point_sec, &proposal_object::expiration_time > > >(
+         _expiration_scheduler.add_wheel<proposal_object>() );
+
+   auto withdraw_permission_idx = add_index< primary_index<withdraw_permission_index > >();
+   withdraw_permission_idx->add_secondary_index< expiration_tracker< withdraw_permission_object,
+         member< withdraw_permission_object, time_point_sec, &withdraw_permission_object::expiration > > >(
+         _expiration_scheduler.add_wheel<withdraw_permission_object>() );
+   auto vb_index = add_index< primary_index<vesting_balance_index> >();
+   vb_index->add_secondary_index< vote_tally_tracker<vesting_balance_object> >( _vote_tally_changes );
    add_index< primary_index<worker_index> >();
    add_index< primary_index<balance_index> >();
    add_index< primary_index<blinded_balance_index> >();
-   add_index< primary_index< htlc_index> >();
+   auto htlc_idx = add_index< primary_index< htlc_index> >();
+   htlc_idx->add_secondary_index< expiration_tracker< htlc_object, htlc_object::timelock_extractor > >(
+         _expiration_scheduler.add_wheel<htlc_object>() );
 
    //Implementation object indexes
-   add_index< primary_index<transaction_index                             > >();
+   auto trx_idx = add_index< primary_index<transaction_index                             > >();
+   trx_idx->add_secondary_index< expiration_tracker< transaction_object,
+         const_mem_fun< transaction_object, time_point_sec, &transaction_object::get_expiration > > >(
+         _expiration_scheduler.add_wheel<transaction_object>() );
 
    auto bal_idx = add_index< primary_index<account_balance_index          > >();
    bal_idx->add_secondary_index<balances_by_account_index>();
 
-   add_index< primary_index<asset_bitasset_data_index,                 13 > >(); // 8192
+   auto bitasset_idx = add_index< primary_index<asset_bitasset_data_index, 13 > >(); // 8192
+   bitasset_idx->add_secondary_index< margin_call_tracker<asset_bitasset_data_object> >( _margin_call_frontier );
    add_index< primary_index<simple_index<global_property_object          >> >();
    add_index< primary_index<simple_index<dynamic_global_property_object  >> >();
-   add_index< primary_index<account_stats_index,                       20 > >(); // 1 Mi
+   auto stats_index = add_index< primary_index<account_stats_index,    20 > >(); // 1 Mi
+   stats_index->add_secondary_index< vote_tally_tracker<account_statistics_object> >( _vote_tally_changes );
    add_index< primary_index<simple_index<asset_dynamic_data_object       >> >();
    add_index< primary_index<simple_index<block_summary_object            >> >();
    add_index< primary_index<simple_index<chain_property_object          > > >();
@@ -230,6 +254,10 @@ void database::initialize_indexes()
    add_index< primary_index< buyback_index                                > >();
    add_index< primary_index<collateral_bid_index                          > >();
    add_index< primary_index< simple_index< fba_accumulator_object       > > >();
+   auto vote_tally_idx = add_index< primary_index< simple_index< vote_tally_object > > >();
+   vote_tally_idx->add_secondary_index<vote_tally_revert_tracker>( _vote_tally_changes );
+   auto voter_record_idx = add_index< primary_index< voter_record_index   > >();
+   voter_record_idx->add_secondary_index<voter_record_tracker>( _vote_tally_changes );
 }
 
 void database::init_genesis(const genesis_state_type& genesis_state)
@@ -243,6 +271,28 @@ void database::init_genesis(const genesis_state_type& genesis_state)
              "initial_active_witnesses is larger than the number of candidate witnesses.");
 
    _undo_db.disable();
+   // the account indexes which only serve the API are built once from all genesis accounts at the end,
+   // the secondary indexes of other objects are read by genesis itself and kept up to date
+   // if genesis fails, the bulk load is ended nevertheless so that the index is complete again
+   struct bulk_load_guard {
+      bulk_load_guard(index& idx) : idx(idx) { idx.begin_bulk_load(); }
+      ~bulk_load_guard()
+      {
+         if( !active )
+            return;
+         try {
+            idx.end_bulk_load();
+         } catch( const fc::exception& e ) {
+            elog( "Could not rebuild the secondary indexes after a bulk load: ${e}", ("e", e.to_detail_string()) );
+         } catch( const std::exception& e ) {
+            elog( "Could not rebuild the secondary indexes after a bulk load: ${e}", ("e", e.what()) );
+         }
+      }
+      void end() { active = false; idx.end_bulk_load(); }
+   private:
+      index& idx;
+      bool active = true;
+   } account_bulk_load( get_mutable_index<account_object>() );
    struct auth_inhibitor {
       auth_inhibitor(database& db) : db(db), old_flags(db.node_properties().skip_flags)
       { db.node_properties().skip_flags |= skip_transaction_signatures; }
@@ -734,6 +784,7 @@ void database::init_genesis(const genesis_state_type& genesis_state)
 
    //debug_dump();
 
+   account_bulk_load.end();
    _undo_db.enable();
 } FC_CAPTURE_AND_RETHROW() }
 
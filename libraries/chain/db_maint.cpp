@@ -24,6 +24,7 @@
 
 #include <boost/multiprecision/integer.hpp>
 
+#include <fc/asio.hpp>
 #include <fc/uint128.hpp>
 
 #include <graphene/chain/database.hpp>
@@ -41,38 +42,374 @@
 #include <graphene/chain/market_object.hpp>
 #include <graphene/chain/special_authority_object.hpp>
 #include <graphene/chain/vesting_balance_object.hpp>
+#include <graphene/chain/vote_tally_object.hpp>
 #include <graphene/chain/vote_count.hpp>
 #include <graphene/chain/witness_object.hpp>
 #include <graphene/chain/worker_object.hpp>
 
+#include <future>
+
 namespace graphene { namespace chain {
 
+namespace {
+
+   /// The stake of one account and the account whose opinions it votes with
+   struct voter_stake
+   {
+      voter_stake( const account_object* o, uint64_t s ) : opinion_account( o ), stake( s ) {}
+
+      const account_object* opinion_account;
+      uint64_t              stake;
+   };
+
+   /**
+    * Vote totals, or a part of them. Histograms are indexed by the desired number of witnesses / committee
+    * members as specified by voters, see @ref fill_histogram. Addition is commutative, so partial tallies can
+    * be summed up in any order, and the running totals can be updated by subtracting the old contribution of
+    * a voter and adding the new one.
+    *
+    * Vote totals cover the vote ids below next_available_vote_id at the time of the tally, votes for other ids
+    * are ignored like before.
+    */
+   struct vote_tally_buffers
+   {
+      vote_tally_buffers() {}
+
+      explicit vote_tally_buffers( uint32_t vote_id_count ) : votes( vote_id_count, 0 ) {}
+
+      explicit vote_tally_buffers( const vote_tally_object& t )
+      : votes( t.votes ), witness_counts( t.witness_counts ), committee_counts( t.committee_counts ),
+        total_stake( t.total_stake )
+      {}
+
+      void add( const flat_set<vote_id_type>& opinions, uint16_t num_witness, uint16_t num_committee,
+                uint64_t voting_stake )
+      {
+         for( vote_id_type id : opinions )
+         {
+            // if they somehow managed to specify an illegal offset, ignore it.
+            if( id.instance() < votes.size() )
+               votes[ id.instance() ] += voting_stake;
+         }
+         at( witness_counts, num_witness ) += voting_stake;
+         at( committee_counts, num_committee ) += voting_stake;
+      }
+
+      void subtract( const flat_set<vote_id_type>& opinions, uint16_t num_witness, uint16_t num_committee,
+                     uint64_t voting_stake )
+      {
+         for( vote_id_type id : opinions )
+         {
+            if( id.instance() < votes.size() )
+               votes[ id.instance() ] -= voting_stake;
+         }
+         at( witness_counts, num_witness ) -= voting_stake;
+         at( committee_counts, num_committee ) -= voting_stake;
+      }
+
+      void add( const vector<voter_stake>& voters, size_t begin, size_t end )
+      {
+         for( size_t i = begin; i < end; ++i )
+         {
+            const account_options& opinions = voters[i].opinion_account->options;
+            add( opinions.votes, opinions.num_witness, opinions.num_committee, voters[i].stake );
+            total_stake += voters[i].stake;
+         }
+      }
+
+      void merge( const vote_tally_buffers& other )
+      {
+         FC_ASSERT( votes.size() == other.votes.size(), "Merging vote tallies of different vote ids" );
+         merge( votes, other.votes );
+         merge( witness_counts, other.witness_counts );
+         merge( committee_counts, other.committee_counts );
+         total_stake += other.total_stake;
+      }
+
+      vector<uint64_t> votes;
+      vector<uint64_t> witness_counts;
+      vector<uint64_t> committee_counts;
+      uint64_t         total_stake = 0;
+
+   private:
+      static uint64_t& at( vector<uint64_t>& v, size_t i )
+      {
+         if( i >= v.size() )
+            v.resize( i + 1 );
+         return v[i];
+      }
+
+      static void merge( vector<uint64_t>& target, const vector<uint64_t>& source )
+      {
+         if( source.size() > target.size() )
+            target.resize( source.size() );
+         for( size_t i = 0; i < source.size(); ++i )
+            target[i] += source[i];
+      }
+   };
+
+   /**
+    * Turns stake by desired number of witnesses / committee members into the histogram used by
+    * update_active_witnesses() and update_active_committee_members().
+    */
+   void fill_histogram( const vector<uint64_t>& counts, uint16_t max_count, vector<uint64_t>& histogram )
+   {
+      histogram.assign( max_count / 2 + 1, 0 );
+      // votes for a number greater than max_count are ignored
+      for( size_t n = 0; n < counts.size() && n <= max_count; ++n )
+      {
+         // in case the parameter was lowered, votes for a number greater than the new maximum are turned into votes
+         // for the maximum, the bound is only there for safety
+         histogram[ std::min( n / 2, histogram.size() - 1 ) ] += counts[n];
+      }
+   }
+
+   /// Below this number of voters per thread, tallying in parallel is not worth the overhead
+   const size_t min_voters_per_tally_thread = 10000;
+
+   /**
+    * Tallies the votes of @p voters for the first @p vote_id_count vote ids from scratch using up to
+    * @p thread_count threads.
+    *
+    * Worker threads are plain std::async tasks rather than fc tasks: waiting on an fc future would let
+    * the fc thread run other tasks, e.g. incoming transactions, in the middle of chain maintenance.
+    * The tally only reads account objects, which are not modified until all workers are done.
+    */
+   vote_tally_buffers tally_votes( const vector<voter_stake>& voters, uint32_t vote_id_count, size_t thread_count )
+   {
+      thread_count = std::min( thread_count, voters.size() / min_voters_per_tally_thread );
+
+      vote_tally_buffers result( vote_id_count );
+      if( thread_count <= 1 )
+      {
+         result.add( voters, 0, voters.size() );
+         return result;
+      }
+
+      const size_t chunk_size = ( voters.size() + thread_count - 1 ) / thread_count;
+      vector< std::future< vote_tally_buffers > > partial_tallies;
+      partial_tallies.reserve( thread_count - 1 );
+      // the first chunk is tallied by the calling thread
+      for( size_t begin = chunk_size; begin < voters.size(); begin += chunk_size )
+      {
+         const size_t end = std::min( begin + chunk_size, voters.size() );
+         partial_tallies.push_back( std::async( std::launch::async, [&voters,vote_id_count,begin,end]() {
+            vote_tally_buffers partial( vote_id_count );
+            partial.add( voters, begin, end );
+            return partial;
+         }));
+      }
+      result.add( voters, 0, chunk_size );
+      // merge in chunk order, so that the result does not depend on thread scheduling in any way
+      for( auto& partial : partial_tallies )
+         result.merge( partial.get() );
+      return result;
+   }
+
+   /**
+    * Recounts the votes of @p voters serially the way maintenance did before votes were tallied in parallel and
+    * maintained incrementally, straight into vote and histogram buffers, and compares the result with the
+    * buffers computed by maintenance.
+    */
+   void verify_vote_tally( const vector<voter_stake>& voters, const global_property_object& gpo,
+                           const vector<uint64_t>& votes, const vector<uint64_t>& witness_histogram,
+                           const vector<uint64_t>& committee_histogram, uint64_t total_stake )
+   {
+      vector<uint64_t> expected_votes( gpo.next_available_vote_id );
+      vector<uint64_t> expected_witnesses( gpo.parameters.maximum_witness_count / 2 + 1 );
+      vector<uint64_t> expected_committee( gpo.parameters.maximum_committee_count / 2 + 1 );
+      uint64_t expected_stake = 0;
+      for( const voter_stake& voter : voters )
+      {
+         const account_options& opinions = voter.opinion_account->options;
+         for( vote_id_type id : opinions.votes )
+         {
+            // if they somehow managed to specify an illegal offset, ignore it.
+            if( id.instance() < expected_votes.size() )
+               expected_votes[ id.instance() ] += voter.stake;
+         }
+         if( opinions.num_witness <= gpo.parameters.maximum_witness_count )
+            expected_witnesses[ std::min( size_t( opinions.num_witness / 2 ), expected_witnesses.size() - 1 ) ]
+               += voter.stake;
+         if( opinions.num_committee <= gpo.parameters.maximum_committee_count )
+            expected_committee[ std::min( size_t( opinions.num_committee / 2 ), expected_committee.size() - 1 ) ]
+               += voter.stake;
+         expected_stake += voter.stake;
+      }
+
+      FC_ASSERT( expected_stake == total_stake, "Total voting stake differs from a serial recount",
+                 ("voters", voters.size())("expected", expected_stake)("actual", total_stake) );
+      FC_ASSERT( expected_votes == votes, "Vote totals differ from a serial recount", ("voters", voters.size()) );
+      FC_ASSERT( expected_witnesses == witness_histogram,
+                 "Witness count histogram differs from a serial recount", ("voters", voters.size()) );
+      FC_ASSERT( expected_committee == committee_histogram,
+                 "Committee count histogram differs from a serial recount", ("voters", voters.size()) );
+   }
+
+   /**
+    * Keeps voter records up to date, and the running vote totals unless votes are being recounted in full.
+    *
+    * The stake of an account is counted in the proxied stake of its opinion account, and the proxied stake of
+    * each account is counted for its opinions. So a change of stake only touches the votes of one opinion account,
+    * and a change of opinions only moves the proxied stake of one account, no matter how many accounts proxy to it.
+    */
+   class voter_record_updater
+   {
+      public:
+         voter_record_updater( database& db, vote_tally_buffers* running )
+         : _db( db ), _running( running ),
+           _records( db.get_index_type<voter_record_index>().indices().get<by_account>() )
+         {}
+
+         /// @param opinion_account nullptr if the stake of @p account is not counted
+         void update( const account_object& account, const account_object* opinion_account, uint64_t stake )
+         {
+            const account_id_type opinion_id = ( stake > 0 ? opinion_account->id : account_id_type() );
+            const voter_record_object* record = find_record( account.id );
+            const uint64_t old_stake = ( record != nullptr ? record->stake : 0 );
+            const account_id_type old_opinion_id = ( record != nullptr ? record->opinion_account : account_id_type() );
+            if( stake != old_stake || opinion_id != old_opinion_id )
+            {
+               if( old_stake > 0 )
+                  change_proxied_stake( old_opinion_id(_db), old_stake, false );
+               if( stake > 0 )
+                  change_proxied_stake( *opinion_account, stake, true );
+               _db.modify( get_or_create_record( account ), [stake,opinion_id]( voter_record_object& r ) {
+                  r.stake = stake;
+                  r.opinion_account = opinion_id;
+               });
+               if( _running != nullptr )
+                  _running->total_stake = _running->total_stake - old_stake + stake;
+            }
+
+            // the opinions of the account, which are counted for the stake of the accounts proxying to it as well
+            record = find_record( account.id );
+            if( record == nullptr )
+               return;
+            if( !has_opinions_of( *record, account ) )
+            {
+               const account_options& opinions = account.options;
+               if( _running != nullptr && record->proxied_stake > 0 )
+               {
+                  _running->subtract( record->votes, record->num_witness, record->num_committee, record->proxied_stake );
+                  _running->add( opinions.votes, opinions.num_witness, opinions.num_committee, record->proxied_stake );
+               }
+               _db.modify( *record, [&opinions]( voter_record_object& r ) {
+                  r.votes = opinions.votes;
+                  r.num_witness = opinions.num_witness;
+                  r.num_committee = opinions.num_committee;
+               });
+            }
+            remove_if_unused( *record );
+         }
+
+         /// @return whether the record of @p account matches what @ref update would write
+         bool is_up_to_date( const account_object& account, const account_object* opinion_account, uint64_t stake )const
+         {
+            const voter_record_object* record = find_record( account.id );
+            if( record == nullptr )
+               return stake == 0;
+            return record->stake == stake
+                   && ( stake == 0 || record->opinion_account == opinion_account->id )
+                   && has_opinions_of( *record, account );
+         }
+
+      private:
+         static bool has_opinions_of( const voter_record_object& record, const account_object& account )
+         {
+            return record.votes == account.options.votes
+                   && record.num_witness == account.options.num_witness
+                   && record.num_committee == account.options.num_committee;
+         }
+
+         const voter_record_object* find_record( account_id_type account )const
+         {
+            auto itr = _records.find( account );
+            return itr != _records.end() ? &*itr : nullptr;
+         }
+
+         const voter_record_object& get_or_create_record( const account_object& account )
+         {
+            const voter_record_object* record = find_record( account.id );
+            if( record != nullptr )
+               return *record;
+            return _db.create<voter_record_object>( [&account]( voter_record_object& r ) {
+               r.account = account.id;
+               r.votes = account.options.votes;
+               r.num_witness = account.options.num_witness;
+               r.num_committee = account.options.num_committee;
+            });
+         }
+
+         void change_proxied_stake( const account_object& opinion_account, uint64_t stake, bool add )
+         {
+            const voter_record_object& record = get_or_create_record( opinion_account );
+            if( _running != nullptr )
+            {
+               if( add )
+                  _running->add( record.votes, record.num_witness, record.num_committee, stake );
+               else
+                  _running->subtract( record.votes, record.num_witness, record.num_committee, stake );
+            }
+            _db.modify( record, [stake,add]( voter_record_object& r ) {
+               r.proxied_stake = ( add ? r.proxied_stake + stake : r.proxied_stake - stake );
+            });
+            remove_if_unused( record );
+         }
+
+         void remove_if_unused( const voter_record_object& record )
+         {
+            if( record.is_unused() )
+               _db.remove( record );
+         }
+
+         database&                  _db;
+         vote_tally_buffers*        _running;
+         const voter_record_multi_index_type::index<by_account>::type& _records;
+   };
+
+} // anonymous namespace
+
 template<class Index>
 vector<std::reference_wrapper<const typename Index::object_type>> database::sort_votable_objects(size_t count) const
 {
    using ObjectType = typename Index::object_type;
    const auto& all_objects = get_index_type<Index>().indices();
    count = std::min(count, all_objects.size());
-   vector<std::reference_wrapper<const ObjectType>> refs;
-   refs.reserve(all_objects.size());
-   std::transform(all_objects.begin(), all_objects.end(),
-                  std::back_inserter(refs),
-                  [](const ObjectType& o) { return std::cref(o); });
-   std::partial_sort(refs.begin(), refs.begin() + count, refs.end(),
-                   [this](const ObjectType& a, const ObjectType& b)->bool {
+   auto ranks_higher = [this](const ObjectType& a, const ObjectType& b)->bool {
       share_type oa_vote = _vote_tally_buffer[a.vote_id];
       share_type ob_vote = _vote_tally_buffer[b.vote_id];
       if( oa_vote != ob_vote )
          return oa_vote > ob_vote;
       return a.vote_id < b.vote_id;
-   });
+   };
 
-   refs.resize(count, refs.front());
+   // Keep the top `count` objects seen so far in a heap with the lowest ranked of them on top,
+   // rather than copying all objects for sorting
+   vector<std::reference_wrapper<const ObjectType>> refs;
+   if( count == 0 )
+      return refs;
+   refs.reserve(count);
+   for( const ObjectType& o : all_objects )
+   {
+      if( refs.size() < count )
+      {
+         refs.push_back( std::cref(o) );
+         std::push_heap( refs.begin(), refs.end(), ranks_higher );
+      }
+      else if( ranks_higher( o, refs.front() ) )
+      {
+         std::pop_heap( refs.begin(), refs.end(), ranks_higher );
+         refs.back() = std::cref(o);
+         std::push_heap( refs.begin(), refs.end(), ranks_higher );
+      }
+   }
+   std::sort_heap( refs.begin(), refs.end(), ranks_higher );
    return refs;
 }
 
 template<class Type>
-void database::perform_account_maintenance(Type tally_helper)
+void database::perform_account_maintenance(Type& tally_helper)
 {
    const auto& bal_idx = get_index_type< account_balance_index >().indices().get< by_maintenance_flag >();
    if( bal_idx.begin() != bal_idx.end() )
@@ -94,22 +431,57 @@ void database::perform_account_maintenance(Type tally_helper)
       }
    }
 
+   // Accounts are visited in the order of their names: those with pending fees, those whose votes may have changed,
+   // or all of them if the tally helper asks for it. Paying fees may change the votes of other accounts, which are
+   // counted in this pass if they come later in the order, so candidates are looked up again after each account.
    const auto& stats_idx = get_index_type< account_stats_index >().indices().get< by_maintenance_seq >();
-   auto stats_itr = stats_idx.lower_bound( true );
+   const auto& accounts_by_name = get_index_type< account_index >().indices().get< by_name >();
+   vote_tally_changes& changes = *_vote_tally_changes;
+   std::map< string, account_id_type > changed_accounts;
 
-   while( stats_itr != stats_idx.end() )
+   bool first = true;
+   string last_name;
+   while( true )
    {
-      const account_statistics_object& acc_stat = *stats_itr;
-      const account_object& acc_obj = acc_stat.owner( *this );
-      ++stats_itr;
+      for( account_id_type id : changes.accounts )
+      {
+         const account_object* changed = find( id );
+         if( changed != nullptr )
+            changed_accounts.emplace( changed->name, id );
+      }
+      changes.accounts.clear();
+
+      const account_object* next = nullptr;
+      auto stats_itr = first ? stats_idx.lower_bound( true ) : stats_idx.upper_bound( boost::make_tuple( true, last_name ) );
+      if( stats_itr != stats_idx.end() )
+         next = &stats_itr->owner( *this );
+      auto changed_itr = first ? changed_accounts.begin() : changed_accounts.upper_bound( last_name );
+      if( changed_itr != changed_accounts.end() && ( next == nullptr || changed_itr->first < next->name ) )
+         next = &changed_itr->second( *this );
+      if( tally_helper.visit_all_accounts() )
+      {
+         auto acc_itr = first ? accounts_by_name.begin() : accounts_by_name.upper_bound( last_name );
+         if( acc_itr != accounts_by_name.end() && ( next == nullptr || acc_itr->name < next->name ) )
+            next = &*acc_itr;
+      }
+      if( next == nullptr )
+         break;
 
-      if( acc_stat.has_some_core_voting() )
-         tally_helper( acc_obj, acc_stat );
+      first = false;
+      last_name = next->name;
+      const account_object& acc_obj = *next;
+      const account_statistics_object& acc_stat = acc_obj.statistics( *this );
+      const bool votes_changed = ( changed_accounts.erase( acc_obj.name ) > 0 );
+
+      tally_helper( acc_obj, acc_stat, votes_changed );
 
       if( acc_stat.has_pending_fees() )
          acc_stat.process_fees( acc_obj, *this );
    }
 
+   // changes of accounts which have been visited already are counted at the next maintenance interval
+   for( const auto& item : changed_accounts )
+      changes.accounts.insert( item.second );
 }
 
 /// @brief A visitor for @ref worker_type which calls pay_worker on the worker within
@@ -707,9 +1079,11 @@ void create_buyback_orders( database& db )
          continue;
       }
 
-      for( const auto& entry : bal_idx.get_account_balances( buyback_account.id ) )
+      // the orders created below may add balances to the list, so iterate over a copy
+      const auto& balances = bal_idx.get_account_balances( buyback_account.id );
+      const vector< const account_balance_object* > balances_to_sell( balances.begin(), balances.end() );
+      for( const account_balance_object* it : balances_to_sell )
       {
-         const auto* it = entry.second;
          asset_id_type asset_to_sell = it->asset_type;
          share_type amount_to_sell = it->balance;
          if( asset_to_sell == asset_to_buy.id )
@@ -800,7 +1174,8 @@ void database::process_bids( const asset_bitasset_data_object& bad )
    const asset_dynamic_data_object& bdd = to_revive.dynamic_data( *this );
 
    const auto& bid_idx = get_index_type< collateral_bid_index >().indices().get<by_price>();
-   const auto start = bid_idx.lower_bound( boost::make_tuple( to_revive_id, price::max( bad.options.short_backing_asset, to_revive_id ), collateral_bid_id_type() ) );
+   const price max_bid = price::max( bad.options.short_backing_asset, to_revive_id );
+   const auto start = bid_idx.lower_bound( boost::make_tuple( to_revive_id, price_sort_key( max_bid ), max_bid, collateral_bid_id_type() ) );
 
    share_type covered = 0;
    auto itr = start;
@@ -1146,76 +1521,129 @@ void process_hf_935( database& db )
 void database::perform_chain_maintenance(const signed_block& next_block, const global_property_object& global_props)
 {
    const auto& gpo = get_global_properties();
+   typedef block_phase_tracer::scoped_phase scoped_phase;
 
-   distribute_fba_balances(*this);
-   create_buyback_orders(*this);
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::maint_fba_and_buyback );
+      distribute_fba_balances(*this);
+      create_buyback_orders(*this);
+   }
 
+   // Vote totals are maintained incrementally: only the accounts whose voting stake or opinions may have changed
+   // since the last maintenance interval are revisited. The stake of an account is taken at the time the account is
+   // visited, since paying fees may change the cashback balance of accounts visited later.
+   //
+   // Votes are recounted in full once after startup, and every time if non-member votes don't count, because
+   // memberships expire over time. The recount is done in parallel, see tally_votes().
    struct vote_tally_helper {
       database& d;
       const global_property_object& props;
+      voter_record_updater records;
+      vote_tally_buffers* running;  ///< nullptr when recounting in full
+      bool verify;
+      vector<voter_stake> voters;   ///< stakes of all voters, collected when recounting in full or verifying
+      uint32_t mismatched_records = 0;
 
-      vote_tally_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo)
-      {
-         d._vote_tally_buffer.resize(props.next_available_vote_id);
-         d._witness_count_histogram_buffer.resize(props.parameters.maximum_witness_count / 2 + 1);
-         d._committee_count_histogram_buffer.resize(props.parameters.maximum_committee_count / 2 + 1);
-         d._total_voting_stake = 0;
-      }
+      vote_tally_helper(database& d, const global_property_object& gpo, vote_tally_buffers* running, bool verify)
+         : d(d), props(gpo), records(d, running), running(running), verify(verify)
+      {}
 
-      void operator()( const account_object& stake_account, const account_statistics_object& stats )
+      bool visit_all_accounts()const { return running == nullptr || verify; }
+
+      void operator()( const account_object& stake_account, const account_statistics_object& stats, bool changed )
       {
-         if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
+         const account_object* opinion_account = nullptr;
+         uint64_t voting_stake = 0;
+         if( stats.has_some_core_voting()
+             && ( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) ) )
          {
             // There may be a difference between the account whose stake is voting and the one specifying opinions.
             // Usually they're the same, but if the stake account has specified a voting_account, that account is the one
             // specifying the opinions.
-            const account_object& opinion_account =
+            opinion_account =
                   (stake_account.options.voting_account ==
-                   GRAPHENE_PROXY_TO_SELF_ACCOUNT)? stake_account
-                                     : d.get(stake_account.options.voting_account);
+                   GRAPHENE_PROXY_TO_SELF_ACCOUNT)? &stake_account
+                                     : &d.get(stake_account.options.voting_account);
 
-            uint64_t voting_stake = stats.total_core_in_orders.value
+            voting_stake = stats.total_core_in_orders.value
                   + (stake_account.cashback_vb.valid() ? (*stake_account.cashback_vb)(d).balance.amount.value: 0)
                   + stats.core_in_balance.value;
 
-            for( vote_id_type id : opinion_account.options.votes )
-            {
-               uint32_t offset = id.instance();
-               // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake;
-            }
-
-            if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
-                                          d._witness_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_witness_count
-               // are turned into votes for maximum_witness_count.
-               //
-               // in particular, this takes care of the case where a
-               // member was voting for a high number, then the
-               // parameter was lowered.
-               d._witness_count_histogram_buffer[offset] += voting_stake;
-            }
-            if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
-                                          d._committee_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_committee_count
-               // are turned into votes for maximum_committee_count.
-               //
-               // same rationale as for witnesses
-               d._committee_count_histogram_buffer[offset] += voting_stake;
-            }
+            if( visit_all_accounts() )
+               voters.emplace_back( opinion_account, voting_stake );
+         }
 
-            d._total_voting_stake += voting_stake;
+         if( changed || running == nullptr )
+            records.update( stake_account, opinion_account, voting_stake );
+         else if( verify && !records.is_up_to_date( stake_account, opinion_account, voting_stake ) )
+         {
+            if( mismatched_records < 10 )
+               elog( "Votes of account ${a} changed without being tracked", ("a", stake_account.name) );
+            ++mismatched_records;
          }
       }
-   } tally_helper(*this, gpo);
+   };
+
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::maint_account_maintenance );
+
+      // voter records and vote totals are modified below, which keeps track of what it does itself
+      struct track_records_guard {
+         vote_tally_changes& changes;
+         track_records_guard( vote_tally_changes& c ) : changes( c ) { changes.track_records = false; }
+         ~track_records_guard() { changes.track_records = true; }
+      } guard( *_vote_tally_changes );
+
+      const vote_tally_object* tally_obj = find( vote_tally_id_type() );
+      const bool created = ( tally_obj == nullptr );
+      if( created )
+         tally_obj = &create<vote_tally_object>( []( vote_tally_object& t ) {} );
+      // the running totals don't include votes for ids created since they were counted
+      const bool recount = ( created
+                             || _vote_tally_changes->recount
+                             || tally_obj->votes.size() != gpo.next_available_vote_id
+                             || !gpo.parameters.count_non_member_votes
+                             || !tally_obj->count_non_member_votes );
+
+      optional<vote_tally_buffers> running;
+      if( !recount )
+         running = vote_tally_buffers( *tally_obj );
+
+      vote_tally_helper tally_helper( *this, gpo, running.valid() ? &*running : nullptr, _verify_vote_tally );
+      perform_account_maintenance( tally_helper );
+
+      const size_t tally_threads = ( _vote_tally_threads > 0 ? _vote_tally_threads
+                                       : fc::asio::default_io_service_scope::get_num_threads() );
+      vote_tally_buffers tally;
+      if( recount )
+         tally = tally_votes( tally_helper.voters, gpo.next_available_vote_id, tally_threads );
+      else
+      {
+         tally = std::move( *running );
+         if( _verify_vote_tally )
+            FC_ASSERT( tally_helper.mismatched_records == 0, "Votes of some accounts changed without being tracked",
+                       ("accounts", tally_helper.mismatched_records) );
+      }
 
-   perform_account_maintenance( tally_helper );
+      _vote_tally_buffer = tally.votes;
+      fill_histogram( tally.witness_counts, gpo.parameters.maximum_witness_count, _witness_count_histogram_buffer );
+      fill_histogram( tally.committee_counts, gpo.parameters.maximum_committee_count,
+                      _committee_count_histogram_buffer );
+      _total_voting_stake = tally.total_stake;
+      if( _verify_vote_tally )
+         verify_vote_tally( tally_helper.voters, gpo, _vote_tally_buffer, _witness_count_histogram_buffer,
+                            _committee_count_histogram_buffer, _total_voting_stake );
+
+      modify( *tally_obj, [&tally,&gpo]( vote_tally_object& t ) {
+         t.votes = std::move( tally.votes );
+         t.witness_counts = std::move( tally.witness_counts );
+         t.committee_counts = std::move( tally.committee_counts );
+         t.total_stake = tally.total_stake;
+         t.count_non_member_votes = gpo.parameters.count_non_member_votes;
+      });
+      // if this block is undone, vote_tally_revert_tracker requests the recount again
+      _vote_tally_changes->recount = false;
+   }
 
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
@@ -1227,13 +1655,27 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                 b(_committee_count_histogram_buffer),
                 c(_vote_tally_buffer);
 
-   update_top_n_authorities(*this);
-   update_active_witnesses();
-   update_active_committee_members();
-   update_worker_votes();
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::maint_top_n_authorities );
+      update_top_n_authorities(*this);
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::maint_active_witnesses );
+      update_active_witnesses();
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::maint_active_committee_members );
+      update_active_committee_members();
+   }
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::maint_worker_votes );
+      update_worker_votes();
+   }
 
    const dynamic_global_property_object& dgpo = get_dynamic_global_properties();
 
+   optional<scoped_phase> global_properties_phase;
+   global_properties_phase.emplace( _block_phase_tracer, block_phase::maint_global_properties );
    modify(gpo, [&dgpo](global_property_object& p) {
       // Remove scaling of account registration fee
       p.parameters.current_fees->get<account_create_operation>().basic_fee >>= p.parameters.account_fee_scale_bitshifts *
@@ -1276,6 +1718,10 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
       }
    }
 
+   global_properties_phase.reset();
+   optional<scoped_phase> hardfork_phase;
+   hardfork_phase.emplace( _block_phase_tracer, block_phase::maint_hardfork_processing );
+
    if( (dgpo.next_maintenance_time < HARDFORK_613_TIME) && (next_maintenance_time >= HARDFORK_613_TIME) )
       deprecate_annual_members(*this);
 
@@ -1321,12 +1767,19 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
       update_median_feeds(*this);
       match_call_orders(*this);
    }
+   hardfork_phase.reset();
 
-   process_bitassets();
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::maint_bitassets );
+      process_bitassets();
+   }
 
    // process_budget needs to run at the bottom because
    //   it needs to know the next_maintenance_time
-   process_budget();
+   {
+      scoped_phase phase( _block_phase_tracer, block_phase::maint_budget );
+      process_budget();
+   }
 }
 
 } }
@@ -191,6 +191,9 @@ void database::open(
           version_file.close();
       }
 
+      // objects are loaded in parallel, don't track them
+      _vote_tally_changes->enabled = false;
+      _margin_call_frontier->clear();
       object_database::open(data_dir);
 
       _block_id_to_block.open(data_dir / "database" / "block_num_to_block");
@@ -207,6 +210,9 @@ void database::open(
          _p_witness_schedule_obj = &get( witness_schedule_id_type() );
       }
 
+      // changes made before tracking started are unknown, recount all votes at the next maintenance interval
+      _vote_tally_changes->reset();
+
       fc::optional<block_id_type> last_block = _block_id_to_block.last_id();
       if( last_block.valid() )
       {
@@ -224,7 +230,8 @@ void database::close(bool rewind)
 {
    if (!_opened)
       return;
-      
+
+   chain_access_lock::write_guard write_guard( _chain_access_lock );
    // TODO:  Save pending tx's on close()
    clear_pending();
 
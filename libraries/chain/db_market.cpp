@@ -68,8 +68,8 @@ void database::globally_settle_asset( const asset_object& mia, const price& sett
    bool before_core_hardfork_342 = ( maint_time <= HARDFORK_CORE_342_TIME ); // better rounding
 
    // cancel all call orders and accumulate it into collateral_gathered
-   auto call_itr = call_price_index.lower_bound( price::min( bitasset.options.short_backing_asset, mia.id ) );
-   auto call_end = call_price_index.upper_bound( price::max( bitasset.options.short_backing_asset, mia.id ) );
+   auto call_itr = call_price_index.lower_bound( price_index_key( price::min( bitasset.options.short_backing_asset, mia.id ) ) );
+   auto call_end = call_price_index.upper_bound( price_index_key( price::max( bitasset.options.short_backing_asset, mia.id ) ) );
    asset pays;
    while( call_itr != call_end )
    {
@@ -140,8 +140,8 @@ void database::_cancel_bids_and_revive_mpa( const asset_object& bitasset, const
 
    // cancel remaining bids
    const auto& bid_idx = get_index_type< collateral_bid_index >().indices().get<by_price>();
-   auto itr = bid_idx.lower_bound( boost::make_tuple( bitasset.id,
-                                                      price::max( bad.options.short_backing_asset, bitasset.id ),
+   const price max_bid = price::max( bad.options.short_backing_asset, bitasset.id );
+   auto itr = bid_idx.lower_bound( boost::make_tuple( bitasset.id, price_sort_key( max_bid ), max_bid,
                                                       collateral_bid_id_type() ) );
    while( itr != bid_idx.end() && itr->inv_swan_price.quote.asset_id == bitasset.id )
    {
@@ -339,6 +339,15 @@ bool maybe_cull_small_order( database& db, const limit_order_object& order )
    return false;
 }
 
+/// @return the best order selling @p max_price.base for @p max_price.quote if its price is at least @p max_price
+static const limit_order_object* best_maker_order( const limit_order_book_index& book, const price& max_price )
+{
+   const limit_order_object* order = book.best_order( max_price.base.asset_id, max_price.quote.asset_id );
+   if( order == nullptr || order->sell_price < max_price )
+      return nullptr;
+   return order;
+}
+
 bool database::apply_order_before_hardfork_625(const limit_order_object& new_order_object, bool allow_black_swan)
 {
    auto order_id = new_order_object.id;
@@ -353,24 +362,17 @@ bool database::apply_order_before_hardfork_625(const limit_order_object& new_ord
    if( called_some && !find_object(order_id) ) // then we were filled by call order
       return true;
 
-   const auto& limit_price_idx = get_index_type<limit_order_index>().indices().get<by_price>();
-
-   // TODO: it should be possible to simply check the NEXT/PREV iterator after new_order_object to
-   // determine whether or not this order has "changed the book" in a way that requires us to
-   // check orders. For now I just lookup the lower bound and check for equality... this is log(n) vs
-   // constant time check. Potential optimization.
-
-   auto max_price = ~new_order_object.sell_price;
-   auto limit_itr = limit_price_idx.lower_bound(max_price.max());
-   auto limit_end = limit_price_idx.upper_bound(max_price);
+   // the best order of the opposite side, as long as it is at least at the price the new order asks for
+   const price max_price = ~new_order_object.sell_price;
+   const limit_order_object* maker = best_maker_order( *_limit_order_book, max_price );
 
    bool finished = false;
-   while( !finished && limit_itr != limit_end )
+   while( !finished && maker != nullptr )
    {
-      auto old_limit_itr = limit_itr;
-      ++limit_itr;
       // match returns 2 when only the old order was fully filled. In this case, we keep matching; otherwise, we stop.
-      finished = (match(new_order_object, *old_limit_itr, old_limit_itr->sell_price) != 2);
+      finished = (match(new_order_object, *maker, maker->sell_price) != 2);
+      if( !finished )
+         maker = best_maker_order( *_limit_order_book, max_price );
    }
 
    //Possible optimization: only check calls if the new order completely filled some old order
@@ -397,19 +399,13 @@ bool database::apply_order(const limit_order_object& new_order_object, bool allo
    asset_id_type recv_asset_id = new_order_object.receive_asset_id();
 
    // We only need to check if the new order will match with others if it is at the front of the book
-   const auto& limit_price_idx = get_index_type<limit_order_index>().indices().get<by_price>();
-   auto limit_itr = limit_price_idx.lower_bound( boost::make_tuple( new_order_object.sell_price, order_id ) );
-   if( limit_itr != limit_price_idx.begin() )
-   {
-      --limit_itr;
-      if( limit_itr->sell_asset_id() == sell_asset_id && limit_itr->receive_asset_id() == recv_asset_id )
-         return false;
-   }
+   if( _limit_order_book->best_order( sell_asset_id, recv_asset_id ) != &new_order_object )
+      return false;
 
-   // this is the opposite side (on the book)
-   auto max_price = ~new_order_object.sell_price;
-   limit_itr = limit_price_idx.lower_bound( max_price.max() );
-   auto limit_end = limit_price_idx.upper_bound( max_price );
+   // this is the opposite side (on the book), the best order there is matched first, as long as its price is
+   // at least the price the new order asks for
+   const price max_price = ~new_order_object.sell_price;
+   const limit_order_object* maker = best_maker_order( *_limit_order_book, max_price );
 
    // Order matching should be in favor of the taker.
    // When a new limit order is created, e.g. an ask, need to check if it will match the highest bid.
@@ -470,12 +466,12 @@ bool database::apply_order(const limit_order_object& new_order_object, bool allo
    if( to_check_call_orders )
    {
       // check limit orders first, match the ones with better price in comparison to call orders
-      while( !finished && limit_itr != limit_end && limit_itr->sell_price > call_match_price )
+      while( !finished && maker != nullptr && maker->sell_price > call_match_price )
       {
-         auto old_limit_itr = limit_itr;
-         ++limit_itr;
          // match returns 2 when only the old order was fully filled. In this case, we keep matching; otherwise, we stop.
-         finished = ( match( new_order_object, *old_limit_itr, old_limit_itr->sell_price ) != 2 );
+         finished = ( match( new_order_object, *maker, maker->sell_price ) != 2 );
+         if( !finished )
+            maker = best_maker_order( *_limit_order_book, max_price );
       }
 
       if( !finished && !before_core_hardfork_1270 ) // TODO refactor or cleanup duplicate code after core-1270 hard fork
@@ -487,7 +483,7 @@ bool database::apply_order(const limit_order_object& new_order_object, bool allo
          {
             // hard fork core-343 and core-625 took place at same time,
             // always check call order with least collateral ratio
-            auto call_itr = call_collateral_idx.lower_bound( call_min );
+            auto call_itr = call_collateral_idx.lower_bound( price_index_key( call_min ) );
             if( call_itr == call_collateral_idx.end()
                   || call_itr->debt_type() != sell_asset_id
                   // feed protected https://github.com/cryptonomex/graphene/issues/436
@@ -512,7 +508,7 @@ bool database::apply_order(const limit_order_object& new_order_object, bool allo
          while( !finished )
          {
             // assume hard fork core-343 and core-625 will take place at same time, always check call order with least call_price
-            auto call_itr = call_price_idx.lower_bound( call_min );
+            auto call_itr = call_price_idx.lower_bound( price_index_key( call_min ) );
             if( call_itr == call_price_idx.end()
                   || call_itr->debt_type() != sell_asset_id
                   // feed protected https://github.com/cryptonomex/graphene/issues/436
@@ -532,12 +528,12 @@ bool database::apply_order(const limit_order_object& new_order_object, bool allo
    }
 
    // still need to check limit orders
-   while( !finished && limit_itr != limit_end )
+   while( !finished && maker != nullptr )
    {
-      auto old_limit_itr = limit_itr;
-      ++limit_itr;
       // match returns 2 when only the old order was fully filled. In this case, we keep matching; otherwise, we stop.
-      finished = ( match( new_order_object, *old_limit_itr, old_limit_itr->sell_price ) != 2 );
+      finished = ( match( new_order_object, *maker, maker->sell_price ) != 2 );
+      if( !finished )
+         maker = best_maker_order( *_limit_order_book, max_price );
    }
 
    const limit_order_object* updated_order_object = find< limit_order_object >( order_id );
@@ -986,6 +982,13 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
 
     if( !mia.is_market_issued() ) return false;
 
+    auto head_time = head_block_time();
+    bool after_hardfork_436 = ( head_time > HARDFORK_436_TIME );
+
+    // nothing changed since the last check found nothing to call
+    if( _margin_call_frontier->is_quiet( mia.id, maint_time, after_hardfork_436 ) )
+       return false;
+
     const asset_bitasset_data_object& bitasset = ( bitasset_ptr ? *bitasset_ptr : mia.bitasset_data(*this) );
 
     if( check_for_blackswan( mia, enable_black_swan, &bitasset ) )
@@ -1006,11 +1009,14 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
                                                  : bitasset.current_feed.max_short_squeeze_price() );
 
     // NOTE limit_price_index is sorted from greatest to least
-    auto limit_itr = limit_price_index.lower_bound( max_price );
-    auto limit_end = limit_price_index.upper_bound( min_price );
+    auto limit_itr = limit_price_index.lower_bound( price_index_key( max_price ) );
+    auto limit_end = limit_price_index.upper_bound( price_index_key( min_price ) );
 
     if( limit_itr == limit_end )
+    {
+       _margin_call_frontier->mark_quiet( mia.id, maint_time, after_hardfork_436 );
        return false;
+    }
 
     const call_order_index& call_index = get_index_type<call_order_index>();
     const auto& call_price_index = call_index.indices().get<by_price>();
@@ -1026,23 +1032,21 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
 
     if( before_core_hardfork_1270 )
     {
-       call_price_itr = call_price_index.lower_bound( call_min );
-       call_price_end = call_price_index.upper_bound( call_max );
+       call_price_itr = call_price_index.lower_bound( price_index_key( call_min ) );
+       call_price_end = call_price_index.upper_bound( price_index_key( call_max ) );
     }
     else
     {
-       call_collateral_itr = call_collateral_index.lower_bound( call_min );
-       call_collateral_end = call_collateral_index.upper_bound( call_max );
+       call_collateral_itr = call_collateral_index.lower_bound( price_index_key( call_min ) );
+       call_collateral_end = call_collateral_index.upper_bound( price_index_key( call_max ) );
     }
 
     bool filled_limit = false;
     bool margin_called = false;
 
-    auto head_time = head_block_time();
     auto head_num = head_block_num();
 
     bool before_hardfork_615 = ( head_time < HARDFORK_615_TIME );
-    bool after_hardfork_436 = ( head_time > HARDFORK_436_TIME );
 
     bool before_core_hardfork_184 = ( maint_time <= HARDFORK_CORE_184_TIME ); // something-for-nothing
     bool before_core_hardfork_342 = ( maint_time <= HARDFORK_CORE_342_TIME ); // better rounding
@@ -1064,7 +1068,11 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
        if( ( !before_core_hardfork_1270 && bitasset.current_maintenance_collateralization < call_order.collateralization() )
              || ( before_core_hardfork_1270
                    && after_hardfork_436 && bitasset.current_feed.settlement_price > ~call_order.call_price ) )
+       {
+          if( !margin_called )
+             _margin_call_frontier->mark_quiet( mia.id, maint_time, after_hardfork_436 );
           return margin_called;
+       }
 
        const limit_order_object& limit_order = *limit_itr;
        price match_price  = limit_order.sell_price;
@@ -1072,7 +1080,11 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
 
        // Old rule: margin calls can only buy high https://github.com/bitshares/bitshares-core/issues/606
        if( before_core_hardfork_606 && match_price > ~call_order.call_price )
+       {
+          if( !margin_called )
+             _margin_call_frontier->mark_quiet( mia.id, maint_time, after_hardfork_436 );
           return margin_called;
+       }
 
        margin_called = true;
 
@@ -1167,9 +1179,9 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
        // when for_new_limit_order is true, the call order is maker, otherwise the call order is taker
        fill_call_order( call_order, call_pays, call_receives, match_price, for_new_limit_order );
        if( !before_core_hardfork_1270 )
-          call_collateral_itr = call_collateral_index.lower_bound( call_min );
+          call_collateral_itr = call_collateral_index.lower_bound( price_index_key( call_min ) );
        else if( !before_core_hardfork_343 )
-          call_price_itr = call_price_index.lower_bound( call_min );
+          call_price_itr = call_price_index.lower_bound( price_index_key( call_min ) );
 
        auto next_limit_itr = std::next( limit_itr );
        // when for_new_limit_order is true, the limit order is taker, otherwise the limit order is maker
@@ -1179,6 +1191,8 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
 
     } // while call_itr != call_end
 
+    if( !margin_called )
+       _margin_call_frontier->mark_quiet( mia.id, maint_time, after_hardfork_436 );
     return margin_called;
 } FC_CAPTURE_AND_RETHROW() }
 
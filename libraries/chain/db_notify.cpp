@@ -15,6 +15,7 @@
 #include <graphene/chain/operation_history_object.hpp>
 #include <graphene/chain/vesting_balance_object.hpp>
 #include <graphene/chain/transaction_object.hpp>
+#include <graphene/chain/vote_tally_object.hpp>
 #include <graphene/chain/impacted.hpp>
 
 using namespace fc;
@@ -436,6 +437,13 @@ void get_relevant_accounts( const object* obj, flat_set<account_id_type>& accoun
               FC_ASSERT( aobj != nullptr );
               accounts.insert( aobj->bidder );
               break;
+           } case impl_vote_tally_object_type:
+              break;
+             case impl_voter_record_object_type:{
+              const auto& aobj = dynamic_cast<const voter_record_object*>(obj);
+              FC_ASSERT( aobj != nullptr );
+              accounts.insert( aobj->account );
+              break;
            }
       }
    }
@@ -453,11 +461,25 @@ void database::notify_on_pending_transaction( const signed_transaction& tx )
    GRAPHENE_TRY_NOTIFY( on_pending_transaction, tx )
 }
 
+std::shared_ptr<void> database::request_impacted_accounts()
+{
+   auto requests = _impacted_account_requests;
+   ++*requests;
+   return std::shared_ptr<void>( nullptr, [requests]( void* ) { --*requests; } );
+}
+
+boost::signals2::connection database::subscribe_to_object_changes( uint8_t space_id, uint8_t type_id,
+                                                                   std::function<void(const object_changes&)> callback )
+{
+   return _object_change_signals[ object_id_type( space_id, type_id, 0 ).space_type() ].connect( callback );
+}
+
 void database::notify_changed_objects()
 { try {
    if( _undo_db.enabled() ) 
    {
       const auto& head_undo = _undo_db.head();
+      const bool with_accounts = impacted_accounts_requested();
 
       // New
       if( !new_objects.empty() )
@@ -467,6 +489,8 @@ void database::notify_changed_objects()
         for( const auto& item : head_undo.new_ids )
         {
           new_ids.push_back(item);
+          if( !with_accounts )
+            continue;
           auto obj = find_object(item);
           if(obj != nullptr)
             get_relevant_accounts(obj, new_accounts_impacted);
@@ -484,7 +508,8 @@ void database::notify_changed_objects()
         for( const auto& item : head_undo.old_values )
         {
           changed_ids.push_back(item.first);
-          get_relevant_accounts(item.second.get(), changed_accounts_impacted);
+          if( with_accounts )
+            get_relevant_accounts(item.second.get(), changed_accounts_impacted);
         }
 
         if( changed_ids.size() )
@@ -502,12 +527,37 @@ void database::notify_changed_objects()
           removed_ids.emplace_back( item.first );
           auto obj = item.second.get();
           removed.emplace_back( obj );
-          get_relevant_accounts(obj, removed_accounts_impacted);
+          if( with_accounts )
+            get_relevant_accounts(obj, removed_accounts_impacted);
         }
 
         if( removed_ids.size() )
            GRAPHENE_TRY_NOTIFY( removed_objects, removed_ids, removed, removed_accounts_impacted)
       }
+
+      // Typed change streams, the undo state is bucketed in a single pass over it
+      if( !_object_change_signals.empty() )
+      {
+        std::map< uint16_t, object_changes > changes;
+        auto changes_of = [this,&changes]( object_id_type id ) -> object_changes* {
+          auto sig = _object_change_signals.find( id.space_type() );
+          if( sig == _object_change_signals.end() || sig->second.empty() )
+            return nullptr;
+          return &changes[ id.space_type() ];
+        };
+        for( const auto& item : head_undo.new_ids )
+          if( object_changes* c = changes_of( item ) )
+            c->new_ids.push_back( item );
+        for( const auto& item : head_undo.old_values )
+          if( object_changes* c = changes_of( item.first ) )
+            c->changed_ids.push_back( item.first );
+        for( const auto& item : head_undo.removed )
+          if( object_changes* c = changes_of( item.first ) )
+            c->removed.push_back( item.second.get() );
+
+        for( const auto& item : changes )
+          GRAPHENE_TRY_NOTIFY( _object_change_signals[ item.first ], item.second )
+      }
    }
 } FC_CAPTURE_AND_LOG( (0) ) }
 
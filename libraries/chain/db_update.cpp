@@ -146,17 +146,19 @@ void database::clear_expired_transactions()
    //Look for expired transactions in the deduplication list, and remove them.
    //Transactions must have expired by at least two forking windows in order to be removed.
    auto& transaction_idx = static_cast<transaction_index&>(get_mutable_index(implementation_ids, impl_transaction_object_type));
-   const auto& dedupe_index = transaction_idx.indices().get<by_expiration>();
-   while( (!dedupe_index.empty()) && (head_block_time() > dedupe_index.begin()->trx.expiration) )
-      transaction_idx.remove(*dedupe_index.begin());
+   auto& wheel = _expiration_scheduler.get_wheel<transaction_object>();
+   // transactions are removed once the head block time is past their expiration
+   const time_point_sec last_expiration( head_block_time().sec_since_epoch() - 1 );
+   while( const object_id_type* id = wheel.next_due( last_expiration ) )
+      transaction_idx.remove( get_object( *id ) );
 } FC_CAPTURE_AND_RETHROW() }
 
 void database::clear_expired_proposals()
 {
-   const auto& proposal_expiration_index = get_index_type<proposal_index>().indices().get<by_expiration>();
-   while( !proposal_expiration_index.empty() && proposal_expiration_index.begin()->expiration_time <= head_block_time() )
+   auto& wheel = _expiration_scheduler.get_wheel<proposal_object>();
+   while( const object_id_type* id = wheel.next_due( head_block_time() ) )
    {
-      const proposal_object& proposal = *proposal_expiration_index.begin();
+      const proposal_object& proposal = get<proposal_object>( *id );
       processed_transaction result;
       try {
          if( proposal.is_authorized_to_execute(*this) )
@@ -203,7 +205,7 @@ bool database::check_for_blackswan( const asset_object& mia, bool enable_black_s
     if( before_core_hardfork_1270 ) // before core-1270 hard fork, check with call_price
     {
        const auto& call_price_index = get_index_type<call_order_index>().indices().get<by_price>();
-       auto call_itr = call_price_index.lower_bound( call_min );
+       auto call_itr = call_price_index.lower_bound( price_index_key( call_min ) );
        if( call_itr == call_price_index.end() ) // no call order
           return false;
        call_ptr = &(*call_itr);
@@ -211,7 +213,7 @@ bool database::check_for_blackswan( const asset_object& mia, bool enable_black_s
     else // after core-1270 hard fork, check with collateralization
     {
        const auto& call_collateral_index = get_index_type<call_order_index>().indices().get<by_collateral>();
-       auto call_itr = call_collateral_index.lower_bound( call_min );
+       auto call_itr = call_collateral_index.lower_bound( price_index_key( call_min ) );
        if( call_itr == call_collateral_index.end() ) // no call order
           return false;
        call_ptr = &(*call_itr);
@@ -237,8 +239,8 @@ bool database::check_for_blackswan( const asset_object& mia, bool enable_black_s
 
     FC_ASSERT( highest_possible_bid.base.asset_id == lowest_possible_bid.base.asset_id );
     // NOTE limit_price_index is sorted from greatest to least
-    auto limit_itr = limit_price_index.lower_bound( highest_possible_bid );
-    auto limit_end = limit_price_index.upper_bound( lowest_possible_bid );
+    auto limit_itr = limit_price_index.lower_bound( price_index_key( highest_possible_bid ) );
+    auto limit_end = limit_price_index.upper_bound( price_index_key( lowest_possible_bid ) );
 
     if( limit_itr != limit_end ) {
        FC_ASSERT( highest.base.asset_id == limit_itr->sell_price.base.asset_id );
@@ -281,10 +283,10 @@ void database::clear_expired_orders()
          bool before_core_hardfork_342 = ( maint_time <= HARDFORK_CORE_342_TIME ); // better rounding
          bool before_core_hardfork_606 = ( maint_time <= HARDFORK_CORE_606_TIME ); // feed always trigger call
 
-         auto& limit_index = get_index_type<limit_order_index>().indices().get<by_expiration>();
-         while( !limit_index.empty() && limit_index.begin()->expiration <= head_time )
+         auto& limit_wheel = _expiration_scheduler.get_wheel<limit_order_object>();
+         while( const object_id_type* id = limit_wheel.next_due( head_time ) )
          {
-            const limit_order_object& order = *limit_index.begin();
+            const limit_order_object& order = get<limit_order_object>( *id );
             auto base_asset = order.sell_price.base.asset_id;
             auto quote_asset = order.sell_price.quote.asset_id;
             cancel_limit_order( order );
@@ -300,179 +302,138 @@ void database::clear_expired_orders()
             }
          }
 
-   //Process expired force settlement orders
-   auto& settlement_index = get_index_type<force_settlement_index>().indices().get<by_expiration>();
-   if( !settlement_index.empty() )
+   // Process expired force settlement orders, one asset after the other
+   const auto& settlement_index = get_index_type<force_settlement_index>().indices().get<by_expiration>();
+   auto settle_itr = settlement_index.begin();
+   while( settle_itr != settlement_index.end() )
    {
-      asset_id_type current_asset = settlement_index.begin()->settlement_asset_id();
-      asset max_settlement_volume;
-      price settlement_fill_price;
-      price settlement_price;
-      bool current_asset_finished = false;
-      bool extra_dump = false;
-
-      auto next_asset = [&current_asset, &current_asset_finished, &settlement_index, &extra_dump] {
-         auto bound = settlement_index.upper_bound(current_asset);
-         if( bound == settlement_index.end() )
-         {
-            if( extra_dump )
-            {
-               ilog( "next_asset() returning false" );
-            }
-            return false;
-         }
-         if( extra_dump )
-         {
-            ilog( "next_asset returning true, bound is ${b}", ("b", *bound) );
-         }
-         current_asset = bound->settlement_asset_id();
-         current_asset_finished = false;
-         return true;
-      };
+      const asset_id_type settle_asset = settle_itr->settlement_asset_id();
+      settle_due_orders( settle_asset( *this ), before_core_hardfork_184, before_core_hardfork_342 );
+      settle_itr = settlement_index.upper_bound( settle_asset );
+   }
+} FC_CAPTURE_AND_RETHROW() }
 
-      uint32_t count = 0;
+void database::settle_due_orders( const asset_object& mia_object, bool before_core_hardfork_184,
+                                  bool before_core_hardfork_342 )
+{
+   const auto head_time = head_block_time();
+   const asset_id_type current_asset = mia_object.id;
+   const asset_bitasset_data_object& mia = mia_object.bitasset_data(*this);
+   const auto& settlement_index = get_index_type<force_settlement_index>().indices().get<by_expiration>();
+   const auto& call_index = get_index_type<call_order_index>().indices().get<by_collateral>();
+
+   // the least collateralized position of the asset is the first one at or after this key
+   const auto call_min = price_index_key( price::min( mia.options.short_backing_asset, current_asset ) );
+
+   // calculated once per asset and block, on the first order which gets to use them
+   optional<asset> max_settlement_volume;
+   price settlement_fill_price;
+   price settlement_price;
+
+   // At each iteration, we either consume the first order of the queue and remove it, or we are done with the asset
+   for( auto itr = settlement_index.lower_bound( current_asset );
+        itr != settlement_index.end() && itr->settlement_asset_id() == current_asset;
+        itr = settlement_index.lower_bound( current_asset ) )
+   {
+      const force_settlement_object& order = *itr;
+      auto order_id = order.id;
 
-      // At each iteration, we either consume the current order and remove it, or we move to the next asset
-      for( auto itr = settlement_index.lower_bound(current_asset);
-           itr != settlement_index.end();
-           itr = settlement_index.lower_bound(current_asset) )
+      if( mia.has_settlement() )
       {
-         ++count;
-         const force_settlement_object& order = *itr;
-         auto order_id = order.id;
-         current_asset = order.settlement_asset_id();
-         const asset_object& mia_object = get(current_asset);
-         const asset_bitasset_data_object& mia = mia_object.bitasset_data(*this);
+         ilog( "Canceling a force settlement because of black swan" );
+         cancel_settle_order( order );
+         continue;
+      }
 
-         extra_dump = ((count >= 1000) && (count <= 1020));
+      // Has this order not reached its settlement date? The orders of the asset are sorted by date.
+      if( order.settlement_date > head_time )
+         return;
 
-         if( extra_dump )
-         {
-            wlog( "clear_expired_orders() dumping extra data for iteration ${c}", ("c", count) );
-            ilog( "head_block_num is ${hb} current_asset is ${a}", ("hb", head_block_num())("a", current_asset) );
-         }
+      // Can we still settle in this asset?
+      if( mia.current_feed.settlement_price.is_null() )
+      {
+         ilog("Canceling a force settlement in ${asset} because settlement price is null",
+              ("asset", mia_object.symbol));
+         cancel_settle_order(order);
+         continue;
+      }
 
-         if( mia.has_settlement() )
-         {
-            ilog( "Canceling a force settlement because of black swan" );
-            cancel_settle_order( order );
-            continue;
-         }
+      if( !max_settlement_volume.valid() )
+         max_settlement_volume = mia_object.amount(mia.max_force_settlement_volume(mia_object.dynamic_data(*this).current_supply));
+      if( mia.force_settled_volume >= max_settlement_volume->amount )
+         return;
 
-         // Has this order not reached its settlement date?
-         if( order.settlement_date > head_time )
-         {
-            if( next_asset() )
-            {
-               if( extra_dump )
-               {
-                  ilog( "next_asset() returned true when order.settlement_date > head_block_time()" );
-               }
-               continue;
-            }
-            break;
-         }
-         // Can we still settle in this asset?
-         if( mia.current_feed.settlement_price.is_null() )
-         {
-            ilog("Canceling a force settlement in ${asset} because settlement price is null",
-                 ("asset", mia_object.symbol));
-            cancel_settle_order(order);
-            continue;
-         }
-         if( max_settlement_volume.asset_id != current_asset )
-            max_settlement_volume = mia_object.amount(mia.max_force_settlement_volume(mia_object.dynamic_data(*this).current_supply));
-         // When current_asset_finished is true, this would be the 2nd time processing the same order.
-         // In this case, we move to the next asset.
-         if( mia.force_settled_volume >= max_settlement_volume.amount || current_asset_finished )
-         {
-            /*
-            ilog("Skipping force settlement in ${asset}; settled ${settled_volume} / ${max_volume}",
-                 ("asset", mia_object.symbol)("settlement_price_null",mia.current_feed.settlement_price.is_null())
-                 ("settled_volume", mia.force_settled_volume)("max_volume", max_settlement_volume));
-                 */
-            if( next_asset() )
-            {
-               if( extra_dump )
-               {
-                  ilog( "next_asset() returned true when mia.force_settled_volume >= max_settlement_volume.amount" );
-               }
-               continue;
-            }
-            break;
-         }
+      if( settlement_fill_price.base.asset_id != current_asset )
+         settlement_fill_price = mia.current_feed.settlement_price
+                                 / ratio_type( GRAPHENE_100_PERCENT - mia.options.force_settlement_offset_percent,
+                                               GRAPHENE_100_PERCENT );
 
-         if( settlement_fill_price.base.asset_id != current_asset ) // only calculate once per asset
-            settlement_fill_price = mia.current_feed.settlement_price
-                                    / ratio_type( GRAPHENE_100_PERCENT - mia.options.force_settlement_offset_percent,
-                                                  GRAPHENE_100_PERCENT );
+      if( before_core_hardfork_342 )
+      {
+         auto& pays = order.balance;
+         auto receives = (order.balance * mia.current_feed.settlement_price);
+         receives.amount = ( fc::uint128_t(receives.amount.value) *
+                             (GRAPHENE_100_PERCENT - mia.options.force_settlement_offset_percent) /
+                             GRAPHENE_100_PERCENT ).to_uint64();
+         assert(receives <= order.balance * mia.current_feed.settlement_price);
+         settlement_price = pays / receives;
+      }
+      else if( settlement_price.base.asset_id != current_asset )
+         settlement_price = settlement_fill_price;
 
-         if( before_core_hardfork_342 )
-         {
-            auto& pays = order.balance;
-            auto receives = (order.balance * mia.current_feed.settlement_price);
-            receives.amount = ( fc::uint128_t(receives.amount.value) *
-                                (GRAPHENE_100_PERCENT - mia.options.force_settlement_offset_percent) /
-                                GRAPHENE_100_PERCENT ).to_uint64();
-            assert(receives <= order.balance * mia.current_feed.settlement_price);
-            settlement_price = pays / receives;
-         }
-         else if( settlement_price.base.asset_id != current_asset ) // only calculate once per asset
-            settlement_price = settlement_fill_price;
+      asset settled = mia_object.amount(mia.force_settled_volume);
+      bool asset_finished = false;
+      // Match against the least collateralized short until the settlement is finished or we reach max settlements
+      while( settled < *max_settlement_volume && find_object(order_id) )
+      {
+         auto call_itr = call_index.lower_bound( call_min );
+         // There should always be a call order, since asset exists!
+         assert(call_itr != call_index.end() && call_itr->debt_type() == current_asset);
+         asset max_settlement = *max_settlement_volume - settled;
 
-         auto& call_index = get_index_type<call_order_index>().indices().get<by_collateral>();
-         asset settled = mia_object.amount(mia.force_settled_volume);
-         // Match against the least collateralized short until the settlement is finished or we reach max settlements
-         while( settled < max_settlement_volume && find_object(order_id) )
+         if( order.balance.amount == 0 )
          {
-            auto itr = call_index.lower_bound(boost::make_tuple(price::min(mia_object.bitasset_data(*this).options.short_backing_asset,
-                                                                           mia_object.get_id())));
-            // There should always be a call order, since asset exists!
-            assert(itr != call_index.end() && itr->debt_type() == mia_object.get_id());
-            asset max_settlement = max_settlement_volume - settled;
-
-            if( order.balance.amount == 0 )
+            wlog( "0 settlement detected" );
+            cancel_settle_order( order );
+            break;
+         }
+         try {
+            asset new_settled = match(*call_itr, order, settlement_price, max_settlement, settlement_fill_price);
+            if( !before_core_hardfork_184 && new_settled.amount == 0 ) // unable to fill this settle order
             {
-               wlog( "0 settlement detected" );
-               cancel_settle_order( order );
-               break;
-            }
-            try {
-               asset new_settled = match(*itr, order, settlement_price, max_settlement, settlement_fill_price);
-               if( !before_core_hardfork_184 && new_settled.amount == 0 ) // unable to fill this settle order
-               {
-                  if( find_object( order_id ) ) // the settle order hasn't been cancelled
-                     current_asset_finished = true;
-                  break;
-               }
-               settled += new_settled;
-               // before hard fork core-342, `new_settled > 0` is always true, we'll have:
-               // * call order is completely filled (thus itr will change in next loop), or
-               // * settle order is completely filled (thus find_object(order_id) will be false so will break out), or
-               // * reached max_settlement_volume limit (thus new_settled == max_settlement so will break out).
-               //
-               // after hard fork core-342, if new_settled > 0, we'll have:
-               // * call order is completely filled (thus itr will change in next loop), or
-               // * settle order is completely filled (thus find_object(order_id) will be false so will break out), or
-               // * reached max_settlement_volume limit, but it's possible that new_settled < max_settlement,
-               //   in this case, new_settled will be zero in next iteration of the loop, so no need to check here.
-            } 
-            catch ( const black_swan_exception& e ) { 
-               wlog( "Cancelling a settle_order since it may trigger a black swan: ${o}, ${e}",
-                     ("o", order)("e", e.to_detail_string()) );
-               cancel_settle_order( order );
+               if( find_object( order_id ) ) // the settle order hasn't been cancelled
+                  asset_finished = true;
                break;
             }
+            settled += new_settled;
+            // before hard fork core-342, `new_settled > 0` is always true, we'll have:
+            // * call order is completely filled (thus call_itr will change in next loop), or
+            // * settle order is completely filled (thus find_object(order_id) will be false so will break out), or
+            // * reached max_settlement_volume limit (thus new_settled == max_settlement so will break out).
+            //
+            // after hard fork core-342, if new_settled > 0, we'll have:
+            // * call order is completely filled (thus call_itr will change in next loop), or
+            // * settle order is completely filled (thus find_object(order_id) will be false so will break out), or
+            // * reached max_settlement_volume limit, but it's possible that new_settled < max_settlement,
+            //   in this case, new_settled will be zero in next iteration of the loop, so no need to check here.
          }
-         if( mia.force_settled_volume != settled.amount )
-         {
-            modify(mia, [settled](asset_bitasset_data_object& b) {
-               b.force_settled_volume = settled.amount;
-            });
+         catch ( const black_swan_exception& e ) {
+            wlog( "Cancelling a settle_order since it may trigger a black swan: ${o}, ${e}",
+                  ("o", order)("e", e.to_detail_string()) );
+            cancel_settle_order( order );
+            break;
          }
       }
+      if( mia.force_settled_volume != settled.amount )
+      {
+         modify(mia, [settled](asset_bitasset_data_object& b) {
+            b.force_settled_volume = settled.amount;
+         });
+      }
+      if( asset_finished )
+         return;
    }
-} FC_CAPTURE_AND_RETHROW() }
+}
 
 void database::update_expired_feeds()
 {
@@ -572,26 +533,25 @@ void database::update_maintenance_flag( bool new_maintenance_flag )
 
 void database::update_withdraw_permissions()
 {
-   auto& permit_index = get_index_type<withdraw_permission_index>().indices().get<by_expiration>();
-   while( !permit_index.empty() && permit_index.begin()->expiration <= head_block_time() )
-      remove(*permit_index.begin());
+   auto& wheel = _expiration_scheduler.get_wheel<withdraw_permission_object>();
+   while( const object_id_type* id = wheel.next_due( head_block_time() ) )
+      remove( get<withdraw_permission_object>( *id ) );
 }
 
 void database::clear_expired_htlcs()
 {
-   const auto& htlc_idx = get_index_type<htlc_index>().indices().get<by_expiration>();
-   while ( htlc_idx.begin() != htlc_idx.end()
-         && htlc_idx.begin()->conditions.time_lock.expiration <= head_block_time() )
+   auto& wheel = _expiration_scheduler.get_wheel<htlc_object>();
+   while( const object_id_type* id = wheel.next_due( head_block_time() ) )
    {
-      const htlc_object& obj = *htlc_idx.begin();
+      const htlc_object& obj = get<htlc_object>( *id );
       adjust_balance( obj.transfer.from, asset(obj.transfer.amount, obj.transfer.asset_id) );
       // virtual op
       htlc_refund_operation vop( obj.id, obj.transfer.from );
-      vop.htlc_id = htlc_idx.begin()->id;
+      vop.htlc_id = obj.id;
       push_applied_operation( vop );
 
       // remove the db object
-      remove( *htlc_idx.begin() );
+      remove( obj );
    }
 }
 
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/execution_profiler.hpp>
+#include <graphene/chain/protocol/operations.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <boost/multiprecision/integer.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   struct operation_name_visitor
+   {
+      typedef std::string result_type;
+
+      template< typename Operation >
+      std::string operator()( const Operation& )const
+      {
+         static const std::string prefix = "graphene::chain::";
+         std::string name = fc::get_typename< Operation >::name();
+         if( name.compare( 0, prefix.size(), prefix ) == 0 )
+            name = name.substr( prefix.size() );
+         return name;
+      }
+   };
+
+   const char* check_name( execution_profiler::check_type which )
+   {
+      switch( which )
+      {
+         case execution_profiler::transaction_total: return "transaction";
+         case execution_profiler::signature_check:   return "signature_check";
+         case execution_profiler::tapos_check:       return "tapos_check";
+         case execution_profiler::dupe_check:        return "dupe_check";
+         case execution_profiler::dupe_record:       return "dupe_record";
+         default:                                    return "unknown";
+      }
+   }
+
+} // anonymous namespace
+
+execution_profile_entry summarize( const std::string& name, const execution_stats& stats )
+{
+   execution_profile_entry entry;
+   entry.name     = name;
+   entry.count    = stats.count;
+   entry.total_ns = stats.total_ns;
+   entry.max_ns   = stats.max_ns;
+   if( stats.count > 0 )
+   {
+      entry.avg_ns = stats.total_ns / stats.count;
+      entry.p50_ns = std::min( stats.histogram.percentile( 0.50, stats.count ), stats.max_ns );
+      entry.p99_ns = std::min( stats.histogram.percentile( 0.99, stats.count ), stats.max_ns );
+   }
+   return entry;
+}
+
+uint32_t latency_histogram::bucket_of( uint64_t value )
+{
+   const uint64_t linear_limit = uint64_t(1) << sub_bucket_bits;
+   if( value < linear_limit )
+      return uint32_t( value );
+   const uint32_t msb = boost::multiprecision::detail::find_msb( value );
+   const uint32_t shift = msb - sub_bucket_bits;
+   const uint32_t sub = uint32_t( value >> shift ) & ( linear_limit - 1 );
+   return ( ( shift + 1 ) << sub_bucket_bits ) + sub;
+}
+
+uint64_t latency_histogram::bucket_upper_bound( uint32_t bucket )
+{
+   const uint64_t linear_limit = uint64_t(1) << sub_bucket_bits;
+   if( bucket < linear_limit )
+      return bucket;
+   const uint32_t shift = ( bucket >> sub_bucket_bits ) - 1;
+   const uint64_t sub = bucket & ( linear_limit - 1 );
+   // for the topmost bucket the shift overflows to 0, yielding the maximum uint64_t value
+   return ( ( linear_limit + sub + 1 ) << shift ) - 1;
+}
+
+void latency_histogram::record( uint64_t value )
+{
+   ++_buckets[ bucket_of( value ) ];
+}
+
+void latency_histogram::reset()
+{
+   _buckets.fill( 0 );
+}
+
+uint64_t latency_histogram::percentile( double fraction, uint64_t total_count )const
+{
+   if( total_count == 0 )
+      return 0;
+   const uint64_t target = std::max< uint64_t >( 1, uint64_t( std::ceil( fraction * total_count ) ) );
+   uint64_t seen = 0;
+   for( uint32_t i = 0; i < bucket_count; ++i )
+   {
+      seen += _buckets[i];
+      if( seen >= target )
+         return bucket_upper_bound( i );
+   }
+   return bucket_upper_bound( bucket_count - 1 );
+}
+
+execution_profiler::execution_profiler()
+{
+   _operation_stats.resize( operation::count() );
+}
+
+void execution_profiler::enable( bool enabled )
+{
+   if( enabled && !_enabled )
+      reset();
+   _enabled = enabled;
+}
+
+void execution_profiler::reset()
+{
+   for( auto& stats : _operation_stats )
+      stats.reset();
+   for( auto& stats : _check_stats )
+      stats.reset();
+   _first_block_num = 0;
+   _last_block_num = 0;
+}
+
+void execution_profiler::on_block_applied( uint32_t block_num )
+{
+   if( !_enabled )
+      return;
+   if( _first_block_num == 0 )
+      _first_block_num = block_num;
+   _last_block_num = block_num;
+   if( _log_interval > 0 && block_num % _log_interval == 0 )
+      log_summary();
+}
+
+execution_profile execution_profiler::get_profile()const
+{
+   execution_profile result;
+   result.enabled = _enabled;
+   result.first_block_num = _first_block_num;
+   result.last_block_num = _last_block_num;
+
+   operation op;
+   for( size_t i = 0; i < _operation_stats.size(); ++i )
+   {
+      if( _operation_stats[i].count == 0 )
+         continue;
+      op.set_which( i );
+      result.operations.push_back( summarize( op.visit( operation_name_visitor() ), _operation_stats[i] ) );
+   }
+   std::sort( result.operations.begin(), result.operations.end(),
+              []( const execution_profile_entry& a, const execution_profile_entry& b ) {
+                 return a.total_ns > b.total_ns;
+              });
+
+   for( int i = 0; i < CHECK_TYPE_COUNT; ++i )
+      result.checks.push_back( summarize( check_name( check_type(i) ), _check_stats[i] ) );
+
+   return result;
+}
+
+void execution_profiler::log_summary()const
+{
+   const execution_profile profile = get_profile();
+   ilog( "Execution profile of blocks ${f} to ${l}:", ("f", profile.first_block_num)("l", profile.last_block_num) );
+   const size_t max_lines = 10;
+   for( size_t i = 0; i < profile.operations.size() && i < max_lines; ++i )
+   {
+      const auto& e = profile.operations[i];
+      ilog( "   ${n}: count ${c}, total ${t} us, p50 ${p50} ns, p99 ${p99} ns, max ${m} ns",
+            ("n", e.name)("c", e.count)("t", e.total_ns / 1000)("p50", e.p50_ns)("p99", e.p99_ns)("m", e.max_ns) );
+   }
+   for( const auto& e : profile.checks )
+   {
+      if( e.count == 0 )
+         continue;
+      ilog( "   [${n}]: count ${c}, total ${t} us, p50 ${p50} ns, p99 ${p99} ns, max ${m} ns",
+            ("n", e.name)("c", e.count)("t", e.total_ns / 1000)("p50", e.p50_ns)("p99", e.p99_ns)("m", e.max_ns) );
+   }
+}
+
+} } // graphene::chain
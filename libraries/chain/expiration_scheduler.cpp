@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/expiration_scheduler.hpp>
+
+#include <fc/exception/exception.hpp>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   const uint32_t wheel_bits = expiration_wheel::slot_bits * expiration_wheel::level_count;
+
+   /// @return the lowest level whose slots cover both times, level_count if the times are too far apart
+   uint32_t level_of( uint32_t a, uint32_t b )
+   {
+      const uint32_t diff = a ^ b;
+      uint32_t level = 0;
+      while( level < expiration_wheel::level_count && ( diff >> ( expiration_wheel::slot_bits * ( level + 1 ) ) ) != 0 )
+         ++level;
+      return level;
+   }
+
+   uint32_t slot_of( uint32_t time, uint32_t level )
+   {
+      return ( time >> ( expiration_wheel::slot_bits * level ) ) & ( expiration_wheel::slot_count - 1 );
+   }
+
+} // anonymous namespace
+
+void expiration_wheel::schedule( object_id_type id, fc::time_point_sec time )
+{
+   const uint32_t t = time.sec_since_epoch();
+   auto itr = _scheduled.find( id.number );
+   if( itr != _scheduled.end() )
+   {
+      if( itr->second == t )
+         return;
+      unschedule( id );
+   }
+   _scheduled[ id.number ] = t;
+   place( entry( t, id ) );
+}
+
+void expiration_wheel::unschedule( object_id_type id )
+{
+   auto itr = _scheduled.find( id.number );
+   if( itr == _scheduled.end() )
+      return;
+   const entry e( itr->second, id );
+   _scheduled.erase( itr );
+   // copies in the slots of the wheel are dropped when they are reached
+   if( _due.erase( e ) == 0 )
+      _overflow.erase( e );
+}
+
+const object_id_type* expiration_wheel::next_due( fc::time_point_sec now )
+{
+   const uint32_t t = now.sec_since_epoch();
+   advance( t );
+   if( _due.empty() || _due.begin()->first > t )
+      return nullptr;
+   return &_due.begin()->second;
+}
+
+void expiration_wheel::clear()
+{
+   _now = 0;
+   for( auto& level : _levels )
+      for( auto& slot : level )
+         slot.clear();
+   _overflow.clear();
+   _due.clear();
+   _scheduled.clear();
+}
+
+void expiration_wheel::place( const entry& e )
+{
+   auto itr = _scheduled.find( e.second.number );
+   if( itr == _scheduled.end() || itr->second != e.first ) // stale
+      return;
+   if( e.first <= _now )
+   {
+      _due.insert( e );
+      return;
+   }
+   const uint32_t level = level_of( e.first, _now );
+   if( level == level_count )
+      _overflow.insert( e );
+   else
+      _levels[level][ slot_of( e.first, level ) ].push_back( e );
+}
+
+void expiration_wheel::advance( uint32_t now )
+{
+   if( now <= _now )
+      return;
+
+   // Entries of the levels below the one in which the old and the new time differ are all due. Of the slots of
+   // that level, those passed by the new time are either due or need to be placed in a lower level.
+   const uint32_t top = level_of( _now, now );
+   std::vector< entry > moved;
+   auto take = [&moved]( std::vector< entry >& slot ) {
+      moved.insert( moved.end(), slot.begin(), slot.end() );
+      slot.clear();
+   };
+   for( uint32_t level = 0; level < top; ++level )
+      for( auto& slot : _levels[level] )
+         take( slot );
+   if( top < level_count )
+   {
+      for( uint32_t s = slot_of( _now, top ) + 1; s <= slot_of( now, top ); ++s )
+         take( _levels[top][s] );
+   }
+   else
+   {
+      const uint64_t horizon = ( uint64_t( now >> wheel_bits ) + 1 ) << wheel_bits;
+      while( !_overflow.empty() && _overflow.begin()->first < horizon )
+      {
+         moved.push_back( *_overflow.begin() );
+         _overflow.erase( _overflow.begin() );
+      }
+   }
+
+   _now = now;
+   for( const entry& e : moved )
+      place( e );
+}
+
+std::shared_ptr< expiration_wheel > expiration_scheduler::add_wheel( uint8_t space_id, uint8_t type_id )
+{
+   auto& wheel = _wheels[ std::make_pair( space_id, type_id ) ];
+   FC_ASSERT( !wheel, "An expiration wheel for ${s}.${t} is already registered", ("s", space_id)("t", type_id) );
+   wheel = std::make_shared< expiration_wheel >();
+   return wheel;
+}
+
+expiration_wheel& expiration_scheduler::get_wheel( uint8_t space_id, uint8_t type_id )const
+{
+   auto itr = _wheels.find( std::make_pair( space_id, type_id ) );
+   FC_ASSERT( itr != _wheels.end(), "No expiration wheel registered for ${s}.${t}", ("s", space_id)("t", type_id) );
+   return *itr->second;
+}
+
+} } // graphene::chain
@@ -26,6 +26,9 @@
 #include <graphene/db/generic_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
 
+#include <array>
+#include <memory>
+
 namespace graphene { namespace chain {
    class database;
 
@@ -101,8 +104,9 @@ namespace graphene { namespace chain {
          /// Whether this account has pending fees, no matter vested or not
          inline bool has_pending_fees() const { return pending_fees > 0 || pending_vested_fees > 0; }
 
-         /// Whether need to process this account during the maintenance interval
-         inline bool need_maintenance() const { return has_some_core_voting() || has_pending_fees(); }
+         /// Whether need to process this account during the maintenance interval.
+         /// Accounts whose votes changed are tracked separately, see @ref vote_tally_changes
+         inline bool need_maintenance() const { return has_pending_fees(); }
 
          /// @brief Split up and pay out @ref pending_fees and @ref pending_vested_fees
          void process_fees(const account_object& a, database& d) const;
@@ -300,6 +304,9 @@ namespace graphene { namespace chain {
          virtual void about_to_modify( const object& before ) override;
          virtual void object_modified( const object& after  ) override;
 
+         /// Only API calls read the memberships, chain logic does not
+         virtual bool is_rebuildable()const override { return true; }
+         virtual void rebuild( const vector<const object*>& objects ) override;
 
          /** given an account or key, map it to the set of accounts that reference it in an active or owner authority */
          map< account_id_type, set<account_id_type> >                    account_to_account_memberships;
@@ -331,10 +338,44 @@ namespace graphene { namespace chain {
          virtual void about_to_modify( const object& before ) override;
          virtual void object_modified( const object& after  ) override;
 
+         virtual bool is_rebuildable()const override { return true; }
+         virtual void rebuild( const vector<const object*>& objects ) override;
+
          /** maps the referrer to the set of accounts that they have referred */
          map< account_id_type, set<account_id_type> > referred_by;
    };
 
+   /**
+    *  @brief The balance objects of one account, ordered by asset
+    *
+    *  Most accounts hold only a few assets, up to @ref inline_capacity balances are stored in place.
+    *  The balances of accounts holding more assets spill over into a sorted vector on the heap.
+    *  Only pointers are stored, the asset of an entry is read from the balance object itself.
+    */
+   class account_balance_list
+   {
+      public:
+         typedef const account_balance_object* const* const_iterator;
+
+         static const size_t inline_capacity = 2;
+
+         const_iterator begin()const { return _spill ? _spill->data() : _inline.data(); }
+         const_iterator end()const   { return begin() + size(); }
+         size_t size()const;
+         bool empty()const { return size() == 0; }
+
+         /// @return the balance object of the given asset, nullptr if there is none
+         const account_balance_object* find( asset_id_type asset )const;
+         /// Adds a balance object, replacing the one of the same asset if there is one
+         void insert( const account_balance_object* balance );
+         void erase( asset_id_type asset );
+
+      private:
+         /// In use while _spill is empty, unused entries are nullptr and at the end
+         std::array< const account_balance_object*, inline_capacity >     _inline{};
+         std::unique_ptr< std::vector< const account_balance_object* > > _spill;
+   };
+
    /**
     *  @brief This secondary index will allow fast access to the balance objects
     *         that belonging to an account.
@@ -347,7 +388,11 @@ namespace graphene { namespace chain {
          virtual void about_to_modify( const object& before ) override;
          virtual void object_modified( const object& after  ) override;
 
-         const map< asset_id_type, const account_balance_object* >& get_account_balances( const account_id_type& acct )const;
+         /// Genesis reads balances while it creates them, so only the object database load rebuilds the index
+         virtual bool is_rebuildable()const override { return true; }
+         virtual void rebuild( const vector<const object*>& objects ) override;
+
+         const account_balance_list& get_account_balances( const account_id_type& acct )const;
          const account_balance_object* get_account_balance( const account_id_type& acct, const asset_id_type& asset )const;
 
       private:
@@ -355,7 +400,7 @@ namespace graphene { namespace chain {
          static const uint64_t mask;
 
          /** Maps each account to its balance objects */
-         vector< vector< map< asset_id_type, const account_balance_object* > > > balances;
+         vector< vector< account_balance_list > > balances;
          std::stack< object_id_type > ids_being_modified;
    };
 
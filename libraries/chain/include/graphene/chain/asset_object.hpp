@@ -23,6 +23,7 @@
  */
 #pragma once
 #include <graphene/chain/protocol/asset_ops.hpp>
+#include <graphene/chain/median_feed_tracker.hpp>
 #include <boost/multi_index/composite_key.hpp>
 #include <graphene/db/generic_index.hpp>
 
@@ -191,6 +192,9 @@ namespace graphene { namespace chain {
          price_feed current_feed;
          /// This is the publication time of the oldest feed which was factored into current_feed.
          time_point_sec current_feed_publication_time;
+         /// The feeds which were alive at the last median calculation, ranked by each field. Not serialized, see
+         /// @ref median_feed_tracker.
+         median_feed_tracker median_feeds;
          /// Call orders with collateralization (aka collateral/debt) not greater than this value are in margin call territory.
          /// This value is derived from @ref current_feed for better performance and should be kept consistent.
          price current_maintenance_collateralization;
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/asset.hpp>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   class database;
+   class account_balance_object;
+
+   /**
+    * @brief Coalesces the balance adjustments made while it is alive
+    *
+    * Every fill modifies the balances of both parties, so a taker which fills N orders modifies its
+    * balance object N times, each time copying it into the undo state and updating the balance indexes.
+    * While a batch is active, database::adjust_balance only accumulates deltas, and @ref flush applies
+    * the net delta of every touched balance with a single create or modify. Balances are flushed in
+    * the order in which they were first touched, so new balance objects get the same ids as without
+    * a batch.
+    *
+    * An adjustment which overdraws a balance fails at once with the same error as without a batch,
+    * and database::get_balance includes the pending deltas.
+    *
+    * A batch destroyed without having been flushed, i.e. during stack unwinding, writes its deltas
+    * nevertheless. Without an enclosing undo session, e.g. in the buyback processing, the adjustments
+    * made before an exception thus persist like they do without a batch.
+    * A batch constructed while another one is active joins the outer one and does nothing itself.
+    */
+   class balance_write_batch
+   {
+      public:
+         explicit balance_write_batch( database& db );
+         ~balance_write_batch();
+
+         /// Writes the pending deltas to the balance objects and ends the batch
+         void flush();
+
+         /// @return the not yet written delta of a balance, 0 if it was not touched
+         share_type pending_delta( account_id_type owner, asset_id_type asset_type )const;
+
+         /// Number of distinct balances touched since the batch started
+         size_t size()const { return _pending.size(); }
+
+      private:
+         friend class database;
+
+         struct pending_balance
+         {
+            account_id_type               owner;
+            asset_id_type                 asset_type;
+            const account_balance_object* balance = nullptr; ///< nullptr if the balance object is to be created
+            share_type                    delta;
+         };
+
+         void adjust( account_id_type owner, const asset& delta );
+
+         database&                                                    _db;
+         bool                                                         _active = false;
+         std::vector< pending_balance >                               _pending;
+         std::map< std::pair< account_id_type, asset_id_type >, size_t > _positions;
+   };
+
+} } // graphene::chain
@@ -23,11 +23,16 @@
  */
 #pragma once
 #include <fstream>
+#include <mutex>
 #include <graphene/chain/protocol/block.hpp>
 
 namespace graphene { namespace chain {
    struct index_entry;
 
+   /**
+    *  Stores the irreversible blocks in a file, indexed by block number. All members may be called by several
+    *  threads at once, they serialize their use of the file streams.
+    */
    class block_database 
    {
       public:
@@ -43,6 +48,8 @@ namespace graphene { namespace chain {
          block_id_type          fetch_block_id( uint32_t block_num )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /// @return the block as it is stored, in the fc::raw format, without unpacking it
+         optional<vector<char>> fetch_packed_by_number( uint32_t block_num )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
          size_t                 blocks_current_position()const;
@@ -50,6 +57,8 @@ namespace graphene { namespace chain {
       private:
          optional<index_entry> last_index_entry()const;
          fc::path _index_filename;
+         /// Guards the read and write positions of the streams, which even the const members move
+         mutable std::mutex   _streams_mutex;
          mutable std::fstream _blocks;
          mutable std::fstream _block_num_to_pos;
    };
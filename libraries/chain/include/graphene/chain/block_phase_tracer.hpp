@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /// The steps of database::_apply_block, and of chain maintenance
+   enum class block_phase
+   {
+      validate_header,
+      apply_transactions,
+      update_global_properties,      ///< missed blocks, dynamic global properties, signing witness, LIB
+      chain_maintenance,
+      maint_fba_and_buyback,         ///< distribute_fba_balances, create_buyback_orders
+      maint_account_maintenance,     ///< vote tally, core_in_balance and pending fees of all accounts
+      maint_top_n_authorities,
+      maint_active_witnesses,
+      maint_active_committee_members,
+      maint_worker_votes,
+      maint_global_properties,
+      maint_hardfork_processing,
+      maint_bitassets,
+      maint_budget,
+      create_block_summary,
+      clear_expired_transactions,
+      clear_expired_proposals,
+      clear_expired_orders,
+      clear_expired_htlcs,
+      update_expired_feeds,
+      update_core_exchange_rates,
+      update_withdraw_permissions,
+      update_witness_schedule,
+      apply_debug_updates,
+      notify_applied_block,
+      notify_changed_objects,
+      BLOCK_PHASE_COUNT
+   };
+
+   struct block_phase_timing
+   {
+      block_phase phase       = block_phase::validate_header;
+      uint8_t     depth       = 0; ///< 0 for steps of _apply_block, 1 for steps nested inside those
+      uint64_t    start_ns    = 0; ///< offset from the beginning of the block
+      uint64_t    duration_ns = 0;
+   };
+
+   struct block_phase_trace
+   {
+      uint32_t                          block_num = 0;
+      fc::time_point_sec                timestamp;
+      uint32_t                          transaction_count = 0;
+      bool                              maintenance = false;
+      fc::time_point                    applied_at; ///< local time at which application of the block started
+      uint64_t                          duration_ns = 0;
+      std::vector< block_phase_timing > phases;
+   };
+
+   /**
+    * @brief Records how long each phase of block application takes
+    *
+    * Keeps the traces of the last N applied blocks in memory and optionally appends every trace
+    * to a file in the Chrome trace event format, which can be loaded into chrome://tracing,
+    * Perfetto or speedscope to get a flame graph of block application over time.
+    *
+    * The tracer is disabled by default, in which case @ref scoped_phase does not read the clock.
+    */
+   class block_phase_tracer
+   {
+      public:
+         typedef std::chrono::steady_clock clock;
+
+         class scoped_phase
+         {
+            public:
+               scoped_phase( block_phase_tracer& tracer, block_phase phase );
+               ~scoped_phase();
+            private:
+               block_phase_tracer* _tracer = nullptr;
+               size_t              _index  = 0;
+         };
+
+         block_phase_tracer();
+         ~block_phase_tracer();
+
+         /// Keep the last @p capacity traces in memory, 0 disables tracing
+         void set_capacity( size_t capacity );
+         size_t get_capacity()const { return _capacity; }
+         bool is_enabled()const { return _capacity > 0; }
+
+         /// Append traces to @p file, pass an empty path to stop writing
+         void set_trace_file( const fc::path& file );
+
+         void begin_block( uint32_t block_num, fc::time_point_sec timestamp, uint32_t transaction_count );
+         void end_block( bool maintenance );
+
+         /// @return up to @p limit most recent traces, newest first
+         std::vector< block_phase_trace > get_traces( uint32_t limit )const;
+
+      private:
+         void write_trace( const block_phase_trace& trace );
+         uint64_t elapsed_ns()const;
+
+         size_t                            _capacity = 0;
+         bool                              _in_block = false;
+         uint8_t                           _depth    = 0;
+         clock::time_point                 _block_start;
+         block_phase_trace                 _current;
+         std::deque< block_phase_trace >   _traces;
+         std::unique_ptr< std::ofstream >  _trace_file;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT_ENUM( graphene::chain::block_phase,
+                 (validate_header)
+                 (apply_transactions)
+                 (update_global_properties)
+                 (chain_maintenance)
+                 (maint_fba_and_buyback)
+                 (maint_account_maintenance)
+                 (maint_top_n_authorities)
+                 (maint_active_witnesses)
+                 (maint_active_committee_members)
+                 (maint_worker_votes)
+                 (maint_global_properties)
+                 (maint_hardfork_processing)
+                 (maint_bitassets)
+                 (maint_budget)
+                 (create_block_summary)
+                 (clear_expired_transactions)
+                 (clear_expired_proposals)
+                 (clear_expired_orders)
+                 (clear_expired_htlcs)
+                 (update_expired_feeds)
+                 (update_core_exchange_rates)
+                 (update_withdraw_permissions)
+                 (update_witness_schedule)
+                 (apply_debug_updates)
+                 (notify_applied_block)
+                 (notify_changed_objects)
+                 (BLOCK_PHASE_COUNT) )
+
+FC_REFLECT( graphene::chain::block_phase_timing, (phase)(depth)(start_ns)(duration_ns) )
+FC_REFLECT( graphene::chain::block_phase_trace,
+            (block_num)(timestamp)(transaction_count)(maintenance)(applied_at)(duration_ns)(phases) )
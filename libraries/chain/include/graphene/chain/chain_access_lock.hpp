@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <boost/thread/shared_mutex.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Lets threads other than the one applying blocks read the chain state
+    *
+    * The thread which pushes blocks and transactions holds the lock exclusively while it changes the state,
+    * readers on other threads hold it shared for the duration of a query. Writes may nest, e.g. push_block
+    * pops blocks when switching forks, and reads on the writing thread, e.g. from signal handlers or from
+    * API calls executed inline, do not lock at all.
+    *
+    * The lock must not be held across a yield of an fc task, another task of the same thread could
+    * otherwise block the whole thread.
+    */
+   class chain_access_lock
+   {
+      public:
+         class read_guard
+         {
+            public:
+               explicit read_guard( chain_access_lock& lock );
+               ~read_guard();
+            private:
+               chain_access_lock& _lock;
+               bool               _locked = false;
+         };
+
+         class write_guard
+         {
+            public:
+               explicit write_guard( chain_access_lock& lock );
+               ~write_guard();
+            private:
+               chain_access_lock& _lock;
+         };
+
+         /// @return whether the calling thread currently holds the lock exclusively
+         bool is_writing()const { return _writer.load() == std::this_thread::get_id(); }
+
+      private:
+         boost::shared_mutex             _mutex;
+         std::atomic<std::thread::id>    _writer;
+         uint32_t                        _write_depth = 0; ///< only accessed by the writer
+   };
+
+} } // graphene::chain
@@ -26,10 +26,18 @@
 #include <graphene/chain/node_property_object.hpp>
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/balance_write_batch.hpp>
+#include <graphene/chain/block_phase_tracer.hpp>
+#include <graphene/chain/chain_access_lock.hpp>
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
+#include <graphene/chain/execution_profiler.hpp>
+#include <graphene/chain/expiration_scheduler.hpp>
+#include <graphene/chain/limit_order_book.hpp>
+#include <graphene/chain/margin_call_frontier.hpp>
+#include <graphene/chain/vote_tally_object.hpp>
 
 #include <graphene/db/object_database.hpp>
 #include <graphene/db/object.hpp>
@@ -38,6 +46,7 @@
 
 #include <fc/log/logger.hpp>
 
+#include <atomic>
 #include <map>
 
 namespace graphene { namespace chain {
@@ -121,6 +130,9 @@ namespace graphene { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /// @return the block in the fc::raw format, as stored in the block database if it is irreversible
+         optional<vector<char>>     fetch_packed_block_by_number( uint32_t num )const;
+         size_t                     get_pending_transaction_count()const { return _pending_tx.size(); }
          const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -205,6 +217,35 @@ namespace graphene { namespace chain {
           */
          fc::signal<void(const vector<object_id_type>&, const vector<const object*>&, const flat_set<account_id_type>&)>  removed_objects;
 
+         /**
+          *  The accounts impacted by the objects passed to the three signals above are only computed while
+          *  a request returned by this method is alive, otherwise the signals receive an empty set.
+          *  Listeners which filter the changes by account hold a request for as long as they do so.
+          */
+         std::shared_ptr<void> request_impacted_accounts();
+         bool impacted_accounts_requested()const { return *_impacted_account_requests > 0; }
+
+         /// The objects of one type which were created, modified or removed by the last applied block
+         struct object_changes
+         {
+            vector<object_id_type> new_ids;
+            vector<object_id_type> changed_ids;
+            vector<const object*>  removed; ///< the last value of every removed object
+         };
+
+         /**
+          *  Emitted after a block has been applied and committed, with the changes of the objects of the
+          *  given space and type, if there are any. Only the subscribed types are gathered and no impacted
+          *  accounts are computed for them. The callback should not yield and should execute quickly.
+          */
+         boost::signals2::connection subscribe_to_object_changes( uint8_t space_id, uint8_t type_id,
+                                                                  std::function<void(const object_changes&)> callback );
+         template<typename ObjectType>
+         boost::signals2::connection subscribe_to_object_changes( std::function<void(const object_changes&)> callback )
+         {
+            return subscribe_to_object_changes( ObjectType::space_id, ObjectType::type_id, std::move(callback) );
+         }
+
          //////////////////// db_witness_schedule.cpp ////////////////////
 
          /**
@@ -299,6 +340,8 @@ namespace graphene { namespace chain {
           * @brief Adjust a particular account's balance in a given asset by a delta
           * @param account ID of account whose balance should be adjusted
           * @param delta Asset ID and amount to adjust balance by
+          *
+          * While a @ref balance_write_batch is active, the adjustment is only written when the batch is flushed.
           */
          void adjust_balance(account_id_type account, asset delta);
 
@@ -432,6 +475,37 @@ namespace graphene { namespace chain {
          /// Enable or disable tracking of votes of standby witnesses and committee members
          inline void enable_standby_votes_tracking(bool enable)  { _track_standby_votes = enable; }
 
+         /// Number of threads to recount votes with during chain maintenance, 0 to use the size of the fc thread pool
+         inline void set_vote_tally_threads(uint32_t threads)  { _vote_tally_threads = threads; }
+         /// When counting votes incrementally, also check the result against a full recount, for testing purposes
+         inline void enable_vote_tally_verification(bool enable)  { _verify_vote_tally = enable; }
+         /// Recount all votes at the next maintenance interval, rather than only those of accounts which changed
+         inline void recount_votes_at_next_maintenance()  { _vote_tally_changes->reset(); }
+
+         /// Per-operation-type and per-check timing, disabled by default
+         ///@{
+         execution_profiler&       get_execution_profiler()       { return _execution_profiler; }
+         const execution_profiler& get_execution_profiler()const  { return _execution_profiler; }
+         ///@}
+
+         /// Per-block timing of the phases of block application, disabled by default
+         ///@{
+         block_phase_tracer&       get_block_phase_tracer()       { return _block_phase_tracer; }
+         const block_phase_tracer& get_block_phase_tracer()const  { return _block_phase_tracer; }
+         ///@}
+
+         /// Held exclusively while blocks and transactions are pushed, and shared by readers on other threads
+         chain_access_lock& get_chain_access_lock()const  { return _chain_access_lock; }
+
+         /// Pending expirations of transactions, proposals, limit orders, withdraw permissions and HTLCs
+         const expiration_scheduler& get_expiration_scheduler()const  { return _expiration_scheduler; }
+
+         /// The limit orders of all markets by price level
+         const limit_order_book_index& get_limit_order_book()const  { return *_limit_order_book; }
+
+         /// The market issued assets which check_call_orders currently has nothing to do for
+         const margin_call_frontier& get_margin_call_frontier()const  { return *_margin_call_frontier; }
+
          /** Precomputes digests, signatures and operation validations depending
           *  on skip flags. "Expensive" computations may be done in a parallel
           *  thread.
@@ -463,6 +537,8 @@ namespace graphene { namespace chain {
          void notify_changed_objects();
 
       private:
+         friend class balance_write_batch;
+
          optional<undo_database::session>       _pending_tx_session;
          vector< unique_ptr<op_evaluator> >     _operation_evaluators;
 
@@ -500,6 +576,9 @@ namespace graphene { namespace chain {
          void clear_expired_transactions();
          void clear_expired_proposals();
          void clear_expired_orders();
+         /// Processes the force settlements of one asset which are due, called by clear_expired_orders()
+         void settle_due_orders( const asset_object& mia_object, bool before_core_hardfork_184,
+                                 bool before_core_hardfork_342 );
          void update_expired_feeds();
          void update_core_exchange_rates();
          void update_maintenance_flag( bool new_maintenance_flag );
@@ -524,7 +603,7 @@ namespace graphene { namespace chain {
          void process_bitassets();
 
          template<class Type>
-         void perform_account_maintenance( Type tally_helper );
+         void perform_account_maintenance( Type& tally_helper );
          ///@}
          ///@}
 
@@ -568,6 +647,41 @@ namespace graphene { namespace chain {
          /// Set it to true to provide accurate data to API clients, set to false to have better performance.
          bool                              _track_standby_votes = true;
 
+         /// Number of threads used to recount votes, 0 for the size of the fc thread pool, 1 for serial tallying
+         uint32_t                          _vote_tally_threads = 0;
+         /// Whether to compare vote totals to a serial full recount
+         bool                              _verify_vote_tally = false;
+
+         /// Accounts whose votes need to be recounted at the next maintenance interval
+         std::shared_ptr<vote_tally_changes> _vote_tally_changes = std::make_shared<vote_tally_changes>();
+
+         /// Number of alive requests returned by request_impacted_accounts()
+         std::shared_ptr< std::atomic<uint32_t> > _impacted_account_requests
+                                                 = std::make_shared< std::atomic<uint32_t> >( 0 );
+
+         /// Signals of the typed change streams, by object_id_type::space_type()
+         std::map< uint16_t, fc::signal<void(const object_changes&)> > _object_change_signals;
+
+         /// Collects execution times of operations and transaction checks when enabled
+         execution_profiler                _execution_profiler;
+
+         /// Records the duration of each phase of the last applied blocks when enabled
+         block_phase_tracer                _block_phase_tracer;
+
+         mutable chain_access_lock         _chain_access_lock;
+
+         /// Expiration times of the objects removed or processed by the clear_expired_*() functions
+         expiration_scheduler              _expiration_scheduler;
+
+         /// Secondary index of the limit order index which order matching walks
+         const limit_order_book_index*     _limit_order_book = nullptr;
+
+         /// Assets whose margin calls check_call_orders can skip until their feed, call orders or bids change
+         std::shared_ptr<margin_call_frontier> _margin_call_frontier = std::make_shared<margin_call_frontier>();
+
+         /// The batch which currently collects balance adjustments, if any
+         balance_write_batch*              _balance_write_batch = nullptr;
+
          /**
           * Whether database is successfully opened or not.
           *
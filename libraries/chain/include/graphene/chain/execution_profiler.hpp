@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief A fixed-size logarithmic histogram of durations
+    *
+    * Each power of two is split into 4 linear sub-buckets, so a reported percentile is
+    * never more than 25% above the real value. Recording a sample is a couple of bit
+    * operations and an increment, no allocation takes place after construction.
+    */
+   class latency_histogram
+   {
+      public:
+         static const uint32_t sub_bucket_bits = 2;
+         static const uint32_t bucket_count = 64 << sub_bucket_bits;
+
+         void     record( uint64_t value );
+         void     reset();
+
+         /// @return an upper bound of the value below which the given fraction of samples falls
+         uint64_t percentile( double fraction, uint64_t total_count )const;
+
+         static uint32_t bucket_of( uint64_t value );
+         static uint64_t bucket_upper_bound( uint32_t bucket );
+
+      private:
+         std::array< uint64_t, bucket_count > _buckets{};
+   };
+
+   /**
+    * @brief Accumulated timing samples of one measured item, all durations in nanoseconds
+    */
+   struct execution_stats
+   {
+      uint64_t          count    = 0;
+      uint64_t          total_ns = 0;
+      uint64_t          max_ns   = 0;
+      latency_histogram histogram;
+
+      void record( uint64_t ns )
+      {
+         ++count;
+         total_ns += ns;
+         if( ns > max_ns )
+            max_ns = ns;
+         histogram.record( ns );
+      }
+
+      void reset() { *this = execution_stats(); }
+   };
+
+   /**
+    * @brief Summary of @ref execution_stats as returned to API clients
+    */
+   struct execution_profile_entry
+   {
+      std::string name;
+      uint64_t    count    = 0;
+      uint64_t    total_ns = 0;
+      uint64_t    avg_ns   = 0;
+      uint64_t    p50_ns   = 0;
+      uint64_t    p99_ns   = 0;
+      uint64_t    max_ns   = 0;
+   };
+
+   /// @return the summary of @p stats, reported under @p name
+   execution_profile_entry summarize( const std::string& name, const execution_stats& stats );
+
+   struct execution_profile
+   {
+      bool     enabled         = false;
+      uint32_t first_block_num = 0; ///< first block measured since the last reset
+      uint32_t last_block_num  = 0; ///< most recent block measured
+      std::vector< execution_profile_entry > operations; ///< one entry per operation type seen, by total time
+      std::vector< execution_profile_entry > checks;     ///< transaction level checks
+   };
+
+   /**
+    * @brief Collects per-operation-type and per-check execution times
+    *
+    * The profiler is disabled by default. When disabled, the accessors below return nullptr
+    * and @ref scoped_timer does not read the clock at all, so the cost of the instrumentation
+    * in the block application path is a single branch.
+    *
+    * Operation timings are inclusive, i.e. operations executed by a proposal are accounted both
+    * on their own and as part of the enclosing proposal_update/proposal_create operation.
+    */
+   class execution_profiler
+   {
+      public:
+         typedef std::chrono::steady_clock clock;
+
+         enum check_type
+         {
+            transaction_total = 0,  ///< the whole of _apply_transaction
+            signature_check,        ///< verify_authority
+            tapos_check,            ///< TaPoS, expiration and size checks
+            dupe_check,             ///< lookup in the transaction index
+            dupe_record,            ///< insertion into the transaction index
+            CHECK_TYPE_COUNT
+         };
+
+         /// Measures the enclosing scope, does nothing if constructed with nullptr
+         class scoped_timer
+         {
+            public:
+               explicit scoped_timer( execution_stats* stats ) : _stats( stats )
+               {
+                  if( _stats != nullptr )
+                     _start = clock::now();
+               }
+               ~scoped_timer()
+               {
+                  if( _stats != nullptr )
+                     _stats->record( std::chrono::duration_cast< std::chrono::nanoseconds >(
+                                        clock::now() - _start ).count() );
+               }
+            private:
+               execution_stats*  _stats;
+               clock::time_point _start;
+         };
+
+         execution_profiler();
+
+         void enable( bool enabled );
+         bool is_enabled()const { return _enabled; }
+
+         /// Log a summary every @p blocks blocks, 0 to disable
+         void set_log_interval( uint32_t blocks ) { _log_interval = blocks; }
+
+         execution_stats* operation_stats( uint64_t which )
+         {
+            return ( _enabled && which < _operation_stats.size() ) ? &_operation_stats[which] : nullptr;
+         }
+         execution_stats* check_stats( check_type which )
+         {
+            return _enabled ? &_check_stats[which] : nullptr;
+         }
+
+         /// Called after each applied block to track the measured range and emit the periodic log
+         void on_block_applied( uint32_t block_num );
+
+         execution_profile get_profile()const;
+         void reset();
+
+      private:
+         void log_summary()const;
+
+         bool                                         _enabled         = false;
+         uint32_t                                     _log_interval    = 0;
+         uint32_t                                     _first_block_num = 0;
+         uint32_t                                     _last_block_num  = 0;
+         std::vector< execution_stats >               _operation_stats;
+         std::array< execution_stats, CHECK_TYPE_COUNT > _check_stats;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::execution_profile_entry,
+            (name)(count)(total_ns)(avg_ns)(p50_ns)(p99_ns)(max_ns) )
+FC_REFLECT( graphene::chain::execution_profile,
+            (enabled)(first_block_num)(last_block_num)(operations)(checks) )
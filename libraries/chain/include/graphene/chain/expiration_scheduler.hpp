@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/types.hpp>
+#include <graphene/db/index.hpp>
+
+#include <fc/time.hpp>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief The pending expirations of all objects of one type, kept in a hierarchical time wheel
+    *
+    * The wheel has @ref level_count levels of @ref slot_count slots each. Level 0 has a resolution of one second,
+    * every further level is @ref slot_count times coarser; times beyond the span of the wheel are kept in an
+    * ordered overflow set. An entry is placed in the level of the most significant group of bits in which its
+    * time differs from the current time of the wheel, so scheduling is O(1), and advancing the wheel only touches
+    * the slots the current time passes. Entries which are due are moved to an ordered set, from which they are
+    * taken in (time, id) order, the same order as that of the former by_expiration indexes.
+    *
+    * Unscheduling only forgets the entry, stale copies left in the slots are dropped when they are reached.
+    * Time may go backwards when blocks are popped, entries which are due at a later time than the queried one
+    * are then simply not returned.
+    */
+   class expiration_wheel
+   {
+      public:
+         static const uint32_t slot_bits   = 6;
+         static const uint32_t slot_count  = 1 << slot_bits;
+         static const uint32_t level_count = 4; ///< 2^24 seconds, about 194 days
+
+         /// Schedule @p id to expire at @p time, replacing a previously scheduled time
+         void schedule( object_id_type id, fc::time_point_sec time );
+         void unschedule( object_id_type id );
+
+         /// @return the scheduled object which is due first at @p now, nullptr if none is due;
+         ///         the pointer is invalidated by any change to the wheel
+         const object_id_type* next_due( fc::time_point_sec now );
+
+         size_t size()const { return _scheduled.size(); }
+         void   clear();
+         /// Prepare for scheduling @p count objects
+         void   reserve( size_t count ) { _scheduled.reserve( count ); }
+
+      private:
+         typedef std::pair< uint32_t, object_id_type > entry;
+
+         void advance( uint32_t now );
+         void place( const entry& e );
+
+         uint32_t                                                          _now = 0;
+         std::array< std::array< std::vector< entry >, slot_count >, level_count > _levels;
+         std::set< entry >                                                 _overflow;
+         std::set< entry >                                                 _due;
+         /// object id -> scheduled time, entries which do not match it are stale
+         std::unordered_map< uint64_t, uint32_t >                          _scheduled;
+   };
+
+   /**
+    * @brief Keeps one @ref expiration_wheel per registered object type
+    *
+    * Object types register a wheel while the indexes are set up, and keep it up to date with an
+    * @ref expiration_tracker. Since the trackers are secondary indexes, undoing a block restores the
+    * scheduled expirations along with the objects.
+    */
+   class expiration_scheduler
+   {
+      public:
+         std::shared_ptr< expiration_wheel > add_wheel( uint8_t space_id, uint8_t type_id );
+         template< typename ObjectType >
+         std::shared_ptr< expiration_wheel > add_wheel()
+         {
+            return add_wheel( ObjectType::space_id, ObjectType::type_id );
+         }
+
+         expiration_wheel& get_wheel( uint8_t space_id, uint8_t type_id )const;
+         template< typename ObjectType >
+         expiration_wheel& get_wheel()const
+         {
+            return get_wheel( ObjectType::space_id, ObjectType::type_id );
+         }
+
+         /// Unregisters all wheels
+         void clear() { _wheels.clear(); }
+
+      private:
+         std::map< std::pair< uint8_t, uint8_t >, std::shared_ptr< expiration_wheel > > _wheels;
+   };
+
+   /**
+    * @brief Schedules the expiration of every object of an index in an @ref expiration_wheel
+    *
+    * @tparam TimeExtractor a boost::multi_index key extractor returning the expiration time of an object
+    */
+   template< typename ObjectType, typename TimeExtractor >
+   class expiration_tracker : public secondary_index
+   {
+      public:
+         explicit expiration_tracker( std::shared_ptr< expiration_wheel > wheel ) : _wheel( std::move( wheel ) ) {}
+
+         virtual void object_inserted( const object& obj ) override
+         {
+            const ObjectType& o = static_cast< const ObjectType& >( obj );
+            _wheel->schedule( o.id, TimeExtractor()( o ) );
+         }
+         virtual void object_removed( const object& obj ) override
+         {
+            _wheel->unschedule( obj.id );
+         }
+         virtual void about_to_modify( const object& before ) override {}
+         virtual void object_modified( const object& after ) override
+         {
+            object_inserted( after );
+         }
+
+         /// Every object type has a wheel of its own, rebuilds of different trackers do not interfere
+         virtual bool is_rebuildable()const override { return true; }
+         virtual void rebuild( const vector<const object*>& objects ) override
+         {
+            _wheel->clear();
+            _wheel->reserve( objects.size() );
+            for( const object* obj : objects )
+               object_inserted( *obj );
+         }
+
+      private:
+         std::shared_ptr< expiration_wheel > _wheel;
+   };
+
+} } // graphene::chain
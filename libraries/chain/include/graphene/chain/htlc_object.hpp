@@ -80,17 +80,12 @@ namespace graphene { namespace chain {
    };
 
    struct by_from_id;
-   struct by_expiration;
+   /// Expirations are kept in an @ref expiration_wheel rather than in an ordered index
    typedef multi_index_container<
          htlc_object,
          indexed_by<
             ordered_unique< tag< by_id >, member< object, object_id_type, &object::id > >,
 
-            ordered_unique< tag< by_expiration >, 
-                  composite_key< htlc_object,
-                  htlc_object::timelock_extractor,
-                  member< object, object_id_type, &object::id > > >,
-
             ordered_unique< tag< by_from_id >,
                   composite_key< htlc_object, 
                   htlc_object::from_extractor,
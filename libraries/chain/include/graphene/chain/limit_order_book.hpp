@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/market_object.hpp>
+#include <graphene/chain/price_sort_key.hpp>
+
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief The limit orders of every market, grouped in price levels
+    *
+    * A secondary index of the limit order index. Each side of a market, i.e. each pair of sell and receive
+    * asset, keeps its price levels in a contiguous vector ordered by price, worst first, so that the best level
+    * which matching consumes is at the back. Each level holds the orders at exactly its price in ascending id
+    * order, the order in which the by_price index sorts equal prices. Walking a side from the best level thus
+    * yields the same orders in the same order as walking by_price from price::max() of the market.
+    */
+   class limit_order_book_index : public secondary_index
+   {
+      public:
+         struct price_level
+         {
+            price_sort_key                          key;
+            price                                   level_price; ///< the price of the orders at this level
+            std::deque< const limit_order_object* > orders;      ///< in ascending id order
+         };
+         /// The price levels of one side of a market, in ascending price order
+         typedef std::vector< price_level > book_side;
+
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after ) override;
+
+         virtual bool is_rebuildable()const override { return true; }
+         virtual void rebuild( const vector<const object*>& objects ) override;
+
+         /// @return the order selling @p sell_asset for @p receive_asset at the best price, nullptr if there is none
+         const limit_order_object* best_order( asset_id_type sell_asset, asset_id_type receive_asset )const;
+
+         /// Calls @p visitor with the orders of one side of a market, best first, until it returns false
+         template< typename Visitor >
+         void visit_orders( asset_id_type sell_asset, asset_id_type receive_asset, Visitor&& visitor )const
+         {
+            const book_side* side = find_side( sell_asset, receive_asset );
+            if( side == nullptr )
+               return;
+            for( auto level = side->rbegin(); level != side->rend(); ++level )
+               for( const limit_order_object* order : level->orders )
+                  if( !visitor( *order ) )
+                     return;
+         }
+
+         /// @return the number of price levels of one side of a market
+         size_t level_count( asset_id_type sell_asset, asset_id_type receive_asset )const;
+
+         /// @return the price levels of one side of a market, nullptr if it has no orders
+         const book_side* find_side( asset_id_type sell_asset, asset_id_type receive_asset )const;
+         /// @return the level of the orders selling at exactly @p sell_price, nullptr if there is none
+         const price_level* find_level( const price& sell_price )const;
+
+      private:
+         void insert_order( const limit_order_object& order );
+         void remove_order( const limit_order_object& order, const price_sort_key& key, const price& sell_price );
+
+         std::map< std::pair< asset_id_type, asset_id_type >, book_side > _sides;
+         price_sort_key                                                    _key_before_modify;
+         price                                                             _price_before_modify;
+   };
+
+} } // graphene::chain
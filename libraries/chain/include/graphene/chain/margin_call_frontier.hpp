@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/asset.hpp>
+#include <graphene/db/index.hpp>
+
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace graphene { namespace chain {
+
+   class asset_bitasset_data_object;
+   class call_order_object;
+   class limit_order_object;
+
+   /**
+    * @brief Remembers the market issued assets for which database::check_call_orders has nothing to do
+    *
+    * Whether a position of an asset can be margin called or trigger a black swan depends only on the bitasset
+    * data of the asset, its call orders, the limit orders selling it and the active hard forks. When
+    * check_call_orders finds that the least collateralized position of an asset is beyond the margin call and
+    * black swan thresholds, it marks the asset quiet. The trackers below clear the mark as soon as one of these
+    * inputs changes, including changes reverted by the undo database, so that checking a quiet asset again
+    * returns at once instead of walking the order books.
+    */
+   class margin_call_frontier
+   {
+      public:
+         /// @return true if nothing could be called when the asset was last checked under the same hard forks
+         bool is_quiet( asset_id_type debt_asset, time_point_sec maint_time, bool after_hardfork_436 )const;
+         void mark_quiet( asset_id_type debt_asset, time_point_sec maint_time, bool after_hardfork_436 );
+         void invalidate( asset_id_type debt_asset );
+         void clear() { _quiet.clear(); }
+
+         size_t quiet_count()const { return _quiet.size(); }
+
+      private:
+         /// The hard fork state a quiet check was made in
+         struct check_state
+         {
+            time_point_sec maint_time;
+            bool           after_hardfork_436 = false;
+         };
+
+         std::unordered_map< uint64_t, check_state > _quiet; ///< by instance of the debt asset
+   };
+
+   /// The parts of an object that check_call_orders reads, changes of anything else are not tracked
+   ///@{
+   typedef std::tuple< share_type, share_type, asset, asset > call_order_margin_state;
+   typedef std::tuple< asset, asset > limit_order_margin_state;
+   typedef std::tuple< asset, asset, uint16_t, uint16_t, asset, asset, asset, asset, bool, asset_id_type >
+           bitasset_margin_state;
+
+   call_order_margin_state  get_margin_call_state( const call_order_object& o );
+   limit_order_margin_state get_margin_call_state( const limit_order_object& o );
+   bitasset_margin_state    get_margin_call_state( const asset_bitasset_data_object& o );
+   asset_id_type            get_margin_call_asset( const call_order_object& o );
+   asset_id_type            get_margin_call_asset( const limit_order_object& o );
+   asset_id_type            get_margin_call_asset( const asset_bitasset_data_object& o );
+   ///@}
+
+   /**
+    * @brief Secondary index which clears the quiet mark of an asset in @ref margin_call_frontier when an object
+    *        that affects its margin calls changes
+    */
+   template< typename ObjectType >
+   class margin_call_tracker : public secondary_index
+   {
+      public:
+         explicit margin_call_tracker( std::shared_ptr<margin_call_frontier> frontier )
+            : _frontier( std::move(frontier) ) {}
+
+         virtual void object_inserted( const object& obj ) override
+         {
+            _frontier->invalidate( get_margin_call_asset( static_cast<const ObjectType&>( obj ) ) );
+         }
+         virtual void object_removed( const object& obj ) override
+         {
+            _frontier->invalidate( get_margin_call_asset( static_cast<const ObjectType&>( obj ) ) );
+         }
+         virtual void about_to_modify( const object& before ) override
+         {
+            _before = get_margin_call_state( static_cast<const ObjectType&>( before ) );
+         }
+         virtual void object_modified( const object& after ) override
+         {
+            const ObjectType& obj = static_cast<const ObjectType&>( after );
+            if( get_margin_call_state( obj ) != _before )
+               _frontier->invalidate( get_margin_call_asset( obj ) );
+         }
+
+         /// The frontier is cleared before the object database is opened, and nothing is checked during a bulk
+         /// load, so no asset can be quiet when it ends. Not touching the shared frontier also keeps the trackers
+         /// of objects loaded in parallel from racing each other.
+         virtual bool is_rebuildable()const override { return true; }
+         virtual void rebuild( const vector<const object*>& objects ) override {}
+
+      private:
+         typedef decltype( get_margin_call_state( std::declval<const ObjectType&>() ) ) state_type;
+
+         std::shared_ptr<margin_call_frontier> _frontier;
+         state_type                            _before;
+   };
+
+} } // graphene::chain
@@ -23,6 +23,7 @@
  */
 #pragma once
 
+#include <graphene/chain/price_sort_key.hpp>
 #include <graphene/chain/protocol/asset.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/db/generic_index.hpp>
@@ -34,6 +35,43 @@ namespace graphene { namespace chain {
 
 using namespace graphene::db;
 
+/**
+ *  @brief a generic_index for market objects whose multi_index keys include precomputed price sort keys
+ *
+ *  The keys are derived from other members and are not serialized. This index refreshes them through
+ *  ObjectType::update_index_keys() before the object enters the container and after every modification,
+ *  so creation, undo and loading from disk all keep them consistent with the prices they were derived from.
+ */
+template<typename ObjectType, typename MultiIndexType>
+class price_keyed_index : public generic_index<ObjectType, MultiIndexType>
+{
+   typedef generic_index<ObjectType, MultiIndexType> base_index;
+
+   public:
+      virtual const object& insert( object&& obj )override
+      {
+         assert( nullptr != dynamic_cast<ObjectType*>(&obj) );
+         static_cast<ObjectType&>(obj).update_index_keys();
+         return base_index::insert( std::move( obj ) );
+      }
+
+      virtual const object& create( const std::function<void(object&)>& constructor )override
+      {
+         return base_index::create( [&constructor]( object& obj ) {
+            constructor( obj );
+            static_cast<ObjectType&>(obj).update_index_keys();
+         } );
+      }
+
+      virtual void modify( const object& obj, const std::function<void(object&)>& m )override
+      {
+         base_index::modify( obj, [&m]( object& o ) {
+            m( o );
+            static_cast<ObjectType&>(o).update_index_keys();
+         } );
+      }
+};
+
 /**
  *  @brief an offer to sell a amount of a asset at a specified exchange rate by a certain time
  *  @ingroup object
@@ -55,6 +93,10 @@ class limit_order_object : public abstract_object<limit_order_object>
       share_type       deferred_fee; ///< fee converted to CORE
       asset            deferred_paid_fee; ///< originally paid fee
 
+      price_sort_key   sell_price_key; ///< sort key of sell_price, not serialized
+
+      void update_index_keys() { sell_price_key = price_sort_key( sell_price ); }
+
       pair<asset_id_type,asset_id_type> get_market()const
       {
          auto tmp = std::make_pair( sell_price.base.asset_id, sell_price.quote.asset_id );
@@ -70,24 +112,22 @@ class limit_order_object : public abstract_object<limit_order_object>
 
 struct by_id;
 struct by_price;
-struct by_expiration;
 struct by_account;
+/// Expirations are kept in an @ref expiration_wheel rather than in an ordered index
 typedef multi_index_container<
    limit_order_object,
    indexed_by<
       ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
-      ordered_unique< tag<by_expiration>,
-         composite_key< limit_order_object,
-            member< limit_order_object, time_point_sec, &limit_order_object::expiration>,
-            member< object, object_id_type, &object::id>
-         >
-      >,
       ordered_unique< tag<by_price>,
          composite_key< limit_order_object,
-            member< limit_order_object, price, &limit_order_object::sell_price>,
-            member< object, object_id_type, &object::id>
+            const_mem_fun< limit_order_object, asset_id_type, &limit_order_object::sell_asset_id >,
+            const_mem_fun< limit_order_object, asset_id_type, &limit_order_object::receive_asset_id >,
+            member< limit_order_object, price_sort_key, &limit_order_object::sell_price_key >,
+            member< limit_order_object, price, &limit_order_object::sell_price >,
+            member< object, object_id_type, &object::id >
          >,
-         composite_key_compare< std::greater<price>, std::less<object_id_type> >
+         composite_key_compare< std::greater<asset_id_type>, std::greater<asset_id_type>,
+                                std::greater<price_sort_key>, std::greater<price>, std::less<object_id_type> >
       >,
       ordered_unique< tag<by_account>,
          composite_key< limit_order_object,
@@ -100,7 +140,7 @@ typedef multi_index_container<
    >
 > limit_order_multi_index_type;
 
-typedef generic_index<limit_order_object, limit_order_multi_index_type> limit_order_index;
+typedef price_keyed_index<limit_order_object, limit_order_multi_index_type> limit_order_index;
 
 /**
  * @class call_order_object
@@ -129,6 +169,15 @@ class call_order_object : public abstract_object<call_order_object>
 
       optional<uint16_t> target_collateral_ratio; ///< maximum CR to maintain when selling collateral on margin call
 
+      price_sort_key   call_price_key;        ///< sort key of call_price, not serialized
+      price_sort_key   collateralization_key; ///< sort key of collateralization(), not serialized
+
+      void update_index_keys()
+      {
+         call_price_key = price_sort_key( call_price );
+         collateralization_key = price_sort_key( price( get_collateral(), get_debt() ) );
+      }
+
       pair<asset_id_type,asset_id_type> get_market()const
       {
          auto tmp = std::make_pair( call_price.base.asset_id, call_price.quote.asset_id );
@@ -191,6 +240,10 @@ class collateral_bid_object : public abstract_object<collateral_bid_object>
 
       account_id_type  bidder;
       price            inv_swan_price;  // Collateral / Debt
+
+      price_sort_key   inv_swan_price_key; ///< sort key of inv_swan_price, not serialized
+
+      void update_index_keys() { inv_swan_price_key = price_sort_key( inv_swan_price ); }
 };
 
 struct by_collateral;
@@ -203,10 +256,12 @@ typedef multi_index_container<
          member< object, object_id_type, &object::id > >,
       ordered_unique< tag<by_price>,
          composite_key< call_order_object,
-            member< call_order_object, price, &call_order_object::call_price>,
-            member< object, object_id_type, &object::id>
-         >,
-         composite_key_compare< std::less<price>, std::less<object_id_type> >
+            const_mem_fun< call_order_object, asset_id_type, &call_order_object::collateral_type >,
+            const_mem_fun< call_order_object, asset_id_type, &call_order_object::debt_type >,
+            member< call_order_object, price_sort_key, &call_order_object::call_price_key >,
+            member< call_order_object, price, &call_order_object::call_price >,
+            member< object, object_id_type, &object::id >
+         >
       >,
       ordered_unique< tag<by_account>,
          composite_key< call_order_object,
@@ -216,6 +271,9 @@ typedef multi_index_container<
       >,
       ordered_unique< tag<by_collateral>,
          composite_key< call_order_object,
+            const_mem_fun< call_order_object, asset_id_type, &call_order_object::collateral_type >,
+            const_mem_fun< call_order_object, asset_id_type, &call_order_object::debt_type >,
+            member< call_order_object, price_sort_key, &call_order_object::collateralization_key >,
             const_mem_fun< call_order_object, price, &call_order_object::collateralization >,
             member< object, object_id_type, &object::id >
          >
@@ -258,17 +316,19 @@ typedef multi_index_container<
       ordered_unique< tag<by_price>,
          composite_key< collateral_bid_object,
             const_mem_fun< collateral_bid_object, asset_id_type, &collateral_bid_object::debt_type>,
+            member< collateral_bid_object, price_sort_key, &collateral_bid_object::inv_swan_price_key >,
             member< collateral_bid_object, price, &collateral_bid_object::inv_swan_price >,
             member< object, object_id_type, &object::id >
          >,
-         composite_key_compare< std::less<asset_id_type>, std::greater<price>, std::less<object_id_type> >
+         composite_key_compare< std::less<asset_id_type>, std::greater<price_sort_key>, std::greater<price>,
+                                std::less<object_id_type> >
       >
    >
 > collateral_bid_object_multi_index_type;
 
-typedef generic_index<call_order_object, call_order_multi_index_type>                      call_order_index;
-typedef generic_index<force_settlement_object, force_settlement_object_multi_index_type>   force_settlement_index;
-typedef generic_index<collateral_bid_object, collateral_bid_object_multi_index_type>       collateral_bid_index;
+typedef price_keyed_index<call_order_object, call_order_multi_index_type>                call_order_index;
+typedef generic_index<force_settlement_object, force_settlement_object_multi_index_type> force_settlement_index;
+typedef price_keyed_index<collateral_bid_object, collateral_bid_object_multi_index_type> collateral_bid_index;
 
 } } // graphene::chain
 
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/asset.hpp>
+
+#include <fc/optional.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief The values of one field of the live price feeds of an asset, kept sorted so that the value of any
+    *        rank can be read directly
+    *
+    * Entries are ordered by value, then by their exact representation, then by producer. Prices of different
+    * representation can compare equivalent, e.g. 1/2 and 2/4, in which case std::nth_element could return either
+    * of them; @ref nth reports such a rank as ambiguous so that the caller can fall back to the selection the
+    * consensus rules are defined by.
+    */
+   template< typename T >
+   class ranked_feed_values
+   {
+      public:
+         void insert( const T& value, account_id_type producer );
+         void erase( const T& value, account_id_type producer );
+
+         /// @return the value at rank @p n in ascending order, or nullptr if the rank is ambiguous
+         const T* nth( size_t n )const;
+
+         size_t size()const { return _entries.size(); }
+
+      private:
+         struct entry
+         {
+            T               value;
+            account_id_type producer;
+         };
+         static bool entry_less( const entry& a, const entry& b );
+
+         std::vector< entry > _entries;
+         /// Number of values for which operator< is not a strict weak ordering, see is_regular_feed_value()
+         uint32_t             _irregular = 0;
+   };
+
+   /**
+    * @brief Keeps the live feeds of an asset ordered by each price feed field, so that the median feed can be
+    *        read without sorting all feeds again
+    *
+    * The tracker is a cache of asset_bitasset_data_object which is neither serialized nor reflected. It is copied
+    * along with the object by the undo database and starts out empty after the object was loaded from disk.
+    * Since evaluators and chain maintenance edit the feeds map directly, @ref update compares the map with the
+    * feeds it has seen last time and only re-ranks the feeds which were published, changed, removed or expired
+    * since then.
+    */
+   class median_feed_tracker
+   {
+      public:
+         typedef flat_map< account_id_type, pair< time_point_sec, price_feed > > feed_map;
+
+         /// Brings the tracked feeds in line with those in @p feeds which are alive at @p current_time
+         void update( const feed_map& feeds, time_point_sec current_time, uint32_t feed_lifetime_sec );
+
+         /// @return the number of live feeds
+         size_t size()const { return _live.size(); }
+         /// @return the live feeds by producer, in the order of the feeds map
+         const feed_map& live_feeds()const { return _live; }
+         /// @return the publication time of the oldest live feed, or the current time if there is none
+         time_point_sec oldest_publication_time()const { return _oldest_publication_time; }
+
+         /// @return the median of every field, or an empty optional if a field's median is ambiguous
+         optional< price_feed > median()const;
+
+      private:
+         void insert_values( account_id_type producer, const price_feed& feed );
+         void erase_values( account_id_type producer, const price_feed& feed );
+
+         feed_map                               _live;
+         time_point_sec                         _oldest_publication_time;
+         ranked_feed_values< price >            _settlement_price;
+         ranked_feed_values< uint16_t >         _maintenance_collateral_ratio;
+         ranked_feed_values< uint16_t >         _maximum_short_squeeze_ratio;
+         ranked_feed_values< price >            _core_exchange_rate;
+   };
+
+} } // graphene::chain
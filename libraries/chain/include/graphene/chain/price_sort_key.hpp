@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/asset.hpp>
+
+#include <boost/tuple/tuple.hpp>
+
+#include <tuple>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief A fixed-width key which orders the prices of one market like price::operator< does
+    *
+    * The key is the ratio base / quote as a 64.64 fixed-point number, rounded down. Comparing two keys is two
+    * integer comparisons rather than two 128-bit multiplications. Since the key is rounded, distinct prices
+    * may have equal keys, use @ref compare_prices to also resolve those.
+    */
+   struct price_sort_key
+   {
+      uint64_t high = 0; ///< integer part of the ratio
+      uint64_t low  = 0; ///< fractional part of the ratio
+
+      price_sort_key() {}
+      explicit price_sort_key( const price& p );
+
+      friend bool operator < ( const price_sort_key& a, const price_sort_key& b )
+      {
+         return std::tie( a.high, a.low ) < std::tie( b.high, b.low );
+      }
+      friend bool operator == ( const price_sort_key& a, const price_sort_key& b )
+      {
+         return a.high == b.high && a.low == b.low;
+      }
+      friend bool operator != ( const price_sort_key& a, const price_sort_key& b ) { return !( a == b ); }
+      friend bool operator > ( const price_sort_key& a, const price_sort_key& b ) { return b < a; }
+   };
+
+   /**
+    * Compares two prices of the same market by their keys, and exactly if the keys are equal
+    * @return a negative number, 0 or a positive number if @p a is less than, equal to or greater than @p b
+    */
+   int compare_prices( const price_sort_key& key_a, const price& a, const price_sort_key& key_b, const price& b );
+
+   typedef boost::tuple< asset_id_type, asset_id_type, price_sort_key, price > price_index_key_type;
+
+   /**
+    * The lookup key of @p p in the market indexes which are sorted by base asset, quote asset, sort key and
+    * finally by the exact price, e.g. limit_order_index by_price and call_order_index by_collateral
+    */
+   inline price_index_key_type price_index_key( const price& p )
+   {
+      return price_index_key_type( p.base.asset_id, p.quote.asset_id, price_sort_key( p ), p );
+   }
+
+} } // graphene::chain
@@ -81,18 +81,11 @@ class required_approval_index : public secondary_index
       map<account_id_type, set<proposal_id_type> > _account_to_proposals;
 };
 
-struct by_expiration{};
+/// Expirations are kept in an @ref expiration_wheel rather than in an ordered index
 typedef boost::multi_index_container<
    proposal_object,
    indexed_by<
-      ordered_unique< tag< by_id >, member< object, object_id_type, &object::id > >,
-      //ordered_non_unique< tag< by_expiration >, member< proposal_object, time_point_sec, &proposal_object::expiration_time > >
-      ordered_unique<tag<by_expiration>,
-         composite_key<proposal_object,
-            member<proposal_object, time_point_sec, &proposal_object::expiration_time>,
-            member< object, object_id_type, &object::id >
-         >
-      >
+      ordered_unique< tag< by_id >, member< object, object_id_type, &object::id > >
    >
 > proposal_multi_index_container;
 typedef generic_index<proposal_object, proposal_multi_index_container> proposal_index;
@@ -179,7 +179,9 @@ namespace graphene { namespace chain {
       impl_special_authority_object_type,
       impl_buyback_object_type,
       impl_fba_accumulator_object_type,
-      impl_collateral_bid_object_type
+      impl_collateral_bid_object_type,
+      impl_vote_tally_object_type,
+      impl_voter_record_object_type
    };
 
    //typedef fc::unsigned_int            object_id_type;
@@ -234,6 +236,8 @@ namespace graphene { namespace chain {
    class buyback_object;
    class fba_accumulator_object;
    class collateral_bid_object;
+   class vote_tally_object;
+   class voter_record_object;
 
    typedef object_id< implementation_ids, impl_global_property_object_type,  global_property_object>                    global_property_id_type;
    typedef object_id< implementation_ids, impl_dynamic_global_property_object_type,  dynamic_global_property_object>    dynamic_global_property_id_type;
@@ -255,6 +259,8 @@ namespace graphene { namespace chain {
    typedef object_id< implementation_ids, impl_buyback_object_type, buyback_object >                                    buyback_id_type;
    typedef object_id< implementation_ids, impl_fba_accumulator_object_type, fba_accumulator_object >                    fba_accumulator_id_type;
    typedef object_id< implementation_ids, impl_collateral_bid_object_type, collateral_bid_object >                      collateral_bid_id_type;
+   typedef object_id< implementation_ids, impl_vote_tally_object_type, vote_tally_object >                              vote_tally_id_type;
+   typedef object_id< implementation_ids, impl_voter_record_object_type, voter_record_object >                          voter_record_id_type;
 
    typedef fc::ripemd160                                        block_id_type;
    typedef fc::ripemd160                                        checksum_type;
@@ -394,6 +400,8 @@ FC_REFLECT_ENUM( graphene::chain::impl_object_type,
                  (impl_buyback_object_type)
                  (impl_fba_accumulator_object_type)
                  (impl_collateral_bid_object_type)
+                 (impl_vote_tally_object_type)
+                 (impl_voter_record_object_type)
                )
 
 FC_REFLECT_TYPENAME( graphene::chain::share_type )
@@ -426,6 +434,8 @@ FC_REFLECT_TYPENAME( graphene::chain::special_authority_id_type )
 FC_REFLECT_TYPENAME( graphene::chain::buyback_id_type )
 FC_REFLECT_TYPENAME( graphene::chain::fba_accumulator_id_type )
 FC_REFLECT_TYPENAME( graphene::chain::collateral_bid_id_type )
+FC_REFLECT_TYPENAME( graphene::chain::vote_tally_id_type )
+FC_REFLECT_TYPENAME( graphene::chain::voter_record_id_type )
 FC_REFLECT_TYPENAME( graphene::chain::htlc_id_type )
 
 FC_REFLECT( graphene::chain::void_t, )
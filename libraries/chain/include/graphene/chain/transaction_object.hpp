@@ -56,15 +56,14 @@ namespace graphene { namespace chain {
          time_point_sec get_expiration()const { return trx.expiration; }
    };
 
-   struct by_expiration;
    struct by_id;
    struct by_trx_id;
+   /// Expirations are kept in an @ref expiration_wheel rather than in an ordered index
    typedef multi_index_container<
       transaction_object,
       indexed_by<
          ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
-         hashed_unique< tag<by_trx_id>, BOOST_MULTI_INDEX_MEMBER(transaction_object, transaction_id_type, trx_id), std::hash<transaction_id_type> >,
-         ordered_non_unique< tag<by_expiration>, const_mem_fun<transaction_object, time_point_sec, &transaction_object::get_expiration > >
+         hashed_unique< tag<by_trx_id>, BOOST_MULTI_INDEX_MEMBER(transaction_object, transaction_id_type, trx_id), std::hash<transaction_id_type> >
       >
    > transaction_multi_index_type;
 
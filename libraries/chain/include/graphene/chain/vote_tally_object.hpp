@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/types.hpp>
+#include <graphene/chain/protocol/vote.hpp>
+#include <graphene/db/generic_index.hpp>
+#include <graphene/db/object.hpp>
+
+#include <fc/time.hpp>
+
+#include <memory>
+#include <set>
+#include <tuple>
+#include <utility>
+
+namespace graphene { namespace chain {
+
+   class account_object;
+   class account_statistics_object;
+   class vesting_balance_object;
+
+   /**
+    * @brief Running totals of all votes
+    * @ingroup object
+    * @ingroup implementation
+    *
+    * The totals are updated during chain maintenance for the accounts whose voting stake or opinions changed
+    * since the previous maintenance interval, rather than being recounted from scratch. The histograms are
+    * indexed by the desired number of witnesses / committee members as specified by the voters, they are
+    * bucketed according to the current chain parameters when they are used.
+    *
+    * This object is created at the first maintenance interval after startup.
+    */
+   class vote_tally_object : public graphene::db::abstract_object<vote_tally_object>
+   {
+      public:
+         static const uint8_t space_id = implementation_ids;
+         static const uint8_t type_id  = impl_vote_tally_object_type;
+
+         vector<uint64_t> votes;                   ///< stake voting for each vote_id existing at the time, indexed by instance
+         vector<uint64_t> witness_counts;          ///< stake by desired number of witnesses
+         vector<uint64_t> committee_counts;        ///< stake by desired number of committee members
+         uint64_t         total_stake = 0;
+         bool             count_non_member_votes = true; ///< chain parameter in effect when the totals were updated
+   };
+
+   /**
+    * @brief What an account contributes to the running vote totals
+    * @ingroup object
+    * @ingroup implementation
+    *
+    * Only exists for accounts whose stake is counted, and for accounts whose opinions are counted.
+    */
+   class voter_record_object : public graphene::db::abstract_object<voter_record_object>
+   {
+      public:
+         static const uint8_t space_id = implementation_ids;
+         static const uint8_t type_id  = impl_voter_record_object_type;
+
+         account_id_type        account;
+         uint64_t               stake = 0;         ///< voting stake of the account as counted in the totals
+         account_id_type        opinion_account;   ///< account whose opinions @ref stake is counted for
+
+         /// Sum of the stakes counted for the opinions of this account, i.e. its own stake plus proxied stake
+         uint64_t               proxied_stake = 0;
+         flat_set<vote_id_type> votes;             ///< opinions of this account as counted in the totals
+         uint16_t               num_witness = 0;
+         uint16_t               num_committee = 0;
+
+         bool is_unused()const { return stake == 0 && proxied_stake == 0; }
+   };
+
+   struct by_account;
+
+   /**
+    * @ingroup object_index
+    */
+   typedef multi_index_container<
+      voter_record_object,
+      indexed_by<
+         ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+         ordered_unique< tag<by_account>,
+                         member< voter_record_object, account_id_type, &voter_record_object::account > >
+      >
+   > voter_record_multi_index_type;
+
+   /**
+    * @ingroup object_index
+    */
+   typedef generic_index<voter_record_object, voter_record_multi_index_type> voter_record_index;
+
+   /**
+    * @brief The accounts whose contribution to the vote totals may have changed since the last maintenance
+    *
+    * Filled by @ref vote_tally_tracker, which observes all objects that affect voting. Changes reverted by the
+    * undo database are observed as well, so the set is always a superset of the accounts to revisit.
+    *
+    * Changes made before tracking started are unknown, so the votes are recounted in full once tracking starts.
+    * The votes are recounted again whenever the undo database reverts the @ref vote_tally_object, e.g. when the
+    * block which performed the recount is popped, see @ref vote_tally_revert_tracker. This state is not part of
+    * the chain state, so the totals stored in the chain do not depend on when the node was started.
+    */
+   struct vote_tally_changes
+   {
+      /// Cleared while the object database is being loaded, objects loaded from disk are not tracked
+      bool                      enabled = true;
+      /// Cleared while maintenance updates voter records and the vote totals itself
+      bool                      track_records = true;
+      /// Whether the next maintenance has to recount all votes
+      bool                      recount = true;
+      std::set<account_id_type> accounts;
+
+      void mark( account_id_type account ) { if( enabled ) accounts.insert( account ); }
+
+      /// Starts tracking anew, the next maintenance recounts all votes
+      void reset()
+      {
+         enabled = true;
+         track_records = true;
+         recount = true;
+         accounts.clear();
+      }
+   };
+
+   /// The parts of an object that affect voting, changes of anything else are not tracked
+   ///@{
+   typedef std::tuple< account_id_type, flat_set<vote_id_type>, uint16_t, uint16_t,
+                       vesting_balance_id_type, time_point_sec > account_vote_state;
+   typedef std::tuple< share_type, share_type, bool, bool > account_statistics_vote_state;
+
+   account_vote_state            get_vote_state( const account_object& a );
+   account_statistics_vote_state get_vote_state( const account_statistics_object& s );
+   share_type                    get_vote_state( const vesting_balance_object& vb );
+   account_id_type               get_voter( const account_object& a );
+   account_id_type               get_voter( const account_statistics_object& s );
+   account_id_type               get_voter( const vesting_balance_object& vb );
+   ///@}
+
+   /**
+    * @brief Secondary index which records the accounts whose votes need to be recounted in
+    *        @ref vote_tally_changes
+    */
+   template< typename ObjectType >
+   class vote_tally_tracker : public secondary_index
+   {
+      public:
+         explicit vote_tally_tracker( std::shared_ptr<vote_tally_changes> changes ) : _changes( std::move(changes) ) {}
+
+         virtual void object_inserted( const object& obj ) override
+         {
+            _changes->mark( get_voter( static_cast<const ObjectType&>( obj ) ) );
+         }
+         virtual void object_removed( const object& obj ) override
+         {
+            _changes->mark( get_voter( static_cast<const ObjectType&>( obj ) ) );
+         }
+         virtual void about_to_modify( const object& before ) override
+         {
+            if( _changes->enabled )
+               _before = get_vote_state( static_cast<const ObjectType&>( before ) );
+         }
+         virtual void object_modified( const object& after ) override
+         {
+            const ObjectType& obj = static_cast<const ObjectType&>( after );
+            if( _changes->enabled && get_vote_state( obj ) != _before )
+               _changes->mark( get_voter( obj ) );
+         }
+
+      private:
+         typedef decltype( get_vote_state( std::declval<const ObjectType&>() ) ) state_type;
+
+         std::shared_ptr<vote_tally_changes> _changes;
+         state_type                          _before;
+   };
+
+   /**
+    * @brief Records changes of voter records, so that voters whose records are reverted by the undo database
+    *        are revisited
+    */
+   class voter_record_tracker : public secondary_index
+   {
+      public:
+         explicit voter_record_tracker( std::shared_ptr<vote_tally_changes> changes ) : _changes( std::move(changes) ) {}
+
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void object_modified( const object& after ) override;
+
+      private:
+         void mark( const object& obj );
+
+         std::shared_ptr<vote_tally_changes> _changes;
+   };
+
+   /**
+    * @brief Requests a full recount of the votes when the vote totals are reverted
+    *
+    * Only maintenance updates the @ref vote_tally_object, so any other change is the undo database reverting it.
+    */
+   class vote_tally_revert_tracker : public secondary_index
+   {
+      public:
+         explicit vote_tally_revert_tracker( std::shared_ptr<vote_tally_changes> changes )
+            : _changes( std::move(changes) ) {}
+
+         virtual void object_removed( const object& ) override { on_revert(); }
+         virtual void object_modified( const object& ) override { on_revert(); }
+
+      private:
+         void on_revert()
+         {
+            if( _changes->track_records )
+               _changes->recount = true;
+         }
+
+         std::shared_ptr<vote_tally_changes> _changes;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT_DERIVED( graphene::chain::vote_tally_object, (graphene::db::object),
+                    (votes)(witness_counts)(committee_counts)(total_stake)(count_non_member_votes) )
+
+FC_REFLECT_DERIVED( graphene::chain::voter_record_object, (graphene::db::object),
+                    (account)(stake)(opinion_account)(proxied_stake)(votes)(num_witness)(num_committee) )
@@ -81,8 +81,8 @@ namespace graphene { namespace chain {
 
    struct by_from;
    struct by_authorized;
-   struct by_expiration;
 
+   /// Expirations are kept in an @ref expiration_wheel rather than in an ordered index
    typedef multi_index_container<
       withdraw_permission_object,
       indexed_by<
@@ -98,12 +98,6 @@ namespace graphene { namespace chain {
                member<withdraw_permission_object, account_id_type, &withdraw_permission_object::authorized_account>,
                member< object, object_id_type, &object::id >
             >
-         >,
-         ordered_unique< tag<by_expiration>,
-            composite_key< withdraw_permission_object,
-               member<withdraw_permission_object, time_point_sec, &withdraw_permission_object::expiration>,
-               member< object, object_id_type, &object::id >
-            >
          >
       >
    > withdraw_permission_object_multi_index_type;
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/limit_order_book.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   typedef limit_order_book_index::book_side book_side;
+
+   /// @return the first level of @p side whose price is not below @p p
+   template< typename Side >
+   auto find_first_level( Side& side, const price_sort_key& key, const price& p ) -> decltype( side.begin() )
+   {
+      return std::lower_bound( side.begin(), side.end(), p,
+                               [&key]( const limit_order_book_index::price_level& level, const price& p ) {
+                                  return compare_prices( level.key, level.level_price, key, p ) < 0;
+                               });
+   }
+
+   bool by_id( const limit_order_object* a, const limit_order_object* b )
+   {
+      return a->id < b->id;
+   }
+
+} // anonymous namespace
+
+void limit_order_book_index::object_inserted( const object& obj )
+{
+   insert_order( static_cast< const limit_order_object& >( obj ) );
+}
+
+void limit_order_book_index::object_removed( const object& obj )
+{
+   const limit_order_object& order = static_cast< const limit_order_object& >( obj );
+   remove_order( order, order.sell_price_key, order.sell_price );
+}
+
+void limit_order_book_index::about_to_modify( const object& before )
+{
+   const limit_order_object& order = static_cast< const limit_order_object& >( before );
+   _key_before_modify = order.sell_price_key;
+   _price_before_modify = order.sell_price;
+}
+
+void limit_order_book_index::object_modified( const object& after )
+{
+   const limit_order_object& order = static_cast< const limit_order_object& >( after );
+   if( order.sell_price_key == _key_before_modify && order.sell_price == _price_before_modify )
+      return;
+   remove_order( order, _key_before_modify, _price_before_modify );
+   insert_order( order );
+}
+
+void limit_order_book_index::rebuild( const vector<const object*>& objects )
+{
+   vector< const limit_order_object* > orders;
+   orders.reserve( objects.size() );
+   for( const object* obj : objects )
+      orders.push_back( static_cast< const limit_order_object* >( obj ) );
+   // the objects come in id order, which the stable sort keeps within each price level
+   std::stable_sort( orders.begin(), orders.end(), []( const limit_order_object* a, const limit_order_object* b ) {
+      if( a->sell_asset_id() != b->sell_asset_id() )
+         return a->sell_asset_id() < b->sell_asset_id();
+      if( a->receive_asset_id() != b->receive_asset_id() )
+         return a->receive_asset_id() < b->receive_asset_id();
+      return compare_prices( a->sell_price_key, a->sell_price, b->sell_price_key, b->sell_price ) < 0;
+   });
+
+   _sides.clear();
+   book_side* side = nullptr;
+   for( const limit_order_object* order : orders )
+   {
+      const auto market = std::make_pair( order->sell_asset_id(), order->receive_asset_id() );
+      if( side == nullptr || _sides.rbegin()->first != market )
+         side = &_sides.emplace_hint( _sides.end(), market, book_side() )->second;
+      if( side->empty() || compare_prices( side->back().key, side->back().level_price,
+                                           order->sell_price_key, order->sell_price ) != 0 )
+      {
+         side->push_back( price_level() );
+         side->back().key = order->sell_price_key;
+         side->back().level_price = order->sell_price;
+      }
+      side->back().orders.push_back( order );
+   }
+}
+
+const limit_order_book_index::book_side* limit_order_book_index::find_side( asset_id_type sell_asset,
+                                                                            asset_id_type receive_asset )const
+{
+   auto itr = _sides.find( std::make_pair( sell_asset, receive_asset ) );
+   return itr == _sides.end() ? nullptr : &itr->second;
+}
+
+const limit_order_object* limit_order_book_index::best_order( asset_id_type sell_asset,
+                                                              asset_id_type receive_asset )const
+{
+   const book_side* side = find_side( sell_asset, receive_asset );
+   if( side == nullptr || side->empty() )
+      return nullptr;
+   return side->back().orders.front();
+}
+
+const limit_order_book_index::price_level* limit_order_book_index::find_level( const price& sell_price )const
+{
+   auto side_itr = _sides.find( std::make_pair( sell_price.base.asset_id, sell_price.quote.asset_id ) );
+   if( side_itr == _sides.end() )
+      return nullptr;
+   const book_side& side = side_itr->second;
+   const price_sort_key key( sell_price );
+   auto level = find_first_level( side, key, sell_price );
+   if( level == side.end() || compare_prices( level->key, level->level_price, key, sell_price ) != 0 )
+      return nullptr;
+   return &*level;
+}
+
+size_t limit_order_book_index::level_count( asset_id_type sell_asset, asset_id_type receive_asset )const
+{
+   const book_side* side = find_side( sell_asset, receive_asset );
+   return side == nullptr ? 0 : side->size();
+}
+
+void limit_order_book_index::insert_order( const limit_order_object& order )
+{
+   book_side& side = _sides[ std::make_pair( order.sell_asset_id(), order.receive_asset_id() ) ];
+   const price_sort_key& key = order.sell_price_key;
+   auto level = find_first_level( side, key, order.sell_price );
+   if( level == side.end() || compare_prices( level->key, level->level_price, key, order.sell_price ) != 0 )
+   {
+      level = side.insert( level, price_level() );
+      level->key = key;
+      level->level_price = order.sell_price;
+   }
+   auto& orders = level->orders;
+   // orders are appended in creation order, only undo inserts older orders
+   if( orders.empty() || orders.back()->id < order.id )
+      orders.push_back( &order );
+   else
+      orders.insert( std::upper_bound( orders.begin(), orders.end(), &order, by_id ), &order );
+}
+
+void limit_order_book_index::remove_order( const limit_order_object& order, const price_sort_key& key,
+                                           const price& sell_price )
+{
+   // every order is in the book, a missing one means that the book and the order index went out of sync
+   auto side_itr = _sides.find( std::make_pair( sell_price.base.asset_id, sell_price.quote.asset_id ) );
+   FC_ASSERT( side_itr != _sides.end(), "Limit order ${o} is not in the order book", ("o", order.id) );
+   book_side& side = side_itr->second;
+   auto level = find_first_level( side, key, sell_price );
+   FC_ASSERT( level != side.end() && compare_prices( level->key, level->level_price, key, sell_price ) == 0,
+              "Limit order ${o} is not in the order book at price ${p}", ("o", order.id)("p", sell_price) );
+   auto& orders = level->orders;
+   if( orders.front() == &order )
+      orders.pop_front();
+   else
+   {
+      auto itr = std::lower_bound( orders.begin(), orders.end(), &order, by_id );
+      FC_ASSERT( itr != orders.end() && *itr == &order,
+                 "Limit order ${o} is not in the order book at price ${p}", ("o", order.id)("p", sell_price) );
+      orders.erase( itr );
+   }
+   if( orders.empty() )
+   {
+      side.erase( level );
+      if( side.empty() )
+         _sides.erase( side_itr );
+   }
+}
+
+} } // graphene::chain
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/margin_call_frontier.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+
+namespace graphene { namespace chain {
+
+bool margin_call_frontier::is_quiet( asset_id_type debt_asset, time_point_sec maint_time,
+                                     bool after_hardfork_436 )const
+{
+   auto itr = _quiet.find( debt_asset.instance.value );
+   return itr != _quiet.end() && itr->second.maint_time == maint_time
+          && itr->second.after_hardfork_436 == after_hardfork_436;
+}
+
+void margin_call_frontier::mark_quiet( asset_id_type debt_asset, time_point_sec maint_time,
+                                       bool after_hardfork_436 )
+{
+   check_state& state = _quiet[ debt_asset.instance.value ];
+   state.maint_time = maint_time;
+   state.after_hardfork_436 = after_hardfork_436;
+}
+
+void margin_call_frontier::invalidate( asset_id_type debt_asset )
+{
+   // nothing is marked while the object database is loaded in parallel, so this does not write then
+   if( !_quiet.empty() )
+      _quiet.erase( debt_asset.instance.value );
+}
+
+call_order_margin_state get_margin_call_state( const call_order_object& o )
+{
+   return call_order_margin_state( o.collateral, o.debt, o.call_price.base, o.call_price.quote );
+}
+
+limit_order_margin_state get_margin_call_state( const limit_order_object& o )
+{
+   return limit_order_margin_state( o.sell_price.base, o.sell_price.quote );
+}
+
+bitasset_margin_state get_margin_call_state( const asset_bitasset_data_object& o )
+{
+   // prices are compared by their amounts rather than by their ratio, derived prices depend on the amounts
+   return bitasset_margin_state( o.current_feed.settlement_price.base, o.current_feed.settlement_price.quote,
+                                 o.current_feed.maintenance_collateral_ratio,
+                                 o.current_feed.maximum_short_squeeze_ratio,
+                                 o.current_maintenance_collateralization.base,
+                                 o.current_maintenance_collateralization.quote,
+                                 o.settlement_price.base, o.settlement_price.quote,
+                                 o.is_prediction_market, o.options.short_backing_asset );
+}
+
+asset_id_type get_margin_call_asset( const call_order_object& o )
+{
+   return o.debt_type();
+}
+
+asset_id_type get_margin_call_asset( const limit_order_object& o )
+{
+   return o.sell_asset_id();
+}
+
+asset_id_type get_margin_call_asset( const asset_bitasset_data_object& o )
+{
+   return o.asset_id;
+}
+
+} } // graphene::chain
@@ -27,6 +27,7 @@
 
 #include <graphene/chain/market_evaluator.hpp>
 
+#include <graphene/chain/balance_write_batch.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/hardfork.hpp>
@@ -115,10 +116,13 @@ object_id_type limit_order_create_evaluator::do_apply(const limit_order_create_o
    });
    limit_order_id_type order_id = new_order_object.id; // save this because we may remove the object by filling it
    bool filled;
+   // the seller and the owners of the matched orders are paid once, however many orders are filled
+   balance_write_batch fill_balances( db() );
    if( db().get_dynamic_global_properties().next_maintenance_time <= HARDFORK_CORE_625_TIME )
       filled = db().apply_order_before_hardfork_625( new_order_object );
    else
       filled = db().apply_order( new_order_object );
+   fill_balances.flush();
 
    FC_ASSERT( !op.fill_or_kill || filled );
 
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/median_feed_tracker.hpp>
+
+#include <boost/preprocessor/cat.hpp>
+#include <boost/preprocessor/seq/for_each.hpp>
+
+#include <algorithm>
+#include <tuple>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   bool is_identical( const price& a, const price& b )
+   {
+      return a.base.asset_id == b.base.asset_id && a.base.amount == b.base.amount
+          && a.quote.asset_id == b.quote.asset_id && a.quote.amount == b.quote.amount;
+   }
+   bool is_identical( uint16_t a, uint16_t b ) { return a == b; }
+
+   bool is_identical( const price_feed& a, const price_feed& b )
+   {
+      return is_identical( a.settlement_price, b.settlement_price )
+          && is_identical( a.core_exchange_rate, b.core_exchange_rate )
+          && a.maintenance_collateral_ratio == b.maintenance_collateral_ratio
+          && a.maximum_short_squeeze_ratio == b.maximum_short_squeeze_ratio;
+   }
+
+   /// Orders values which compare equivalent with operator<
+   bool representation_less( const price& a, const price& b )
+   {
+      return std::tie( a.base.asset_id, a.base.amount, a.quote.asset_id, a.quote.amount )
+           < std::tie( b.base.asset_id, b.base.amount, b.quote.asset_id, b.quote.amount );
+   }
+   bool representation_less( uint16_t a, uint16_t b ) { return a < b; }
+
+   /**
+    * The price comparison cross-multiplies the amounts, which is a strict weak ordering as long as both amounts
+    * are positive. A null price compares equivalent to any price between the same assets, which is fine as long
+    * as no other price is between asset 0 and asset 0.
+    */
+   bool is_regular_feed_value( const price& p )
+   {
+      if( p.base.amount == 0 && p.quote.amount == 0 )
+         return p.base.asset_id == asset_id_type() && p.quote.asset_id == asset_id_type();
+      return p.base.amount > 0 && p.quote.amount > 0
+          && !( p.base.asset_id == asset_id_type() && p.quote.asset_id == asset_id_type() );
+   }
+   bool is_regular_feed_value( uint16_t ) { return true; }
+
+} // anonymous namespace
+
+template< typename T >
+bool ranked_feed_values<T>::entry_less( const entry& a, const entry& b )
+{
+   if( a.value < b.value )
+      return true;
+   if( b.value < a.value )
+      return false;
+   if( representation_less( a.value, b.value ) )
+      return true;
+   if( representation_less( b.value, a.value ) )
+      return false;
+   return a.producer < b.producer;
+}
+
+template< typename T >
+void ranked_feed_values<T>::insert( const T& value, account_id_type producer )
+{
+   const entry e{ value, producer };
+   _entries.insert( std::upper_bound( _entries.begin(), _entries.end(), e, &entry_less ), e );
+   if( !is_regular_feed_value( value ) )
+      ++_irregular;
+}
+
+template< typename T >
+void ranked_feed_values<T>::erase( const T& value, account_id_type producer )
+{
+   const entry e{ value, producer };
+   const auto matches = [&e]( const entry& x ) {
+      return x.producer == e.producer && is_identical( x.value, e.value );
+   };
+   // while irregular values are present the entries may not be sorted by entry_less
+   auto itr = _entries.end();
+   if( _irregular == 0 )
+      itr = std::lower_bound( _entries.begin(), _entries.end(), e, &entry_less );
+   if( itr == _entries.end() || !matches( *itr ) )
+      itr = std::find_if( _entries.begin(), _entries.end(), matches );
+   FC_ASSERT( itr != _entries.end(), "Feed value to remove is not ranked" );
+   _entries.erase( itr );
+   if( !is_regular_feed_value( value ) )
+      --_irregular;
+}
+
+template< typename T >
+const T* ranked_feed_values<T>::nth( size_t n )const
+{
+   if( _irregular > 0 || n >= _entries.size() )
+      return nullptr;
+   const auto nth_itr = _entries.begin() + n;
+   const T& value = nth_itr->value;
+   // the values equivalent to the one at rank n, sorted by representation
+   const auto first = std::partition_point( _entries.begin(), nth_itr,
+                                            [&value]( const entry& x ) { return x.value < value; } );
+   const auto last = std::partition_point( nth_itr, _entries.end(),
+                                           [&value]( const entry& x ) { return !( value < x.value ); } ) - 1;
+   if( !is_identical( first->value, last->value ) )
+      return nullptr;
+   return &value;
+}
+
+template class ranked_feed_values< price >;
+template class ranked_feed_values< uint16_t >;
+
+void median_feed_tracker::insert_values( account_id_type producer, const price_feed& feed )
+{
+#define INSERT_FEED_VALUE(r, data, field_name) \
+   BOOST_PP_CAT( _, field_name ).insert( feed.field_name, producer );
+   BOOST_PP_SEQ_FOR_EACH( INSERT_FEED_VALUE, ~, GRAPHENE_PRICE_FEED_FIELDS )
+#undef INSERT_FEED_VALUE
+}
+
+void median_feed_tracker::erase_values( account_id_type producer, const price_feed& feed )
+{
+#define ERASE_FEED_VALUE(r, data, field_name) \
+   BOOST_PP_CAT( _, field_name ).erase( feed.field_name, producer );
+   BOOST_PP_SEQ_FOR_EACH( ERASE_FEED_VALUE, ~, GRAPHENE_PRICE_FEED_FIELDS )
+#undef ERASE_FEED_VALUE
+}
+
+void median_feed_tracker::update( const feed_map& feeds, time_point_sec current_time, uint32_t feed_lifetime_sec )
+{
+   _oldest_publication_time = current_time;
+   auto live_itr = _live.begin();
+   for( const auto& f : feeds )
+   {
+      // producers removed from the feeds map
+      while( live_itr != _live.end() && live_itr->first < f.first )
+      {
+         erase_values( live_itr->first, live_itr->second.second );
+         live_itr = _live.erase( live_itr );
+      }
+
+      const time_point_sec published = f.second.first;
+      const bool alive = ( current_time - published ).to_seconds() < feed_lifetime_sec
+                         && published != time_point_sec();
+      if( live_itr != _live.end() && live_itr->first == f.first )
+      {
+         if( !alive || live_itr->second.first != published
+                    || !is_identical( live_itr->second.second, f.second.second ) )
+         {
+            erase_values( live_itr->first, live_itr->second.second );
+            if( alive )
+            {
+               live_itr->second = f.second;
+               insert_values( f.first, f.second.second );
+            }
+            else
+            {
+               live_itr = _live.erase( live_itr );
+               continue;
+            }
+         }
+         ++live_itr;
+      }
+      else if( alive )
+      {
+         live_itr = _live.emplace_hint( live_itr, f );
+         insert_values( f.first, f.second.second );
+         ++live_itr;
+      }
+
+      if( alive )
+         _oldest_publication_time = std::min( _oldest_publication_time, published );
+   }
+   while( live_itr != _live.end() )
+   {
+      erase_values( live_itr->first, live_itr->second.second );
+      live_itr = _live.erase( live_itr );
+   }
+}
+
+optional< price_feed > median_feed_tracker::median()const
+{
+   // the same rank std::nth_element selects in asset_bitasset_data_object::update_median_feeds
+   const size_t median_rank = _live.size() / 2;
+   price_feed median_feed;
+#define READ_MEDIAN_VALUE(r, data, field_name) \
+   { \
+      const auto* value = BOOST_PP_CAT( _, field_name ).nth( median_rank ); \
+      if( value == nullptr ) \
+         return optional< price_feed >(); \
+      median_feed.field_name = *value; \
+   }
+   BOOST_PP_SEQ_FOR_EACH( READ_MEDIAN_VALUE, ~, GRAPHENE_PRICE_FEED_FIELDS )
+#undef READ_MEDIAN_VALUE
+   return median_feed;
+}
+
+} } // graphene::chain
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/price_sort_key.hpp>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include <limits>
+
+namespace graphene { namespace chain {
+
+typedef boost::multiprecision::uint128_t uint128_t;
+
+price_sort_key::price_sort_key( const price& p )
+{
+   const uint64_t base = p.base.amount.value > 0 ? uint64_t( p.base.amount.value ) : 0;
+   const uint64_t quote = p.quote.amount.value > 0 ? uint64_t( p.quote.amount.value ) : 0;
+   if( quote == 0 )
+   {
+      // not a valid price, sorts above all others
+      high = low = std::numeric_limits< uint64_t >::max();
+      return;
+   }
+   // base < 2^63, so the shifted value fits
+   const uint128_t ratio = ( uint128_t( base ) << 64 ) / quote;
+   high = uint128_t( ratio >> 64 ).convert_to< uint64_t >();
+   low  = uint128_t( ratio & std::numeric_limits< uint64_t >::max() ).convert_to< uint64_t >();
+}
+
+int compare_prices( const price_sort_key& key_a, const price& a, const price_sort_key& key_b, const price& b )
+{
+   if( key_a < key_b )
+      return -1;
+   if( key_b < key_a )
+      return 1;
+   const uint128_t amult = uint128_t( b.quote.amount.value ) * a.base.amount.value;
+   const uint128_t bmult = uint128_t( a.quote.amount.value ) * b.base.amount.value;
+   return amult < bmult ? -1 : ( bmult < amult ? 1 : 0 );
+}
+
+} } // graphene::chain
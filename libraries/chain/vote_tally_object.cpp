@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/vote_tally_object.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/vesting_balance_object.hpp>
+
+namespace graphene { namespace chain {
+
+account_vote_state get_vote_state( const account_object& a )
+{
+   const vesting_balance_id_type cashback_vb = ( a.cashback_vb.valid() ? *a.cashback_vb
+                                                 : vesting_balance_id_type( GRAPHENE_DB_MAX_INSTANCE_ID ) );
+   return account_vote_state( a.options.voting_account, a.options.votes, a.options.num_witness,
+                              a.options.num_committee, cashback_vb, a.membership_expiration_date );
+}
+
+account_statistics_vote_state get_vote_state( const account_statistics_object& s )
+{
+   return account_statistics_vote_state( s.total_core_in_orders, s.core_in_balance, s.has_cashback_vb, s.is_voting );
+}
+
+share_type get_vote_state( const vesting_balance_object& vb )
+{
+   return vb.balance.amount;
+}
+
+account_id_type get_voter( const account_object& a )
+{
+   return a.id;
+}
+
+account_id_type get_voter( const account_statistics_object& s )
+{
+   return s.owner;
+}
+
+account_id_type get_voter( const vesting_balance_object& vb )
+{
+   return vb.owner;
+}
+
+void voter_record_tracker::object_inserted( const object& obj )
+{
+   mark( obj );
+}
+
+void voter_record_tracker::object_removed( const object& obj )
+{
+   mark( obj );
+}
+
+void voter_record_tracker::object_modified( const object& after )
+{
+   mark( after );
+}
+
+void voter_record_tracker::mark( const object& obj )
+{
+   if( _changes->track_records )
+      _changes->mark( static_cast<const voter_record_object&>( obj ).account );
+}
+
+} } // graphene::chain
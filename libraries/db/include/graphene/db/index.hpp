@@ -30,6 +30,7 @@
 #include <fc/crypto/sha256.hpp>
 
 #include <fstream>
+#include <functional>
 #include <stack>
 
 namespace graphene { namespace db {
@@ -94,11 +95,27 @@ namespace graphene { namespace db {
          virtual const object&  create( const std::function<void(object&)>& constructor ) = 0;
 
          /**
-          *  Opens the index loading objects from a file
+          *  Opens the index loading objects from a file, object_database::open() does so within a bulk load
           */
          virtual void open( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /**
+          *  Between these calls secondary indexes which can be rebuilt are not notified of inserted, modified
+          *  and removed objects. Instead they are built once from all objects when the bulk load ends.
+          */
+         virtual void begin_bulk_load() {}
+         void end_bulk_load()
+         {
+            for( const auto& rebuild : finish_bulk_load() )
+               rebuild();
+         }
+         /**
+          *  Ends a bulk load without rebuilding the secondary indexes
+          *  @return the rebuilds left to run, one per secondary index, which may run concurrently
+          */
+         virtual vector< std::function<void()> > finish_bulk_load() { return vector< std::function<void()> >(); }
+
 
 
          /** @return the object with id or nullptr if not found */
@@ -145,6 +162,17 @@ namespace graphene { namespace db {
          virtual void object_removed( const object& obj ){};
          virtual void about_to_modify( const object& before ){};
          virtual void object_modified( const object& after  ){};
+
+         /**
+          *  @return true if the index may be left stale during a bulk load and built by @ref rebuild at its end,
+          *  which requires that nothing reads the index while objects are loaded or created in bulk
+          */
+         virtual bool is_rebuildable()const { return false; }
+         /**
+          *  Discards the contents of the index and indexes the given objects instead
+          *  @param objects all objects of the primary index, ordered by id
+          */
+         virtual void rebuild( const vector<const object*>& objects ){};
    };
 
    /**
@@ -381,7 +409,8 @@ namespace graphene { namespace db {
          {
             const auto& result = DerivedIndex::insert( fc::raw::unpack<object_type>( data ) );
             for( const auto& item : _sindex )
-               item->object_inserted( result );
+               if( is_notified( *item ) )
+                  item->object_inserted( result );
             return result;
          }
 
@@ -390,7 +419,8 @@ namespace graphene { namespace db {
          {
             const auto& result = DerivedIndex::create( constructor );
             for( const auto& item : _sindex )
-               item->object_inserted( result );
+               if( is_notified( *item ) )
+                  item->object_inserted( result );
             on_add( result );
             return result;
          }
@@ -399,7 +429,8 @@ namespace graphene { namespace db {
          {
             const auto& result = DerivedIndex::insert( std::move( obj ) );
             for( const auto& item : _sindex )
-               item->object_inserted( result );
+               if( is_notified( *item ) )
+                  item->object_inserted( result );
             on_add( result );
             return result;
          }
@@ -407,7 +438,8 @@ namespace graphene { namespace db {
          virtual void  remove( const object& obj ) override
          {
             for( const auto& item : _sindex )
-               item->object_removed( obj );
+               if( is_notified( *item ) )
+                  item->object_removed( obj );
             on_remove(obj);
             DerivedIndex::remove(obj);
          }
@@ -416,13 +448,38 @@ namespace graphene { namespace db {
          {
             save_undo( obj );
             for( const auto& item : _sindex )
-               item->about_to_modify( obj );
+               if( is_notified( *item ) )
+                  item->about_to_modify( obj );
             DerivedIndex::modify( obj, m );
             for( const auto& item : _sindex )
-               item->object_modified( obj );
+               if( is_notified( *item ) )
+                  item->object_modified( obj );
             on_modify( obj );
          }
 
+         virtual void begin_bulk_load() override
+         {
+            _bulk_loading = true;
+         }
+
+         virtual vector< std::function<void()> > finish_bulk_load() override
+         {
+            vector< std::function<void()> > rebuilds;
+            if( !_bulk_loading )
+               return rebuilds;
+            _bulk_loading = false;
+            auto objects = std::make_shared< vector<const object*> >();
+            this->inspect_all_objects( [&objects]( const object& o ) { objects->push_back( &o ); } );
+            for( const auto& item : _sindex )
+            {
+               if( !item->is_rebuildable() )
+                  continue;
+               secondary_index* sindex = item.get();
+               rebuilds.emplace_back( [sindex, objects]() { sindex->rebuild( *objects ); } );
+            }
+            return rebuilds;
+         }
+
          virtual void add_observer( const shared_ptr<index_observer>& o ) override
          {
             _observers.emplace_back( o );
@@ -447,8 +504,14 @@ namespace graphene { namespace db {
          }
 
       private:
+         bool is_notified( const secondary_index& item )const
+         {
+            return !_bulk_loading || !item.is_rebuildable();
+         }
+
          object_id_type                                 _next_id;
          const direct_index< object_type, DirectBits >* _direct_by_id = nullptr;
+         bool                                           _bulk_loading = false;
    };
 
 } } // graphene::db
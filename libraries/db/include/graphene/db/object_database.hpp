@@ -53,6 +53,16 @@ namespace graphene { namespace db {
          void wipe(const fc::path& data_dir); // remove from disk
          void close();
 
+         /// Starts or ends a bulk load in all indexes, see index::begin_bulk_load(). The secondary indexes are
+         /// rebuilt concurrently when the bulk load ends.
+         ///@{
+         void begin_bulk_load();
+         void end_bulk_load();
+         ///@}
+
+         /// Calls @p visitor with every index, e.g. to add an observer to all of them
+         void inspect_all_indexes( const std::function<void(index&)>& visitor );
+
          template<typename T, typename F>
          const T& create( F&& constructor )
          {
@@ -32,12 +32,12 @@ namespace graphene { namespace db {
    void base_primary_index::on_add( const object& obj )
    {
       _db.save_undo_add( obj );
-      for( auto ob : _observers ) ob->on_add( obj );
+      for( const auto& ob : _observers ) ob->on_add( obj );
    }
 
    void base_primary_index::on_remove( const object& obj )
-   { _db.save_undo_remove( obj ); for( auto ob : _observers ) ob->on_remove( obj ); }
+   { _db.save_undo_remove( obj ); for( const auto& ob : _observers ) ob->on_remove( obj ); }
 
    void base_primary_index::on_modify( const object& obj )
-   {for( auto ob : _observers ) ob->on_modify(  obj ); }
+   {for( const auto& ob : _observers ) ob->on_modify(  obj ); }
 } } // graphene::chain
@@ -113,6 +113,8 @@ void object_database::open(const fc::path& data_dir)
    std::vector<fc::future<void>> tasks;
    tasks.reserve(200);
    ilog("Opening object database from ${d} ...", ("d", data_dir));
+   // load all primary objects first, then build the secondary indexes from the complete object sets
+   begin_bulk_load();
    for( uint32_t space = 0; space < _index.size(); ++space )
       for( uint32_t type = 0; type  < _index[space].size(); ++type )
          if( _index[space][type] )
@@ -121,11 +123,40 @@ void object_database::open(const fc::path& data_dir)
             } ) );
    for( auto& task : tasks )
       task.wait();
+   end_bulk_load();
    ilog( "Done opening object database." );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
 
+void object_database::begin_bulk_load()
+{
+   for( const auto& space : _index )
+      for( const auto& idx : space )
+         if( idx )
+            idx->begin_bulk_load();
+}
+
+void object_database::end_bulk_load()
+{
+   std::vector<fc::future<void>> tasks;
+   for( const auto& space : _index )
+      for( const auto& idx : space )
+         if( idx )
+            for( auto& rebuild : idx->finish_bulk_load() )
+               tasks.push_back( fc::do_parallel( std::move( rebuild ) ) );
+   for( auto& task : tasks )
+      task.wait();
+}
+
+void object_database::inspect_all_indexes( const std::function<void(index&)>& visitor )
+{
+   for( const auto& space : _index )
+      for( const auto& idx : space )
+         if( idx )
+            visitor( *idx );
+}
+
 void object_database::pop_undo()
 { try {
    _undo_db.pop_commit();
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/account_object.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/time.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <deque>
+#include <fstream>
+#include <set>
+#include <random>
+
+#include <unistd.h>
+
+using namespace graphene::chain;
+
+namespace {
+
+   /// Resident set size of the process in bytes, 0 where /proc is not available
+   uint64_t resident_set_size()
+   {
+      std::ifstream statm( "/proc/self/statm" );
+      uint64_t pages = 0;
+      uint64_t resident = 0;
+      if( !( statm >> pages >> resident ) )
+         return 0;
+      return resident * uint64_t( sysconf( _SC_PAGESIZE ) );
+   }
+
+   /// The layout balances_by_account_index used before, a std::map per account
+   class map_balances_by_account
+   {
+      public:
+         void insert( const account_balance_object& abo )
+         {
+            while( balances.size() < (abo.owner.instance.value >> bits) + 1 )
+            {
+               balances.resize( balances.size() + 1 );
+               balances.back().resize( 1ULL << bits );
+            }
+            balances[abo.owner.instance.value >> bits][abo.owner.instance.value & mask][abo.asset_type] = &abo;
+         }
+
+         const account_balance_object* find( account_id_type acct, asset_id_type asset )const
+         {
+            if( balances.size() < (acct.instance.value >> bits) + 1 ) return nullptr;
+            const auto& mine = balances[acct.instance.value >> bits][acct.instance.value & mask];
+            const auto itr = mine.find( asset );
+            return itr == mine.end() ? nullptr : itr->second;
+         }
+
+      private:
+         static const uint8_t  bits = 20;
+         static const uint64_t mask = (1ULL << bits) - 1;
+         vector< vector< map< asset_id_type, const account_balance_object* > > > balances;
+   };
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( account_balances_bench )
+{
+   try {
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t account_count = 1500000;
+      const uint32_t lookup_count = 5000000;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t account_count = 150000;
+      const uint32_t lookup_count = 500000;
+#endif
+      const uint32_t asset_count = 4000;
+
+      // like on mainnet, most accounts hold CORE and maybe one or two other assets, few hold many
+      std::mt19937_64 rng( 42 );
+      std::deque< account_balance_object > balance_objects;
+      for( uint32_t i = 0; i < account_count; ++i )
+      {
+         const uint32_t kind = rng() % 100;
+         const uint32_t held = kind < 60 ? 1 : kind < 90 ? 2 + rng() % 2 : kind < 99 ? 4 + rng() % 7 : 11 + rng() % 190;
+         std::set< uint64_t > assets{ 0 };
+         while( assets.size() < held )
+            assets.insert( 1 + rng() % ( asset_count - 1 ) );
+         for( const uint64_t a : assets )
+         {
+            balance_objects.emplace_back();
+            account_balance_object& abo = balance_objects.back();
+            abo.id = account_balance_id_type( balance_objects.size() - 1 );
+            abo.owner = account_id_type( i );
+            abo.asset_type = asset_id_type( a );
+            abo.balance = int64_t( rng() % 1000000 );
+         }
+      }
+      ilog("Created ${b} balances of ${a} accounts.", ("b", balance_objects.size())("a", account_count));
+
+      uint64_t rss_before = resident_set_size();
+      fc::time_point start_time = fc::time_point::now();
+      balances_by_account_index index;
+      for( const account_balance_object& abo : balance_objects )
+         index.object_inserted( abo );
+      const uint64_t list_build_us = ( fc::time_point::now() - start_time ).count();
+      const uint64_t list_rss = resident_set_size() - rss_before;
+
+      rss_before = resident_set_size();
+      start_time = fc::time_point::now();
+      map_balances_by_account map_index;
+      for( const account_balance_object& abo : balance_objects )
+         map_index.insert( abo );
+      const uint64_t map_build_us = ( fc::time_point::now() - start_time ).count();
+      const uint64_t map_rss = resident_set_size() - rss_before;
+
+      // a third of the lookups is for a balance that does not exist
+      vector< std::pair< account_id_type, asset_id_type > > lookups;
+      lookups.reserve( lookup_count );
+      for( uint32_t i = 0; i < lookup_count; ++i )
+      {
+         const account_balance_object& abo = balance_objects[ rng() % balance_objects.size() ];
+         lookups.emplace_back( abo.owner, i % 3 == 0 ? asset_id_type( rng() % asset_count ) : abo.asset_type );
+      }
+
+      uint64_t list_found = 0;
+      start_time = fc::time_point::now();
+      for( const auto& lookup : lookups )
+         if( index.get_account_balance( lookup.first, lookup.second ) != nullptr )
+            ++list_found;
+      const uint64_t list_lookup_us = ( fc::time_point::now() - start_time ).count();
+
+      uint64_t map_found = 0;
+      start_time = fc::time_point::now();
+      for( const auto& lookup : lookups )
+         if( map_index.find( lookup.first, lookup.second ) != nullptr )
+            ++map_found;
+      const uint64_t map_lookup_us = ( fc::time_point::now() - start_time ).count();
+      BOOST_CHECK_EQUAL( list_found, map_found );
+
+      ilog("Balance lists: ${m} MiB, built in ${b} ms, ${l} ns per lookup.",
+           ("m", list_rss >> 20)("b", list_build_us / 1000)("l", list_lookup_us * 1000 / lookup_count));
+      ilog("Maps per account: ${m} MiB, built in ${b} ms, ${l} ns per lookup.",
+           ("m", map_rss >> 20)("b", map_build_us / 1000)("l", map_lookup_us * 1000 / lookup_count));
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
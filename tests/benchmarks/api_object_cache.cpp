@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/database_api.hpp>
+#include <graphene/app/serialized_object_cache.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_CASE( api_object_cache_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t session_count = 1000;
+      const uint32_t calls_per_block = 20000;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t session_count = 100;
+      const uint32_t calls_per_block = 2000;
+#endif
+      const uint32_t popular_account_count = 100;
+      const uint32_t block_count = 10;
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      for( uint32_t i = 0; i < popular_account_count; ++i )
+         genesis_state.initial_accounts.emplace_back( "popular"+fc::to_string(i), witness_priv_key.get_public_key(),
+                                                      witness_priv_key.get_public_key() );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      // what wallets and explorers ask for all the time: global properties, core asset and a popular account
+      const auto& accounts_by_name = db.get_index_type<account_index>().indices().get<by_name>();
+      vector< vector<object_id_type> > requests;
+      for( uint32_t i = 0; i < popular_account_count; ++i )
+      {
+         vector<object_id_type> ids;
+         ids.push_back( global_property_id_type() );
+         ids.push_back( dynamic_global_property_id_type() );
+         ids.push_back( asset_id_type() );
+         ids.push_back( accounts_by_name.find( "popular"+fc::to_string(i) )->id );
+         requests.push_back( ids );
+      }
+
+      vector< std::unique_ptr<graphene::app::database_api> > sessions;
+      for( uint32_t i = 0; i < session_count; ++i )
+         sessions.emplace_back( new graphene::app::database_api( db ) );
+
+      auto cache = graphene::app::serialized_object_cache::get( db );
+      // @return the time taken by all calls, in microseconds
+      auto run_calls = [&]() -> int64_t {
+         int64_t total_us = 0;
+         size_t result_count = 0;
+         for( uint32_t b = 0; b < block_count; ++b )
+         {
+            // every block modifies the dynamic global properties
+            db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+            fc::time_point start_time = fc::time_point::now();
+            for( uint32_t c = 0; c < calls_per_block; ++c )
+               result_count += sessions[ c % session_count ]->get_objects( requests[ c % popular_account_count ] ).size();
+            total_us += ( fc::time_point::now() - start_time ).count();
+         }
+         BOOST_CHECK_EQUAL( result_count, size_t( block_count ) * calls_per_block * 4 );
+         return total_us;
+      };
+
+      cache->set_capacity( 0 );
+      const int64_t uncached_us = run_calls();
+
+      cache->set_capacity( graphene::app::serialized_object_cache::default_capacity );
+      cache->reset_stats();
+      const int64_t cached_us = run_calls();
+      const graphene::app::object_cache_stats stats = cache->get_stats();
+      BOOST_CHECK_GT( stats.hits, stats.misses );
+
+      const uint64_t calls = uint64_t( block_count ) * calls_per_block;
+      ilog("${c} get_objects calls from ${s} sessions: ${u} us per call converting every object, ${h} us per call "
+           "with the cache, ${hits} hits, ${m} misses, ${i} invalidations.",
+           ("c", calls)("s", session_count)("u", double( uncached_us ) / calls)("h", double( cached_us ) / calls)
+           ("hits", stats.hits)("m", stats.misses)("i", stats.invalidations));
+
+      sessions.clear();
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
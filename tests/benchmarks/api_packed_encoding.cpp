@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api.hpp>
+#include <graphene/app/packed_encoding.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_CASE( api_packed_encoding_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t block_count = 200;
+      const uint32_t transfers_per_block = 500;
+      const uint32_t rounds = 20;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t block_count = 50;
+      const uint32_t transfers_per_block = 100;
+      const uint32_t rounds = 5;
+#endif
+      const uint32_t account_count = 1000;
+      // the largest range a block explorer or an indexer asks for in one call
+      const uint32_t blocks_per_call = 50;
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      for( uint32_t i = 0; i < account_count; ++i )
+         genesis_state.initial_accounts.emplace_back( "sender"+fc::to_string(i), witness_priv_key.get_public_key(),
+                                                      witness_priv_key.get_public_key() );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      const auto& accounts_by_name = db.get_index_type<account_index>().indices().get<by_name>();
+      vector<account_id_type> senders;
+      for( uint32_t i = 0; i < account_count; ++i )
+      {
+         senders.push_back( accounts_by_name.find( "sender"+fc::to_string(i) )->id );
+         db.adjust_balance( senders.back(), asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+      }
+
+      uint32_t next_sender = 0;
+      for( uint32_t b = 0; b < block_count; ++b )
+      {
+         for( uint32_t t = 0; t < transfers_per_block; ++t )
+         {
+            transfer_operation op;
+            op.from = senders[ next_sender ];
+            next_sender = ( next_sender + 1 ) % account_count;
+            op.to = senders[ next_sender ];
+            op.amount = asset( 1 );
+            signed_transaction trx;
+            trx.operations.push_back( op );
+            db.current_fee_schedule().set_fee( trx.operations.back() );
+            trx.set_expiration( db.head_block_time() + fc::minutes(1) );
+            db.push_transaction( trx, ~0 );
+         }
+         db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+      }
+
+      // both measure the whole response as it is sent to the client, i.e. including the conversion to text
+      graphene::app::block_api block_api( db );
+      const uint32_t last_block = db.head_block_num();
+      uint64_t json_bytes = 0;
+      uint64_t packed_bytes = 0;
+
+      fc::time_point start_time = fc::time_point::now();
+      for( uint32_t r = 0; r < rounds; ++r )
+         for( uint32_t from = 2; from + blocks_per_call - 1 <= last_block; from += blocks_per_call )
+            json_bytes += fc::json::to_string( fc::variant( block_api.get_blocks( from, from + blocks_per_call - 1 ),
+                                                            GRAPHENE_MAX_NESTED_OBJECTS ) ).size();
+      const int64_t json_us = ( fc::time_point::now() - start_time ).count();
+
+      start_time = fc::time_point::now();
+      for( uint32_t r = 0; r < rounds; ++r )
+         for( uint32_t from = 2; from + blocks_per_call - 1 <= last_block; from += blocks_per_call )
+            packed_bytes += fc::json::to_string( fc::variant( block_api.get_blocks_packed( from,
+                                                                 from + blocks_per_call - 1 ), 1 ) ).size();
+      const int64_t packed_us = ( fc::time_point::now() - start_time ).count();
+
+      // the client side of the binary encoding
+      const auto blocks = graphene::app::unpack_result< vector<optional<signed_block>> >(
+                             fc::variant( block_api.get_blocks_packed( 2, 1 + blocks_per_call ), 1 ) );
+      BOOST_REQUIRE_EQUAL( blocks.size(), blocks_per_call );
+      BOOST_REQUIRE( blocks.front().valid() );
+      BOOST_CHECK_EQUAL( blocks.front()->transactions.size(), transfers_per_block );
+
+      const uint64_t blocks_returned = uint64_t( rounds ) * ( ( last_block - 1 ) / blocks_per_call ) * blocks_per_call;
+      ilog("get_blocks of ${b} blocks with ${t} transfers each: ${j} blocks/s and ${jb} bytes as JSON, "
+           "${p} blocks/s and ${pb} bytes packed.",
+           ("b", blocks_returned)("t", transfers_per_block)
+           ("j", blocks_returned * 1000000 / std::max<int64_t>( json_us, 1 ))("jb", json_bytes)
+           ("p", blocks_returned * 1000000 / std::max<int64_t>( packed_us, 1 ))("pb", packed_bytes));
+
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/balance_write_batch.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_CASE( balance_batch_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t maker_count = 1000;
+      const uint32_t resting_order_count = 200000;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t maker_count = 100;
+      const uint32_t resting_order_count = 20000;
+#endif
+      // every taker fills this many bids, like a block full of large market sells in one market
+      const uint32_t fills_per_taker = 50;
+      const uint32_t taker_count = resting_order_count / fills_per_taker;
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      for( uint32_t i = 0; i < maker_count; ++i )
+         genesis_state.initial_accounts.emplace_back( "maker"+fc::to_string(i), witness_priv_key.get_public_key(),
+                                                      witness_priv_key.get_public_key() );
+      // two markets with the same book, the takers of one are applied without and of the other with a batch
+      for( const string symbol : { "PLAIN", "BATCHED" } )
+      {
+         genesis_state_type::initial_asset_type market_asset;
+         market_asset.symbol = symbol;
+         market_asset.issuer_name = "init0";
+         market_asset.max_supply = GRAPHENE_MAX_SHARE_SUPPLY;
+         genesis_state.initial_assets.push_back( market_asset );
+      }
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      const auto& accounts_by_name = db.get_index_type<account_index>().indices().get<by_name>();
+      const account_id_type taker_account = accounts_by_name.find( "init0" )->id;
+      vector<account_id_type> makers;
+      for( uint32_t i = 0; i < maker_count; ++i )
+         makers.push_back( accounts_by_name.find( "maker"+fc::to_string(i) )->id );
+      const auto& assets_by_symbol = db.get_index_type<asset_index>().indices().get<by_symbol>();
+      const asset_id_type plain = assets_by_symbol.find( "PLAIN" )->id;
+      const asset_id_type batched = assets_by_symbol.find( "BATCHED" )->id;
+
+      // bids of 100 CORE for 100 units each
+      for( uint32_t i = 0; i < resting_order_count; ++i )
+      {
+         for( const asset_id_type market : { plain, batched } )
+         {
+            db.create<limit_order_object>( [&]( limit_order_object& o ) {
+               o.seller = makers[ i % maker_count ];
+               o.expiration = time_point_sec::maximum();
+               o.for_sale = 100;
+               o.sell_price = price( asset( 100 ), asset( 100, market ) );
+            });
+         }
+      }
+
+      auto create_taker = [&]( asset_id_type market ) -> const limit_order_object& {
+         return db.create<limit_order_object>( [&]( limit_order_object& o ) {
+            o.seller = taker_account;
+            o.expiration = time_point_sec::maximum();
+            o.for_sale = 100 * fills_per_taker;
+            o.sell_price = price( asset( 100 * fills_per_taker, market ), asset( 100 * fills_per_taker ) );
+         });
+      };
+
+      const int64_t taker_core_before = db.get_balance( taker_account, asset_id_type() ).amount.value;
+      uint64_t plain_us = 0;
+      uint64_t batched_us = 0;
+      uint32_t filled_takers = 0;
+      size_t written_balances = 0;
+      for( uint32_t i = 0; i < taker_count; ++i )
+      {
+         const limit_order_object& plain_taker = create_taker( plain );
+         fc::time_point start_time = fc::time_point::now();
+         if( db.apply_order( plain_taker ) )
+            ++filled_takers;
+         plain_us += ( fc::time_point::now() - start_time ).count();
+
+         const limit_order_object& batched_taker = create_taker( batched );
+         start_time = fc::time_point::now();
+         {
+            balance_write_batch batch( db );
+            if( db.apply_order( batched_taker ) )
+               ++filled_takers;
+            written_balances += batch.size();
+            batch.flush();
+         }
+         batched_us += ( fc::time_point::now() - start_time ).count();
+      }
+      BOOST_CHECK_EQUAL( filled_takers, 2 * taker_count );
+      BOOST_CHECK_EQUAL( db.get_balance( taker_account, asset_id_type() ).amount.value,
+                         taker_core_before + 2 * 100 * int64_t( resting_order_count ) );
+      for( const account_id_type maker : makers )
+         BOOST_CHECK_EQUAL( db.get_balance( maker, plain ).amount.value, db.get_balance( maker, batched ).amount.value );
+
+      const uint64_t adjustments = uint64_t( 2 ) * fills_per_taker * taker_count;
+      ilog("${n} takers filling ${f} bids each: ${p} us per taker writing every fill, "
+           "${b} us per taker with a batch, ${a} balance adjustments coalesced into ${w} writes.",
+           ("n", taker_count)("f", fills_per_taker)("p", double( plain_us ) / taker_count)
+           ("b", double( batched_us ) / taker_count)("a", adjustments)("w", written_balances));
+
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/database_api.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/protocol/transfer.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_CASE( change_notification_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t account_count = 20000;
+      const uint32_t transfers_per_block = 5000;
+      const uint32_t idle_sessions = 5000;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t account_count = 2000;
+      const uint32_t transfers_per_block = 500;
+      const uint32_t idle_sessions = 500;
+#endif
+      const uint32_t measured_blocks = 10;
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      for( uint32_t i = 0; i < account_count; ++i )
+         genesis_state.initial_accounts.emplace_back( "sender"+fc::to_string(i), witness_priv_key.get_public_key(),
+                                                      witness_priv_key.get_public_key() );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      const auto& accounts_by_name = db.get_index_type<account_index>().indices().get<by_name>();
+      vector<account_id_type> senders;
+      for( uint32_t i = 0; i < account_count; ++i )
+      {
+         senders.push_back( accounts_by_name.find( "sender"+fc::to_string(i) )->id );
+         db.adjust_balance( senders.back(), asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+      }
+
+      // API sessions of clients which neither subscribed to objects nor to accounts
+      uint64_t notifications = 0;
+      vector<boost::signals2::scoped_connection> connections;
+      for( uint32_t i = 0; i < idle_sessions; ++i )
+      {
+         connections.emplace_back( db.new_objects.connect(
+            [&]( const vector<object_id_type>&, const flat_set<account_id_type>& ) { ++notifications; } ) );
+         connections.emplace_back( db.changed_objects.connect(
+            [&]( const vector<object_id_type>&, const flat_set<account_id_type>& ) { ++notifications; } ) );
+         connections.emplace_back( db.removed_objects.connect(
+            [&]( const vector<object_id_type>&, const vector<const object*>&, const flat_set<account_id_type>& ) {
+               ++notifications;
+            } ) );
+      }
+
+      block_phase_tracer& tracer = db.get_block_phase_tracer();
+      tracer.set_capacity( measured_blocks );
+      uint32_t next_sender = 0;
+      // @return the average time spent in notify_changed_objects per block, in microseconds
+      auto measure = [&]() -> uint64_t {
+         for( uint32_t b = 0; b < measured_blocks; ++b )
+         {
+            for( uint32_t t = 0; t < transfers_per_block; ++t )
+            {
+               transfer_operation op;
+               op.from = senders[ next_sender ];
+               next_sender = ( next_sender + 1 ) % account_count;
+               op.to = senders[ next_sender ];
+               op.amount = asset( 1 );
+               signed_transaction trx;
+               trx.operations.push_back( op );
+               db.current_fee_schedule().set_fee( trx.operations.back() );
+               trx.set_expiration( db.head_block_time() + fc::minutes(1) );
+               db.push_transaction( trx, ~0 );
+            }
+            db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+         }
+         uint64_t total_ns = 0;
+         for( const block_phase_trace& trace : tracer.get_traces( measured_blocks ) )
+            for( const block_phase_timing& timing : trace.phases )
+               if( timing.phase == block_phase::notify_changed_objects )
+                  total_ns += timing.duration_ns;
+         return total_ns / measured_blocks / 1000;
+      };
+
+      const uint64_t idle_us = measure();
+      BOOST_CHECK( !db.impacted_accounts_requested() );
+
+      // a single session subscribed to an account makes every block compute the impacted accounts
+      std::shared_ptr<void> request = db.request_impacted_accounts();
+      const uint64_t requested_us = measure();
+      request.reset();
+
+      BOOST_CHECK_GE( notifications, uint64_t( 2 ) * measured_blocks * idle_sessions );
+      ilog("${t} transfers per block, ${s} idle sessions: notify_changed_objects took ${i} us per block "
+           "without and ${r} us per block with impacted accounts requested.",
+           ("t", transfers_per_block)("s", idle_sessions)("i", idle_us)("r", requested_us));
+
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( subscription_fanout_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t session_count = 5000;
+      const uint32_t transfers_per_block = 2000;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t session_count = 500;
+      const uint32_t transfers_per_block = 200;
+#endif
+      const uint32_t measured_blocks = 10;
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      for( uint32_t i = 0; i < session_count; ++i )
+         genesis_state.initial_accounts.emplace_back( "client"+fc::to_string(i), witness_priv_key.get_public_key(),
+                                                      witness_priv_key.get_public_key() );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      const auto& accounts_by_name = db.get_index_type<account_index>().indices().get<by_name>();
+      vector<account_id_type> clients;
+      for( uint32_t i = 0; i < session_count; ++i )
+      {
+         clients.push_back( accounts_by_name.find( "client"+fc::to_string(i) )->id );
+         db.adjust_balance( clients.back(), asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+      }
+
+      // every client watches its own account object, only one of them follows all changes of its account
+      uint64_t updates = 0;
+      vector< std::unique_ptr<graphene::app::database_api> > sessions;
+      for( uint32_t i = 0; i < session_count; ++i )
+      {
+         sessions.emplace_back( new graphene::app::database_api( db ) );
+         sessions.back()->set_subscribe_callback( [&updates]( const fc::variant& ) { ++updates; }, false );
+         sessions.back()->get_objects( { clients[i] } );
+      }
+      sessions.front()->get_full_accounts( { "client0" }, true );
+
+      block_phase_tracer& tracer = db.get_block_phase_tracer();
+      tracer.set_capacity( measured_blocks );
+      for( uint32_t b = 0; b < measured_blocks; ++b )
+      {
+         for( uint32_t t = 0; t < transfers_per_block; ++t )
+         {
+            transfer_operation op;
+            op.from = clients[ ( b * transfers_per_block + t ) % session_count ];
+            op.to = clients[ ( b * transfers_per_block + t + 1 ) % session_count ];
+            op.amount = asset( 1 );
+            signed_transaction trx;
+            trx.operations.push_back( op );
+            db.current_fee_schedule().set_fee( trx.operations.back() );
+            trx.set_expiration( db.head_block_time() + fc::minutes(1) );
+            db.push_transaction( trx, ~0 );
+         }
+         db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+      }
+      // deliver the queued callbacks
+      fc::usleep( fc::milliseconds( 200 ) );
+
+      uint64_t total_ns = 0;
+      for( const block_phase_trace& trace : tracer.get_traces( measured_blocks ) )
+         for( const block_phase_timing& timing : trace.phases )
+            if( timing.phase == block_phase::notify_changed_objects )
+               total_ns += timing.duration_ns;
+      BOOST_CHECK_GT( updates, 0u );
+      ilog("${s} subscribed sessions, ${t} transfers per block: notify_changed_objects took ${n} us per block, "
+           "${u} updates delivered.",
+           ("s", session_count)("t", transfers_per_block)("n", total_ns / measured_blocks / 1000)("u", updates));
+
+      sessions.clear();
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
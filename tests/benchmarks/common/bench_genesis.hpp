@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/genesis_state.hpp>
+#include <graphene/chain/config.hpp>
+
+#include <fc/crypto/elliptic.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <fc/string.hpp>
+#include <fc/time.hpp>
+
+#include <string>
+
+namespace graphene { namespace chain { namespace test {
+
+/// @return the key of the init witnesses of the benchmarks
+inline fc::ecc::private_key bench_witness_key()
+{
+   return fc::ecc::private_key::regenerate( fc::sha256::hash( std::string("null_key") ) );
+}
+
+/**
+ * Starts the chain of @p genesis_state at the current block slot, with the init accounts as witnesses and
+ * committee members, all signing with @p witness_key
+ */
+inline void init_bench_genesis( genesis_state_type& genesis_state, const fc::ecc::private_key& witness_key )
+{
+   const uint32_t now = fc::time_point::now().sec_since_epoch();
+   genesis_state.initial_timestamp = fc::time_point_sec( now - now % GRAPHENE_DEFAULT_BLOCK_INTERVAL );
+   for( uint64_t i = 0; i < genesis_state.initial_active_witnesses; ++i )
+   {
+      auto name = "init"+fc::to_string(i);
+      genesis_state.initial_accounts.emplace_back( name, witness_key.get_public_key(),
+                                                   witness_key.get_public_key(), true );
+      genesis_state.initial_committee_candidates.push_back({name});
+      genesis_state.initial_witness_candidates.push_back({name, witness_key.get_public_key()});
+   }
+}
+
+} } } // graphene::chain::test
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/chain/proposal_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+namespace {
+
+   bool is_expiration_phase( block_phase phase )
+   {
+      return phase == block_phase::clear_expired_transactions || phase == block_phase::clear_expired_proposals
+          || phase == block_phase::clear_expired_orders || phase == block_phase::clear_expired_htlcs
+          || phase == block_phase::update_withdraw_permissions;
+   }
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( expiration_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t order_count = 1000000;
+      const uint32_t proposal_count = 200000;
+      const uint32_t blocks_to_produce = 2000;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t order_count = 50000;
+      const uint32_t proposal_count = 10000;
+      const uint32_t blocks_to_produce = 200;
+#endif
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      genesis_state_type::initial_asset_type bench_asset;
+      bench_asset.symbol = "BENCH";
+      bench_asset.issuer_name = "init0";
+      bench_asset.max_supply = GRAPHENE_MAX_SHARE_SUPPLY;
+      genesis_state.initial_assets.push_back( bench_asset );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      const account_object& seller = *db.get_index_type<account_index>().indices().get<by_name>().find( "init0" );
+      const asset_id_type quote_id = db.get_index_type<asset_index>().indices().get<by_symbol>().find( "BENCH" )->id;
+
+      // spread the expirations over 4 times the produced time span, so a quarter of the objects expire
+      const uint32_t block_interval = db.get_global_properties().parameters.block_interval;
+      const uint32_t span = 4 * blocks_to_produce * block_interval;
+      const time_point_sec first_expiration = db.head_block_time() + block_interval;
+
+      fc::time_point start_time = fc::time_point::now();
+      for( uint32_t i = 0; i < order_count; ++i )
+      {
+         db.create<limit_order_object>( [&]( limit_order_object& o ) {
+            o.seller = seller.id;
+            o.for_sale = 1;
+            o.sell_price = price( asset( 1 + i % 1000 ), asset( 1000, quote_id ) );
+            o.expiration = first_expiration + uint32_t( ( uint64_t(i) * 7919 ) % span );
+         });
+      }
+      db.modify( seller.statistics( db ), [order_count]( account_statistics_object& s ) {
+         s.total_core_in_orders += order_count;
+      });
+      const uint64_t orders_ms = ( fc::time_point::now() - start_time ).count() / 1000;
+
+      start_time = fc::time_point::now();
+      for( uint32_t i = 0; i < proposal_count; ++i )
+      {
+         db.create<proposal_object>( [&]( proposal_object& p ) {
+            p.proposer = seller.id;
+            p.expiration_time = first_expiration + uint32_t( ( uint64_t(i) * 104729 ) % span );
+            p.required_active_approvals.insert( seller.id );
+         });
+      }
+      const uint64_t proposals_ms = ( fc::time_point::now() - start_time ).count() / 1000;
+      ilog("Created ${o} limit orders in ${to} ms and ${p} proposals in ${tp} ms.",
+           ("o", order_count)("to", orders_ms)("p", proposal_count)("tp", proposals_ms));
+
+      const size_t orders_before = db.get_index_type<limit_order_index>().indices().size();
+      const size_t proposals_before = db.get_index_type<proposal_index>().indices().size();
+
+      db.get_block_phase_tracer().set_capacity( blocks_to_produce );
+      for( uint32_t i = 0; i < blocks_to_produce; ++i )
+         db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      uint32_t block_count = 0;
+      uint64_t block_ns = 0;
+      uint64_t expiration_ns = 0;
+      uint64_t max_expiration_ns = 0;
+      for( const auto& trace : db.get_block_phase_tracer().get_traces( blocks_to_produce ) )
+      {
+         if( trace.maintenance )
+            continue;
+         uint64_t ns = 0;
+         for( const auto& timing : trace.phases )
+            if( is_expiration_phase( timing.phase ) )
+               ns += timing.duration_ns;
+         ++block_count;
+         block_ns += trace.duration_ns;
+         expiration_ns += ns;
+         max_expiration_ns = std::max( max_expiration_ns, ns );
+      }
+
+      const size_t expired_orders = orders_before - db.get_index_type<limit_order_index>().indices().size();
+      const size_t expired_proposals = proposals_before - db.get_index_type<proposal_index>().indices().size();
+      BOOST_CHECK_GT( expired_orders, 0u );
+      BOOST_CHECK_GT( expired_proposals, 0u );
+      ilog("Produced ${b} blocks, ${eo} limit orders and ${ep} proposals expired.",
+           ("b", blocks_to_produce)("eo", expired_orders)("ep", expired_proposals));
+      BOOST_REQUIRE_GT( block_count, 0u );
+      ilog("Per block: ${t} us in total, ${e} us (max ${m} us) expiring objects.",
+           ("t", block_ns / block_count / 1000)("e", expiration_ns / block_count / 1000)
+           ("m", max_expiration_ns / 1000));
+
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_CASE( force_settlement_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t asset_count = 20;
+      const uint32_t positions_per_asset = 5000;
+      const uint32_t settles_per_asset = 5000;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t asset_count = 4;
+      const uint32_t positions_per_asset = 500;
+      const uint32_t settles_per_asset = 500;
+#endif
+      const uint32_t queued_blocks = 5;
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      // positions with 500% to 1000% collateral at a feed of 2 CORE per unit
+      for( uint32_t i = 0; i < asset_count; ++i )
+      {
+         genesis_state_type::initial_asset_type bitasset;
+         bitasset.symbol = "FSBIT" + fc::to_string( i );
+         bitasset.issuer_name = "init0";
+         bitasset.max_supply = GRAPHENE_MAX_SHARE_SUPPLY;
+         bitasset.is_bitasset = true;
+         for( uint32_t j = 0; j < positions_per_asset; ++j )
+         {
+            genesis_state_type::initial_asset_type::initial_collateral_position position;
+            position.owner = address( witness_priv_key.get_public_key() );
+            position.debt = 1000;
+            position.collateral = 10000 + ( j * 10000 ) / positions_per_asset;
+            bitasset.collateral_records.push_back( position );
+         }
+         // balances the debt in the genesis supply check, handed to the settling account below
+         bitasset.accumulated_fees = int64_t( positions_per_asset ) * 1000;
+         genesis_state.initial_assets.push_back( bitasset );
+      }
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      const account_id_type settler = db.get_index_type<account_index>().indices().get<by_name>().find( "init0" )->id;
+      vector<const asset_object*> bitassets;
+      const auto& assets_by_symbol = db.get_index_type<asset_index>().indices().get<by_symbol>();
+      for( uint32_t i = 0; i < asset_count; ++i )
+         bitassets.push_back( &*assets_by_symbol.find( "FSBIT" + fc::to_string( i ) ) );
+
+      price_feed feed;
+      feed.maintenance_collateral_ratio = GRAPHENE_DEFAULT_MAINTENANCE_COLLATERAL_RATIO;
+      feed.maximum_short_squeeze_ratio = GRAPHENE_DEFAULT_MAX_SHORT_SQUEEZE_RATIO;
+      for( const asset_object* a : bitassets )
+      {
+         feed.settlement_price = asset( 1, a->id ) / asset( 2 );
+         db.modify( a->bitasset_data( db ), [&]( asset_bitasset_data_object& b ) {
+            b.options.minimum_feeds = 1;
+            b.options.feed_lifetime_sec = 365 * 24 * 3600;
+            b.feeds[ settler ] = std::make_pair( db.head_block_time(), feed );
+            b.update_median_feeds( db.head_block_time(), db.get_dynamic_global_properties().next_maintenance_time );
+         });
+         // every settle order is half of a position, so that the settle orders of an asset take half of the supply
+         db.modify( a->dynamic_asset_data_id( db ), [&]( asset_dynamic_data_object& d ) {
+            d.accumulated_fees -= int64_t( settles_per_asset ) * 500;
+         });
+         db.adjust_balance( settler, asset( int64_t( settles_per_asset ) * 500, a->id ) );
+      }
+
+      // all settle orders are due in the next block, the default volume limit of 20% of the supply lets
+      // 2/5 of them settle in that block, the rest stays queued
+      const uint32_t block_interval = db.get_global_properties().parameters.block_interval;
+      for( const asset_object* a : bitassets )
+      {
+         for( uint32_t k = 0; k < settles_per_asset; ++k )
+         {
+            db.adjust_balance( settler, asset( -500, a->id ) );
+            db.create<force_settlement_object>( [&]( force_settlement_object& o ) {
+               o.owner = settler;
+               o.balance = asset( 500, a->id );
+               o.settlement_date = db.head_block_time() + block_interval;
+            });
+         }
+      }
+      const auto& settle_idx = db.get_index_type<force_settlement_index>().indices();
+      const size_t queued_before = settle_idx.size();
+
+      block_phase_tracer& tracer = db.get_block_phase_tracer();
+      tracer.set_capacity( queued_blocks + 1 );
+      for( uint32_t b = 0; b < 1 + queued_blocks; ++b )
+         db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      // the traces are newest first, the last one is the block in which the orders fell due
+      vector<uint64_t> clear_ns;
+      for( const block_phase_trace& trace : tracer.get_traces( queued_blocks + 1 ) )
+         for( const block_phase_timing& timing : trace.phases )
+            if( timing.phase == block_phase::clear_expired_orders )
+               clear_ns.push_back( timing.duration_ns );
+      BOOST_REQUIRE_EQUAL( clear_ns.size(), queued_blocks + 1 );
+      uint64_t queued_ns = 0;
+      for( uint32_t b = 0; b < queued_blocks; ++b )
+         queued_ns += clear_ns[b];
+
+      ilog("${s} settle orders in ${a} assets: ${n} settled in ${t} us, then ${q} us per block "
+           "with the rest queued and the volume limit reached.",
+           ("s", queued_before)("a", asset_count)("n", queued_before - settle_idx.size())
+           ("t", clear_ns.back() / 1000)("q", queued_ns / queued_blocks / 1000));
+
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -67,12 +67,15 @@ BOOST_AUTO_TEST_CASE( genesis_and_persistence_bench )
 
       {
          database db;
+         fc::time_point start_time = fc::time_point::now();
          db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+         ilog("Initialized genesis with ${n} accounts in ${t} milliseconds.",
+              ("n", account_count)("t", (fc::time_point::now() - start_time).count() / 1000));
 
          for( int i = 11; i < account_count + 11; ++i)
             BOOST_CHECK(db.get_balance(account_id_type(i), asset_id_type()).amount == GRAPHENE_MAX_SHARE_SUPPLY / account_count);
 
-         fc::time_point start_time = fc::time_point::now();
+         start_time = fc::time_point::now();
          db.close();
          ilog("Closed database in ${t} milliseconds.", ("t", (fc::time_point::now() - start_time).count() / 1000));
       }
@@ -81,7 +84,13 @@ BOOST_AUTO_TEST_CASE( genesis_and_persistence_bench )
 
          fc::time_point start_time = fc::time_point::now();
          db.open(data_dir.path(), [&]{return genesis_state;}, "test");
-         ilog("Opened database in ${t} milliseconds.", ("t", (fc::time_point::now() - start_time).count() / 1000));
+         ilog("Opened database from the saved object database in ${t} milliseconds.",
+              ("t", (fc::time_point::now() - start_time).count() / 1000));
+
+         // the secondary indexes built in bulk on both paths see every account
+         const auto& account_idx = dynamic_cast<const base_primary_index&>( db.get_index_type<account_index>() );
+         const auto& members = account_idx.get_secondary_index<account_member_index>();
+         BOOST_CHECK_GE( members.account_to_key_memberships.size(), size_t(account_count) );
 
          for( int i = 11; i < account_count + 11; ++i)
             BOOST_CHECK(db.get_balance(account_id_type(i), asset_id_type()).amount == GRAPHENE_MAX_SHARE_SUPPLY / account_count);
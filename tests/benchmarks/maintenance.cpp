@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/committee_member_object.hpp>
+#include <graphene/chain/witness_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <thread>
+
+using namespace graphene::chain;
+
+namespace {
+
+   /// Applies the next maintenance block, returns the duration of account maintenance in microseconds
+   uint64_t apply_maintenance_block( database& db, const fc::ecc::private_key& witness_key )
+   {
+      const uint32_t slot = db.get_slot_at_time( db.get_dynamic_global_properties().next_maintenance_time );
+      db.generate_block( db.get_slot_time( slot ), db.get_scheduled_witness( slot ), witness_key, ~0 );
+
+      const auto traces = db.get_block_phase_tracer().get_traces( 1 );
+      BOOST_REQUIRE_EQUAL( traces.size(), 1u );
+      BOOST_REQUIRE( traces.front().maintenance );
+      for( const auto& timing : traces.front().phases )
+         if( timing.phase == block_phase::maint_account_maintenance )
+            return timing.duration_ns / 1000;
+      BOOST_FAIL( "no account maintenance phase recorded" );
+      return 0;
+   }
+
+   vector<share_type> witness_votes( const database& db )
+   {
+      vector<share_type> result;
+      for( const witness_object& wit : db.get_index_type<witness_index>().indices() )
+         result.push_back( wit.total_votes );
+      return result;
+   }
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( vote_tally_maintenance_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const int account_count = 2000000;
+#else
+      ilog("Running in debug mode.");
+      const int account_count = 30000;
+#endif
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      for( int i = 0; i < account_count; ++i )
+         genesis_state.initial_accounts.emplace_back("target"+fc::to_string(i),
+                                                     public_key_type(fc::ecc::private_key::regenerate(fc::digest(i)).get_public_key()));
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      fc::time_point start_time = fc::time_point::now();
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      ilog("Opened database with ${n} accounts in ${t} milliseconds.",
+           ("n", account_count)("t", (fc::time_point::now() - start_time).count() / 1000));
+
+      // let every account vote for all witnesses and committee members with some stake
+      flat_set<vote_id_type> votes;
+      for( const witness_object& wit : db.get_index_type<witness_index>().indices() )
+         votes.insert( wit.vote_id );
+      for( const committee_member_object& cm : db.get_index_type<committee_member_index>().indices() )
+         votes.insert( cm.vote_id );
+
+      start_time = fc::time_point::now();
+      const auto& accounts = db.get_index_type<account_index>().indices().get<by_name>();
+      const auto first_voter = accounts.lower_bound( "target" );
+      const auto last_voter = accounts.upper_bound( "target~" );
+      uint32_t voter_count = 0;
+      for( auto itr = first_voter; itr != last_voter; ++itr, ++voter_count )
+      {
+         db.modify( *itr, [&votes,voter_count]( account_object& a ) {
+            a.options.votes = votes;
+            a.options.num_witness = voter_count % ( GRAPHENE_DEFAULT_MIN_WITNESS_COUNT + 1 );
+            a.options.num_committee = voter_count % ( GRAPHENE_DEFAULT_MIN_COMMITTEE_MEMBER_COUNT + 1 );
+         });
+         db.modify( itr->statistics( db ), []( account_statistics_object& s ) {
+            s.is_voting = true;
+         });
+         db.adjust_balance( itr->id, asset( 1000 + voter_count ) );
+      }
+      ilog("Set up ${n} voters in ${t} milliseconds.",
+           ("n", voter_count)("t", (fc::time_point::now() - start_time).count() / 1000));
+
+      db.get_block_phase_tracer().set_capacity( 1 );
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      // the first maintenance counts all votes and updates core_in_balance of all voters
+      apply_maintenance_block( db, witness_priv_key );
+      const vector<share_type> expected_votes = witness_votes( db );
+
+      db.set_vote_tally_threads( 1 );
+      db.recount_votes_at_next_maintenance();
+      const uint64_t serial_us = apply_maintenance_block( db, witness_priv_key );
+      BOOST_CHECK( witness_votes( db ) == expected_votes );
+      db.pop_block();
+
+      const uint32_t threads = std::max( 2u, std::thread::hardware_concurrency() );
+      db.set_vote_tally_threads( threads );
+      db.recount_votes_at_next_maintenance();
+      const uint64_t parallel_us = apply_maintenance_block( db, witness_priv_key );
+      BOOST_CHECK( witness_votes( db ) == expected_votes );
+      db.pop_block();
+
+      ilog("Full recount of ${n} voters: serial ${s} ms, parallel with ${p} threads ${t} ms.",
+           ("n", voter_count)("s", serial_us / 1000)("p", threads)("t", parallel_us / 1000));
+
+      // change the stake of 1% of the voters, the votes of the others are not visited again
+      const uint32_t changed_count = voter_count / 100;
+      uint32_t i = 0;
+      for( auto itr = first_voter; itr != last_voter && i < changed_count; ++itr, ++i )
+         db.adjust_balance( itr->id, asset( 1 ) );
+      const uint64_t incremental_us = apply_maintenance_block( db, witness_priv_key );
+      ilog("Incremental maintenance with ${c} of ${n} voters changed: ${t} ms.",
+           ("c", changed_count)("n", voter_count)("t", incremental_us / 1000));
+      db.pop_block();
+
+      db.enable_vote_tally_verification( true );
+      apply_maintenance_block( db, witness_priv_key );
+      ilog("Incremental vote totals verified against a full recount.");
+
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
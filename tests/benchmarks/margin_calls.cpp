@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_CASE( margin_call_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t asset_count = 10;
+      const uint32_t positions_per_asset = 5000;
+      const uint32_t publish_count = 20000;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t asset_count = 2;
+      const uint32_t positions_per_asset = 500;
+      const uint32_t publish_count = 2000;
+#endif
+      const uint32_t asks_per_asset = 100;
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      // positions with 500% to 1000% collateral at a feed of 2 CORE per unit
+      for( uint32_t i = 0; i < asset_count; ++i )
+      {
+         genesis_state_type::initial_asset_type bitasset;
+         bitasset.symbol = "MCBIT" + fc::to_string( i );
+         bitasset.issuer_name = "init0";
+         bitasset.max_supply = GRAPHENE_MAX_SHARE_SUPPLY;
+         bitasset.is_bitasset = true;
+         for( uint32_t j = 0; j < positions_per_asset; ++j )
+         {
+            genesis_state_type::initial_asset_type::initial_collateral_position position;
+            position.owner = address( witness_priv_key.get_public_key() );
+            position.debt = 1000;
+            position.collateral = 10000 + ( j * 10000 ) / positions_per_asset;
+            bitasset.collateral_records.push_back( position );
+         }
+         // balances the debt in the genesis supply check
+         bitasset.accumulated_fees = int64_t( positions_per_asset ) * 1000;
+         genesis_state.initial_assets.push_back( bitasset );
+      }
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      fc::time_point start_time = fc::time_point::now();
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      ilog("Opened database with ${n} positions in ${t} ms.",
+           ("n", asset_count * positions_per_asset)("t", (fc::time_point::now() - start_time).count() / 1000));
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      const account_object& producer = *db.get_index_type<account_index>().indices().get<by_name>().find( "init0" );
+      vector<const asset_object*> bitassets;
+      const auto& assets_by_symbol = db.get_index_type<asset_index>().indices().get<by_symbol>();
+      for( uint32_t i = 0; i < asset_count; ++i )
+         bitassets.push_back( &*assets_by_symbol.find( "MCBIT" + fc::to_string( i ) ) );
+
+      price_feed feed;
+      feed.maintenance_collateral_ratio = GRAPHENE_DEFAULT_MAINTENANCE_COLLATERAL_RATIO;
+      feed.maximum_short_squeeze_ratio = GRAPHENE_DEFAULT_MAX_SHORT_SQUEEZE_RATIO;
+      auto publish = [&]( const asset_object& a, share_type core_per_unit ) {
+         feed.settlement_price = asset( 1, a.id ) / asset( core_per_unit );
+         db.modify( a.bitasset_data( db ), [&]( asset_bitasset_data_object& b ) {
+            b.options.minimum_feeds = 1;
+            b.feeds[ producer.id ] = std::make_pair( db.head_block_time(), feed );
+            b.update_median_feeds( db.head_block_time(), db.get_dynamic_global_properties().next_maintenance_time );
+         });
+         return db.check_call_orders( a );
+      };
+
+      // asks above the max short squeeze price, so that margin calls reach the feed protection check
+      for( const asset_object* a : bitassets )
+      {
+         publish( *a, 2 );
+         for( uint32_t j = 0; j < asks_per_asset; ++j )
+         {
+            db.create<limit_order_object>( [&]( limit_order_object& o ) {
+               o.seller = producer.id;
+               o.expiration = time_point_sec::maximum();
+               o.for_sale = 10;
+               o.sell_price = asset( 10, a->id ) / asset( 1 + j % 5 );
+            });
+         }
+      }
+
+      // the median feed changes with every publication, every check walks the order books
+      bool called = false;
+      start_time = fc::time_point::now();
+      for( uint32_t i = 0; i < publish_count; ++i )
+         called |= publish( *bitassets[ i % asset_count ], 2 + i % 2 );
+      const uint64_t changing_us = ( fc::time_point::now() - start_time ).count();
+
+      // the median feed does not change, checks after the first one return at once
+      start_time = fc::time_point::now();
+      for( uint32_t i = 0; i < publish_count; ++i )
+         called |= publish( *bitassets[ i % asset_count ], 2 );
+      const uint64_t unchanged_us = ( fc::time_point::now() - start_time ).count();
+      BOOST_CHECK( !called );
+
+      ilog("${n} feed publications with ${p} positions per asset: ${c} us per changing feed, "
+           "${u} us per unchanged feed, ${q} assets without margin calls.",
+           ("n", publish_count)("p", positions_per_asset)("c", double( changing_us ) / publish_count)
+           ("u", double( unchanged_us ) / publish_count)("q", db.get_margin_call_frontier().quiet_count()));
+
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/limit_order_book.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_CASE( order_matching_bench )
+{
+   try {
+      genesis_state_type genesis_state;
+
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const uint32_t market_count = 500;
+      const uint32_t resting_order_count = 100000;
+      const uint32_t taker_count = 20000;
+#else
+      ilog("Running in debug mode.");
+      const uint32_t market_count = 50;
+      const uint32_t resting_order_count = 10000;
+      const uint32_t taker_count = 1000;
+#endif
+      const uint32_t levels_per_side = 200;
+      const uint32_t book_depth = 50;
+
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      for( uint32_t i = 0; i < market_count; ++i )
+      {
+         genesis_state_type::initial_asset_type market_asset;
+         market_asset.symbol = "MKT" + fc::to_string( i );
+         market_asset.issuer_name = "init0";
+         market_asset.max_supply = GRAPHENE_MAX_SHARE_SUPPLY;
+         genesis_state.initial_assets.push_back( market_asset );
+      }
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+
+      const account_object& trader = *db.get_index_type<account_index>().indices().get<by_name>().find( "init0" );
+      vector<asset_id_type> markets;
+      const auto& assets_by_symbol = db.get_index_type<asset_index>().indices().get<by_symbol>();
+      for( uint32_t i = 0; i < market_count; ++i )
+         markets.push_back( assets_by_symbol.find( "MKT" + fc::to_string( i ) )->id );
+
+      // asks at 1 to 3 CORE per unit and bids at 0.2 to 0.5 CORE per unit, so the book does not cross
+      fc::time_point start_time = fc::time_point::now();
+      for( uint32_t i = 0; i < resting_order_count; ++i )
+      {
+         const asset_id_type market = markets[ ( i / 2 ) % market_count ];
+         const uint32_t level = ( i / market_count / 2 ) % levels_per_side;
+         db.create<limit_order_object>( [&]( limit_order_object& o ) {
+            o.seller = trader.id;
+            o.expiration = time_point_sec::maximum();
+            o.for_sale = 1000;
+            if( i % 2 == 0 )
+               o.sell_price = price( asset( 1000, market ), asset( 1000 + level * 10 ) );
+            else
+               o.sell_price = price( asset( 1000 ), asset( 2000 + level * 15, market ) );
+         });
+      }
+      ilog("Created ${n} resting orders in ${m} markets in ${t} ms.",
+           ("n", resting_order_count)("m", market_count)("t", (fc::time_point::now() - start_time).count() / 1000));
+
+      // each taker buys the best two or three asks and is filled
+      const auto& order_idx = db.get_index_type<limit_order_index>().indices();
+      const size_t orders_before = order_idx.size();
+      uint32_t filled_takers = 0;
+      start_time = fc::time_point::now();
+      for( uint32_t i = 0; i < taker_count; ++i )
+      {
+         const asset_id_type market = markets[ i % market_count ];
+         const limit_order_object& taker = db.create<limit_order_object>( [&]( limit_order_object& o ) {
+            o.seller = trader.id;
+            o.expiration = time_point_sec::maximum();
+            o.for_sale = 2500;
+            o.sell_price = price( asset( 2500 ), asset( 1000, market ) );
+         });
+         if( db.apply_order( taker ) )
+            ++filled_takers;
+      }
+      const uint64_t matching_us = ( fc::time_point::now() - start_time ).count();
+      const size_t filled_makers = orders_before + taker_count - filled_takers - order_idx.size();
+      ilog("Matched ${n} takers, ${ft} filled, against ${f} resting orders in ${t} ms, ${p} us per taker.",
+           ("n", taker_count)("ft", filled_takers)("f", filled_makers)("t", matching_us / 1000)
+           ("p", double( matching_us ) / taker_count));
+
+      // order book queries, by price level and by walking the by_price index
+      const auto& book = db.get_limit_order_book();
+      uint64_t visited = 0;
+      start_time = fc::time_point::now();
+      for( const asset_id_type market : markets )
+      {
+         for( const auto& side : { std::make_pair( market, asset_id_type() ), std::make_pair( asset_id_type(), market ) } )
+         {
+            uint32_t count = 0;
+            book.visit_orders( side.first, side.second, [&count,&visited,book_depth]( const limit_order_object& ) -> bool {
+               ++visited;
+               return ++count < book_depth;
+            });
+         }
+      }
+      const uint64_t book_us = ( fc::time_point::now() - start_time ).count();
+
+      const auto& price_idx = order_idx.get<by_price>();
+      uint64_t walked = 0;
+      start_time = fc::time_point::now();
+      for( const asset_id_type market : markets )
+      {
+         for( const auto& side : { std::make_pair( market, asset_id_type() ), std::make_pair( asset_id_type(), market ) } )
+         {
+            auto itr = price_idx.lower_bound( price_index_key( price::max( side.first, side.second ) ) );
+            auto end = price_idx.upper_bound( price_index_key( price::min( side.first, side.second ) ) );
+            for( uint32_t count = 0; itr != end && count < book_depth; ++itr, ++count )
+               ++walked;
+         }
+      }
+      const uint64_t tree_us = ( fc::time_point::now() - start_time ).count();
+      BOOST_CHECK_EQUAL( visited, walked );
+      ilog("Top ${d} orders of both sides of ${m} markets: ${b} us by price level, ${t} us walking by_price.",
+           ("d", book_depth)("m", market_count)("b", book_us)("t", tree_us));
+
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
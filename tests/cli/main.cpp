@@ -33,9 +33,11 @@
 #include <graphene/wallet/wallet.hpp>
 
 #include <fc/thread/thread.hpp>
+#include <fc/network/http/connection.hpp>
 #include <fc/network/http/websocket.hpp>
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/rpc/cli.hpp>
+#include <fc/io/json.hpp>
 #include <fc/crypto/base58.hpp>
 
 #ifdef _WIN32
@@ -110,9 +112,11 @@ int get_available_port()
 /// @brief Start the application
 /// @param app_dir the temporary directory to use
 /// @param server_port_number to be filled with the rpc endpoint port number
+/// @param metrics_port_number if given, to be filled with the port number of the API metrics endpoint
 /// @returns the application object
 //////////
-std::shared_ptr<graphene::app::application> start_application(fc::temp_directory& app_dir, int& server_port_number) {
+std::shared_ptr<graphene::app::application> start_application(fc::temp_directory& app_dir, int& server_port_number,
+                                                              int* metrics_port_number = nullptr) {
    std::shared_ptr<graphene::app::application> app1(new graphene::app::application{});
 
    app1->register_plugin<graphene::account_history::account_history_plugin>(true);
@@ -131,6 +135,14 @@ std::shared_ptr<graphene::app::application> start_application(fc::temp_directory
    );
    cfg.emplace("genesis-json", boost::program_options::variable_value(create_genesis_file(app_dir), false));
    cfg.emplace("seed-nodes", boost::program_options::variable_value(string("[]"), false));
+   if( metrics_port_number != nullptr )
+   {
+      *metrics_port_number = get_available_port();
+      cfg.emplace(
+         "api-metrics-endpoint",
+         boost::program_options::variable_value(string("127.0.0.1:" + std::to_string(*metrics_port_number)), false)
+      );
+   }
    app1->initialize(app_dir.path(), cfg);
 
    app1->initialize_plugins(cfg);
@@ -321,6 +333,83 @@ BOOST_FIXTURE_TEST_CASE( cli_quit, cli_fixture )
    BOOST_CHECK_THROW( con.wallet_api_ptr->quit(), fc::canceled_exception );
 }
 
+////////////////
+// Send a JSON-RPC batch over a plain websocket, the responses come back in one frame
+////////////////
+BOOST_FIXTURE_TEST_CASE( api_batch_request, cli_fixture )
+{
+   try
+   {
+      fc::http::websocket_client client;
+      auto connection = client.connect( "ws://127.0.0.1:" + std::to_string( server_port_number ) );
+      fc::promise<std::string>::ptr reply( new fc::promise<std::string>( "batch reply" ) );
+      connection->on_message_handler( [reply]( const std::string& msg ) {
+         if( !reply->ready() )
+            reply->set_value( msg );
+      });
+
+      // the notification without an id gets no response
+      connection->send_message( "["
+         "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"call\",\"params\":[0,\"get_objects\",[[\"2.0.0\"]]]},"
+         "{\"jsonrpc\":\"2.0\",\"method\":\"call\",\"params\":[0,\"get_chain_id\",[]]},"
+         "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"call\",\"params\":[0,\"get_accounts\",[[\"nathan\"]]]},"
+         "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"call\",\"params\":[0,\"no_such_method\",[]]}"
+         "]" );
+      const std::string result = fc::future<std::string>( reply ).wait( fc::seconds( 10 ) );
+      const fc::variants responses = fc::json::from_string( result ).get_array();
+      BOOST_REQUIRE_EQUAL( responses.size(), 3u );
+      BOOST_CHECK_EQUAL( responses[0]["id"].as_uint64(), 1u );
+      BOOST_CHECK( responses[0].get_object().contains( "result" ) );
+      BOOST_CHECK_EQUAL( responses[1]["id"].as_uint64(), 2u );
+      BOOST_CHECK_EQUAL( responses[1]["result"].get_array().size(), 1u );
+      BOOST_CHECK_EQUAL( responses[2]["id"].as_uint64(), 3u );
+      BOOST_CHECK( responses[2].get_object().contains( "error" ) );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+////////////////
+// Malformed elements of a batch are answered with JSON-RPC errors, the valid ones still execute
+////////////////
+BOOST_FIXTURE_TEST_CASE( api_batch_malformed_request, cli_fixture )
+{
+   try
+   {
+      fc::http::websocket_client client;
+      auto connection = client.connect( "ws://127.0.0.1:" + std::to_string( server_port_number ) );
+      fc::promise<std::string>::ptr reply( new fc::promise<std::string>( "batch reply" ) );
+      connection->on_message_handler( [reply]( const std::string& msg ) {
+         if( !reply->ready() )
+            reply->set_value( msg );
+      });
+
+      connection->send_message( "["
+         "{\"jsonrpc\":\"2.0\",\"id\":1,\"params\":[0,\"get_chain_id\",[]]},"
+         "{\"jsonrpc\":\"2.0\",\"id\":\"two\",\"method\":\"call\",\"params\":[0,\"get_chain_id\",[]]},"
+         "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"call\",\"params\":\"not an array\"},"
+         "{\"jsonrpc\":\"2.0\",\"id\":4,\"method\":\"call\",\"params\":[0,\"get_chain_id\",[]]}"
+         "]" );
+      const std::string result = fc::future<std::string>( reply ).wait( fc::seconds( 10 ) );
+      const fc::variants responses = fc::json::from_string( result ).get_array();
+      BOOST_REQUIRE_EQUAL( responses.size(), 4u );
+      for( size_t i = 0; i < 3; ++i )
+      {
+         BOOST_REQUIRE( responses[i].is_object() );
+         BOOST_CHECK_EQUAL( responses[i]["error"]["code"].as_int64(), -32600 );
+      }
+      BOOST_CHECK( responses[0]["id"].is_null() );
+      BOOST_CHECK( responses[1]["id"].is_null() );
+      BOOST_CHECK_EQUAL( responses[2]["id"].as_uint64(), 3u );
+      BOOST_CHECK_EQUAL( responses[3]["id"].as_uint64(), 4u );
+      BOOST_CHECK( responses[3].get_object().contains( "result" ) );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_FIXTURE_TEST_CASE( upgrade_nathan_account, cli_fixture )
 {
    try
@@ -766,3 +855,64 @@ BOOST_AUTO_TEST_CASE( cli_create_htlc )
    }
    app1->shutdown();
 }
+
+////////////////
+// Scrape the API metrics endpoint after a few calls, as Prometheus does
+////////////////
+BOOST_AUTO_TEST_CASE( api_metrics_endpoint )
+{
+   std::shared_ptr<graphene::app::application> app1;
+   try {
+      fc::temp_directory app_dir( graphene::utilities::temp_directory_path() );
+
+      int server_port_number = 0;
+      int metrics_port_number = 0;
+      app1 = start_application(app_dir, server_port_number, &metrics_port_number);
+      BOOST_REQUIRE( app1->get_api_metrics() );
+
+      fc::http::websocket_client client;
+      auto connection = client.connect( "ws://127.0.0.1:" + std::to_string( server_port_number ) );
+      std::vector<std::string> replies;
+      fc::promise<void>::ptr done( new fc::promise<void>( "metrics replies" ) );
+      connection->on_message_handler( [&replies,done]( const std::string& msg ) {
+         replies.push_back( msg );
+         if( replies.size() == 4 )
+            done->set_value();
+      });
+      // the history API is named after the login API method which returned its id
+      connection->send_message( "{\"id\":1,\"method\":\"call\",\"params\":[0,\"get_objects\",[[\"2.0.0\"]]]}" );
+      connection->send_message( "{\"id\":2,\"method\":\"call\",\"params\":[0,\"no_such_method\",[]]}" );
+      connection->send_message( "{\"id\":3,\"method\":\"call\",\"params\":[1,\"history\",[]]}" );
+      connection->send_message( "{\"id\":4,\"method\":\"call\",\"params\":[2,\"get_account_history\","
+                                "[\"nathan\",\"1.11.0\",10,\"1.11.0\"]]}" );
+      fc::future<void>( done ).wait( fc::seconds( 10 ) );
+
+      fc::http::connection scraper;
+      scraper.connect_to( fc::ip::endpoint::from_string( "127.0.0.1:" + std::to_string( metrics_port_number ) ) );
+      const fc::http::reply reply = scraper.request( "GET",
+                                                     "http://127.0.0.1:" + std::to_string( metrics_port_number )
+                                                     + "/metrics" );
+      BOOST_REQUIRE_EQUAL( reply.status, fc::http::reply::OK );
+      const std::string body( reply.body.begin(), reply.body.end() );
+      BOOST_TEST_MESSAGE( body );
+      BOOST_CHECK( body.find( "graphene_api_calls_total{api=\"database\",method=\"get_objects\"} 1\n" )
+                   != std::string::npos );
+      BOOST_CHECK( body.find( "graphene_api_errors_total{api=\"database\",method=\"get_objects\"} 0\n" )
+                   != std::string::npos );
+      BOOST_CHECK( body.find( "graphene_api_errors_total{api=\"database\",method=\"no_such_method\"} 1\n" )
+                   != std::string::npos );
+      BOOST_CHECK( body.find( "graphene_api_calls_total{api=\"history\",method=\"get_account_history\"} 1\n" )
+                   != std::string::npos );
+      BOOST_CHECK( body.find( "graphene_api_latency_seconds_bucket{api=\"database\",method=\"get_objects\","
+                              "le=\"+Inf\"} 1\n" ) != std::string::npos );
+      BOOST_CHECK( body.find( "graphene_head_block_number " ) != std::string::npos );
+      BOOST_CHECK( body.find( "graphene_pending_transactions 0\n" ) != std::string::npos );
+
+      const auto metrics = app1->get_api_metrics()->get_metrics();
+      BOOST_CHECK_EQUAL( metrics.size(), 4u );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+   app1->shutdown();
+}
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+
+# Compares the throughput of the calls an explorer makes to render a page,
+# sent one round trip at a time versus as a single JSON-RPC 2.0 batch.
+# Start the node with api-threads > 0 to let the calls of a batch execute
+# concurrently.
+
+import json
+import os
+import sys
+import time
+
+try:
+    import asyncio
+except ImportError:
+    print("asyncio module not found (try pip install asyncio, or upgrade to Python 3.4 or later)")
+    sys.exit(1)
+
+try:
+    import websockets
+except ImportError:
+    print("websockets module not found (try pip install websockets)")
+    sys.exit(1)
+
+URL = 'ws://localhost:8090/'
+CLIENTS = 50
+PAGES_PER_CLIENT = 100
+
+def page_calls():
+    calls = [
+        ["get_objects", [["2.0.0", "2.1.0", "1.3.0"]]],
+        ["get_account_balances", ["1.2.0", []]],
+        ["get_ticker", ["BTS", "CNY"]],
+    ]
+    for n in range(1, 21):
+        calls.append(["get_block_header", [n]])
+    for n in range(0, 10):
+        calls.append(["get_objects", [["1.2." + str(n)]]])
+    return [{"jsonrpc":"2.0", "id":i, "method":"call", "params":[0] + call} for i, call in enumerate(calls)]
+
+@asyncio.coroutine
+def single_calls(ws, requests):
+    for request in requests:
+        yield from ws.send(json.dumps(request))
+        yield from ws.recv()
+
+@asyncio.coroutine
+def batch_call(ws, requests):
+    yield from ws.send(json.dumps(requests))
+    responses = json.loads((yield from ws.recv()))
+    assert len(responses) == len(requests)
+
+@asyncio.coroutine
+def client(load_page):
+    ws = yield from websockets.connect(URL)
+    requests = page_calls()
+    for i in range(PAGES_PER_CLIENT):
+        yield from load_page(ws, requests)
+    yield from ws.close()
+
+def run(name, load_page):
+    started = time.time()
+    loop = asyncio.get_event_loop()
+    loop.run_until_complete(asyncio.gather(*[client(load_page) for i in range(CLIENTS)]))
+    elapsed = time.time() - started
+    calls = CLIENTS * PAGES_PER_CLIENT * len(page_calls())
+    print("%-12s %8.1f pages/s %10.1f calls/s" % (name, CLIENTS * PAGES_PER_CLIENT / elapsed, calls / elapsed))
+
+run("single", single_calls)
+run("batch", batch_call)
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+
+# Pulls a range of blocks from a local node the way an indexer does, once with
+# block_api.get_blocks and once with block_api.stream_blocks, and reports the
+# blocks per second of both. The block API has to be enabled for the default
+# user in the api-access file.
+#
+# Usage: block_stream_pull.py [first block] [last block] [window]
+
+import base64
+import json
+import sys
+import time
+
+try:
+    import asyncio
+except ImportError:
+    print("asyncio module not found (try pip install asyncio, or upgrade to Python 3.4 or later)")
+    sys.exit(1)
+
+try:
+    import websockets
+except ImportError:
+    print("websockets module not found (try pip install websockets)")
+    sys.exit(1)
+
+URL = 'ws://localhost:8090/'
+FIRST = int(sys.argv[1]) if len(sys.argv) > 1 else 1
+LAST = int(sys.argv[2]) if len(sys.argv) > 2 else 100000
+WINDOW = int(sys.argv[3]) if len(sys.argv) > 3 else 8
+BLOCKS_PER_CALL = 100
+CALLBACK_ID = 1
+
+next_id = 0
+
+@asyncio.coroutine
+def call(ws, api, method, params):
+    global next_id
+    next_id += 1
+    yield from ws.send(json.dumps({"id":next_id, "method":"call", "params":[api, method, params]}))
+    while True:
+        response = json.loads((yield from ws.recv()))
+        if response.get("id") == next_id:
+            if "error" in response:
+                raise RuntimeError(response["error"])
+            return response["result"]
+
+@asyncio.coroutine
+def block_api(ws):
+    yield from call(ws, 1, "login", ["", ""])
+    return (yield from call(ws, 1, "block", []))
+
+@asyncio.coroutine
+def pull_with_get_blocks(ws, api):
+    count = 0
+    for first in range(FIRST, LAST + 1, BLOCKS_PER_CALL):
+        blocks = yield from call(ws, api, "get_blocks", [first, min(first + BLOCKS_PER_CALL - 1, LAST)])
+        count += sum(1 for b in blocks if b is not None)
+    return count
+
+@asyncio.coroutine
+def pull_with_stream(ws, api):
+    global next_id
+    stream_id = yield from call(ws, api, "stream_blocks", [CALLBACK_ID, FIRST, LAST, WINDOW])
+    count = 0
+    byte_count = 0
+    while True:
+        message = json.loads((yield from ws.recv()))
+        if message.get("method") != "notice" or message["params"][0] != CALLBACK_ID:
+            continue
+        chunk = message["params"][1][0]
+        count += chunk["block_count"]
+        byte_count += len(base64.b64decode(chunk["blocks"]))
+        if chunk["last"]:
+            return count, byte_count
+        # acknowledged without waiting for the response, to keep the window full
+        next_id += 1
+        yield from ws.send(json.dumps({"id":next_id, "method":"call",
+                                       "params":[api, "acknowledge_block_chunk", [stream_id, chunk["sequence"]]]}))
+
+@asyncio.coroutine
+def main():
+    ws = yield from websockets.connect(URL, max_size=None)
+    api = yield from block_api(ws)
+
+    started = time.time()
+    count = yield from pull_with_get_blocks(ws, api)
+    elapsed = time.time() - started
+    print("get_blocks:    %8d blocks %10.1f blocks/s" % (count, count / elapsed))
+
+    started = time.time()
+    count, byte_count = yield from pull_with_stream(ws, api)
+    elapsed = time.time() - started
+    print("stream_blocks: %8d blocks %10.1f blocks/s, %d packed bytes" % (count, count / elapsed, byte_count))
+
+    yield from ws.close()
+
+asyncio.get_event_loop().run_until_complete(main())
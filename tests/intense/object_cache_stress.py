@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+
+# Hammers get_objects with the objects that most clients ask for, then prints
+# the hit rate of the serialized object cache (requires the metrics API to be
+# accessible, see api-access).
+
+import json
+import os
+import signal
+import sys
+import time
+
+try:
+    import asyncio
+except ImportError:
+    print("asyncio module not found (try pip install asyncio, or upgrade to Python 3.4 or later)")
+    sys.exit(1)
+
+try:
+    import websockets
+except ImportError:
+    print("websockets module not found (try pip install websockets)")
+    sys.exit(1)
+
+URL = 'ws://localhost:8090/'
+CLIENTS = 200
+DURATION = 60
+POPULAR_IDS = ["2.0.0", "2.1.0", "1.3.0", "1.2.0", "1.2.1", "1.2.2", "1.2.3"]
+
+@asyncio.coroutine
+def client():
+    ws = yield from websockets.connect(URL)
+    call_id = 1
+    started = time.time()
+    while True:
+        get = {"id":call_id, "method":"call", "params":[0, "get_objects", [POPULAR_IDS]]}
+        call_id += 1
+        yield from ws.send(json.dumps(get))
+        result = yield from ws.recv()
+        if result is None:
+            break
+        if call_id % 1000 == 0:
+            print("pid %d: %.1f calls/s" % (os.getpid(), call_id / (time.time() - started)))
+
+@asyncio.coroutine
+def print_cache_stats():
+    ws = yield from websockets.connect(URL)
+    yield from ws.send(json.dumps({"id":1, "method":"call", "params":[1, "login", ["", ""]]}))
+    yield from ws.recv()
+    yield from ws.send(json.dumps({"id":2, "method":"call", "params":[1, "metrics", []]}))
+    api_id = json.loads((yield from ws.recv()))["result"]
+    yield from ws.send(json.dumps({"id":3, "method":"call", "params":[api_id, "get_object_cache_stats", []]}))
+    stats = json.loads((yield from ws.recv()))["result"]
+    lookups = stats["hits"] + stats["misses"]
+    print(json.dumps(stats))
+    if lookups > 0:
+        print("hit rate: %.2f%%" % (100.0 * stats["hits"] / lookups))
+    yield from ws.close()
+
+child_procs = []
+
+while len(child_procs) < CLIENTS:
+    pid = os.fork()
+    if pid == 0:
+        asyncio.get_event_loop().run_until_complete(client())
+        sys.exit(0)
+    else:
+        child_procs.append(pid)
+
+time.sleep(DURATION)
+for pid in child_procs:
+    os.kill(pid, signal.SIGTERM)
+
+time.sleep(2)
+for pid in child_procs:
+    os.kill(pid, signal.SIGKILL)
+
+asyncio.get_event_loop().run_until_complete(print_cache_stats())
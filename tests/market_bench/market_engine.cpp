@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2019 BitShares Blockchain Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/execution_profiler.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include "../benchmarks/common/bench_genesis.hpp"
+
+#include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
+#include <fc/string.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace graphene { namespace chain { namespace market_bench {
+
+   /// Sizes of the synthetic markets, set with --name=value after the -- separator of the test runner
+   struct bench_config
+   {
+      uint32_t    markets         = 4;     ///< market issued assets, all backed by CORE
+      uint32_t    limit_orders    = 20000; ///< per market, half asks and half bids
+      uint32_t    call_orders     = 5000;  ///< per market
+      uint32_t    settle_orders   = 2000;  ///< per market
+      uint32_t    collateral_bids = 2000;  ///< on the market which is globally settled at the end
+      uint32_t    samples         = 2000;  ///< calls of apply_order, a tenth as many of the heavier functions
+      uint32_t    expiry_blocks   = 10;    ///< blocks over which the settle orders and expiring limit orders fall due
+      std::string results;                 ///< file to write the JSON results to, standard output if empty
+   };
+
+   /// Latency distribution of one measured function, all durations in nanoseconds
+   struct bench_entry
+   {
+      std::string name;
+      uint64_t    count      = 0;
+      uint64_t    total_ns   = 0;
+      uint64_t    avg_ns     = 0;
+      uint64_t    p50_ns     = 0;
+      uint64_t    p99_ns     = 0;
+      uint64_t    max_ns     = 0;
+      double      per_second = 0;
+   };
+
+   struct bench_report
+   {
+      bench_config               config;
+      std::vector< bench_entry > entries;
+   };
+
+} } } // graphene::chain::market_bench
+
+FC_REFLECT( graphene::chain::market_bench::bench_config,
+            (markets)(limit_orders)(call_orders)(settle_orders)(collateral_bids)(samples)(expiry_blocks)(results) )
+FC_REFLECT( graphene::chain::market_bench::bench_entry,
+            (name)(count)(total_ns)(avg_ns)(p50_ns)(p99_ns)(max_ns)(per_second) )
+FC_REFLECT( graphene::chain::market_bench::bench_report, (config)(entries) )
+
+using namespace graphene::chain;
+using namespace graphene::chain::market_bench;
+
+namespace {
+
+   bench_config parse_config()
+   {
+      bench_config config;
+      const int argc = boost::unit_test::framework::master_test_suite().argc;
+      char** argv = boost::unit_test::framework::master_test_suite().argv;
+      for( int i = 1; i < argc; ++i )
+      {
+         const std::string arg = argv[i];
+         const size_t eq = arg.find( '=' );
+         FC_ASSERT( arg.compare( 0, 2, "--" ) == 0 && eq != std::string::npos, "Invalid argument ${a}", ("a", arg) );
+         const std::string name = arg.substr( 2, eq - 2 );
+         const std::string value = arg.substr( eq + 1 );
+         if( name == "results" )
+         {
+            config.results = value;
+            continue;
+         }
+         const uint32_t number = fc::to_uint64( value );
+         if( name == "markets" )              config.markets = number;
+         else if( name == "limit-orders" )    config.limit_orders = number;
+         else if( name == "call-orders" )     config.call_orders = number;
+         else if( name == "settle-orders" )   config.settle_orders = number;
+         else if( name == "collateral-bids" ) config.collateral_bids = number;
+         else if( name == "samples" )         config.samples = number;
+         else if( name == "expiry-blocks" )  config.expiry_blocks = number;
+         else
+            FC_THROW( "Unknown option ${o}", ("o", name) );
+      }
+      FC_ASSERT( config.markets > 0 && config.call_orders > 0 && config.expiry_blocks > 0 );
+      return config;
+   }
+
+   bench_entry summarize( const std::string& name, const execution_stats& stats )
+   {
+      bench_entry entry;
+      entry.name     = name;
+      entry.count    = stats.count;
+      entry.total_ns = stats.total_ns;
+      entry.max_ns   = stats.max_ns;
+      if( stats.count > 0 )
+      {
+         entry.avg_ns = stats.total_ns / stats.count;
+         entry.p50_ns = std::min( stats.histogram.percentile( 0.50, stats.count ), stats.max_ns );
+         entry.p99_ns = std::min( stats.histogram.percentile( 0.99, stats.count ), stats.max_ns );
+      }
+      if( stats.total_ns > 0 )
+         entry.per_second = double( stats.count ) * 1e9 / stats.total_ns;
+      return entry;
+   }
+
+   /// Records the durations of @p phase in the traces of the blocks after @p after_block
+   void record_phase( const block_phase_tracer& tracer, uint32_t after_block, block_phase phase,
+                      execution_stats& stats )
+   {
+      for( const block_phase_trace& trace : tracer.get_traces( uint32_t( tracer.get_capacity() ) ) )
+      {
+         if( trace.block_num <= after_block )
+            continue;
+         for( const block_phase_timing& timing : trace.phases )
+            if( timing.phase == phase )
+               stats.record( timing.duration_ns );
+      }
+   }
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( market_engine_bench )
+{
+   try {
+      const bench_config config = parse_config();
+      const uint32_t asks_per_market = config.limit_orders / 2;
+      const uint32_t bids_per_market = config.limit_orders - asks_per_market;
+      // every position owes 1000 units, asks and settle orders are of 10 units
+      FC_ASSERT( uint64_t( asks_per_market + config.settle_orders ) * 10 <= uint64_t( config.call_orders ) * 1000,
+                 "Not enough supply for the asks and settle orders, add call orders" );
+
+      genesis_state_type genesis_state;
+      const auto witness_priv_key = test::bench_witness_key();
+      test::init_bench_genesis( genesis_state, witness_priv_key );
+      // positions with 10000 to 20000 CORE of collateral for a debt of 1000 units, i.e. 500% to 1000%
+      // at a feed of 2 CORE per unit; the supply is parked in the accumulated fees to balance the debt
+      for( uint32_t i = 0; i < config.markets; ++i )
+      {
+         genesis_state_type::initial_asset_type bitasset;
+         bitasset.symbol = "MKTBIT" + fc::to_string( i );
+         bitasset.issuer_name = "init0";
+         bitasset.max_supply = GRAPHENE_MAX_SHARE_SUPPLY;
+         bitasset.is_bitasset = true;
+         for( uint32_t j = 0; j < config.call_orders; ++j )
+         {
+            genesis_state_type::initial_asset_type::initial_collateral_position position;
+            position.owner = address( witness_priv_key.get_public_key() );
+            position.debt = 1000;
+            position.collateral = 10000 + ( uint64_t( j ) * 10000 ) / config.call_orders;
+            bitasset.collateral_records.push_back( position );
+         }
+         bitasset.accumulated_fees = int64_t( config.call_orders ) * 1000;
+         genesis_state.initial_assets.push_back( bitasset );
+      }
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      database db;
+      fc::time_point start_time = fc::time_point::now();
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+      ilog("Opened database with ${n} positions in ${t} ms.",
+           ("n", config.markets * config.call_orders)("t", (fc::time_point::now() - start_time).count() / 1000));
+
+      const auto& accounts_by_name = db.get_index_type<account_index>().indices().get<by_name>();
+      const account_id_type trader = accounts_by_name.find( "init0" )->id;
+      vector<const asset_object*> markets;
+      const auto& assets_by_symbol = db.get_index_type<asset_index>().indices().get<by_symbol>();
+      for( uint32_t i = 0; i < config.markets; ++i )
+         markets.push_back( &*assets_by_symbol.find( "MKTBIT" + fc::to_string( i ) ) );
+      const uint32_t block_interval = db.get_global_properties().parameters.block_interval;
+
+      // hands out assets to the trader, keeping the supplies consistent
+      auto fund = [&]( const asset& amount ) {
+         const asset_dynamic_data_object& dyn = amount.asset_id( db ).dynamic_asset_data_id( db );
+         db.modify( dyn, [&]( asset_dynamic_data_object& d ) {
+            if( amount.asset_id == asset_id_type() )
+               d.current_supply += amount.amount;
+            else
+               d.accumulated_fees -= amount.amount;
+         });
+         db.adjust_balance( trader, amount );
+      };
+
+      // sets the only feed of an asset, which does not expire during the benchmark
+      price_feed feed;
+      feed.maintenance_collateral_ratio = GRAPHENE_DEFAULT_MAINTENANCE_COLLATERAL_RATIO;
+      feed.maximum_short_squeeze_ratio = GRAPHENE_DEFAULT_MAX_SHORT_SQUEEZE_RATIO;
+      auto publish = [&]( const asset_object& a, share_type core_per_unit ) {
+         feed.settlement_price = asset( 1, a.id ) / asset( core_per_unit );
+         db.modify( a.bitasset_data( db ), [&]( asset_bitasset_data_object& b ) {
+            b.options.minimum_feeds = 1;
+            b.options.feed_lifetime_sec = 365 * 24 * 3600;
+            b.feeds[ trader ] = std::make_pair( db.head_block_time(), feed );
+            b.update_median_feeds( db.head_block_time(), db.get_dynamic_global_properties().next_maintenance_time );
+         });
+      };
+
+      // asks at 2.2 to 3.9 CORE per unit, bids at 1.0 to 1.9 CORE per unit, every fourth bid expires
+      // during the expiration blocks below
+      start_time = fc::time_point::now();
+      for( const asset_object* mia : markets )
+      {
+         publish( *mia, 2 );
+         fund( asset( int64_t( asks_per_market ) * 10, mia->id ) );
+         fund( asset( int64_t( bids_per_market ) * 20 ) );
+         for( uint32_t k = 0; k < asks_per_market; ++k )
+         {
+            db.adjust_balance( trader, asset( -10, mia->id ) );
+            db.create<limit_order_object>( [&]( limit_order_object& o ) {
+               o.seller = trader;
+               o.expiration = time_point_sec::maximum();
+               o.for_sale = 10;
+               o.sell_price = asset( 10, mia->id ) / asset( 22 + k % 18 );
+            });
+         }
+         for( uint32_t k = 0; k < bids_per_market; ++k )
+         {
+            const share_type core = 10 + k % 10;
+            db.adjust_balance( trader, asset( -core ) );
+            db.create<limit_order_object>( [&]( limit_order_object& o ) {
+               o.seller = trader;
+               o.expiration = k % 4 == 0 ? db.head_block_time() + block_interval * ( 1 + k % config.expiry_blocks )
+                                         : time_point_sec::maximum();
+               o.for_sale = core;
+               o.sell_price = asset( core ) / asset( 10, mia->id );
+            });
+         }
+      }
+      ilog("Created ${n} limit orders in ${m} markets in ${t} ms.",
+           ("n", config.markets * config.limit_orders)("m", config.markets)
+           ("t", (fc::time_point::now() - start_time).count() / 1000));
+
+      bench_report report;
+      report.config = config;
+      const uint32_t heavy_samples = std::max< uint32_t >( 1, config.samples / 10 );
+
+      // takers crossing 1 to 10 price levels on either side, undone after each call so that the books do not change
+      execution_stats apply_stats;
+      for( uint32_t s = 0; s < config.samples; ++s )
+      {
+         const asset_object& mia = *markets[ s % markets.size() ];
+         const int64_t depth = 1 + ( s / markets.size() ) % 10;
+         auto session = db._undo_db.start_undo_session();
+         const limit_order_object& taker = db.create<limit_order_object>( [&]( limit_order_object& o ) {
+            o.seller = trader;
+            o.expiration = time_point_sec::maximum();
+            if( s % 2 == 0 )
+            {
+               o.for_sale = 40 * depth;
+               o.sell_price = asset( 40 * depth ) / asset( 10 * depth, mia.id );
+            }
+            else
+            {
+               o.for_sale = 10 * depth;
+               o.sell_price = asset( 10 * depth, mia.id ) / asset( 10 * depth );
+            }
+         });
+         execution_profiler::scoped_timer timer( &apply_stats );
+         db.apply_order( taker );
+      }
+      report.entries.push_back( summarize( "apply_order", apply_stats ) );
+
+      // feeds of 6 to 9 CORE per unit margin call 5% to 57% of the positions, which buy the asks
+      execution_stats call_stats;
+      for( uint32_t s = 0; s < heavy_samples; ++s )
+      {
+         const asset_object& mia = *markets[ s % markets.size() ];
+         auto session = db._undo_db.start_undo_session();
+         publish( mia, 6 + ( s / markets.size() ) % 4 );
+         execution_profiler::scoped_timer timer( &call_stats );
+         db.check_call_orders( mia );
+      }
+      report.entries.push_back( summarize( "check_call_orders", call_stats ) );
+
+      execution_stats global_settle_stats;
+      for( uint32_t s = 0; s < heavy_samples; ++s )
+      {
+         const asset_object& mia = *markets[ s % markets.size() ];
+         auto session = db._undo_db.start_undo_session();
+         execution_profiler::scoped_timer timer( &global_settle_stats );
+         db.globally_settle_asset( mia, asset( 1, mia.id ) / asset( 2 ) );
+      }
+      report.entries.push_back( summarize( "globally_settle_asset", global_settle_stats ) );
+
+      // settle orders fall due over the next blocks, together with every fourth bid
+      for( const asset_object* mia : markets )
+      {
+         fund( asset( int64_t( config.settle_orders ) * 10, mia->id ) );
+         for( uint32_t k = 0; k < config.settle_orders; ++k )
+         {
+            db.adjust_balance( trader, asset( -10, mia->id ) );
+            db.create<force_settlement_object>( [&]( force_settlement_object& o ) {
+               o.owner = trader;
+               o.balance = asset( 10, mia->id );
+               o.settlement_date = db.head_block_time() + block_interval * ( 1 + k % config.expiry_blocks );
+            });
+         }
+      }
+      block_phase_tracer& tracer = db.get_block_phase_tracer();
+      tracer.set_capacity( config.expiry_blocks + 1 );
+      uint32_t first_block = db.head_block_num();
+      for( uint32_t b = 0; b < config.expiry_blocks; ++b )
+         db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_priv_key, ~0 );
+      execution_stats expired_stats;
+      record_phase( tracer, first_block, block_phase::clear_expired_orders, expired_stats );
+      report.entries.push_back( summarize( "clear_expired_orders", expired_stats ) );
+
+      // collateral bids of the former borrowers of a globally settled asset, processed at the next maintenance
+      const asset_object& settled = *markets.front();
+      vector<account_id_type> bidders;
+      const auto& calls_by_account = db.get_index_type<call_order_index>().indices().get<by_account>();
+      for( const call_order_object& call : calls_by_account )
+         if( call.debt_type() == settled.id && bidders.size() < config.collateral_bids )
+            bidders.push_back( call.borrower );
+      db.globally_settle_asset( settled, asset( 1, settled.id ) / asset( 2 ) );
+      for( uint32_t k = 0; k < bidders.size(); ++k )
+      {
+         const asset collateral( 2000 + k % 1000 );
+         db.adjust_balance( bidders[k], -collateral );
+         db.create<collateral_bid_object>( [&]( collateral_bid_object& b ) {
+            b.bidder = bidders[k];
+            b.inv_swan_price = collateral / asset( 1000, settled.id );
+         });
+      }
+      const uint32_t maint_slot = db.get_slot_at_time( db.get_dynamic_global_properties().next_maintenance_time );
+      first_block = db.head_block_num();
+      db.generate_block( db.get_slot_time( maint_slot ), db.get_scheduled_witness( maint_slot ), witness_priv_key, ~0 );
+      execution_stats bids_stats;
+      record_phase( tracer, first_block, block_phase::maint_bitassets, bids_stats );
+      report.entries.push_back( summarize( "process_bids", bids_stats ) );
+
+      const std::string json = fc::json::to_pretty_string( report );
+      if( config.results.empty() )
+         std::cout << json << std::endl;
+      else
+      {
+         std::ofstream out( config.results );
+         out << json << std::endl;
+         BOOST_CHECK( out.good() );
+      }
+
+      db.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
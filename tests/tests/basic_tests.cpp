@@ -607,4 +607,68 @@ BOOST_AUTO_TEST_CASE( bitasset_feed_expiration_test )
    BOOST_CHECK( !o.feed_is_expired( now ) );
 }
 
+BOOST_AUTO_TEST_CASE( account_balance_list_test )
+{
+   std::vector<account_balance_object> balances( 6 );
+   for( size_t i = 0; i < 5; ++i )
+      balances[i].asset_type = asset_id_type( i + 1 );
+   balances[5].asset_type = asset_id_type( 3 ); // replaces balances[2]
+
+   account_balance_list list;
+   // the entries are stored in place unless they spilled over into a heap vector
+   const auto is_inline = [&list]() {
+      const char* first = reinterpret_cast<const char*>( list.begin() );
+      const char* self = reinterpret_cast<const char*>( &list );
+      return first >= self && first < self + sizeof( list );
+   };
+   const auto check_order = [&list]( const std::vector<const account_balance_object*>& expected ) {
+      BOOST_REQUIRE_EQUAL( list.size(), expected.size() );
+      BOOST_CHECK( std::equal( list.begin(), list.end(), expected.begin() ) );
+      for( const auto* b : expected )
+         BOOST_CHECK( list.find( b->asset_type ) == b );
+   };
+
+   BOOST_CHECK( list.empty() );
+   BOOST_CHECK( list.find( asset_id_type( 1 ) ) == nullptr );
+
+   BOOST_TEST_MESSAGE( "Filling the inline storage" );
+   list.insert( &balances[2] );
+   list.insert( &balances[0] );
+   BOOST_REQUIRE_EQUAL( list.size(), account_balance_list::inline_capacity );
+   BOOST_CHECK( is_inline() );
+   check_order( { &balances[0], &balances[2] } );
+
+   BOOST_TEST_MESSAGE( "Spilling past the inline capacity" );
+   list.insert( &balances[3] );
+   BOOST_CHECK( !is_inline() );
+   check_order( { &balances[0], &balances[2], &balances[3] } );
+   list.insert( &balances[1] );
+   list.insert( &balances[4] );
+   check_order( { &balances[0], &balances[1], &balances[2], &balances[3], &balances[4] } );
+
+   BOOST_TEST_MESSAGE( "Replacing an existing asset in place" );
+   list.insert( &balances[5] );
+   check_order( { &balances[0], &balances[1], &balances[5], &balances[3], &balances[4] } );
+
+   BOOST_TEST_MESSAGE( "Erasing back down to inline storage" );
+   list.erase( asset_id_type( 9 ) ); // not in the list
+   list.erase( asset_id_type( 1 ) );
+   list.erase( asset_id_type( 5 ) );
+   BOOST_CHECK( !is_inline() );
+   check_order( { &balances[1], &balances[5], &balances[3] } );
+   list.erase( asset_id_type( 4 ) );
+   BOOST_CHECK( is_inline() );
+   check_order( { &balances[1], &balances[5] } );
+   BOOST_CHECK( list.find( asset_id_type( 4 ) ) == nullptr );
+
+   BOOST_TEST_MESSAGE( "Replacing and erasing in the inline storage" );
+   list.insert( &balances[2] );
+   check_order( { &balances[1], &balances[2] } );
+   list.erase( asset_id_type( 2 ) );
+   check_order( { &balances[2] } );
+   list.erase( asset_id_type( 3 ) );
+   BOOST_CHECK( list.empty() );
+   BOOST_CHECK( list.begin() == list.end() );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 
+#include <random>
 #include <vector>
 #include <boost/test/unit_test.hpp>
 
@@ -1408,4 +1409,136 @@ BOOST_AUTO_TEST_CASE(hf_890_test_hf1270)
 
 } FC_LOG_AND_RETHROW() }
 
+namespace {
+
+   /// The median calculation of asset_bitasset_data_object::update_median_feeds before the median feed tracker
+   price_feed sorted_median_feed( const asset_bitasset_data_object& o, time_point_sec current_time,
+                                  time_point_sec& publication_time, size_t& feed_count )
+   {
+      publication_time = current_time;
+      vector<std::reference_wrapper<const price_feed>> current_feeds;
+      for( const auto& f : o.feeds )
+      {
+         if( (current_time - f.second.first).to_seconds() < o.options.feed_lifetime_sec &&
+             f.second.first != time_point_sec() )
+         {
+            current_feeds.emplace_back( f.second.second );
+            publication_time = std::min( publication_time, f.second.first );
+         }
+      }
+      feed_count = current_feeds.size();
+      if( current_feeds.size() < o.options.minimum_feeds )
+         return price_feed();
+      price_feed median_feed;
+      const auto median_itr = current_feeds.begin() + current_feeds.size() / 2;
+#define CALCULATE_MEDIAN_VALUE(r, data, field_name) \
+      std::nth_element( current_feeds.begin(), median_itr, current_feeds.end(), \
+                        [](const price_feed& a, const price_feed& b) { \
+         return a.field_name < b.field_name; \
+      }); \
+      median_feed.field_name = median_itr->get().field_name;
+      BOOST_PP_SEQ_FOR_EACH( CALCULATE_MEDIAN_VALUE, ~, GRAPHENE_PRICE_FEED_FIELDS )
+#undef CALCULATE_MEDIAN_VALUE
+      return median_feed;
+   }
+
+   /// Equal amounts and assets, unlike operator== which only compares the ratio
+   bool same_price( const price& a, const price& b )
+   {
+      return a.base.asset_id == b.base.asset_id && a.base.amount == b.base.amount
+          && a.quote.asset_id == b.quote.asset_id && a.quote.amount == b.quote.amount;
+   }
+
+}
+
+/*********
+ * @brief the median read from the feed tracker equals the median found by selection, with feeds published,
+ *        replaced, removed and expiring, equivalent prices of different representation, and trackers which
+ *        were copied by the undo database or emptied by reloading the object
+ */
+BOOST_AUTO_TEST_CASE( median_feed_tracker_matches_selection )
+{ try {
+   std::mt19937 rng( 1270 );
+   auto pick = [&rng]( uint32_t n ) { return uint32_t( rng() % n ); };
+
+   const asset_id_type bit_id( 1 );
+   const asset_id_type backing_id( 2 );
+   auto random_price = [&]( asset_id_type quote_id ) {
+      // small amounts make equivalent prices such as 1/2 and 2/4 frequent
+      if( pick( 10 ) == 0 )
+         return price();
+      return asset( 1 + pick( 4 ), bit_id ) / asset( 1 + pick( 8 ), quote_id );
+   };
+
+   asset_bitasset_data_object obj;
+   obj.asset_id = bit_id;
+   obj.options.short_backing_asset = backing_id;
+   obj.options.feed_lifetime_sec = 600;
+   const time_point_sec next_maint = HARDFORK_CORE_1270_TIME + 1;
+   time_point_sec now = HARDFORK_CORE_1270_TIME - 86400;
+
+   size_t fallbacks = 0;
+   for( uint32_t step = 0; step < 20000; ++step )
+   {
+      const account_id_type producer( pick( 40 ) );
+      switch( pick( 10 ) )
+      {
+         case 0:
+            obj.feeds.erase( producer );
+            break;
+         case 1:
+            now += 1 + pick( 300 );
+            break;
+         case 2:
+            obj.options.feed_lifetime_sec = 60 + pick( 1200 );
+            obj.options.minimum_feeds = 1 + pick( 3 );
+            break;
+         case 3:
+         {
+            // the undo database keeps copies, loading from disk starts with an empty tracker
+            asset_bitasset_data_object copy = obj;
+            if( pick( 2 ) == 0 )
+               copy.median_feeds = median_feed_tracker();
+            obj = copy;
+            break;
+         }
+         case 4:
+            // a producer added by asset_update_feed_producers has no feed yet
+            obj.feeds[producer];
+            break;
+         default:
+         {
+            price_feed feed;
+            feed.settlement_price = random_price( backing_id );
+            feed.core_exchange_rate = random_price( asset_id_type() );
+            feed.maintenance_collateral_ratio = 1001 + pick( 4 ) * 250;
+            feed.maximum_short_squeeze_ratio = 1001 + pick( 4 ) * 100;
+            // republished with an older time, as if replayed after a time change
+            obj.feeds[producer] = std::make_pair( now - pick( 700 ), feed );
+         }
+      }
+
+      time_point_sec expected_time;
+      size_t live_count = 0;
+      const price_feed expected = sorted_median_feed( obj, now, expected_time, live_count );
+      obj.update_median_feeds( now, next_maint );
+      if( live_count > 1 && !obj.median_feeds.median().valid() )
+         ++fallbacks;
+
+      BOOST_REQUIRE_EQUAL( obj.median_feeds.size(), live_count );
+      if( live_count >= obj.options.minimum_feeds )
+         BOOST_REQUIRE( obj.current_feed_publication_time == expected_time );
+      else
+         BOOST_REQUIRE( obj.current_feed_publication_time == now );
+      BOOST_REQUIRE( same_price( obj.current_feed.settlement_price, expected.settlement_price ) );
+      BOOST_REQUIRE( same_price( obj.current_feed.core_exchange_rate, expected.core_exchange_rate ) );
+      BOOST_REQUIRE_EQUAL( obj.current_feed.maintenance_collateral_ratio, expected.maintenance_collateral_ratio );
+      BOOST_REQUIRE_EQUAL( obj.current_feed.maximum_short_squeeze_ratio, expected.maximum_short_squeeze_ratio );
+   }
+   // both the ranked path and the fallback were exercised
+   BOOST_CHECK_GT( fallbacks, 0u );
+   BOOST_CHECK_LT( fallbacks, 20000u );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
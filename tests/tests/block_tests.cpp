@@ -42,6 +42,9 @@
 
 #include "../common/database_fixture.hpp"
 
+#include <atomic>
+#include <thread>
+
 using namespace graphene::chain;
 using namespace graphene::chain::test;
 
@@ -129,6 +132,53 @@ BOOST_AUTO_TEST_CASE( block_database_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( block_database_concurrent_read_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      const uint32_t block_count = 20;
+      vector<block_id_type> ids;
+      clearable_block b;
+      for( uint32_t i = 0; i < block_count; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+      }
+
+      // API threads read blocks at the same time, each read moves the shared stream positions
+      std::atomic<uint32_t> failures( 0 );
+      vector<std::thread> readers;
+      for( uint32_t t = 0; t < 4; ++t )
+         readers.emplace_back( [&bdb,&ids,&failures,t]() {
+            for( uint32_t round = 0; round < 200; ++round )
+            {
+               const uint32_t num = ( round * 7 + t ) % block_count + 1;
+               auto by_number = bdb.fetch_by_number( num );
+               auto by_id = bdb.fetch_optional( ids[num - 1] );
+               auto packed = bdb.fetch_packed_by_number( num );
+               if( !by_number.valid() || by_number->id() != ids[num - 1]
+                     || !by_id.valid() || by_id->id() != ids[num - 1]
+                     || !packed.valid() || fc::raw::unpack<signed_block>( *packed ).id() != ids[num - 1] )
+                  ++failures;
+            }
+         });
+      for( auto& reader : readers )
+         reader.join();
+      BOOST_CHECK_EQUAL( failures.load(), 0u );
+
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( generate_empty_blocks )
 {
    try {
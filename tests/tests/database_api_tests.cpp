@@ -24,7 +24,14 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/api.hpp>
+#include <graphene/app/api_executor.hpp>
+#include <graphene/app/api_throttle.hpp>
 #include <graphene/app/database_api.hpp>
+#include <graphene/app/order_book_feed.hpp>
+#include <graphene/app/packed_encoding.hpp>
+#include <graphene/app/serialized_object_cache.hpp>
+#include <graphene/app/subscription_registry.hpp>
 #include <graphene/chain/hardfork.hpp>
 
 #include <fc/crypto/digest.hpp>
@@ -815,6 +822,557 @@ BOOST_AUTO_TEST_CASE( set_subscribe_callback_disable_notify_all_test )
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( subscription_registry_test )
+{
+   try {
+      ACTORS( (alice)(bob) );
+      generate_block();
+
+      uint32_t alice_updates = 0;
+      uint32_t bob_updates = 0;
+      uint32_t idle_updates = 0;
+
+      auto registry = graphene::app::subscription_registry::get( db );
+      {
+         graphene::app::database_api alice_api( db );
+         graphene::app::database_api bob_api( db );
+         graphene::app::database_api idle_api( db );
+         BOOST_CHECK( graphene::app::subscription_registry::get( db ) == registry );
+         BOOST_CHECK_EQUAL( registry->subscriber_count(), 0u );
+
+         alice_api.set_subscribe_callback( [&]( const variant& ) { ++alice_updates; }, false );
+         bob_api.set_subscribe_callback( [&]( const variant& ) { ++bob_updates; }, false );
+         idle_api.set_subscribe_callback( [&]( const variant& ) { ++idle_updates; }, false );
+         BOOST_CHECK_EQUAL( registry->subscriber_count(), 3u );
+
+         vector<object_id_type> ids;
+         ids.push_back( alice_id );
+         alice_api.get_objects( ids );
+         BOOST_CHECK( !db.impacted_accounts_requested() );
+         bob_api.get_full_accounts( { "bob" }, true );
+         BOOST_CHECK( db.impacted_accounts_requested() );
+
+         // only the changes impacting bob reach his session, nothing reaches the idle one
+         transfer( account_id_type(), bob_id, asset(1) );
+         generate_block();
+         fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
+         BOOST_CHECK_GT( bob_updates, 0u );
+         BOOST_CHECK_EQUAL( alice_updates, 0u );
+         BOOST_CHECK_EQUAL( idle_updates, 0u );
+
+         bob_api.cancel_all_subscriptions();
+         BOOST_CHECK( !db.impacted_accounts_requested() );
+         BOOST_CHECK_EQUAL( registry->subscriber_count(), 2u );
+
+         const uint32_t bob_updates_before = bob_updates;
+         transfer( account_id_type(), bob_id, asset(1) );
+         generate_block();
+         fc::usleep(fc::milliseconds(200));
+         BOOST_CHECK_EQUAL( bob_updates, bob_updates_before );
+         BOOST_CHECK_EQUAL( idle_updates, 0u );
+      }
+      // destroyed sessions remove themselves
+      BOOST_CHECK_EQUAL( registry->subscriber_count(), 0u );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( subscription_registry_limit_test )
+{
+   try {
+      struct idle_subscriber : graphene::app::subscription_registry::subscriber
+      {
+         virtual void on_object_updates( const std::vector<variant>& ) override {}
+         virtual void on_market_updates( const graphene::app::market_queue_type& ) override {}
+      };
+      const size_t max_objects = 3;
+
+      auto registry = graphene::app::subscription_registry::get( db );
+      BOOST_CHECK_EQUAL( registry->get_max_objects_per_subscriber(),
+                         graphene::app::subscription_registry::default_max_objects_per_subscriber );
+      registry->set_max_objects_per_subscriber( max_objects );
+      auto session = std::make_shared<idle_subscriber>();
+      registry->subscribe_to_objects( session, false );
+      for( size_t i = 0; i < max_objects; ++i )
+         registry->subscribe_to_object( session.get(), object_id_type( 1, 2, i ) );
+
+      // the limit is reached, further objects are not subscribed to but the subscribing call does not fail
+      registry->subscribe_to_object( session.get(), object_id_type( 1, 2, max_objects - 1 ) );
+      registry->subscribe_to_object( session.get(), object_id_type( 1, 2, max_objects ) );
+      {
+         // the genesis accounts exist, so reading them subscribes to them
+         graphene::app::database_api db_api( db );
+         db_api.set_subscribe_callback( []( const variant& ) {}, false );
+         vector<object_id_type> ids;
+         for( size_t i = 0; i <= max_objects; ++i )
+            ids.push_back( object_id_type( 1, 2, i ) );
+         fc::variants accounts;
+         BOOST_CHECK_NO_THROW( accounts = db_api.get_objects( ids ) );
+         BOOST_REQUIRE_EQUAL( accounts.size(), max_objects + 1 );
+         BOOST_CHECK( !accounts[max_objects].is_null() );
+      }
+
+      // registering again starts over
+      registry->subscribe_to_objects( session, false );
+      registry->subscribe_to_object( session.get(), object_id_type( 1, 2, max_objects ) );
+
+      registry->remove( session.get() );
+      BOOST_CHECK_EQUAL( registry->subscriber_count(), 0u );
+      registry->set_max_objects_per_subscriber(
+            graphene::app::subscription_registry::default_max_objects_per_subscriber );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( serialized_object_cache_test )
+{
+   try {
+      ACTORS( (alice) );
+      generate_block();
+
+      graphene::app::database_api db_api( db );
+      auto cache = graphene::app::serialized_object_cache::get( db );
+      BOOST_CHECK( graphene::app::serialized_object_cache::get( db ) == cache );
+      cache->reset_stats();
+
+      vector<object_id_type> ids;
+      ids.push_back( alice_id );
+      ids.push_back( asset_id_type() );
+      fc::variants first = db_api.get_objects( ids );
+      fc::variants second = db_api.get_objects( ids );
+      graphene::app::object_cache_stats stats = cache->get_stats();
+      BOOST_CHECK_EQUAL( stats.misses, 2u );
+      BOOST_CHECK_EQUAL( stats.hits, 2u );
+      BOOST_CHECK_EQUAL( stats.size, 2u );
+      BOOST_CHECK_EQUAL( fc::json::to_string( first ), fc::json::to_string( second ) );
+
+      // a modification, in a block or in a pending transaction, drops the cached variant
+      db.modify( alice_id( db ), []( account_object& a ) { a.name = "alice-renamed"; } );
+      BOOST_CHECK_EQUAL( cache->get_stats().invalidations, 1u );
+      fc::variants renamed = db_api.get_objects( ids );
+      BOOST_CHECK_EQUAL( renamed[0]["name"].as_string(), "alice-renamed" );
+      BOOST_CHECK_EQUAL( cache->get_stats().misses, 3u );
+
+      // an undo is a modification too
+      {
+         auto session = db._undo_db.start_undo_session();
+         db.modify( alice_id( db ), []( account_object& a ) { a.name = "alice-undone"; } );
+         BOOST_CHECK_EQUAL( db_api.get_objects( ids )[0]["name"].as_string(), "alice-undone" );
+      }
+      BOOST_CHECK_EQUAL( db_api.get_objects( ids )[0]["name"].as_string(), "alice-renamed" );
+
+      // the least recently used object is evicted first, the core asset was used after alice
+      cache->set_capacity( 2 );
+      db_api.get_objects( { alice_id } );
+      stats = cache->get_stats();
+      db_api.get_objects( { account_id_type() } );
+      BOOST_CHECK_EQUAL( cache->get_stats().evictions, stats.evictions + 1 );
+      db_api.get_objects( { alice_id } );
+      BOOST_CHECK_EQUAL( cache->get_stats().hits, stats.hits + 1 );
+      db_api.get_objects( { asset_id_type() } );
+      BOOST_CHECK_EQUAL( cache->get_stats().misses, stats.misses + 2 );
+
+      cache->set_capacity( 1 );
+      stats = cache->get_stats();
+      BOOST_CHECK_EQUAL( stats.size, 1u );
+      BOOST_CHECK_GE( stats.evictions, 1u );
+      db_api.get_objects( { asset_id_type() } );
+      BOOST_CHECK_EQUAL( cache->get_stats().hits, stats.hits + 1 );
+
+      cache->set_capacity( 0 );
+      const uint64_t hits_before = cache->get_stats().hits;
+      db_api.get_objects( ids );
+      db_api.get_objects( ids );
+      BOOST_CHECK_EQUAL( cache->get_stats().hits, hits_before );
+      BOOST_CHECK_EQUAL( cache->get_stats().size, 0u );
+      cache->set_capacity( graphene::app::serialized_object_cache::default_capacity );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( order_book_feed_test )
+{
+   try {
+      ACTORS( (seller) );
+      const auto& bitcny = create_bitasset( "CNY" );
+      const auto& core = asset_id_type()( db );
+      transfer( committee_account, seller_id, asset( 10000000 ) );
+      generate_block();
+
+      vector<graphene::app::order_book_delta> deltas;
+      auto feed = graphene::app::order_book_feed::get( db );
+      graphene::app::database_api db_api( db );
+      db_api.subscribe_to_order_book_deltas( [&]( const variant& v ) {
+         deltas.push_back( v.as<graphene::app::order_book_delta>( GRAPHENE_MAX_NESTED_OBJECTS ) );
+      }, GRAPHENE_SYMBOL, "CNY" );
+      BOOST_CHECK_EQUAL( feed->market_count(), 1u );
+
+      graphene::app::order_book_snapshot snapshot = db_api.get_order_book_snapshot( "CNY", GRAPHENE_SYMBOL );
+      BOOST_CHECK( snapshot.base == core.id );
+      BOOST_CHECK( snapshot.quote == bitcny.id );
+      BOOST_CHECK_EQUAL( snapshot.sequence, 0u );
+      BOOST_CHECK( snapshot.levels.empty() );
+
+      // two orders at the same price make up a single level
+      create_sell_order( seller, core.amount(100), bitcny.amount(250) );
+      create_sell_order( seller, core.amount(200), bitcny.amount(500) );
+      create_sell_order( seller, core.amount(100), bitcny.amount(300) );
+      generate_block();
+      fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
+      BOOST_REQUIRE_EQUAL( deltas.size(), 1u );
+      BOOST_CHECK_EQUAL( deltas[0].sequence, 1u );
+      BOOST_CHECK_EQUAL( deltas[0].block_num, db.head_block_num() );
+      BOOST_REQUIRE_EQUAL( deltas[0].levels.size(), 2u );
+
+      snapshot = db_api.get_order_book_snapshot( GRAPHENE_SYMBOL, "CNY" );
+      BOOST_CHECK_EQUAL( snapshot.sequence, 1u );
+      BOOST_REQUIRE_EQUAL( snapshot.levels.size(), 2u );
+      // ascending price, i.e. the higher amount of CNY asked for comes first
+      BOOST_CHECK( snapshot.levels[0].level_price == core.amount(100) / bitcny.amount(300) );
+      BOOST_CHECK_EQUAL( snapshot.levels[0].for_sale.value, 100 );
+      BOOST_CHECK( snapshot.levels[1].level_price == core.amount(100) / bitcny.amount(250) );
+      BOOST_CHECK_EQUAL( snapshot.levels[1].for_sale.value, 300 );
+
+      // cancelling an order updates the total of its level, removing the last one of a level sends 0
+      const auto& orders = db.get_index_type<limit_order_index>().indices().get<by_id>();
+      vector<limit_order_id_type> order_ids;
+      for( const limit_order_object& order : orders )
+         order_ids.push_back( order.id );
+      BOOST_REQUIRE_EQUAL( order_ids.size(), 3u );
+      cancel_limit_order( order_ids[0]( db ) );
+      cancel_limit_order( order_ids[2]( db ) );
+      generate_block();
+      fc::usleep(fc::milliseconds(200));
+      BOOST_REQUIRE_EQUAL( deltas.size(), 2u );
+      BOOST_CHECK_EQUAL( deltas[1].sequence, 2u );
+      BOOST_REQUIRE_EQUAL( deltas[1].levels.size(), 2u );
+      BOOST_CHECK( deltas[1].levels[0].level_price == core.amount(100) / bitcny.amount(300) );
+      BOOST_CHECK_EQUAL( deltas[1].levels[0].for_sale.value, 0 );
+      BOOST_CHECK_EQUAL( deltas[1].levels[1].for_sale.value, 200 );
+
+      snapshot = db_api.get_order_book_snapshot( GRAPHENE_SYMBOL, "CNY" );
+      BOOST_CHECK_EQUAL( snapshot.sequence, 2u );
+      BOOST_REQUIRE_EQUAL( snapshot.levels.size(), 1u );
+      BOOST_CHECK_EQUAL( snapshot.levels[0].for_sale.value, 200 );
+
+      // blocks which do not touch the market send nothing
+      transfer( committee_account, seller_id, asset( 1 ) );
+      generate_block();
+      fc::usleep(fc::milliseconds(200));
+      BOOST_CHECK_EQUAL( deltas.size(), 2u );
+
+      db_api.unsubscribe_from_order_book_deltas( GRAPHENE_SYMBOL, "CNY" );
+      BOOST_CHECK_EQUAL( feed->market_count(), 0u );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( api_executor_test )
+{
+   try {
+      ACTORS( (alice) );
+      generate_block();
+
+      // nested writes and reads of the writing thread do not block
+      graphene::chain::chain_access_lock& lock = db.get_chain_access_lock();
+      {
+         graphene::chain::chain_access_lock::write_guard outer( lock );
+         graphene::chain::chain_access_lock::write_guard inner( lock );
+         graphene::chain::chain_access_lock::read_guard read( lock );
+         BOOST_CHECK( lock.is_writing() );
+      }
+      BOOST_CHECK( !lock.is_writing() );
+
+      // readers on other threads wait for the writer
+      std::atomic<bool> read_done{ false };
+      std::thread reader;
+      {
+         graphene::chain::chain_access_lock::write_guard write( lock );
+         reader = std::thread( [&lock,&read_done]() {
+            graphene::chain::chain_access_lock::read_guard read( lock );
+            read_done = true;
+         });
+         std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+         BOOST_CHECK( !read_done );
+      }
+      reader.join();
+      BOOST_CHECK( read_done );
+
+      auto executor = graphene::app::api_executor::get( db );
+      graphene::app::database_api db_api( db );
+      vector<object_id_type> ids;
+      ids.push_back( alice_id );
+      const string inline_result = fc::json::to_string( db_api.get_objects( ids ) );
+
+      executor->reset_profile();
+      executor->set_thread_count( 2 );
+      BOOST_CHECK_EQUAL( executor->get_thread_count(), 2u );
+      BOOST_CHECK_EQUAL( fc::json::to_string( db_api.get_objects( ids ) ), inline_result );
+      BOOST_CHECK_EQUAL( db_api.get_accounts( { "alice" } ).size(), 1u );
+      GRAPHENE_CHECK_THROW( db_api.get_order_book( "NOSUCHASSET", GRAPHENE_SYMBOL, 10 ), fc::exception );
+
+      // blocks can be applied while the pool serves calls
+      generate_block();
+      BOOST_CHECK_EQUAL( db_api.get_dynamic_global_properties().head_block_number, db.head_block_num() );
+
+      vector<graphene::app::api_method_profile> profile = executor->get_profile();
+      std::map<string, uint64_t> counts;
+      for( const auto& method : profile )
+         counts[ method.method ] = method.execution.count;
+      BOOST_CHECK_EQUAL( counts["get_objects"], 1u );
+      BOOST_CHECK_EQUAL( counts["get_accounts"], 1u );
+      BOOST_CHECK_EQUAL( counts["get_order_book"], 1u );
+      BOOST_CHECK_EQUAL( counts["get_dynamic_global_properties"], 1u );
+
+      executor->set_thread_count( 0 );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( packed_encoding_test )
+{
+   try {
+      ACTORS( (alice) );
+      const auto& bitcny = create_bitasset( "CNY" );
+      const auto& core = asset_id_type()( db );
+      transfer( committee_account, alice_id, asset( 1000000 ) );
+      generate_blocks( 5 );
+
+      // blocks, including one which does not exist yet
+      graphene::app::block_api block_api( db );
+      const uint32_t head = db.head_block_num();
+      const vector<optional<signed_block>> blocks = block_api.get_blocks( 1, head + 1 );
+      const fc::variant packed_blocks( block_api.get_blocks_packed( 1, head + 1 ), 1 );
+      BOOST_CHECK( packed_blocks.is_string() );
+      const auto unpacked_blocks = graphene::app::unpack_result< vector<optional<signed_block>> >( packed_blocks );
+      BOOST_REQUIRE_EQUAL( unpacked_blocks.size(), blocks.size() );
+      for( size_t i = 0; i < blocks.size(); ++i )
+      {
+         BOOST_REQUIRE_EQUAL( unpacked_blocks[i].valid(), blocks[i].valid() );
+         if( blocks[i].valid() )
+            BOOST_CHECK( unpacked_blocks[i]->id() == blocks[i]->id() );
+      }
+      BOOST_CHECK( !unpacked_blocks.back().valid() );
+
+      // orders
+      graphene::app::database_api db_api( db );
+      create_sell_order( alice, core.amount(100), bitcny.amount(300) );
+      create_sell_order( alice, core.amount(100), bitcny.amount(200) );
+      const vector<limit_order_object> orders = db_api.get_limit_orders( GRAPHENE_SYMBOL, "CNY", 10 );
+      const auto unpacked_orders = graphene::app::unpack_result< vector<limit_order_object> >(
+                                      fc::variant( db_api.get_limit_orders_packed( GRAPHENE_SYMBOL, "CNY", 10 ), 1 ) );
+      BOOST_REQUIRE_EQUAL( orders.size(), 2u );
+      BOOST_REQUIRE_EQUAL( unpacked_orders.size(), orders.size() );
+      for( size_t i = 0; i < orders.size(); ++i )
+      {
+         BOOST_CHECK( unpacked_orders[i].id == orders[i].id );
+         BOOST_CHECK( unpacked_orders[i].sell_price == orders[i].sell_price );
+      }
+
+      // notifications
+      vector<variant> updates;
+      db_api.set_notification_encoding( graphene::app::api_encoding::packed );
+      db_api.set_subscribe_callback( [&]( const variant& v ) {
+         for( const variant& update : v.get_array() )
+            updates.push_back( update );
+      }, false );
+      const account_statistics_id_type stats_id = alice_id( db ).statistics;
+      vector<object_id_type> ids;
+      ids.push_back( stats_id );
+      db_api.get_objects( ids );
+      transfer( committee_account, alice_id, asset( 1 ) );
+      generate_block();
+      fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
+      BOOST_REQUIRE_EQUAL( updates.size(), 1u );
+      const auto packed = updates[0].as< graphene::app::packed_data >( 1 );
+      BOOST_CHECK( graphene::app::packed_object_id( packed ) == stats_id );
+      const auto stats = graphene::app::unpack_data< account_statistics_object >( packed );
+      BOOST_CHECK( stats.owner == alice_id );
+      BOOST_CHECK_EQUAL( stats.total_ops, stats_id( db ).total_ops );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( block_stream_test )
+{
+   try {
+      generate_blocks( 2 * graphene::app::block_api::max_chunk_blocks + 10 );
+      const uint32_t head = db.head_block_num();
+
+      auto block_api = std::make_shared<graphene::app::block_api>( db );
+      vector<graphene::app::block_chunk> chunks;
+      auto callback = [&]( const variant& v ) {
+         chunks.push_back( v.as<graphene::app::block_chunk>( GRAPHENE_MAX_NESTED_OBJECTS ) );
+      };
+
+      // a window of one chunk waits for every acknowledgement, the stream ends at the head block
+      const uint32_t stream_id = block_api->stream_blocks( callback, 1, head + 100, 1 );
+      fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
+      BOOST_REQUIRE_EQUAL( chunks.size(), 1u );
+      block_api->acknowledge_block_chunk( stream_id, 1 );
+      fc::usleep(fc::milliseconds(200));
+      BOOST_REQUIRE_EQUAL( chunks.size(), 2u );
+      GRAPHENE_CHECK_THROW( block_api->acknowledge_block_chunk( stream_id, 3 ), fc::exception );
+      block_api->acknowledge_block_chunk( stream_id, 2 );
+      fc::usleep(fc::milliseconds(200));
+      BOOST_REQUIRE_EQUAL( chunks.size(), 3u );
+
+      uint32_t next_block_num = 1;
+      for( size_t i = 0; i < chunks.size(); ++i )
+      {
+         BOOST_CHECK_EQUAL( chunks[i].stream_id, stream_id );
+         BOOST_CHECK_EQUAL( chunks[i].sequence, i + 1 );
+         BOOST_CHECK_EQUAL( chunks[i].first_block_num, next_block_num );
+         BOOST_CHECK_EQUAL( chunks[i].last, i == 2 );
+         BOOST_CHECK( !chunks[i].error.valid() );
+         const auto blocks = graphene::app::unpack_data< vector<signed_block> >( chunks[i].blocks );
+         BOOST_REQUIRE_EQUAL( blocks.size(), chunks[i].block_count );
+         for( const signed_block& block : blocks )
+         {
+            BOOST_CHECK_EQUAL( block.block_num(), next_block_num );
+            BOOST_CHECK( block.id() == db.get_block_id_for_num( next_block_num ) );
+            ++next_block_num;
+         }
+      }
+      BOOST_CHECK_EQUAL( next_block_num, head + 1 );
+      // acknowledging a finished stream does nothing
+      block_api->acknowledge_block_chunk( stream_id, 3 );
+
+      // a cancelled stream sends no more chunks
+      chunks.clear();
+      const uint32_t cancelled_id = block_api->stream_blocks( callback, 1, head, 1 );
+      fc::usleep(fc::milliseconds(200));
+      BOOST_REQUIRE_EQUAL( chunks.size(), 1u );
+      block_api->cancel_block_stream( cancelled_id );
+      block_api->acknowledge_block_chunk( cancelled_id, 1 );
+      fc::usleep(fc::milliseconds(200));
+      BOOST_CHECK_EQUAL( chunks.size(), 1u );
+
+      GRAPHENE_CHECK_THROW( block_api->stream_blocks( callback, 1, head, graphene::app::block_api::max_window + 1 ),
+                            fc::exception );
+
+      // a stream whose callback fails, e.g. after the client disconnected, ends and frees its slot
+      uint32_t failed_calls = 0;
+      auto failing_callback = [&failed_calls]( const variant& ) {
+         ++failed_calls;
+         FC_THROW( "Connection closed" );
+      };
+      for( uint32_t i = 0; i <= graphene::app::block_api::max_streams; ++i )
+      {
+         const uint32_t failing_id = block_api->stream_blocks( failing_callback, 1, head, 1 );
+         fc::usleep(fc::milliseconds(200));
+         block_api->acknowledge_block_chunk( failing_id, 1 );
+      }
+      fc::usleep(fc::milliseconds(200));
+      BOOST_CHECK_EQUAL( failed_calls, graphene::app::block_api::max_streams + 1 );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( api_throttle_test )
+{
+   try {
+      using graphene::app::api_cost_info;
+
+      graphene::app::api_throttle_config config;
+      config.connection_rate = 0.001;
+      config.connection_burst = 3;
+      config.user_rate = 0.001;
+      config.user_burst = 5;
+      config.default_method_cost = 2;
+      config.method_costs["get_block"] = 0.5;
+      config.cost_per_ms = 0;
+      config.cost_per_kib = 1;
+
+      auto registry = std::make_shared<graphene::app::api_cost_registry>();
+      auto unlimited = registry->new_session();
+      BOOST_CHECK( !unlimited->is_limited() );
+      for( int i = 0; i < 10; ++i )
+         BOOST_CHECK( unlimited->admit( "get_objects" ) );
+
+      // calls are admitted while the budget is positive, so the last admitted one may overdraw it
+      auto a = registry->new_session();
+      a->set_user( "alice", config );
+      BOOST_CHECK( a->is_limited() );
+      BOOST_CHECK( a->admit( "get_objects" ) );
+      BOOST_CHECK( a->admit( "get_objects" ) );
+      BOOST_CHECK( !a->admit( "get_objects" ) );
+
+      // a new connection has its own budget, but shares the one of its user
+      auto b = registry->new_session();
+      b->set_user( "alice", config );
+      BOOST_CHECK( b->admit( "get_block" ) );
+      BOOST_CHECK( b->admit( "get_objects" ) );
+      BOOST_CHECK( !b->admit( "get_objects" ) );
+      b->charge( 0, 2048 );
+
+      api_cost_info info = a->get_info();
+      BOOST_CHECK_EQUAL( info.user, "alice" );
+      BOOST_CHECK_EQUAL( info.calls, 2u );
+      BOOST_CHECK_EQUAL( info.throttled, 1u );
+      BOOST_CHECK_CLOSE( info.cost, 4, 0.001 );
+      info = b->get_info();
+      BOOST_CHECK_EQUAL( info.calls, 2u );
+      BOOST_CHECK_EQUAL( info.throttled, 1u );
+      BOOST_CHECK_CLOSE( info.cost, 4.5, 0.001 );
+
+      b.reset();
+      const vector<api_cost_info> costs = registry->get_costs();
+      BOOST_REQUIRE_EQUAL( costs.size(), 3u );
+      BOOST_CHECK_EQUAL( costs[0].session_id, unlimited->get_info().session_id );
+      BOOST_CHECK_EQUAL( costs[0].calls, 10u );
+      BOOST_CHECK_EQUAL( costs[1].session_id, a->get_info().session_id );
+      BOOST_CHECK_EQUAL( costs[2].session_id, 0u );
+      BOOST_CHECK_EQUAL( costs[2].user, "alice" );
+      BOOST_CHECK_EQUAL( costs[2].calls, 4u );
+      BOOST_CHECK_EQUAL( costs[2].throttled, 2u );
+      BOOST_CHECK_CLOSE( costs[2].cost, 8.5, 0.001 );
+
+      const std::string text = registry->to_prometheus();
+      BOOST_CHECK( text.find( "graphene_api_user_throttled_calls_total{user=\"alice\"} 2\n" ) != std::string::npos );
+      BOOST_CHECK( text.find( "graphene_api_session_throttled_calls_total{user=\"alice\",session=\"" )
+                   != std::string::npos );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( api_throttle_relogin_test )
+{
+   try {
+      graphene::app::api_throttle_config config;
+      config.connection_rate = 0.001;
+      config.connection_burst = 3;
+      config.default_method_cost = 2;
+      config.cost_per_ms = 0;
+      config.cost_per_kib = 0;
+
+      auto registry = std::make_shared<graphene::app::api_cost_registry>();
+      auto session = registry->new_session();
+      session->set_user( "alice", config );
+      BOOST_CHECK( session->admit( "get_objects" ) );
+      BOOST_CHECK( session->admit( "get_objects" ) );
+      BOOST_CHECK( !session->admit( "get_objects" ) );
+
+      // logging in again, as the same or as another user, does not refill the budget of the connection
+      session->set_user( "alice", config );
+      BOOST_CHECK( !session->admit( "get_objects" ) );
+      session->set_user( "*", config );
+      BOOST_CHECK( !session->admit( "get_objects" ) );
+      graphene::app::api_cost_info info = session->get_info();
+      BOOST_CHECK_EQUAL( info.user, "*" );
+      BOOST_CHECK_EQUAL( info.calls, 2u );
+      BOOST_CHECK_EQUAL( info.throttled, 3u );
+      BOOST_CHECK_EQUAL( info.available, 0 );
+
+      // the first login of a connection starts with a full budget
+      auto other = registry->new_session();
+      other->set_user( "alice", config );
+      BOOST_CHECK_CLOSE( other->get_info().available, 3, 0.1 );
+      BOOST_CHECK( other->admit( "get_objects" ) );
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( lookup_vote_ids )
 { try {
    ACTORS( (connie)(whitney)(wolverine) );
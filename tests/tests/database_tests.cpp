@@ -27,6 +27,8 @@
 #include <graphene/chain/database.hpp>
 
 #include <graphene/chain/account_object.hpp>
+#include <graphene/chain/expiration_scheduler.hpp>
+#include <graphene/chain/market_object.hpp>
 
 #include <fc/crypto/digest.hpp>
 
@@ -222,4 +224,336 @@ BOOST_AUTO_TEST_CASE( direct_index_test )
    // but the secondary has not updated its representation
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( latency_histogram_test )
+{ try {
+   // buckets are contiguous and monotonic
+   for( uint32_t b = 1; b < latency_histogram::bucket_count - 8; ++b )
+   {
+      uint64_t lower = latency_histogram::bucket_upper_bound( b - 1 ) + 1;
+      BOOST_CHECK_EQUAL( latency_histogram::bucket_of( lower ), b );
+      BOOST_CHECK_EQUAL( latency_histogram::bucket_of( latency_histogram::bucket_upper_bound( b ) ), b );
+   }
+   BOOST_CHECK_EQUAL( latency_histogram::bucket_upper_bound( latency_histogram::bucket_of( uint64_t(-1) ) ),
+                      uint64_t(-1) );
+
+   latency_histogram h;
+   for( uint64_t i = 1; i <= 1000; ++i )
+      h.record( i );
+   uint64_t p50 = h.percentile( 0.5, 1000 );
+   uint64_t p99 = h.percentile( 0.99, 1000 );
+   BOOST_CHECK_GE( p50, 500u );
+   BOOST_CHECK_LE( p50, 625u );
+   BOOST_CHECK_GE( p99, 990u );
+   BOOST_CHECK_LE( p99, 1237u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( execution_profiler_test )
+{ try {
+   ACTORS( (alice)(bob) );
+   transfer( account_id_type(), alice_id, asset(1000) );
+
+   BOOST_CHECK( !db.get_execution_profiler().is_enabled() );
+   BOOST_CHECK( db.get_execution_profiler().get_profile().operations.empty() );
+
+   db.get_execution_profiler().enable( true );
+   transfer( alice_id, bob_id, asset(100) );
+   transfer( alice_id, bob_id, asset(100) );
+
+   execution_profile profile = db.get_execution_profiler().get_profile();
+   BOOST_CHECK( profile.enabled );
+   BOOST_REQUIRE_EQUAL( profile.operations.size(), 1u );
+   BOOST_CHECK_EQUAL( profile.operations[0].name, "transfer_operation" );
+   BOOST_CHECK_EQUAL( profile.operations[0].count, 2u );
+   BOOST_CHECK_LE( profile.operations[0].p50_ns, profile.operations[0].max_ns );
+   BOOST_CHECK_EQUAL( profile.checks.size(), size_t(execution_profiler::CHECK_TYPE_COUNT) );
+   BOOST_CHECK_EQUAL( profile.checks[execution_profiler::transaction_total].count, 2u );
+
+   // pending transactions are applied again while generating and pushing the block
+   generate_block();
+   profile = db.get_execution_profiler().get_profile();
+   BOOST_CHECK_EQUAL( profile.last_block_num, db.head_block_num() );
+   BOOST_CHECK_GT( profile.operations[0].count, 2u );
+   const uint64_t count_while_enabled = profile.operations[0].count;
+
+   db.get_execution_profiler().enable( false );
+   transfer( alice_id, bob_id, asset(100) );
+   BOOST_CHECK_EQUAL( db.get_execution_profiler().get_profile().operations[0].count, count_while_enabled );
+
+   db.get_execution_profiler().reset();
+   BOOST_CHECK( db.get_execution_profiler().get_profile().operations.empty() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( block_phase_tracer_test )
+{ try {
+   generate_block();
+   BOOST_CHECK( db.get_block_phase_tracer().get_traces( 10 ).empty() );
+
+   db.get_block_phase_tracer().set_capacity( 3 );
+   generate_blocks( 5 );
+
+   vector<block_phase_trace> traces = db.get_block_phase_tracer().get_traces( 10 );
+   BOOST_REQUIRE_EQUAL( traces.size(), 3u );
+   BOOST_CHECK_EQUAL( traces[0].block_num, db.head_block_num() );
+   BOOST_CHECK_EQUAL( traces[2].block_num, db.head_block_num() - 2 );
+   BOOST_CHECK_EQUAL( db.get_block_phase_tracer().get_traces( 1 ).size(), 1u );
+
+   for( const auto& trace : traces )
+   {
+      BOOST_CHECK( !trace.phases.empty() );
+      BOOST_CHECK( trace.phases.front().phase == block_phase::validate_header );
+      BOOST_CHECK( trace.phases.back().phase == block_phase::notify_changed_objects );
+      for( const auto& timing : trace.phases )
+      {
+         BOOST_CHECK_EQUAL( timing.depth, 0 );
+         BOOST_CHECK_LE( timing.start_ns + timing.duration_ns, trace.duration_ns );
+      }
+   }
+
+   // maintenance steps are nested in the chain_maintenance phase
+   generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+   traces = db.get_block_phase_tracer().get_traces( 1 );
+   BOOST_REQUIRE_EQUAL( traces.size(), 1u );
+   BOOST_CHECK( traces[0].maintenance );
+   bool found_account_maintenance = false;
+   for( const auto& timing : traces[0].phases )
+   {
+      if( timing.phase == block_phase::maint_account_maintenance )
+      {
+         found_account_maintenance = true;
+         BOOST_CHECK_EQUAL( timing.depth, 1 );
+      }
+   }
+   BOOST_CHECK( found_account_maintenance );
+
+   db.get_block_phase_tracer().set_capacity( 0 );
+   BOOST_CHECK( db.get_block_phase_tracer().get_traces( 10 ).empty() );
+} FC_LOG_AND_RETHROW() }
+
+
+BOOST_AUTO_TEST_CASE( expiration_wheel_test )
+{ try {
+   expiration_wheel wheel;
+   std::set< std::pair< uint32_t, object_id_type > > expected;
+   const uint32_t start = 1500000000;
+
+   // entries in every level of the wheel and in the overflow set
+   const uint32_t offsets[] = { 0, 1, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 300000,
+                                16777215, 16777216, 50000000 };
+   uint64_t instance = 0;
+   for( uint32_t offset : offsets )
+   {
+      for( int i = 0; i < 3; ++i )
+      {
+         const object_id_type id( protocol_ids, limit_order_object_type, instance++ );
+         wheel.schedule( id, time_point_sec( start + offset ) );
+         expected.emplace( start + offset, id );
+      }
+   }
+   BOOST_CHECK_EQUAL( wheel.size(), expected.size() );
+
+   // rescheduling replaces the previous time
+   const object_id_type moved( protocol_ids, limit_order_object_type, 0 );
+   expected.erase( std::make_pair( start, moved ) );
+   wheel.schedule( moved, time_point_sec( start + 100 ) );
+   expected.emplace( start + 100, moved );
+   const object_id_type removed( protocol_ids, limit_order_object_type, 10 );
+   expected.erase( std::make_pair( start + offsets[3], removed ) );
+   wheel.unschedule( removed );
+   BOOST_CHECK_EQUAL( wheel.size(), expected.size() );
+
+   // nothing is due before the first entry, also not after time went back
+   BOOST_CHECK( wheel.next_due( time_point_sec( start - 1 ) ) == nullptr );
+   BOOST_REQUIRE( wheel.next_due( time_point_sec( start + 1 ) ) != nullptr );
+   BOOST_CHECK( wheel.next_due( time_point_sec( start - 1 ) ) == nullptr );
+
+   // advance with uneven steps, entries must come out in (time, id) order
+   uint32_t now = start - 10;
+   for( uint64_t k = 0; !expected.empty(); ++k )
+   {
+      now += 1 + ( k * 2654435761u ) % 20000;
+      while( const object_id_type* id = wheel.next_due( time_point_sec( now ) ) )
+      {
+         BOOST_REQUIRE( !expected.empty() );
+         BOOST_CHECK( *id == expected.begin()->second );
+         BOOST_CHECK_LE( expected.begin()->first, now );
+         const object_id_type due = *id;
+         wheel.unschedule( due );
+         expected.erase( expected.begin() );
+      }
+      BOOST_CHECK( expected.empty() || expected.begin()->first > now );
+   }
+   BOOST_CHECK_EQUAL( wheel.size(), 0u );
+
+   // entries scheduled in the past are due immediately
+   const object_id_type late( protocol_ids, limit_order_object_type, instance );
+   wheel.schedule( late, time_point_sec( now - 5 ) );
+   BOOST_CHECK( wheel.next_due( time_point_sec( now - 6 ) ) == nullptr );
+   BOOST_REQUIRE( wheel.next_due( time_point_sec( now - 5 ) ) != nullptr );
+   BOOST_CHECK( *wheel.next_due( time_point_sec( now - 5 ) ) == late );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( expired_order_undo_test )
+{ try {
+   ACTOR( alice );
+   transfer( committee_account, alice_id, asset( 10000 ) );
+   const asset_id_type test_id = create_user_issued_asset( "EXPTEST" ).id;
+   generate_block();
+
+   const time_point_sec expiration = db.head_block_time() + 60;
+   const limit_order_id_type order_id =
+         create_sell_order( alice_id, asset( 100 ), asset( 100, test_id ), expiration )->id;
+   const limit_order_id_type later_id =
+         create_sell_order( alice_id, asset( 100 ), asset( 100, test_id ), expiration + 600 )->id;
+   const int64_t balance = get_balance( alice_id, asset_id_type() );
+
+   generate_blocks( expiration );
+   BOOST_CHECK( db.find( order_id ) == nullptr );
+   BOOST_CHECK( db.find( later_id ) != nullptr );
+   const int64_t refunded_balance = get_balance( alice_id, asset_id_type() );
+   BOOST_CHECK_GT( refunded_balance, balance );
+
+   // the expiration is scheduled again when the block is popped
+   db.pop_block();
+   BOOST_CHECK( db.find( order_id ) != nullptr );
+   BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), balance );
+
+   generate_blocks( expiration );
+   BOOST_CHECK( db.find( order_id ) == nullptr );
+   BOOST_CHECK( db.find( later_id ) != nullptr );
+   BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), refunded_balance );
+
+   generate_blocks( expiration + 600 );
+   BOOST_CHECK( db.find( later_id ) == nullptr );
+   BOOST_CHECK_GT( get_balance( alice_id, asset_id_type() ), refunded_balance );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( bulk_load_rebuild_test )
+{ try {
+   ACTORS( (alice)(bob)(carol) );
+   // bob is a member of carol's active authority
+   db.modify( carol_id( db ), [&]( account_object& a ) {
+      a.active.account_auths[ bob_id ] = 1;
+   });
+
+   const auto& account_idx = dynamic_cast<const base_primary_index&>( db.get_index_type<account_index>() );
+   const auto& live = account_idx.get_secondary_index<account_member_index>();
+
+   vector<const object*> accounts;
+   account_member_index one_by_one;
+   db.get_index_type<account_index>().inspect_all_objects( [&]( const object& o ) {
+      accounts.push_back( &o );
+      one_by_one.object_inserted( o );
+   });
+   account_member_index rebuilt;
+   rebuilt.rebuild( accounts );
+
+   BOOST_CHECK( rebuilt.account_to_account_memberships == one_by_one.account_to_account_memberships );
+   BOOST_CHECK( rebuilt.account_to_key_memberships == one_by_one.account_to_key_memberships );
+   BOOST_CHECK( rebuilt.account_to_address_memberships == one_by_one.account_to_address_memberships );
+   BOOST_CHECK( live.account_to_account_memberships == one_by_one.account_to_account_memberships );
+   BOOST_CHECK( live.account_to_key_memberships == one_by_one.account_to_key_memberships );
+   BOOST_CHECK_EQUAL( live.account_to_account_memberships.at( bob_id ).count( carol_id ), 1u );
+
+   // orders and balances whose indexes are rebuilt as well
+   transfer( committee_account, alice_id, asset( 10000 ) );
+   const asset_id_type uia_id = create_user_issued_asset( "BULKTEST" ).id;
+   create_sell_order( alice_id, asset( 100 ), asset( 100, uia_id ) );
+   create_sell_order( alice_id, asset( 100 ), asset( 200, uia_id ) );
+   create_sell_order( alice_id, asset( 100 ), asset( 100, uia_id ) );
+   auto book_of = [&]() {
+      vector<limit_order_id_type> orders;
+      db.get_limit_order_book().visit_orders( asset_id_type(), uia_id, [&orders]( const limit_order_object& o ) {
+         orders.push_back( o.id );
+         return true;
+      });
+      return orders;
+   };
+   const vector<limit_order_id_type> book_before = book_of();
+   BOOST_CHECK_EQUAL( book_before.size(), 3u );
+   const int64_t alice_balance = get_balance( alice_id, asset_id_type() );
+
+   // the membership index is stale during a bulk load and complete after it; the object is created directly
+   // since applying operations reads balances, whose index is stale as well
+   db.begin_bulk_load();
+   const public_key_type dan_key = generate_private_key( "dan" ).get_public_key();
+   const account_id_type dan_id = db.create<account_object>( [&]( account_object& a ) {
+      a.name = "dan";
+      a.owner = authority( 1, dan_key, 1 );
+      a.active = a.owner;
+      a.options.memo_key = dan_key;
+   }).id;
+   BOOST_CHECK( live.account_to_key_memberships.find( dan_key ) == live.account_to_key_memberships.end() );
+   db.modify( carol_id( db ), [&]( account_object& a ) {
+      a.active.account_auths.erase( bob_id );
+      a.active.account_auths[ dan_id ] = 1;
+   });
+   db.end_bulk_load();
+   BOOST_CHECK_EQUAL( live.account_to_key_memberships.at( dan_key ).count( dan_id ), 1u );
+   BOOST_CHECK_EQUAL( live.account_to_account_memberships.at( dan_id ).count( carol_id ), 1u );
+   BOOST_CHECK( live.account_to_account_memberships.find( bob_id ) == live.account_to_account_memberships.end() );
+   BOOST_CHECK( book_of() == book_before );
+   BOOST_CHECK_EQUAL( db.get_limit_order_book().level_count( asset_id_type(), uia_id ), 2u );
+   BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), alice_balance );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( change_notification_test )
+{ try {
+   ACTORS( (alice)(bob) );
+   transfer( committee_account, alice_id, asset(1000000) );
+   generate_block();
+
+   size_t changed_count = 0;
+   flat_set<account_id_type> impacted;
+   boost::signals2::scoped_connection changed_conn = db.changed_objects.connect(
+      [&]( const vector<object_id_type>& ids, const flat_set<account_id_type>& accounts ) {
+         changed_count += ids.size();
+         impacted.insert( accounts.begin(), accounts.end() );
+      });
+   vector<database::object_changes> balance_changes;
+   boost::signals2::scoped_connection balance_conn = db.subscribe_to_object_changes<account_balance_object>(
+      [&]( const database::object_changes& changes ) { balance_changes.push_back( changes ); } );
+
+   // nobody requested the impacted accounts
+   BOOST_CHECK( !db.impacted_accounts_requested() );
+   transfer( alice_id, bob_id, asset(1000) );
+   generate_block();
+   BOOST_CHECK_GT( changed_count, 0u );
+   BOOST_CHECK( impacted.empty() );
+
+   BOOST_REQUIRE_EQUAL( balance_changes.size(), 1u );
+   const account_balance_object* bob_balance = db.get_index_type< primary_index< account_balance_index > >()
+                                                 .get_secondary_index< balances_by_account_index >()
+                                                 .get_account_balance( bob_id, asset_id_type() );
+   BOOST_REQUIRE( bob_balance != nullptr );
+   BOOST_REQUIRE_EQUAL( balance_changes[0].new_ids.size(), 1u );
+   BOOST_CHECK( balance_changes[0].new_ids[0] == bob_balance->id );
+   BOOST_CHECK( !balance_changes[0].changed_ids.empty() );
+   for( const auto& id : balance_changes[0].changed_ids )
+      BOOST_CHECK( id.is<account_balance_id_type>() );
+   BOOST_CHECK( balance_changes[0].removed.empty() );
+
+   // blocks which do not touch balances are not reported to the typed stream
+   generate_block();
+   BOOST_CHECK_EQUAL( balance_changes.size(), 1u );
+
+   std::shared_ptr<void> request = db.request_impacted_accounts();
+   std::shared_ptr<void> other_request = db.request_impacted_accounts();
+   BOOST_CHECK( db.impacted_accounts_requested() );
+   transfer( bob_id, alice_id, asset(10) );
+   generate_block();
+   BOOST_CHECK( impacted.find( alice_id ) != impacted.end() );
+   BOOST_CHECK( impacted.find( bob_id ) != impacted.end() );
+   BOOST_CHECK_EQUAL( balance_changes.size(), 2u );
+
+   request.reset();
+   BOOST_CHECK( db.impacted_accounts_requested() );
+   other_request.reset();
+   BOOST_CHECK( !db.impacted_accounts_requested() );
+
+   balance_conn.disconnect();
+   transfer( alice_id, bob_id, asset(10) );
+   generate_block();
+   BOOST_CHECK_EQUAL( balance_changes.size(), 2u );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
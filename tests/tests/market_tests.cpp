@@ -26,6 +26,8 @@
 
 #include <graphene/chain/hardfork.hpp>
 
+#include <graphene/chain/balance_write_batch.hpp>
+#include <graphene/chain/limit_order_book.hpp>
 #include <graphene/chain/market_object.hpp>
 
 #include "../common/database_fixture.hpp"
@@ -1888,5 +1890,305 @@ BOOST_AUTO_TEST_CASE(target_cr_test_call_limit_after_hf1270)
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE(limit_order_book_matches_price_index)
+{ try {
+   ACTORS((buyer)(seller));
+   const asset_id_type test_id = create_user_issued_asset( "BOOKTEST" ).id;
+   const asset_id_type core_id;
+   issue_uia( seller, asset( 1000000, test_id ) );
+   transfer( committee_account, buyer_id, asset( 1000000 ) );
+
+   // the book must list the orders of both sides in the order of the by_price index
+   auto check_book = [&]() {
+      const auto& book = db.get_limit_order_book();
+      const auto& price_idx = db.get_index_type<limit_order_index>().indices().get<by_price>();
+      for( const auto& market : { std::make_pair( test_id, core_id ), std::make_pair( core_id, test_id ) } )
+      {
+         vector<limit_order_id_type> expected;
+         auto itr = price_idx.lower_bound( price_index_key( price::max( market.first, market.second ) ) );
+         auto end = price_idx.upper_bound( price_index_key( price::min( market.first, market.second ) ) );
+         for( ; itr != end; ++itr )
+            expected.push_back( itr->id );
+         vector<limit_order_id_type> walked;
+         book.visit_orders( market.first, market.second, [&walked]( const limit_order_object& o ) -> bool {
+            walked.push_back( o.id );
+            return true;
+         });
+         BOOST_CHECK( walked == expected );
+         const limit_order_object* best = book.best_order( market.first, market.second );
+         if( expected.empty() )
+            BOOST_CHECK( best == nullptr );
+         else
+            BOOST_CHECK( best != nullptr && best->id == expected.front() );
+      }
+   };
+
+   // asks, some of them at equal prices given with different amounts
+   create_sell_order( seller_id, asset( 100, test_id ), asset( 200 ) );
+   const limit_order_id_type same_price_ask = create_sell_order( seller_id, asset( 50, test_id ), asset( 100 ) )->id;
+   create_sell_order( seller_id, asset( 100, test_id ), asset( 300 ) );
+   create_sell_order( seller_id, asset( 100, test_id ), asset( 150 ) );
+   create_sell_order( seller_id, asset( 33, test_id ), asset( 100 ) );
+   // bids below the asks
+   create_sell_order( buyer_id, asset( 100 ), asset( 100, test_id ) );
+   create_sell_order( buyer_id, asset( 120 ), asset( 100, test_id ) );
+   create_sell_order( buyer_id, asset( 60 ), asset( 50, test_id ) );
+   check_book();
+   BOOST_CHECK_EQUAL( db.get_limit_order_book().level_count( test_id, core_id ), 4u );
+   BOOST_CHECK_EQUAL( db.get_limit_order_book().level_count( core_id, test_id ), 2u );
+   generate_block();
+
+   // a bid which takes the best ask and stays on the book as the best bid
+   const limit_order_object* taker = create_sell_order( buyer_id, asset( 250 ), asset( 150, test_id ) );
+   BOOST_REQUIRE( taker != nullptr );
+   BOOST_CHECK( db.get_limit_order_book().best_order( core_id, test_id ) == taker );
+   check_book();
+
+   cancel_limit_order( same_price_ask( db ) );
+   check_book();
+   BOOST_CHECK_EQUAL( db.get_limit_order_book().level_count( test_id, core_id ), 3u );
+
+   generate_block();
+   check_book();
+   db.pop_block();
+   check_book();
+   BOOST_CHECK_EQUAL( db.get_limit_order_book().level_count( test_id, core_id ), 4u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(price_index_orders_by_exact_price)
+{ try {
+   const asset_id_type test_id = create_user_issued_asset( "KEYTEST" ).id;
+   const asset_id_type core_id;
+   const int64_t big = GRAPHENE_MAX_SHARE_SUPPLY;
+
+   // prices which differ by less than the precision of the sort key, equal prices and ordinary ones
+   const vector<price> prices = {
+      price( asset( big, test_id ), asset( big - 1 ) ),
+      price( asset( big - 1, test_id ), asset( big - 2 ) ),
+      price( asset( big - 2, test_id ), asset( big - 3 ) ),
+      price( asset( 2, test_id ), asset( 2 ) ),
+      price( asset( 1, test_id ), asset( 1 ) ),
+      price( asset( 1, test_id ), asset( big ) ),
+      price( asset( big, test_id ), asset( 1 ) ),
+      price( asset( 3, test_id ), asset( 7 ) ),
+      price( asset( 7 ), asset( 3, test_id ) ),
+      price( asset( big ), asset( big - 1, test_id ) ),
+      price( asset( big - 1 ), asset( big - 2, test_id ) )
+   };
+   for( const price& p : prices )
+   {
+      db.create<limit_order_object>( [&p]( limit_order_object& o ) {
+         o.seller = account_id_type();
+         o.expiration = time_point_sec::maximum();
+         o.for_sale = 1;
+         o.sell_price = p;
+      });
+   }
+
+   auto check_order = [&]() {
+      const auto& price_idx = db.get_index_type<limit_order_index>().indices().get<by_price>();
+      vector<const limit_order_object*> expected;
+      for( const limit_order_object& o : price_idx )
+         expected.push_back( &o );
+      std::sort( expected.begin(), expected.end(), []( const limit_order_object* a, const limit_order_object* b ) {
+         return a->sell_price > b->sell_price || ( a->sell_price == b->sell_price && a->id < b->id );
+      });
+      auto itr = price_idx.begin();
+      for( const limit_order_object* o : expected )
+      {
+         BOOST_REQUIRE( itr != price_idx.end() );
+         BOOST_CHECK( &*itr == o );
+         BOOST_CHECK( itr->sell_price_key == price_sort_key( itr->sell_price ) );
+         ++itr;
+      }
+   };
+   check_order();
+
+   // keys follow modifications of the price
+   const auto& order_idx = db.get_index_type<limit_order_index>().indices().get<by_id>();
+   db.modify( *order_idx.begin(), [&]( limit_order_object& o ) {
+      o.sell_price = price( asset( big - 3, test_id ), asset( big - 4 ) );
+   });
+   check_order();
+
+   // lookups find the first order at or below the given price
+   const auto& price_idx = db.get_index_type<limit_order_index>().indices().get<by_price>();
+   const price lookup = prices[1];
+   auto itr = price_idx.lower_bound( price_index_key( lookup ) );
+   BOOST_REQUIRE( itr != price_idx.end() );
+   BOOST_CHECK( itr->sell_price == lookup );
+   BOOST_CHECK( itr != price_idx.begin() && lookup < std::prev( itr )->sell_price );
+
+   // the orders are not backed by balances
+   while( !order_idx.empty() )
+      db.remove( *order_idx.begin() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(margin_call_frontier_test)
+{ try {
+   generate_blocks(HARDFORK_615_TIME); // get around Graphene issue #615 feed expiration bug
+   generate_block();
+
+   set_expiration( db, trx );
+
+   ACTORS((seller)(borrower)(borrower2)(feedproducer));
+
+   const auto& bitusd = create_bitasset("USDBIT", feedproducer_id);
+   const auto& core   = asset_id_type()(db);
+   const asset_id_type usd_id = bitusd.id;
+
+   transfer(committee_account, borrower_id, asset(1000000));
+   transfer(committee_account, borrower2_id, asset(1000000));
+   update_feed_producers( bitusd, {feedproducer.id} );
+
+   const margin_call_frontier& frontier = db.get_margin_call_frontier();
+   auto is_quiet = [&]() {
+      return frontier.is_quiet( usd_id, db.get_dynamic_global_properties().next_maintenance_time,
+                                db.head_block_time() > HARDFORK_436_TIME );
+   };
+
+   price_feed current_feed;
+   current_feed.maintenance_collateral_ratio = 1750;
+   current_feed.maximum_short_squeeze_ratio = 1100;
+   current_feed.settlement_price = bitusd.amount( 1 ) / core.amount(5);
+   publish_feed( bitusd, feedproducer, current_feed );
+   const call_order_object& call = *borrow( borrower, bitusd.amount(1000), asset(15000));
+   borrow( borrower2, bitusd.amount(1000), asset(20000));
+   transfer(borrower, seller, bitusd.amount(1000));
+
+   // the operations above checked for margin calls and found nothing to call
+   BOOST_CHECK( is_quiet() );
+   publish_feed( bitusd, feedproducer, current_feed );
+   BOOST_CHECK( is_quiet() );
+
+   {
+      auto session = db._undo_db.start_undo_session();
+      const asset_bitasset_data_object& bitasset = bitusd.bitasset_data(db);
+      // changes of anything that check_call_orders does not read keep the mark
+      db.modify( bitasset, []( asset_bitasset_data_object& b ) { b.force_settled_volume += 1; } );
+      BOOST_CHECK( is_quiet() );
+
+      // changes of the feed, of positions and of asks clear it
+      db.modify( bitasset, []( asset_bitasset_data_object& b ) { b.current_feed.maximum_short_squeeze_ratio += 1; } );
+      BOOST_CHECK( !is_quiet() );
+      BOOST_CHECK( !db.check_call_orders( bitusd ) );
+      BOOST_CHECK( is_quiet() );
+
+      db.modify( call, []( call_order_object& c ) { c.collateral += 1; } );
+      BOOST_CHECK( !is_quiet() );
+      BOOST_CHECK( !db.check_call_orders( bitusd ) );
+      BOOST_CHECK( is_quiet() );
+
+      db.create<limit_order_object>( [&]( limit_order_object& o ) {
+         o.seller = seller_id;
+         o.expiration = time_point_sec::maximum();
+         o.for_sale = 7;
+         o.sell_price = bitusd.amount(7) / core.amount(700);
+      });
+      BOOST_CHECK( !is_quiet() );
+      BOOST_CHECK( !db.check_call_orders( bitusd ) );
+      BOOST_CHECK( is_quiet() );
+
+      // so does undoing them
+      session.undo();
+      BOOST_CHECK( !is_quiet() );
+   }
+   BOOST_CHECK( !db.check_call_orders( bitusd ) );
+   BOOST_CHECK( is_quiet() );
+
+   // adjust price feed to get call_order into margin call territory, there are no asks yet
+   current_feed.settlement_price = bitusd.amount( 1 ) / core.amount(10);
+   publish_feed( bitusd, feedproducer, current_feed );
+   BOOST_CHECK( is_quiet() );
+   BOOST_CHECK_EQUAL( 1000, call.debt.value );
+
+   // an ask above the MSSP is matched with the margin call
+   BOOST_CHECK( !create_sell_order(seller, bitusd.amount(7), core.amount(60)) );
+   BOOST_CHECK_EQUAL( 993, call.debt.value );
+   BOOST_CHECK_EQUAL( 14940, call.collateral.value );
+
+   // undoing a block clears the marks of the assets it changed
+   BOOST_CHECK( !db.check_call_orders( bitusd ) );
+   BOOST_CHECK( is_quiet() );
+   generate_block();
+   BOOST_CHECK( !db.check_call_orders( bitusd ) );
+   BOOST_CHECK( is_quiet() );
+   db.pop_block();
+   BOOST_CHECK( !is_quiet() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(balance_write_batch_test)
+{ try {
+   ACTORS((alice)(bob)(carol));
+   transfer(committee_account, alice_id, asset(1000));
+
+   const auto& bal_idx = db.get_index_type< primary_index< account_balance_index > >()
+                            .get_secondary_index< balances_by_account_index >();
+   const account_balance_object& alice_core = *bal_idx.get_account_balance( alice_id, asset_id_type() );
+
+   {
+      auto session = db._undo_db.start_undo_session();
+      {
+         balance_write_batch batch( db );
+         db.adjust_balance( alice_id, asset(-300) );
+         db.adjust_balance( bob_id, asset(200) );
+         db.adjust_balance( alice_id, asset(100) );
+
+         // reads include the pending deltas, the balance objects are not written yet
+         BOOST_CHECK_EQUAL( db.get_balance( alice_id, asset_id_type() ).amount.value, 800 );
+         BOOST_CHECK_EQUAL( db.get_balance( bob_id, asset_id_type() ).amount.value, 200 );
+         BOOST_CHECK_EQUAL( alice_core.balance.value, 1000 );
+         BOOST_CHECK( bal_idx.get_account_balance( bob_id, asset_id_type() ) == nullptr );
+
+         // an adjustment which overdraws fails at once, as without a batch
+         GRAPHENE_REQUIRE_THROW( db.adjust_balance( alice_id, asset(-801) ), fc::exception );
+         GRAPHENE_REQUIRE_THROW( db.adjust_balance( carol_id, asset(-1) ), fc::exception );
+         BOOST_CHECK_EQUAL( db.get_balance( alice_id, asset_id_type() ).amount.value, 800 );
+
+         // a nested batch joins the outer one
+         balance_write_batch nested( db );
+         db.adjust_balance( bob_id, asset(-200) );
+         db.adjust_balance( alice_id, asset(-800) );
+         nested.flush();
+         BOOST_CHECK_EQUAL( alice_core.balance.value, 1000 );
+         BOOST_CHECK_EQUAL( batch.size(), 2u );
+
+         batch.flush();
+      }
+      BOOST_CHECK_EQUAL( alice_core.balance.value, 0 );
+      // the balance object of bob is created although the net delta is 0, like without a batch
+      const account_balance_object* bob_core = bal_idx.get_account_balance( bob_id, asset_id_type() );
+      BOOST_REQUIRE( bob_core != nullptr );
+      BOOST_CHECK_EQUAL( bob_core->balance.value, 0 );
+      BOOST_CHECK( bob_core->maintenance_flag );
+
+      // a batch left by an exception writes the adjustments made before it, as they are without a batch
+      try
+      {
+         balance_write_batch batch( db );
+         db.adjust_balance( carol_id, asset(5) );
+         db.adjust_balance( carol_id, asset(-6) );
+      }
+      catch( const fc::exception& )
+      {
+      }
+      const account_balance_object* carol_core = bal_idx.get_account_balance( carol_id, asset_id_type() );
+      BOOST_REQUIRE( carol_core != nullptr );
+      BOOST_CHECK_EQUAL( carol_core->balance.value, 5 );
+   }
+   BOOST_CHECK_EQUAL( alice_core.balance.value, 1000 );
+
+   // a taker filling several orders is paid the sum of the fills
+   const asset_object& uia = create_user_issued_asset( "UIATEST" );
+   const asset_id_type uia_id = uia.id;
+   issue_uia( bob, uia.amount(300) );
+   for( int i = 0; i < 3; ++i )
+      BOOST_REQUIRE( create_sell_order( bob, uia.amount(100), asset(100 + 10 * i) ) );
+   BOOST_CHECK( !create_sell_order( alice, asset(330), uia.amount(275) ) );
+   BOOST_CHECK_EQUAL( get_balance( alice_id, uia_id ), 300 );
+   BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), 1000 - 330 );
+   BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), 330 );
+   BOOST_CHECK_EQUAL( get_balance( bob_id, uia_id ), 0 );
+} FC_LOG_AND_RETHROW() }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -26,6 +26,7 @@
 
 #include <graphene/app/database_api.hpp>
 #include <graphene/chain/exceptions.hpp>
+#include <graphene/chain/vote_tally_object.hpp>
 
 #include <iostream>
 
@@ -539,4 +540,111 @@ BOOST_AUTO_TEST_CASE(last_voting_date_proxy)
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(incremental_vote_totals)
+{
+   try
+   {
+      // check the incrementally maintained totals against a serial recount at every maintenance interval
+      db.enable_vote_tally_verification( true );
+
+      ACTORS((alice)(bob)(proxy));
+
+      const witness_id_type witness1_id = witness_id_type(1);
+      const witness_id_type witness2_id = witness_id_type(2);
+      const vote_id_type vote1 = witness1_id(db).vote_id;
+      const vote_id_type vote2 = witness2_id(db).vote_id;
+
+      auto update_options = [&]( account_id_type account, const fc::ecc::private_key& key,
+                                 const std::function<void(account_options&)>& f ) {
+         account_update_operation op;
+         op.account = account;
+         op.new_options = account(db).options;
+         f( *op.new_options );
+         trx.operations.push_back( op );
+         set_expiration( db, trx );
+         sign( trx, key );
+         PUSH_TX( db, trx, ~0 );
+         trx.clear();
+      };
+      auto next_maintenance = [&]() {
+         generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+      };
+
+      next_maintenance();
+      const share_type base1 = witness1_id(db).total_votes;
+      const share_type base2 = witness2_id(db).total_votes;
+
+      transfer( committee_account, alice_id, asset(100) );
+      transfer( committee_account, bob_id, asset(200) );
+      transfer( committee_account, proxy_id, asset(300) );
+      update_options( proxy_id, proxy_private_key, [&]( account_options& o ) { o.votes.insert( vote1 ); } );
+      update_options( alice_id, alice_private_key, [&]( account_options& o ) { o.voting_account = proxy_id; } );
+      update_options( bob_id, bob_private_key, [&]( account_options& o ) { o.votes.insert( vote1 ); } );
+
+      next_maintenance();
+      BOOST_CHECK_EQUAL( witness1_id(db).total_votes.value, base1.value + 600 );
+      BOOST_CHECK_EQUAL( witness2_id(db).total_votes.value, base2.value );
+
+      // a stake change of an account proxying to another one
+      transfer( committee_account, alice_id, asset(1000) );
+      next_maintenance();
+      BOOST_CHECK_EQUAL( witness1_id(db).total_votes.value, base1.value + 1600 );
+
+      // a change of opinions moves the stake proxied to the account as well
+      update_options( proxy_id, proxy_private_key, [&]( account_options& o ) {
+         o.votes.erase( vote1 );
+         o.votes.insert( vote2 );
+      });
+      next_maintenance();
+      BOOST_CHECK_EQUAL( witness1_id(db).total_votes.value, base1.value + 200 );
+      BOOST_CHECK_EQUAL( witness2_id(db).total_votes.value, base2.value + 1400 );
+
+      // stopping to proxy
+      update_options( alice_id, alice_private_key, [&]( account_options& o ) {
+         o.voting_account = GRAPHENE_PROXY_TO_SELF_ACCOUNT;
+      });
+      next_maintenance();
+      BOOST_CHECK_EQUAL( witness2_id(db).total_votes.value, base2.value + 300 );
+
+      // changes reverted by popping a maintenance block are counted again
+      transfer( committee_account, bob_id, asset(50) );
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time - db.get_global_properties().parameters.block_interval );
+      generate_block();
+      BOOST_CHECK_EQUAL( witness1_id(db).total_votes.value, base1.value + 250 );
+      db.pop_block();
+      transfer( committee_account, bob_id, asset(50) );
+      generate_block();
+      BOOST_CHECK_EQUAL( witness1_id(db).total_votes.value, base1.value + 300 );
+
+      // a full recount yields the same totals
+      db.recount_votes_at_next_maintenance();
+      next_maintenance();
+      BOOST_CHECK_EQUAL( witness1_id(db).total_votes.value, base1.value + 300 );
+      BOOST_CHECK_EQUAL( witness2_id(db).total_votes.value, base2.value + 300 );
+
+      // a recount undone by popping its block is repeated by the next maintenance
+      db.recount_votes_at_next_maintenance();
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time - db.get_global_properties().parameters.block_interval );
+      generate_block();
+      db.pop_block();
+      transfer( committee_account, bob_id, asset(50) );
+      generate_block();
+      BOOST_CHECK_EQUAL( witness1_id(db).total_votes.value, base1.value + 350 );
+      next_maintenance();
+      BOOST_CHECK_EQUAL( witness1_id(db).total_votes.value, base1.value + 350 );
+
+      // votes for a witness created after the totals were counted
+      upgrade_to_lifetime_member( bob_id );
+      const witness_id_type witness3_id = create_witness( bob_id, bob_private_key ).id;
+      update_options( bob_id, bob_private_key, [&]( account_options& o ) {
+         o.votes.insert( witness3_id(db).vote_id );
+      });
+      next_maintenance();
+      BOOST_CHECK_EQUAL( witness3_id(db).total_votes.value, witness1_id(db).total_votes.value - base1.value );
+      BOOST_CHECK_EQUAL( db.get( vote_tally_id_type() ).votes.size(),
+                         db.get_global_properties().next_available_vote_id );
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()